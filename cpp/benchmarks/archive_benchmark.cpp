@@ -0,0 +1,85 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// benchmark data
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\",\"Polarity\":\"up\",\"Onset\":\"questionable\",\"Picker\":\"manual\",\"Filter\":[{\"HighPass\":1.05,\"LowPass\":2.65}],\"Amplitude\":{\"Amplitude\":21.5,\"Period\":2.65,\"SNR\":3.8},\"Beam\":{\"BackAzimuth\":2.65,\"Slowness\":1.44,\"PowerRatio\":12.18,\"BackAzimuthError\":3.8,\"SlownessError\":0.4,\"PowerRatioError\":0.557},\"AssociationInfo\":{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}}"
+
+#define MESSAGECOUNT 200000
+
+// reads the archive at path once with next() and once with readmessages(),
+// and reports the rate of each
+void readbenchmark(const std::string &name, const std::string &path,
+		bool useuring) {
+	std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+	uint64_t total = 0;
+	{
+		detectionformats::archivereader reader(path, 1024 * 1024, 4,
+				useuring);
+		const char *data;
+		size_t length;
+		while (reader.next(data, length) == true) {
+			detectionformats::benchmark::keep(data);
+			total += length;
+		}
+	}
+	double seconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start).count();
+	std::printf("%-8s read     %10.1f MB/s\n", name.c_str(),
+			static_cast<double>(total) / seconds / 1e6);
+
+	start = std::chrono::steady_clock::now();
+	uint64_t count = 0;
+	{
+		detectionformats::archivereader reader(path, 1024 * 1024, 4,
+				useuring);
+		count = reader.readmessages(
+				[](detectionformats::parseresult &result) {
+					detectionformats::benchmark::keep(result);
+				});
+	}
+	seconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start).count();
+	std::printf("%-8s messages %10.0f messages/s\n", name.c_str(),
+			static_cast<double>(count) / seconds);
+}
+
+// writes an archive of picks and reads it back with io_uring and with the
+// pread fallback
+int main(int argc, char **argv) {
+	size_t messagecount = MESSAGECOUNT;
+	if (argc > 1) {
+		messagecount = std::strtoul(argv[1], NULL, 10);
+	}
+
+	std::string path = "/tmp/detectionformats-archive-benchmark-"
+			+ std::to_string(getpid()) + ".json";
+	FILE *file = std::fopen(path.c_str(), "wb");
+	if (file == NULL) {
+		std::perror("fopen");
+		return (1);
+	}
+	std::string line = std::string(PICKSTRING) + "\n";
+	for (size_t i = 0; i < messagecount; i++) {
+		std::fwrite(line.data(), 1, line.length(), file);
+	}
+	std::fclose(file);
+
+	detectionformats::archivereader probe(path);
+	std::printf("archive %zu messages, %.1f MB, io_uring %s\n", messagecount,
+			static_cast<double>(probe.size()) / 1e6,
+			probe.isuring() ? "available" : "unavailable");
+
+	readbenchmark("io_uring", path, true);
+	readbenchmark("pread", path, false);
+
+	std::remove(path.c_str());
+	return (0);
+}
@@ -0,0 +1,74 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+// benchmark data
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\",\"Polarity\":\"up\",\"Onset\":\"questionable\",\"Picker\":\"manual\",\"Filter\":[{\"HighPass\":1.05,\"LowPass\":2.65}],\"Amplitude\":{\"Amplitude\":21.5,\"Period\":2.65,\"SNR\":3.8},\"Beam\":{\"BackAzimuth\":2.65,\"Slowness\":1.44,\"PowerRatio\":12.18,\"BackAzimuthError\":3.8,\"SlownessError\":0.4,\"PowerRatioError\":0.557},\"AssociationInfo\":{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}}"
+#define CORRELATIONSTRING "{\"Type\":\"Correlation\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Phase\":\"P\",\"Time\":\"2015-12-28T21:32:24.017Z\",\"Correlation\":2.65,\"Hypocenter\":{\"Latitude\":40.3344,\"Longitude\":-121.44,\"Depth\":32.44,\"Time\":\"2015-12-28T21:30:44.039Z\"},\"EventType\":\"earthquake\",\"Magnitude\":2.14,\"SNR\":3.8,\"ZScore\":33.67,\"DetectionThreshold\":1.5,\"ThresholdType\":\"minimum\",\"AssociationInfo\":{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}}"
+#define DETECTIONSTRING "{\"Type\":\"Detection\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Hypocenter\":{\"Latitude\":40.3344,\"Longitude\":-121.44,\"Depth\":32.44,\"Time\":\"2015-12-28T21:32:24.017Z\",\"LatitudeError\":12.5,\"LongitudeError\":22.64,\"DepthError\":2.44,\"TimeError\":1.984},\"DetectionType\":\"New\",\"DetectionTime\":\"2015-12-28T21:32:28.017Z\",\"EventType\":\"earthquake\",\"Bayes\":2.65,\"MinimumDistance\":2.14,\"RMS\":3.8,\"Gap\":33.67,\"Data\":[" PICKSTRING "," CORRELATIONSTRING "]}"
+#define RETRACTSTRING "{\"Type\":\"Retract\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define STATIONINFOSTRING "{\"Type\":\"StationInfo\",\"Site\":{\"Station\":\"BOZ\",\"Channel\":\"BHZ\",\"Network\":\"US\",\"Location\":\"00\"},\"Latitude\":45.59697,\"Longitude\":-111.62967,\"Elevation\":1589.0,\"Quality\":1.0,\"Enable\":true,\"UseForTeleseismic\":true,\"InformationRequestor\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+
+#define MESSAGECOUNT 100000
+#define ITERATIONS 10
+
+// times parsing a mixed batch of messages with ParseBatch on 1 up to the
+// number of hardware threads, doubling each step
+int main(int argc, char **argv) {
+	size_t iterations = ITERATIONS;
+	size_t messagecount = MESSAGECOUNT;
+	size_t maxthreads = std::thread::hardware_concurrency();
+	if (argc > 1) {
+		iterations = std::strtoul(argv[1], NULL, 10);
+	}
+	if (argc > 2) {
+		messagecount = std::strtoul(argv[2], NULL, 10);
+	}
+	if (argc > 3) {
+		maxthreads = std::strtoul(argv[3], NULL, 10);
+	}
+	if (maxthreads == 0) {
+		maxthreads = 1;
+	}
+
+	// mostly picks, as in a day of archive
+	const char *mix[] = { PICKSTRING, PICKSTRING, PICKSTRING, PICKSTRING,
+	PICKSTRING, CORRELATIONSTRING, DETECTIONSTRING, RETRACTSTRING,
+	STATIONINFOSTRING };
+	std::vector<std::string> messages;
+	messages.reserve(messagecount);
+	for (size_t i = 0; i < messagecount; i++) {
+		messages.push_back(mix[i % (sizeof(mix) / sizeof(mix[0]))]);
+	}
+
+	detectionformats::benchmark::header();
+
+	double singlethread = 0;
+	for (size_t threads = 1; threads <= maxthreads;
+			threads = (threads * 2 > maxthreads && threads < maxthreads) ?
+					maxthreads : threads * 2) {
+		detectionformats::threadpool pool(threads);
+
+		double nanoseconds = detectionformats::benchmark::run(
+				"parsebatch " + std::to_string(messagecount) + " messages "
+						+ std::to_string(threads) + " threads", iterations,
+				[&messages, &pool]() {
+					std::vector<detectionformats::parseresult> results =
+							detectionformats::ParseBatch(messages, pool);
+					detectionformats::benchmark::keep(results);
+				});
+
+		if (threads == 1) {
+			singlethread = nanoseconds;
+		}
+		std::printf("%-40s %12s %13.2fx\n", "  speedup", "",
+				singlethread / nanoseconds);
+	}
+
+	return (0);
+}
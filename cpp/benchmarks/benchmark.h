@@ -0,0 +1,84 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_BENCHMARK_H
+#define DETECTION_BENCHMARK_H
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace detectionformats {
+/**
+ * \brief detectionformats benchmark harness
+ *
+ * A minimal timing harness shared by the benchmark executables.  Each
+ * benchmark is a callable run for a fixed number of iterations after a short
+ * warm up, and the mean time per iteration is printed.
+ *
+ * Benchmarks are only meaningful in an optimized build without coverage,
+ * i.e. configured with -DCMAKE_BUILD_TYPE=Release -DSUPPORT_COVERAGE=OFF.
+ */
+namespace benchmark {
+
+/**
+ * \brief Keep a benchmark result
+ *
+ * Marks value as used so that the optimizer cannot discard the work that
+ * produced it.
+ * \param value - The result to keep
+ */
+template<class T>
+inline void keep(T &value) {
+#if defined(__GNUC__)
+	asm volatile("" : : "g"(&value) : "memory");
+#else
+	static T * volatile sink;
+	sink = &value;
+#endif
+}
+
+/**
+ * \brief Print the benchmark table header
+ */
+inline void header() {
+	std::printf("%-40s %12s %14s\n", "benchmark", "iterations", "ns/iteration");
+}
+
+/**
+ * \brief Run a benchmark
+ *
+ * Runs function iterations / 10 times to warm up, then times iterations
+ * calls and prints the mean time per call.
+ * \param name - A std::string containing the name to report
+ * \param iterations - The number of timed calls to make
+ * \param function - The callable to time
+ * \return Returns a double containing the mean nanoseconds per call
+ */
+template<class Function>
+double run(const std::string &name, size_t iterations, Function function) {
+	for (size_t i = 0; i < iterations / 10; i++) {
+		function();
+	}
+
+	std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		function();
+	}
+	std::chrono::steady_clock::time_point end =
+			std::chrono::steady_clock::now();
+
+	double nanoseconds = std::chrono::duration<double, std::nano>(
+			end - start).count() / static_cast<double>(iterations);
+
+	std::printf("%-40s %12zu %14.1f\n", name.c_str(), iterations,
+			nanoseconds);
+	return (nanoseconds);
+}
+}
+}
+#endif
@@ -0,0 +1,94 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// benchmark data
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\",\"Polarity\":\"up\",\"Onset\":\"questionable\",\"Picker\":\"manual\",\"Filter\":[{\"HighPass\":1.05,\"LowPass\":2.65},{\"HighPass\":2.10,\"LowPass\":3.58}],\"Amplitude\":{\"Amplitude\":21.5,\"Period\":2.65,\"SNR\":3.8},\"Beam\":{\"BackAzimuth\":2.65,\"Slowness\":1.44,\"PowerRatio\":12.18,\"BackAzimuthError\":3.8,\"SlownessError\":0.4,\"PowerRatioError\":0.557},\"AssociationInfo\":{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}}"
+#define CORRELATIONSTRING "{\"Type\":\"Correlation\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Phase\":\"P\",\"Time\":\"2015-12-28T21:32:24.017Z\",\"Correlation\":2.65,\"Hypocenter\":{\"Latitude\":40.3344,\"Longitude\":-121.44,\"Depth\":32.44,\"Time\":\"2015-12-28T21:30:44.039Z\"},\"EventType\":\"earthquake\",\"Magnitude\":2.14,\"SNR\":3.8,\"ZScore\":33.67,\"DetectionThreshold\":1.5,\"ThresholdType\":\"minimum\",\"AssociationInfo\":{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}}"
+#define DETECTIONHEADER "{\"Type\":\"Detection\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Hypocenter\":{\"Latitude\":40.3344,\"Longitude\":-121.44,\"Depth\":32.44,\"Time\":\"2015-12-28T21:32:24.017Z\"},\"DetectionType\":\"New\",\"DetectionTime\":\"2015-12-28T21:32:28.017Z\",\"Data\":["
+
+#define DATACOUNT 1000
+#define ITERATIONS 50
+
+// builds a detection with datacount entries, alternating picks and
+// correlations
+std::string builddetection(size_t datacount) {
+	std::string detectionstring = DETECTIONHEADER;
+	for (size_t i = 0; i < datacount; i++) {
+		if (i > 0) {
+			detectionstring += ",";
+		}
+		detectionstring += (i % 2 == 0) ? PICKSTRING : CORRELATIONSTRING;
+	}
+	detectionstring += "]}";
+	return (detectionstring);
+}
+
+int main(int argc, char **argv) {
+	size_t iterations = ITERATIONS;
+	size_t datacount = DATACOUNT;
+	if (argc > 1) {
+		iterations = std::strtoul(argv[1], NULL, 10);
+	}
+	if (argc > 2) {
+		datacount = std::strtoul(argv[2], NULL, 10);
+	}
+
+	std::string name = "detection " + std::to_string(datacount)
+			+ " entries";
+
+	rapidjson::Document document;
+	detectionformats::FromJSONString(builddetection(datacount), document);
+
+	detectionformats::benchmark::header();
+
+	detectionformats::benchmark::run(name + " construct", iterations,
+			[&document]() {
+				detectionformats::detection object(document);
+				detectionformats::benchmark::keep(object);
+			});
+
+	detectionformats::detection object;
+	detectionformats::benchmark::run(name + " resetfrom", iterations,
+			[&document, &object]() {
+				object.resetfrom(document);
+				detectionformats::benchmark::keep(object);
+			});
+
+	detectionformats::benchmark::run(name + " tojson", iterations,
+			[&object]() {
+				rapidjson::Document outputdocument;
+				object.tojson(outputdocument, outputdocument.GetAllocator());
+				detectionformats::benchmark::keep(outputdocument);
+			});
+
+	// validation, serial and on a pool with one thread per hardware thread
+	detectionformats::threadpool pool;
+	std::string poolname = " " + std::to_string(pool.size()) + " threads";
+
+	detectionformats::benchmark::run(name + " geterrors", iterations,
+			[&object]() {
+				std::vector<std::string> errors = object.geterrors();
+				detectionformats::benchmark::keep(errors);
+			});
+	detectionformats::benchmark::run(name + " geterrors" + poolname,
+			iterations, [&object, &pool]() {
+				std::vector<std::string> errors = object.geterrors(pool);
+				detectionformats::benchmark::keep(errors);
+			});
+	detectionformats::benchmark::run(name + " isvalid", iterations,
+			[&object]() {
+				bool valid = object.isvalid();
+				detectionformats::benchmark::keep(valid);
+			});
+	detectionformats::benchmark::run(name + " isvalid" + poolname,
+			iterations, [&object, &pool]() {
+				bool valid = object.isvalid(pool);
+				detectionformats::benchmark::keep(valid);
+			});
+
+	return (0);
+}
@@ -0,0 +1,118 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#define PICKCOUNT 500
+#define ADDEDPICKS 10
+#define MODIFIEDPICKS 5
+#define ITERATIONS 2000
+
+// times publishing an update of a large detection, a relocation that adds
+// and repicks a few of its picks, as the full new version against the
+// changes from the previous one, in both encodings, and reports their sizes
+int main(int argc, char **argv) {
+	size_t iterations = ITERATIONS;
+	if (argc > 1) {
+		iterations = std::strtoul(argv[1], NULL, 10);
+	}
+
+	detectionformats::detection olddetection;
+	olddetection.id = "12GFH48776857";
+	olddetection.source = detectionformats::source("US", "TestAuthor");
+	olddetection.hypocenter = detectionformats::hypocenter(40.3344, -121.44,
+			1000.0, 32.44, 12.5, 22.64, 2.44, 1.2);
+	olddetection.detectiontype = "New";
+	olddetection.detectiontime = 1010.0;
+	for (size_t i = 0; i < PICKCOUNT; i++) {
+		detectionformats::pick newpick;
+		newpick.id = "pick" + std::to_string(i);
+		newpick.site = detectionformats::site("S" + std::to_string(i), "BHZ",
+				"US", "00");
+		newpick.time = 1001.0 + i * 0.1;
+		newpick.source = detectionformats::source("US", "TestAuthor");
+		newpick.phase = "P";
+		olddetection.pickdata.push_back(newpick);
+	}
+
+	detectionformats::detection newdetection(olddetection);
+	newdetection.detectiontype = "Update";
+	newdetection.detectiontime = 1020.0;
+	newdetection.hypocenter.latitude = 40.3351;
+	newdetection.hypocenter.longitude = -121.4412;
+	newdetection.hypocenter.time = 1000.12;
+	for (size_t i = 0; i < MODIFIEDPICKS; i++) {
+		newdetection.pickdata[i * 7].time += 0.05;
+	}
+	for (size_t i = 0; i < ADDEDPICKS; i++) {
+		detectionformats::pick newpick = olddetection.pickdata.shared(i);
+		newpick.id = "late" + std::to_string(i);
+		newpick.time = 1060.0 + i;
+		newdetection.pickdata.push_back(newpick);
+	}
+
+	std::string fullbinary;
+	newdetection.tobinary(fullbinary);
+	rapidjson::Document fulldocument;
+	std::string fulljson = detectionformats::ToJSONString(
+			newdetection.tojson(fulldocument, fulldocument.GetAllocator()));
+	detectionformats::detectiondiff changes(olddetection, newdetection);
+	std::string diffbinary;
+	changes.tobinary(diffbinary);
+	rapidjson::Document diffdocument;
+	std::string diffjson = detectionformats::ToJSONString(
+			changes.tojson(diffdocument, diffdocument.GetAllocator()));
+
+	std::printf("%zu picks, %d added, %d modified\n", olddetection.pickdata
+			.size(), ADDEDPICKS, MODIFIEDPICKS);
+	std::printf("%-14s %10zu bytes json %10zu bytes binary\n", "full",
+			fulljson.length(), fullbinary.length());
+	std::printf("%-14s %10zu bytes json %10zu bytes binary\n", "diff",
+			diffjson.length(), diffbinary.length());
+
+	detectionformats::benchmark::header();
+
+	detectionformats::benchmark::run("full json", iterations,
+			[&newdetection]() {
+				rapidjson::Document document;
+				std::string json = detectionformats::ToJSONString(
+						newdetection.tojson(document, document.GetAllocator()));
+				detectionformats::benchmark::keep(json);
+			});
+
+	detectionformats::benchmark::run("diff json", iterations,
+			[&olddetection, &newdetection]() {
+				detectionformats::detectiondiff diff(olddetection,
+						newdetection);
+				rapidjson::Document document;
+				std::string json = detectionformats::ToJSONString(
+						diff.tojson(document, document.GetAllocator()));
+				detectionformats::benchmark::keep(json);
+			});
+
+	detectionformats::benchmark::run("full binary", iterations,
+			[&newdetection]() {
+				std::string buffer;
+				newdetection.tobinary(buffer);
+				detectionformats::benchmark::keep(buffer);
+			});
+
+	detectionformats::benchmark::run("diff binary", iterations,
+			[&olddetection, &newdetection]() {
+				std::string buffer;
+				detectionformats::detectiondiff(olddetection, newdetection)
+						.tobinary(buffer);
+				detectionformats::benchmark::keep(buffer);
+			});
+
+	detectionformats::benchmark::run("diff apply", iterations,
+			[&olddetection, &changes]() {
+				detectionformats::detection applied = changes.apply(
+						olddetection);
+				detectionformats::benchmark::keep(applied);
+			});
+
+	return (0);
+}
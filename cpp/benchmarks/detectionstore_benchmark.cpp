@@ -0,0 +1,111 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define DETECTIONCOUNT 200000
+#define VERSIONS 3
+#define THREADS 4
+#define ITERATIONS 3
+
+// the baseline's record of a detection
+struct versionentry {
+	detectionformats::detectionstore::version current;
+	std::multimap<double, std::string>::iterator position;
+};
+
+// times applying several versions of each of a couple hundred thousand
+// detections from several threads, with a detectionstore against the same
+// shared versions and origin time index behind a single mutex
+int main(int argc, char **argv) {
+	size_t iterations = ITERATIONS;
+	if (argc > 1) {
+		iterations = std::strtoul(argv[1], NULL, 10);
+	}
+
+	// each thread's messages, versions of a detection in sequence
+	std::vector<std::vector<detectionformats::detection>> messages(THREADS);
+	for (size_t i = 0; i < DETECTIONCOUNT; i++) {
+		for (size_t v = 0; v < VERSIONS; v++) {
+			detectionformats::detection newdetection;
+			newdetection.id = "detection" + std::to_string(i);
+			newdetection.source = detectionformats::source("US", "TestAuthor");
+			newdetection.hypocenter = detectionformats::hypocenter(40.3344,
+					-121.44, 1000.0 + i, 32.44, 12.5, 22.64, 2.44, 1.2);
+			newdetection.detectiontype = (v == 0) ? "New" : "Update";
+			newdetection.detectiontime = 2000.0 + i + v;
+			messages[i % THREADS].push_back(newdetection);
+		}
+	}
+
+	detectionformats::benchmark::header();
+
+	detectionformats::benchmark::run(
+			"single mutex " + std::to_string(DETECTIONCOUNT * VERSIONS)
+					+ " messages", iterations, [&messages]() {
+				std::unordered_map<std::string, versionentry> detections;
+				std::multimap<double, std::string> times;
+				std::mutex mutex;
+				std::vector<std::thread> threads;
+				for (size_t t = 0; t < THREADS; t++) {
+					threads.push_back(std::thread([&detections, &times, &mutex,
+							&messages, t]() {
+						for (size_t i = 0; i < messages[t].size(); i++) {
+							const detectionformats::detection &message =
+									messages[t][i];
+							detectionformats::detectionstore::version
+									newversion = std::make_shared<
+											const detectionformats::detection>(
+											message);
+							std::lock_guard<std::mutex> guard(mutex);
+							versionentry &entry = detections[message.id];
+							if ((entry.current)
+									&& (message.detectiontime
+											< entry.current->detectiontime)) {
+								continue;
+							}
+							if (entry.current) {
+								times.erase(entry.position);
+							}
+							entry.current = newversion;
+							entry.position = times.insert(
+									std::make_pair(message.hypocenter.time,
+											message.id));
+						}
+					}));
+				}
+				for (size_t t = 0; t < threads.size(); t++) {
+					threads[t].join();
+				}
+				size_t count = detections.size();
+				detectionformats::benchmark::keep(count);
+			});
+
+	detectionformats::benchmark::run(
+			"detectionstore " + std::to_string(DETECTIONCOUNT * VERSIONS)
+					+ " messages", iterations, [&messages]() {
+				detectionformats::detectionstore store;
+				std::vector<std::thread> threads;
+				for (size_t t = 0; t < THREADS; t++) {
+					threads.push_back(std::thread([&store, &messages, t]() {
+						for (size_t i = 0; i < messages[t].size(); i++) {
+							store.apply(messages[t][i]);
+						}
+					}));
+				}
+				for (size_t t = 0; t < threads.size(); t++) {
+					threads[t].join();
+				}
+				size_t count = store.size();
+				detectionformats::benchmark::keep(count);
+			});
+
+	return (0);
+}
@@ -0,0 +1,119 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// benchmark data
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\",\"Polarity\":\"up\",\"Onset\":\"questionable\",\"Picker\":\"manual\",\"Filter\":[{\"HighPass\":1.05,\"LowPass\":2.65}],\"Amplitude\":{\"Amplitude\":21.5,\"Period\":2.65,\"SNR\":3.8},\"Beam\":{\"BackAzimuth\":2.65,\"Slowness\":1.44,\"PowerRatio\":12.18,\"BackAzimuthError\":3.8,\"SlownessError\":0.4,\"PowerRatioError\":0.557},\"AssociationInfo\":{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}}"
+
+#define MESSAGECOUNT 50000
+#define CLIENTCOUNT 2
+#define WRITESIZE 65536
+
+// sends messagecount picks over a unix domain socket in large writes
+void sendmessages(const std::string &path, size_t messagecount) {
+	int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.c_str(), path.length());
+	if (connect(descriptor, reinterpret_cast<sockaddr *>(&address),
+			sizeof(address)) < 0) {
+		std::perror("connect");
+		return;
+	}
+
+	std::string line = std::string(PICKSTRING) + "\n";
+	std::string buffer;
+	for (size_t i = 0; i < messagecount; i++) {
+		buffer += line;
+		if ((buffer.length() >= WRITESIZE) || (i + 1 == messagecount)) {
+			size_t written = 0;
+			while (written < buffer.length()) {
+				ssize_t length = write(descriptor, buffer.data() + written,
+						buffer.length() - written);
+				if (length <= 0) {
+					close(descriptor);
+					return;
+				}
+				written += length;
+			}
+			buffer.clear();
+		}
+	}
+	close(descriptor);
+}
+
+// sends picks from several clients over unix domain sockets to an ingest
+// server and reports the messages per second received by the callback
+int main(int argc, char **argv) {
+	size_t messagecount = MESSAGECOUNT;
+	size_t clientcount = CLIENTCOUNT;
+	size_t callbackthreads = 1;
+	if (argc > 1) {
+		messagecount = std::strtoul(argv[1], NULL, 10);
+	}
+	if (argc > 2) {
+		clientcount = std::strtoul(argv[2], NULL, 10);
+	}
+	if (argc > 3) {
+		callbackthreads = std::strtoul(argv[3], NULL, 10);
+	}
+
+	std::atomic<uint64_t> received(0);
+	detectionformats::ingestserver server(
+			[&received](detectionformats::parseresult &result, bool valid) {
+				detectionformats::benchmark::keep(result);
+				detectionformats::benchmark::keep(valid);
+				received++;
+			}, 4096, callbackthreads);
+
+	std::string path = "/tmp/detectionformats-ingest-benchmark-"
+			+ std::to_string(getpid()) + ".sock";
+	server.listenunix(path);
+	std::thread loop([&server]() {server.run();});
+
+	std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+
+	std::vector<std::thread> clients;
+	for (size_t i = 0; i < clientcount; i++) {
+		clients.push_back(std::thread(sendmessages, path, messagecount));
+	}
+	for (size_t i = 0; i < clients.size(); i++) {
+		clients[i].join();
+	}
+
+	uint64_t expected = messagecount * clientcount;
+	while (received.load() < expected) {
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+
+	double seconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start).count();
+
+	server.stop();
+	loop.join();
+
+	detectionformats::ingeststatistics statistics = server.getstatistics();
+	std::printf("ingest %zu clients x %zu messages, %zu callback threads\n",
+			clientcount, messagecount, callbackthreads);
+	std::printf("  throughput   %.0f messages/s  %.1f MB/s\n",
+			static_cast<double>(expected) / seconds,
+			static_cast<double>(statistics.bytes) / seconds / 1e6);
+	std::printf("  pauses       %llu\n",
+			static_cast<unsigned long long>(statistics.pauses));
+
+	return (0);
+}
@@ -0,0 +1,187 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define PICKCOUNT 200000
+#define LOOKUPS 100
+#define RANGE 1000.0
+#define ITERATIONS 10
+
+// removes a log directory and its files
+static void RemoveLog(const std::string &path) {
+	DIR *listing = opendir(path.c_str());
+	if (listing == NULL) {
+		return;
+	}
+	for (struct dirent *item = readdir(listing); item != NULL;
+			item = readdir(listing)) {
+		std::string file = item->d_name;
+		if ((file != ".") && (file != "..")) {
+			unlink((path + "/" + file).c_str());
+		}
+	}
+	closedir(listing);
+	rmdir(path.c_str());
+}
+
+// times finding one pick by id and the picks in a time range, with a
+// messagelog and a messagelogreader against scanning the same picks as an
+// NDJSON archive, the id lookups with memmem and the range by parsing
+// every line
+int main(int argc, char **argv) {
+	size_t iterations = ITERATIONS;
+	if (argc > 1) {
+		iterations = std::strtoul(argv[1], NULL, 10);
+	}
+
+	std::string directory = "/tmp/detectionformats-messagelog-benchmark-"
+			+ std::to_string(getpid());
+	std::string archivepath = directory + ".json";
+	RemoveLog(directory);
+
+	std::vector<detectionformats::pick> picks;
+	for (size_t i = 0; i < PICKCOUNT; i++) {
+		detectionformats::pick newpick;
+		newpick.id = "pick" + std::to_string(i);
+		newpick.site = detectionformats::site("S" + std::to_string(i % 500),
+				"BHZ", "US", "00");
+		newpick.time = 1451338344.017 + i * 0.5;
+		newpick.source = detectionformats::source("US", "TestAuthor");
+		newpick.phase = "P";
+		picks.push_back(newpick);
+	}
+
+	detectionformats::benchmark::header();
+
+	detectionformats::benchmark::run(
+			"ndjson write " + std::to_string(PICKCOUNT) + " picks", 1,
+			[&picks, &archivepath]() {
+				FILE *file = std::fopen(archivepath.c_str(), "wb");
+				for (size_t i = 0; i < picks.size(); i++) {
+					rapidjson::Document document;
+					std::string line = detectionformats::ToJSONString(
+							picks[i].tojson(document, document.GetAllocator()))
+							+ "\n";
+					std::fwrite(line.data(), 1, line.length(), file);
+				}
+				std::fclose(file);
+			});
+
+	detectionformats::benchmark::run(
+			"messagelog append " + std::to_string(PICKCOUNT) + " picks", 1,
+			[&picks, &directory]() {
+				detectionformats::messagelog log(directory);
+				for (size_t i = 0; i < picks.size(); i++) {
+					log.append(picks[i]);
+				}
+			});
+
+	std::vector<std::string> ids;
+	for (size_t i = 0; i < LOOKUPS; i++) {
+		ids.push_back("pick" + std::to_string((i * 7919) % PICKCOUNT));
+	}
+	double start = picks[PICKCOUNT / 2].time;
+	detectionformats::mappedarchive archive(archivepath);
+	detectionformats::messagelog log(directory);
+	detectionformats::messagelogreader reader(directory);
+
+	detectionformats::benchmark::run(
+			"ndjson memmem " + std::to_string(LOOKUPS) + " ids", iterations,
+			[&archive, &ids]() {
+				size_t found = 0;
+				for (size_t i = 0; i < ids.size(); i++) {
+					std::string key = "\"ID\":\"" + ids[i] + "\"";
+					found += (memmem(archive.data(), archive.size(),
+							key.data(), key.length()) != NULL);
+				}
+				detectionformats::benchmark::keep(found);
+			});
+
+	detectionformats::benchmark::run(
+			"messagelog read " + std::to_string(LOOKUPS) + " ids", iterations,
+			[&log, &ids]() {
+				size_t found = 0;
+				std::vector<detectionformats::messagelogentry> entries;
+				std::string message;
+				for (size_t i = 0; i < ids.size(); i++) {
+					entries.clear();
+					log.find(ids[i], entries);
+					found += log.read(entries[0], message);
+				}
+				detectionformats::benchmark::keep(found);
+			});
+
+	detectionformats::benchmark::run(
+			"messagelogreader get " + std::to_string(LOOKUPS) + " ids",
+			iterations, [&reader, &ids]() {
+				size_t found = 0;
+				std::vector<detectionformats::messagelogentry> entries;
+				const char *data = NULL;
+				size_t length = 0;
+				for (size_t i = 0; i < ids.size(); i++) {
+					entries.clear();
+					reader.find(ids[i], entries);
+					found += reader.get(entries[0], data, length);
+				}
+				detectionformats::benchmark::keep(found);
+			});
+
+	detectionformats::benchmark::run("ndjson parse time range", 1,
+			[&archive, start]() {
+				size_t found = 0;
+				detectionformats::parsecontext context;
+				const char *position = archive.data();
+				const char *end = position + archive.size();
+				while (position < end) {
+					const char *newline = static_cast<const char *>(
+							std::memchr(position, '\n', end - position));
+					detectionformats::parsecontext::document &document =
+							context.parse(position, newline - position);
+					rapidjson::Value::ConstMemberIterator time =
+							document.FindMember("Time");
+					double value = detectionformats::ConvertISO8601ToEpochTime(
+							time->value.GetString(),
+							time->value.GetStringLength());
+					found += (value >= start) && (value <= start + RANGE);
+					position = newline + 1;
+				}
+				detectionformats::benchmark::keep(found);
+			});
+
+	detectionformats::benchmark::run("messagelog time range", iterations,
+			[&log, start]() {
+				std::vector<detectionformats::messagelogentry> entries;
+				std::string message;
+				log.within(start, start + RANGE, entries);
+				size_t found = 0;
+				for (size_t i = 0; i < entries.size(); i++) {
+					found += log.read(entries[i], message);
+				}
+				detectionformats::benchmark::keep(found);
+			});
+
+	detectionformats::benchmark::run("messagelogreader time range", iterations,
+			[&reader, start]() {
+				std::vector<detectionformats::messagelogentry> entries;
+				reader.within(start, start + RANGE, entries);
+				size_t found = 0;
+				const char *data = NULL;
+				size_t length = 0;
+				for (size_t i = 0; i < entries.size(); i++) {
+					found += reader.get(entries[i], data, length);
+				}
+				detectionformats::benchmark::keep(found);
+			});
+
+	std::remove(archivepath.c_str());
+	RemoveLog(directory);
+	return (0);
+}
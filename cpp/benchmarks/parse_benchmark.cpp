@@ -0,0 +1,79 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <cstdlib>
+#include <string>
+
+// benchmark data
+#define SITESTRING "{\"Station\":\"BMN\",\"Channel\":\"HHZ\",\"Network\":\"LB\",\"Location\":\"01\"}"
+#define SOURCESTRING "{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}"
+#define FILTERSTRING "{\"HighPass\":1.05,\"LowPass\":2.65}"
+#define AMPLITUDESTRING "{\"Amplitude\":21.5,\"Period\":2.65,\"SNR\":3.8}"
+#define BEAMSTRING "{\"BackAzimuth\":2.65,\"Slowness\":1.44,\"PowerRatio\":12.18,\"BackAzimuthError\":3.8,\"SlownessError\":0.4,\"PowerRatioError\":0.557}"
+#define ASSOCIATEDSTRING "{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}"
+#define HYPOCENTERSTRING "{\"Latitude\":40.3344,\"Longitude\":-121.44,\"Depth\":32.44,\"Time\":\"2015-12-28T21:32:24.017Z\",\"LatitudeError\":12.5,\"LongitudeError\":22.64,\"DepthError\":2.44,\"TimeError\":1.984}"
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\",\"Polarity\":\"up\",\"Onset\":\"questionable\",\"Picker\":\"manual\",\"Filter\":[{\"HighPass\":1.05,\"LowPass\":2.65}],\"Amplitude\":{\"Amplitude\":21.5,\"Period\":2.65,\"SNR\":3.8},\"Beam\":{\"BackAzimuth\":2.65,\"Slowness\":1.44,\"PowerRatio\":12.18,\"BackAzimuthError\":3.8,\"SlownessError\":0.4,\"PowerRatioError\":0.557},\"AssociationInfo\":{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}}"
+#define CORRELATIONSTRING "{\"Type\":\"Correlation\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Phase\":\"P\",\"Time\":\"2015-12-28T21:32:24.017Z\",\"Correlation\":2.65,\"Hypocenter\":{\"Latitude\":40.3344,\"Longitude\":-121.44,\"Depth\":32.44,\"Time\":\"2015-12-28T21:30:44.039Z\"},\"EventType\":\"earthquake\",\"Magnitude\":2.14,\"SNR\":3.8,\"ZScore\":33.67,\"DetectionThreshold\":1.5,\"ThresholdType\":\"minimum\",\"AssociationInfo\":{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}}"
+#define DETECTIONSTRING "{\"Type\":\"Detection\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Hypocenter\":{\"Latitude\":40.3344,\"Longitude\":-121.44,\"Depth\":32.44,\"Time\":\"2015-12-28T21:32:24.017Z\",\"LatitudeError\":12.5,\"LongitudeError\":22.64,\"DepthError\":2.44,\"TimeError\":1.984},\"DetectionType\":\"New\",\"DetectionTime\":\"2015-12-28T21:32:28.017Z\",\"EventType\":\"earthquake\",\"Bayes\":2.65,\"MinimumDistance\":2.14,\"RMS\":3.8,\"Gap\":33.67,\"Data\":[" PICKSTRING "," CORRELATIONSTRING "]}"
+#define RETRACTSTRING "{\"Type\":\"Retract\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define STATIONINFOSTRING "{\"Type\":\"StationInfo\",\"Site\":{\"Station\":\"BOZ\",\"Channel\":\"BHZ\",\"Network\":\"US\",\"Location\":\"00\"},\"Latitude\":45.59697,\"Longitude\":-111.62967,\"Elevation\":1589.0,\"Quality\":1.0,\"Enable\":true,\"UseForTeleseismic\":true,\"InformationRequestor\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define STATIONINFOREQUESTSTRING "{\"Type\":\"StationInfoRequest\",\"Site\":{\"Station\":\"BOZ\",\"Channel\":\"BHZ\",\"Network\":\"US\",\"Location\":\"00\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+
+#define ITERATIONS 200000
+
+// times constructing an object from, and resetting an object from, an
+// already parsed json document, so that only the member dispatch is measured
+template<class T>
+void parsebenchmark(const std::string &name, const char *jsonstring,
+		size_t iterations) {
+	rapidjson::Document document;
+	detectionformats::FromJSONString(std::string(jsonstring), document);
+
+	detectionformats::benchmark::run(name + " construct", iterations,
+			[&document]() {
+				T object(document);
+				detectionformats::benchmark::keep(object);
+			});
+
+	T object;
+	detectionformats::benchmark::run(name + " resetfrom", iterations,
+			[&document, &object]() {
+				object.resetfrom(document);
+				detectionformats::benchmark::keep(object);
+			});
+}
+
+int main(int argc, char **argv) {
+	size_t iterations = ITERATIONS;
+	if (argc > 1) {
+		iterations = std::strtoul(argv[1], NULL, 10);
+	}
+
+	detectionformats::benchmark::header();
+
+	parsebenchmark<detectionformats::site>("site", SITESTRING, iterations);
+	parsebenchmark<detectionformats::source>("source", SOURCESTRING,
+			iterations);
+	parsebenchmark<detectionformats::filter>("filter", FILTERSTRING,
+			iterations);
+	parsebenchmark<detectionformats::amplitude>("amplitude", AMPLITUDESTRING,
+			iterations);
+	parsebenchmark<detectionformats::beam>("beam", BEAMSTRING, iterations);
+	parsebenchmark<detectionformats::associated>("associated",
+			ASSOCIATEDSTRING, iterations);
+	parsebenchmark<detectionformats::hypocenter>("hypocenter",
+			HYPOCENTERSTRING, iterations);
+	parsebenchmark<detectionformats::pick>("pick", PICKSTRING, iterations);
+	parsebenchmark<detectionformats::correlation>("correlation",
+			CORRELATIONSTRING, iterations);
+	parsebenchmark<detectionformats::detection>("detection", DETECTIONSTRING,
+			iterations);
+	parsebenchmark<detectionformats::retract>("retract", RETRACTSTRING,
+			iterations);
+	parsebenchmark<detectionformats::stationInfo>("stationInfo",
+			STATIONINFOSTRING, iterations);
+	parsebenchmark<detectionformats::stationInfoRequest>("stationInfoRequest",
+			STATIONINFOREQUESTSTRING, iterations);
+
+	return (0);
+}
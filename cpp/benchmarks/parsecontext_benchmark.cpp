@@ -0,0 +1,75 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <cstdlib>
+#include <string>
+
+// benchmark data
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\",\"Polarity\":\"up\",\"Onset\":\"questionable\",\"Picker\":\"manual\",\"Filter\":[{\"HighPass\":1.05,\"LowPass\":2.65}],\"Amplitude\":{\"Amplitude\":21.5,\"Period\":2.65,\"SNR\":3.8},\"Beam\":{\"BackAzimuth\":2.65,\"Slowness\":1.44,\"PowerRatio\":12.18,\"BackAzimuthError\":3.8,\"SlownessError\":0.4,\"PowerRatioError\":0.557},\"AssociationInfo\":{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}}"
+
+#define ITERATIONS 200000
+
+// times parsing and serializing a pick with a document made per call, as
+// the library used to, against a reused parsecontext
+int main(int argc, char **argv) {
+	size_t iterations = ITERATIONS;
+	if (argc > 1) {
+		iterations = std::strtoul(argv[1], NULL, 10);
+	}
+
+	std::string json = PICKSTRING;
+	rapidjson::Document pickdocument;
+	detectionformats::pick pickobject(
+			detectionformats::FromJSONString(json, pickdocument));
+
+	detectionformats::benchmark::header();
+
+	detectionformats::benchmark::run("parse document per call", iterations,
+			[&json]() {
+				rapidjson::Document document;
+				document.Parse(json.c_str(), json.length());
+				detectionformats::benchmark::keep(document);
+			});
+
+	detectionformats::parsecontext context;
+	detectionformats::benchmark::run("parse parsecontext", iterations,
+			[&json, &context]() {
+				detectionformats::parsecontext::document &document =
+						context.parse(json.c_str(), json.length());
+				detectionformats::benchmark::keep(document);
+			});
+
+	detectionformats::benchmark::run("parsemessage document per call",
+			iterations, [&json]() {
+				rapidjson::Document document;
+				detectionformats::parseresult result;
+				detectionformats::ParseMessage(json.c_str(), json.length(),
+						document, result);
+				detectionformats::benchmark::keep(result);
+			});
+
+	detectionformats::benchmark::run("parsemessage parsecontext", iterations,
+			[&json, &context]() {
+				detectionformats::parseresult result;
+				detectionformats::ParseMessage(json.c_str(), json.length(),
+						context, result);
+				detectionformats::benchmark::keep(result);
+			});
+
+	detectionformats::benchmark::run("serialize document per call",
+			iterations, [&pickobject]() {
+				rapidjson::Document document;
+				std::string output = detectionformats::ToJSONString(
+						pickobject.tojson(document, document.GetAllocator()));
+				detectionformats::benchmark::keep(output);
+			});
+
+	std::string output;
+	detectionformats::benchmark::run("serialize parsecontext", iterations,
+			[&pickobject, &context, &output]() {
+				context.serialize(pickobject, output);
+				detectionformats::benchmark::keep(output);
+			});
+
+	return (0);
+}
@@ -0,0 +1,86 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define PICKCOUNT 200000
+#define SITECOUNT 2000
+#define RELAYS 3
+#define RATE 200.0
+#define ITERATIONS 10
+
+// times deduplicating a feed in which each pick arrives from several
+// relays, with a pickdedup against a std::unordered_map of ids to picks
+int main(int argc, char **argv) {
+	size_t iterations = ITERATIONS;
+	if (argc > 1) {
+		iterations = std::strtoul(argv[1], NULL, 10);
+	}
+
+	std::mt19937 generator(42);
+	std::uniform_int_distribution<int> station(0, SITECOUNT - 1);
+	std::uniform_int_distribution<int> relay(0, 20);
+
+	// each pick followed by its relayed copies a few picks later
+	std::vector<detectionformats::pick> picks;
+	for (size_t i = 0; i < PICKCOUNT / RELAYS; i++) {
+		detectionformats::pick newpick;
+		newpick.id = "pick" + std::to_string(i);
+		newpick.site = detectionformats::site(
+				"STA" + std::to_string(station(generator)), "BHZ", "US", "00");
+		newpick.time = i / RATE;
+		newpick.source = detectionformats::source("US", "TestAuthor");
+		newpick.phase = "P";
+		picks.push_back(newpick);
+	}
+	std::vector<const detectionformats::pick *> feed;
+	for (size_t i = 0; i < picks.size(); i++) {
+		for (size_t r = 0; r < RELAYS; r++) {
+			size_t position = feed.size() + relay(generator);
+			feed.push_back(&picks[i]);
+			if (position < feed.size()) {
+				std::swap(feed.back(), feed[position]);
+			}
+		}
+	}
+
+	detectionformats::benchmark::header();
+
+	detectionformats::benchmark::run(
+			"unordered_map " + std::to_string(feed.size()) + " picks",
+			iterations, [&feed]() {
+				std::unordered_map<std::string, detectionformats::pick> seen;
+				size_t unique = 0;
+				for (size_t i = 0; i < feed.size(); i++) {
+					const detectionformats::pick &newpick = *feed[i];
+					std::unordered_map<std::string, detectionformats::pick>
+							::iterator found = seen.find(newpick.id);
+					if (found == seen.end()) {
+						seen.insert(std::make_pair(newpick.id, newpick));
+						unique++;
+					} else if (found->second != newpick) {
+						found->second = newpick;
+					}
+				}
+				detectionformats::benchmark::keep(unique);
+			});
+
+	detectionformats::benchmark::run(
+			"pickdedup " + std::to_string(feed.size()) + " picks", iterations,
+			[&feed]() {
+				detectionformats::pickdedup dedup;
+				size_t unique = 0;
+				for (size_t i = 0; i < feed.size(); i++) {
+					if (dedup.check(*feed[i]) == detectionformats::uniquepick) {
+						unique++;
+					}
+				}
+				detectionformats::benchmark::keep(unique);
+			});
+
+	return (0);
+}
@@ -0,0 +1,100 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#define PICKCOUNT 200000
+#define SITECOUNT 500
+#define RATE 100.0
+#define DURATION 300.0
+#define QUERYEVERY 10
+#define QUERYSPAN 120.0
+#define ITERATIONS 5
+
+// times a stream of slightly out of order picks through a five minute
+// window, querying it as an associator would, with a pickwindow against
+// the std::multimap it replaces
+int main(int argc, char **argv) {
+	size_t iterations = ITERATIONS;
+	if (argc > 1) {
+		iterations = std::strtoul(argv[1], NULL, 10);
+	}
+
+	std::mt19937 generator(42);
+	std::normal_distribution<double> jitter(0.0, 0.5);
+	std::uniform_int_distribution<int> station(0, SITECOUNT - 1);
+
+	std::vector<detectionformats::pick> stream;
+	for (size_t i = 0; i < PICKCOUNT; i++) {
+		detectionformats::pick newpick;
+		newpick.id = "pick" + std::to_string(i);
+		newpick.site = detectionformats::site(
+				"STA" + std::to_string(station(generator)), "BHZ", "US", "00");
+		newpick.time = i / RATE + jitter(generator);
+		newpick.source = detectionformats::source("US", "TestAuthor");
+		newpick.phase = "P";
+		stream.push_back(newpick);
+	}
+
+	detectionformats::benchmark::header();
+
+	detectionformats::benchmark::run(
+			"multimap " + std::to_string(stream.size()) + " picks", iterations,
+			[&stream]() {
+				std::multimap<double, detectionformats::pick> window;
+				std::vector<const detectionformats::pick *> found;
+				double newest = -1e300;
+				size_t total = 0;
+				for (size_t i = 0; i < stream.size(); i++) {
+					const detectionformats::pick &newpick = stream[i];
+					if (newpick.time < newest - DURATION) {
+						continue;
+					}
+					window.insert(std::make_pair(newpick.time, newpick));
+					if (newpick.time > newest) {
+						newest = newpick.time;
+						window.erase(window.begin(),
+								window.lower_bound(newest - DURATION));
+					}
+					if ((i % QUERYEVERY) == 0) {
+						found.clear();
+						std::multimap<double, detectionformats::pick>::iterator
+								it = window.lower_bound(newest - QUERYSPAN);
+						for (; it != window.end(); ++it) {
+							if (it->second.site == newpick.site) {
+								found.push_back(&it->second);
+							}
+						}
+						total += found.size();
+					}
+				}
+				detectionformats::benchmark::keep(total);
+			});
+
+	detectionformats::benchmark::run(
+			"pickwindow " + std::to_string(stream.size()) + " picks",
+			iterations, [&stream]() {
+				detectionformats::pickwindow window(DURATION);
+				std::vector<const detectionformats::pick *> found;
+				size_t total = 0;
+				for (size_t i = 0; i < stream.size(); i++) {
+					const detectionformats::pick &newpick = stream[i];
+					if (window.add(newpick) == false) {
+						continue;
+					}
+					if ((i % QUERYEVERY) == 0) {
+						found.clear();
+						double newest = window.getnewest();
+						total += window.query(newest - QUERYSPAN, newest,
+								newpick.site, found);
+					}
+				}
+				detectionformats::benchmark::keep(total);
+			});
+
+	return (0);
+}
@@ -0,0 +1,98 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+// benchmark data
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\",\"Polarity\":\"up\",\"Onset\":\"questionable\",\"Picker\":\"manual\",\"Filter\":[{\"HighPass\":1.05,\"LowPass\":2.65}],\"Amplitude\":{\"Amplitude\":21.5,\"Period\":2.65,\"SNR\":3.8},\"Beam\":{\"BackAzimuth\":2.65,\"Slowness\":1.44,\"PowerRatio\":12.18,\"BackAzimuthError\":3.8,\"SlownessError\":0.4,\"PowerRatioError\":0.557},\"AssociationInfo\":{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}}"
+#define RETRACTSTRING "{\"Type\":\"Retract\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define STATIONINFOSTRING "{\"Type\":\"StationInfo\",\"Site\":{\"Station\":\"BOZ\",\"Channel\":\"BHZ\",\"Network\":\"US\",\"Location\":\"00\"},\"Latitude\":45.59697,\"Longitude\":-111.62967,\"Elevation\":1589.0,\"Quality\":1.0,\"Enable\":true,\"UseForTeleseismic\":true,\"InformationRequestor\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+
+#define MESSAGECOUNT 20000
+#define QUEUECAPACITY 1024
+
+// prints a stage's metrics
+void printstage(const char *name,
+		const detectionformats::stagemetrics &metrics) {
+	std::printf("  %-12s processed %10llu  max depth %6zu\n", name,
+			static_cast<unsigned long long>(metrics.processed),
+			metrics.maxdepth);
+}
+
+// pushes messages through a pipeline from one reader thread while the main
+// thread pops, and reports the throughput, the push to pop latency, and
+// each stage's metrics
+int main(int argc, char **argv) {
+	size_t messagecount = MESSAGECOUNT;
+	size_t parsethreads = 1;
+	size_t validatethreads = 1;
+	if (argc > 1) {
+		messagecount = std::strtoul(argv[1], NULL, 10);
+	}
+	if (argc > 2) {
+		parsethreads = std::strtoul(argv[2], NULL, 10);
+	}
+	if (argc > 3) {
+		validatethreads = std::strtoul(argv[3], NULL, 10);
+	}
+
+	const char *mix[] = { PICKSTRING, PICKSTRING, PICKSTRING, RETRACTSTRING,
+	STATIONINFOSTRING };
+	std::vector<std::string> messages;
+	for (size_t i = 0; i < messagecount; i++) {
+		messages.push_back(mix[i % (sizeof(mix) / sizeof(mix[0]))]);
+	}
+
+	detectionformats::pipeline messagepipeline(QUEUECAPACITY, parsethreads,
+			validatethreads);
+	std::vector<double> latencies;
+	latencies.reserve(messagecount);
+
+	std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+
+	std::thread reader([&messages, &messagepipeline]() {
+		for (size_t i = 0; i < messages.size(); i++) {
+			messagepipeline.push(messages[i]);
+		}
+		messagepipeline.close();
+	});
+
+	detectionformats::pipeline::handle message;
+	while (messagepipeline.pop(message) == true) {
+		latencies.push_back(
+				std::chrono::duration<double, std::micro>(
+						std::chrono::steady_clock::now() - message->received)
+						.count());
+		detectionformats::benchmark::keep(message);
+	}
+	reader.join();
+
+	double seconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start).count();
+
+	std::sort(latencies.begin(), latencies.end());
+	std::printf("pipeline %zu messages, %zu parse threads, %zu validate "
+			"threads\n", messagecount, parsethreads, validatethreads);
+	std::printf("  throughput   %.0f messages/s\n",
+			static_cast<double>(latencies.size()) / seconds);
+	if (latencies.empty() == false) {
+		std::printf("  latency us   p50 %.1f  p99 %.1f  max %.1f\n",
+				latencies[latencies.size() / 2],
+				latencies[(latencies.size() * 99) / 100], latencies.back());
+	}
+
+	detectionformats::pipelinemetrics metrics = messagepipeline.getmetrics();
+	printstage("parse", metrics.parse);
+	printstage("validate", metrics.validate);
+	printstage("serialize", metrics.serialize);
+	printstage("output", metrics.output);
+
+	return (0);
+}
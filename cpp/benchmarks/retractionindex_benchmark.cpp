@@ -0,0 +1,79 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#define RETRACTIONS 100000
+#define LOOKUPS 1000000
+#define THREADS 4
+#define ITERATIONS 10
+
+// times lookups of ids that were not retracted, the common case, on
+// several threads at once, with a retractionindex against a mutex guarded
+// std::unordered_set
+int main(int argc, char **argv) {
+	size_t iterations = ITERATIONS;
+	if (argc > 1) {
+		iterations = std::strtoul(argv[1], NULL, 10);
+	}
+
+	detectionformats::retractionindex index(RETRACTIONS);
+	std::unordered_set<std::string> retracted;
+	std::mutex mutex;
+	for (size_t i = 0; i < RETRACTIONS; i++) {
+		std::string id = "retracted" + std::to_string(i);
+		index.add(detectionformats::retract(id, "US", "TestAuthor"));
+		retracted.insert(id);
+	}
+
+	std::vector<std::string> ids;
+	for (size_t i = 0; i < LOOKUPS / THREADS; i++) {
+		ids.push_back("detection" + std::to_string(i));
+	}
+
+	detectionformats::benchmark::header();
+
+	detectionformats::benchmark::run(
+			"unordered_set " + std::to_string(LOOKUPS) + " lookups",
+			iterations, [&retracted, &mutex, &ids]() {
+				std::vector<std::thread> threads;
+				for (size_t t = 0; t < THREADS; t++) {
+					threads.push_back(std::thread([&retracted, &mutex, &ids]() {
+						size_t found = 0;
+						for (size_t i = 0; i < ids.size(); i++) {
+							std::lock_guard<std::mutex> guard(mutex);
+							found += retracted.count(ids[i]);
+						}
+						detectionformats::benchmark::keep(found);
+					}));
+				}
+				for (size_t t = 0; t < threads.size(); t++) {
+					threads[t].join();
+				}
+			});
+
+	detectionformats::benchmark::run(
+			"retractionindex " + std::to_string(LOOKUPS) + " lookups",
+			iterations, [&index, &ids]() {
+				std::vector<std::thread> threads;
+				for (size_t t = 0; t < THREADS; t++) {
+					threads.push_back(std::thread([&index, &ids]() {
+						size_t found = 0;
+						for (size_t i = 0; i < ids.size(); i++) {
+							found += index.isretracted(ids[i]);
+						}
+						detectionformats::benchmark::keep(found);
+					}));
+				}
+				for (size_t t = 0; t < threads.size(); t++) {
+					threads[t].join();
+				}
+			});
+
+	return (0);
+}
@@ -0,0 +1,70 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+// benchmark data
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\",\"Polarity\":\"up\",\"Onset\":\"questionable\",\"Picker\":\"manual\",\"Filter\":[{\"HighPass\":1.05,\"LowPass\":2.65}],\"Amplitude\":{\"Amplitude\":21.5,\"Period\":2.65,\"SNR\":3.8},\"Beam\":{\"BackAzimuth\":2.65,\"Slowness\":1.44,\"PowerRatio\":12.18,\"BackAzimuthError\":3.8,\"SlownessError\":0.4,\"PowerRatioError\":0.557},\"AssociationInfo\":{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}}"
+
+#define MESSAGECOUNT 200000
+#define RINGSIZE (1024 * 1024)
+
+// pushes messagecount picks through a ring from a producer thread, as json
+// or binary, and reports the messages per second popped by the reader
+void ringbenchmark(const std::string &name, bool binary,
+		size_t messagecount) {
+	std::string ringname = "/detectionformats-benchmark-"
+			+ std::to_string(getpid());
+	detectionformats::shmring reader(ringname, RINGSIZE);
+
+	std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+
+	std::thread producer([ringname, binary, messagecount]() {
+		detectionformats::shmring writer(ringname);
+		rapidjson::Document document;
+		detectionformats::pick pickobject(
+				detectionformats::FromJSONString(std::string(PICKSTRING),
+						document));
+		size_t length = std::strlen(PICKSTRING);
+		for (size_t i = 0; i < messagecount; i++) {
+			if (binary == true) {
+				writer.push(pickobject);
+			} else {
+				writer.pushjson(PICKSTRING, length);
+			}
+		}
+	});
+
+	detectionformats::parseresult result;
+	for (size_t i = 0; i < messagecount; i++) {
+		reader.pop(result);
+		detectionformats::benchmark::keep(result);
+	}
+	producer.join();
+
+	double seconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start).count();
+	std::printf("%-8s %10.0f messages/s\n", name.c_str(),
+			static_cast<double>(messagecount) / seconds);
+}
+
+int main(int argc, char **argv) {
+	size_t messagecount = MESSAGECOUNT;
+	if (argc > 1) {
+		messagecount = std::strtoul(argv[1], NULL, 10);
+	}
+
+	std::printf("shmring %zu picks, one producer\n", messagecount);
+	ringbenchmark("json", false, messagecount);
+	ringbenchmark("binary", true, messagecount);
+
+	return (0);
+}
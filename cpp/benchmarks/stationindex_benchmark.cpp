@@ -0,0 +1,114 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#define STATIONCOUNT 20000
+#define QUERYCOUNT 1000000
+#define BRUTEFORCEQUERIES 200
+#define NEARESTCOUNT 10
+#define RADIUS 5.0
+
+// times nearest station and radius queries against a stationindex of
+// stations spread over the globe, and a brute force scan for comparison
+int main(int argc, char **argv) {
+	size_t querycount = QUERYCOUNT;
+	size_t stationcount = STATIONCOUNT;
+	if (argc > 1) {
+		querycount = std::strtoul(argv[1], NULL, 10);
+	}
+	if (argc > 2) {
+		stationcount = std::strtoul(argv[2], NULL, 10);
+	}
+
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	double degrees = 180.0 / 3.14159265358979323846;
+
+	detectionformats::stationinventory inventory(stationcount);
+	for (size_t i = 0; i < stationcount; i++) {
+		inventory.add(
+				detectionformats::stationInfo("S" + std::to_string(i), "BHZ",
+						"US", "00", std::asin(2 * unit(generator) - 1) * degrees,
+						360.0 * unit(generator) - 180.0, 0.0, 1.0, true,
+						(i % 4) == 0, "US", "TestAuthor"));
+	}
+
+	std::vector<double> latitudes(4096);
+	std::vector<double> longitudes(4096);
+	for (size_t i = 0; i < latitudes.size(); i++) {
+		latitudes[i] = std::asin(2 * unit(generator) - 1) * degrees;
+		longitudes[i] = 360.0 * unit(generator) - 180.0;
+	}
+
+	detectionformats::benchmark::header();
+
+	detectionformats::benchmark::run(
+			"build " + std::to_string(stationcount) + " stations", 20,
+			[&inventory]() {
+				detectionformats::stationindex index(inventory);
+				detectionformats::benchmark::keep(index);
+			});
+
+	detectionformats::stationindex index(inventory);
+	size_t next = 0;
+	detectionformats::benchmark::run("nearest 10", querycount,
+			[&index, &latitudes, &longitudes, &next]() {
+				size_t i = next++ & 4095;
+				std::vector<detectionformats::stationdistance> found =
+						index.nearest(latitudes[i], longitudes[i],
+						NEARESTCOUNT);
+				detectionformats::benchmark::keep(found);
+			});
+
+	detectionformats::benchmark::run("nearest 10 teleseismic", querycount,
+			[&index, &latitudes, &longitudes, &next]() {
+				size_t i = next++ & 4095;
+				std::vector<detectionformats::stationdistance> found =
+						index.nearest(latitudes[i], longitudes[i],
+						NEARESTCOUNT, true);
+				detectionformats::benchmark::keep(found);
+			});
+
+	detectionformats::benchmark::run("within 5 degrees", querycount,
+			[&index, &latitudes, &longitudes, &next]() {
+				size_t i = next++ & 4095;
+				std::vector<detectionformats::stationdistance> found =
+						index.within(latitudes[i], longitudes[i], RADIUS);
+				detectionformats::benchmark::keep(found);
+			});
+
+	// every station's haversine distance, then the nearest
+	const double *stationlatitudes = inventory.getlatitudes();
+	const double *stationlongitudes = inventory.getlongitudes();
+	std::vector<std::pair<double, uint32_t>> distances(stationcount);
+	detectionformats::benchmark::run("nearest 10 brute force",
+			BRUTEFORCEQUERIES,
+			[&]() {
+				size_t q = next++ & 4095;
+				double radians = 1.0 / degrees;
+				for (uint32_t i = 0; i < stationcount; i++) {
+					double dlatitude = (stationlatitudes[i] - latitudes[q])
+							* radians;
+					double dlongitude = (stationlongitudes[i] - longitudes[q])
+							* radians;
+					double a = std::sin(dlatitude / 2) * std::sin(dlatitude / 2)
+							+ std::cos(latitudes[q] * radians)
+									* std::cos(stationlatitudes[i] * radians)
+									* std::sin(dlongitude / 2)
+									* std::sin(dlongitude / 2);
+					distances[i] = std::make_pair(
+							2 * std::asin(std::min(1.0, std::sqrt(a))), i);
+				}
+				std::partial_sort(distances.begin(),
+						distances.begin() + NEARESTCOUNT, distances.end());
+				detectionformats::benchmark::keep(distances);
+			});
+
+	return (0);
+}
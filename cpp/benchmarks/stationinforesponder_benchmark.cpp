@@ -0,0 +1,77 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#define STATIONCOUNT 2000
+#define SOURCECOUNT 5
+#define REPEATS 2
+#define ITERATIONS 20
+
+// times answering a burst of stationInfoRequests, each site asked for by
+// several sources, some more than once, one at a time against coalesced
+int main(int argc, char **argv) {
+	size_t iterations = ITERATIONS;
+	if (argc > 1) {
+		iterations = std::strtoul(argv[1], NULL, 10);
+	}
+
+	detectionformats::stationinventory inventory;
+	for (size_t i = 0; i < STATIONCOUNT; i++) {
+		inventory.add(
+				detectionformats::stationInfo("S" + std::to_string(i), "BHZ",
+						"US", "00", 45.0, -111.0, 1589.0, 1.0, true, false,
+						"US", "TestAuthor"));
+	}
+
+	std::vector<detectionformats::stationInfoRequest> burst;
+	for (size_t r = 0; r < REPEATS; r++) {
+		for (size_t s = 0; s < SOURCECOUNT; s++) {
+			for (size_t i = 0; i < STATIONCOUNT; i++) {
+				burst.push_back(
+						detectionformats::stationInfoRequest(
+								"S" + std::to_string(i), "BHZ", "US", "00",
+								"A" + std::to_string(s), "TestAuthor"));
+			}
+		}
+	}
+
+	detectionformats::benchmark::header();
+
+	detectionformats::benchmark::run(
+			"one at a time " + std::to_string(burst.size()) + " requests",
+			iterations, [&inventory, &burst]() {
+				std::vector<std::string> responses;
+				for (size_t i = 0; i < burst.size(); i++) {
+					uint32_t id = inventory.find(burst[i].site);
+					if (id == detectionformats::stationinventory::npos) {
+						continue;
+					}
+					detectionformats::stationInfo station = inventory.getstation(
+							id);
+					station.informationRequestor = burst[i].source;
+					rapidjson::Document document;
+					responses.push_back(
+							detectionformats::ToJSONString(
+									station.tojson(document,
+											document.GetAllocator())));
+				}
+				detectionformats::benchmark::keep(responses);
+			});
+
+	detectionformats::benchmark::run(
+			"coalesced " + std::to_string(burst.size()) + " requests",
+			iterations, [&inventory, &burst]() {
+				detectionformats::stationinforesponder responder(inventory);
+				for (size_t i = 0; i < burst.size(); i++) {
+					responder.add(burst[i]);
+				}
+				std::vector<std::string> responses;
+				responder.flush(responses);
+				detectionformats::benchmark::keep(responses);
+			});
+
+	return (0);
+}
@@ -0,0 +1,97 @@
+#include "detection-formats.h"
+#include "benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#define STATIONCOUNT 20000
+#define ITERATIONS 1000000
+#define LOADITERATIONS 20
+
+// times finding station coordinates for picks in a stationinventory
+// against a std::map keyed by a concatenated site string, and rebuilding
+// the inventory at start up from json against loading a snapshot
+int main(int argc, char **argv) {
+	size_t iterations = ITERATIONS;
+	size_t stationcount = STATIONCOUNT;
+	if (argc > 1) {
+		iterations = std::strtoul(argv[1], NULL, 10);
+	}
+	if (argc > 2) {
+		stationcount = std::strtoul(argv[2], NULL, 10);
+	}
+
+	std::vector<detectionformats::site> sites;
+	detectionformats::stationinventory inventory(stationcount);
+	std::map<std::string, detectionformats::stationInfo> stationmap;
+	std::string json;
+	for (size_t i = 0; i < stationcount; i++) {
+		detectionformats::stationInfo station("S" + std::to_string(i), "BHZ",
+				"N" + std::to_string(i % 50), "00", i * 0.001, i * 0.002, 100.0,
+				1.0, true, false, "US", "TestAuthor");
+		sites.push_back(station.site);
+		rapidjson::Document document;
+		json += detectionformats::ToJSONString(
+				station.tojson(document, document.GetAllocator())) + "\n";
+		inventory.add(station);
+		stationmap[station.site.station + "." + station.site.channel + "."
+				+ station.site.network + "." + station.site.location] =
+				station;
+	}
+
+	// look up in a scattered order, as picks arrive
+	std::vector<size_t> order;
+	for (size_t i = 0; i < 4096; i++) {
+		order.push_back((i * 7919) % stationcount);
+	}
+
+	detectionformats::benchmark::header();
+
+	size_t next = 0;
+	detectionformats::benchmark::run("std::map site lookup", iterations,
+			[&sites, &stationmap, &order, &next]() {
+				const detectionformats::site &pick = sites[order[next++ & 4095]];
+				double latitude = stationmap[pick.station + "." + pick.channel
+						+ "." + pick.network + "." + pick.location].latitude;
+				detectionformats::benchmark::keep(latitude);
+			});
+
+	const double *latitudes = inventory.getlatitudes();
+	detectionformats::benchmark::run("stationinventory site lookup",
+			iterations, [&sites, &inventory, &latitudes, &order, &next]() {
+				const detectionformats::site &pick = sites[order[next++ & 4095]];
+				double latitude = latitudes[inventory.find(pick)];
+				detectionformats::benchmark::keep(latitude);
+			});
+
+	std::string jsonpath = "/tmp/detectionformats-stationinventory.json";
+	std::string snapshotpath =
+			"/tmp/detectionformats-stationinventory.snapshot";
+	FILE *file = std::fopen(jsonpath.c_str(), "wb");
+	std::fwrite(json.data(), 1, json.length(), file);
+	std::fclose(file);
+	inventory.save(snapshotpath);
+
+	detectionformats::benchmark::run(
+			"load " + std::to_string(stationcount) + " stations json",
+			LOADITERATIONS, [&jsonpath]() {
+				detectionformats::stationinventory loaded;
+				loaded.loadjson(jsonpath);
+				detectionformats::benchmark::keep(loaded);
+			});
+
+	detectionformats::benchmark::run(
+			"load " + std::to_string(stationcount) + " stations snapshot",
+			LOADITERATIONS, [&snapshotpath]() {
+				detectionformats::stationinventory loaded;
+				loaded.loadsnapshot(snapshotpath);
+				detectionformats::benchmark::keep(loaded);
+			});
+
+	std::remove(jsonpath.c_str());
+	std::remove(snapshotpath.c_str());
+	return (0);
+}
@@ -0,0 +1,121 @@
+// ingest_server
+//
+// An example ingest server.  Accepts newline delimited json detection format
+// messages on a Unix domain socket and/or localhost TCP port, and prints a
+// line for each message received.  Stop with ctrl-c.
+//
+// usage: ingest_server [-u socketpath] [-p port] [-q]
+//   -u socketpath  listen on a Unix domain socket
+//   -p port        listen on localhost TCP
+//   -q             quiet, only print statistics on exit
+
+#include "detection-formats.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+// the running server, for the signal handler
+static detectionformats::ingestserver *runningserver = NULL;
+
+static void handlesignal(int) {
+	if (runningserver != NULL) {
+		runningserver->stop();
+	}
+}
+
+static const char *formatname(int type) {
+	switch (type) {
+		case detectionformats::formattypes::picktype:
+			return ("Pick");
+		case detectionformats::formattypes::correlationtype:
+			return ("Correlation");
+		case detectionformats::formattypes::detectiontype:
+			return ("Detection");
+		case detectionformats::formattypes::retracttype:
+			return ("Retract");
+		case detectionformats::formattypes::stationinfotype:
+			return ("StationInfo");
+		case detectionformats::formattypes::stationinforequesttype:
+			return ("StationInfoRequest");
+		default:
+			return ("Unknown");
+	}
+}
+
+int main(int argc, char **argv) {
+	std::string socketpath;
+	int port = -1;
+	bool quiet = false;
+
+	for (int i = 1; i < argc; i++) {
+		if ((std::strcmp(argv[i], "-u") == 0) && (i + 1 < argc)) {
+			socketpath = argv[++i];
+		} else if ((std::strcmp(argv[i], "-p") == 0) && (i + 1 < argc)) {
+			port = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "-q") == 0) {
+			quiet = true;
+		} else {
+			std::fprintf(stderr,
+					"usage: %s [-u socketpath] [-p port] [-q]\n", argv[0]);
+			return (1);
+		}
+	}
+	if ((socketpath.empty() == true) && (port < 0)) {
+		std::fprintf(stderr, "%s: specify -u and/or -p\n", argv[0]);
+		return (1);
+	}
+
+	std::mutex printmutex;
+	detectionformats::ingestserver server(
+			[quiet, &printmutex](detectionformats::parseresult &result,
+					bool valid) {
+				if (quiet == true) {
+					return;
+				}
+
+				std::lock_guard<std::mutex> lock(printmutex);
+				if (result.isparsed() == false) {
+					std::printf("error: %s\n", result.error.c_str());
+				} else {
+					std::printf("%s %s\n", formatname(result.type),
+							valid ? "valid" : "invalid");
+				}
+			});
+
+	try {
+		if (socketpath.empty() == false) {
+			server.listenunix(socketpath);
+			std::printf("listening on %s\n", socketpath.c_str());
+		}
+		if (port >= 0) {
+			std::printf("listening on 127.0.0.1:%u\n",
+					server.listentcp(static_cast<uint16_t>(port)));
+		}
+	} catch (const std::exception &e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		return (1);
+	}
+	std::fflush(stdout);
+
+	runningserver = &server;
+	std::signal(SIGINT, handlesignal);
+	std::signal(SIGTERM, handlesignal);
+
+	server.run();
+
+	detectionformats::ingeststatistics statistics = server.getstatistics();
+	std::printf("connections %llu bytes %llu messages %llu errors %llu "
+			"pauses %llu\n",
+			static_cast<unsigned long long>(statistics.connections),
+			static_cast<unsigned long long>(statistics.bytes),
+			static_cast<unsigned long long>(statistics.messages),
+			static_cast<unsigned long long>(statistics.errors),
+			static_cast<unsigned long long>(statistics.pauses));
+
+	runningserver = NULL;
+	return (0);
+}
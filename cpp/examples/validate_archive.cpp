@@ -0,0 +1,85 @@
+// validate_archive
+//
+// Validates newline delimited json detection format archives.  Each archive
+// is mapped into memory, split into ranges of whole lines, and the ranges
+// are parsed and validated in parallel.  Prints a summary line for each
+// archive and the byte offsets of the first failing lines.  Exits with 1 if
+// any line failed to parse or validate.
+//
+// usage: validate_archive [-t threads] [-q] archive...
+//   -t threads  the number of threads, defaults to one per core
+//   -q          quiet, do not print the failing offsets
+
+#include "detection-formats.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	size_t threads = 0;
+	bool quiet = false;
+	std::vector<std::string> paths;
+
+	for (int i = 1; i < argc; i++) {
+		if ((std::strcmp(argv[i], "-t") == 0) && (i + 1 < argc)) {
+			threads = std::strtoul(argv[++i], NULL, 10);
+		} else if (std::strcmp(argv[i], "-q") == 0) {
+			quiet = true;
+		} else if (argv[i][0] == '-') {
+			std::fprintf(stderr, "usage: %s [-t threads] [-q] archive...\n",
+					argv[0]);
+			return (1);
+		} else {
+			paths.push_back(argv[i]);
+		}
+	}
+	if (paths.empty() == true) {
+		std::fprintf(stderr, "usage: %s [-t threads] [-q] archive...\n",
+				argv[0]);
+		return (1);
+	}
+
+	detectionformats::threadpool pool(threads);
+	bool failed = false;
+
+	for (size_t i = 0; i < paths.size(); i++) {
+		try {
+			std::chrono::steady_clock::time_point start =
+					std::chrono::steady_clock::now();
+
+			detectionformats::mappedarchive archive(paths[i]);
+			detectionformats::archivesummary summary = archive.validate(pool);
+
+			double seconds = std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - start).count();
+
+			std::printf("%s: lines %llu errors %llu invalid %llu "
+					"(%.1f MB/s)\n", paths[i].c_str(),
+					static_cast<unsigned long long>(summary.lines),
+					static_cast<unsigned long long>(summary.errors),
+					static_cast<unsigned long long>(summary.invalid),
+					static_cast<double>(archive.size()) / seconds / 1e6);
+
+			if ((quiet == false) && (summary.failures.empty() == false)) {
+				for (size_t j = 0; j < summary.failures.size(); j++) {
+					std::printf("  failed at offset %llu\n",
+							static_cast<unsigned long long>(
+									summary.failures[j]));
+				}
+			}
+
+			if ((summary.errors > 0) || (summary.invalid > 0)) {
+				failed = true;
+			}
+		} catch (const std::exception &e) {
+			std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+			failed = true;
+		}
+	}
+
+	return (failed ? 1 : 0);
+}
@@ -69,6 +69,22 @@ namespace detectionformats
 		*/
 		~amplitude();
 
+		/**
+		* \brief amplitude reset function
+		*
+		* Overwrites the members of this amplitude in place from the provided
+		* json::Object.
+		* \param json - A json object.
+		*/
+		void resetfrom(rapidjson::Value &json);
+
+		/**
+		* \brief amplitude clear function
+		*
+		* Resets the members of this amplitude to null values.
+		*/
+		void clear();
+
 		/**
 		* \brief Convert to json object function
 		*
@@ -76,7 +92,47 @@ namespace detectionformats
 		* \param jsondocument - a reference to the json document to fill in with the class contents.
 		* \return Returns rapidjson::Value & if successful
 		*/
-		virtual rapidjson::Value & tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) override;
+		virtual rapidjson::Value & tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const override;
+
+		/**
+		* \brief Convert to binary function
+		*
+		* Appends the compact binary encoding of the class to buffer.  The encoding
+		* holds the fields in a fixed order without keys, and is only intended for
+		* exchange between programs built with the same version of this library.
+		* \param buffer - The std::string to append to
+		*/
+		void tobinary(std::string &buffer) const;
+
+		/**
+		* \brief Convert from binary function
+		*
+		* Overwrites the members of this amplitude from its binary
+		* encoding.  Throws std::invalid_argument if the buffer is truncated or
+		* corrupt.
+		* \param buffer - A pointer to the encoded buffer
+		* \param length - The number of characters in buffer
+		* \return Returns the number of characters consumed
+		*/
+		size_t frombinary(const char *buffer, size_t length);
+
+		/**
+		* \brief Equality operator
+		*
+		* Compares every member of this amplitude to the provided one,
+		* missing values compare equal
+		* \param other - The amplitude to compare to
+		* \return Returns true if all the members are equal
+		*/
+		bool operator==(const amplitude &other) const;
+
+		/**
+		* \brief Inequality operator
+		*
+		* \param other - The amplitude to compare to
+		* \return Returns true if any member differs
+		*/
+		bool operator!=(const amplitude &other) const;
 
 		/**
 		* \brief Gets any errors in the class
@@ -84,7 +140,7 @@ namespace detectionformats
 		* Gets any formatting errors in the class
 		* \return Returns a std::vector<std::string> containing the errors
 		*/
-		virtual std::vector<std::string> geterrors() override;
+		virtual std::vector<std::string> geterrors() const override;
 
 		/**
 		* \brief Empty check
@@ -92,7 +148,7 @@ namespace detectionformats
 		* Checks to see if this object is empty
 		* \return Returns true if empty, false otherwise.
 		*/
-		bool isempty();
+		bool isempty() const;
 
 		/**
 		* \brief amplitude ampvalue
@@ -0,0 +1,188 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_ARCHIVEREADER_H
+#define DETECTION_ARCHIVEREADER_H
+
+#if !defined(_WIN32)
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats archive reader class
+ *
+ * The detectionformats archivereader class reads a newline delimited json
+ * archive file in large blocks, keeping several block reads in flight
+ * while the caller works on the blocks already read, so that parsing is
+ * not stalled waiting on one synchronous read at a time.
+ *
+ * On Linux the reads are queued with io_uring.  Where io_uring is not
+ * available, at build time or because the kernel or a seccomp policy
+ * refuses it, the reader falls back to plain pread with kernel read ahead
+ * requested through posix_fadvise.
+ *
+ * next() hands out regions of the file that hold only complete lines,
+ * directly from the read buffers where possible; a line that spans two
+ * blocks is assembled in a separate buffer.  A region is valid until the
+ * following call to next().
+ *
+ * archivereader is not thread safe.
+ */
+class archivereader {
+public:
+	/**
+	 * \brief archivereader constructor
+	 *
+	 * Opens the archive and queues the first reads.  Throws
+	 * std::runtime_error if the file cannot be opened.
+	 * \param path - The archive file path
+	 * \param blocksize - The size of each read
+	 * \param depth - The number of reads to keep in flight, at least 1
+	 * \param useuring - Set to false to use pread even if io_uring is
+	 * available
+	 */
+	explicit archivereader(const std::string &path,
+			size_t blocksize = 1024 * 1024, size_t depth = 4,
+			bool useuring = true);
+
+	/**
+	 * \brief archivereader destructor
+	 *
+	 * Waits for any reads in flight and closes the archive.
+	 */
+	~archivereader();
+
+	/**
+	 * \brief Get the next lines
+	 *
+	 * Gets the next region of the archive holding one or more complete
+	 * lines, including their newlines except possibly the last line of the
+	 * file.  Throws std::runtime_error if a read fails.
+	 * \param data - Set to the start of the region
+	 * \param length - Set to the number of characters in the region
+	 * \return Returns false at the end of the archive
+	 */
+	bool next(const char *&data, size_t &length);
+
+	/**
+	 * \brief Read every message
+	 *
+	 * Reads the rest of the archive, parsing each non blank line with
+	 * ParseMessage and passing the result to handler.
+	 * \param handler - The function to pass each parseresult to
+	 * \return Returns the number of messages read
+	 */
+	uint64_t readmessages(const std::function<void(parseresult &)> &handler);
+
+	/**
+	 * \brief Check for io_uring
+	 *
+	 * \return Returns true if reads are queued with io_uring, false if the
+	 * pread fallback is in use
+	 */
+	bool isuring() const;
+
+	/**
+	 * \brief Get the archive size
+	 *
+	 * \return Returns the size of the archive in bytes
+	 */
+	uint64_t size() const;
+
+private:
+	/**
+	 * \brief Start reading a block
+	 *
+	 * \param block - The index of the block in the archive
+	 */
+	void startread(uint64_t block);
+
+	/**
+	 * \brief Wait for a block
+	 *
+	 * \param block - The index of the block in the archive
+	 * \return Returns the number of bytes in the block
+	 */
+	size_t waitread(uint64_t block);
+
+	// disallow copying, the reader owns its file and buffers
+	archivereader(const archivereader &);
+	archivereader & operator=(const archivereader &);
+
+	/**
+	 * \brief The archive file descriptor
+	 */
+	int descriptor;
+
+	/**
+	 * \brief The archive size in bytes
+	 */
+	uint64_t filesize;
+
+	/**
+	 * \brief The size of each read
+	 */
+	size_t blocksize;
+
+	/**
+	 * \brief The number of blocks in the archive
+	 */
+	uint64_t blockcount;
+
+	/**
+	 * \brief The read buffers, block n is read into buffer n % depth
+	 */
+	std::vector<std::vector<char>> buffers;
+
+	/**
+	 * \brief The next block to start reading
+	 */
+	uint64_t nextread;
+
+	/**
+	 * \brief The block being handed out by next(), or blockcount before
+	 * the first block
+	 */
+	uint64_t currentblock;
+
+	/**
+	 * \brief The number of bytes in the current block
+	 */
+	size_t currentlength;
+
+	/**
+	 * \brief The next position in the current block to hand out
+	 */
+	size_t position;
+
+	/**
+	 * \brief The start of a line that continues into the next block
+	 */
+	std::vector<char> carry;
+
+	/**
+	 * \brief A line assembled from two or more blocks, handed out by
+	 * next()
+	 */
+	std::vector<char> joined;
+
+	/**
+	 * \brief io_uring state, empty when using pread
+	 */
+	struct uring;
+	std::unique_ptr<uring> ring;
+};
+}
+#endif
+#endif
@@ -0,0 +1,400 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_ASYNCMESSAGESTREAM_H
+#define DETECTION_ASYNCMESSAGESTREAM_H
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "batch.h"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#define DETECTION_HAVE_COROUTINES
+#endif
+#endif
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats message stream class
+ *
+ * The detectionformats messagestream class reads newline delimited json
+ * detection format messages from a non blocking descriptor, such as a
+ * socket or pipe, without ever waiting.  trynext() hands back the next
+ * buffered message, reading from the descriptor only when no complete
+ * message is buffered, and reports when the descriptor has nothing more to
+ * read yet, so that many streams can be served by one thread.
+ *
+ * The messagestream does not own the descriptor.
+ */
+class messagestream {
+public:
+	/**
+	 * \brief trynext() status values
+	 */
+	enum status {
+		ready = 0,
+		wouldblock = 1,
+		finished = 2
+	};
+
+	/**
+	 * \brief messagestream constructor
+	 *
+	 * \param descriptor - The non blocking descriptor to read
+	 */
+	explicit messagestream(int descriptor);
+
+	/**
+	 * \brief Try to get the next message
+	 *
+	 * Parses the next non blank line with ParseMessage.  Throws
+	 * std::runtime_error if the read fails or a line is longer than 16 MB.
+	 * \param result - The parseresult to fill with the message
+	 * \return Returns ready if result holds the next message, wouldblock if
+	 * the descriptor must become readable first, or finished at the end of
+	 * the stream
+	 */
+	int trynext(parseresult &result);
+
+	/**
+	 * \brief Get the descriptor
+	 *
+	 * \return Returns the descriptor being read
+	 */
+	int getdescriptor() const;
+
+private:
+	/**
+	 * \brief Parse the line at the start of the buffered data
+	 *
+	 * \param length - The length of the line, without its newline
+	 * \param result - The parseresult to fill
+	 * \return Returns false if the line was blank
+	 */
+	bool parseline(size_t length, parseresult &result);
+
+	/**
+	 * \brief The descriptor being read
+	 */
+	int descriptor;
+
+	/**
+	 * \brief The read buffer
+	 */
+	std::vector<char> buffer;
+
+	/**
+	 * \brief The offset of the first unparsed character in buffer
+	 */
+	size_t start;
+
+	/**
+	 * \brief The number of characters read into buffer
+	 */
+	size_t used;
+
+	/**
+	 * \brief Whether the end of the stream has been read
+	 */
+	bool ended;
+};
+
+/**
+ * \brief detectionformats event waiter interface
+ *
+ * Implemented by anything waiting on an eventloop for a descriptor to
+ * become readable.
+ */
+class eventwaiter {
+public:
+	/**
+	 * \brief eventwaiter destructor
+	 */
+	virtual ~eventwaiter() {
+	}
+
+	/**
+	 * \brief The descriptor is readable
+	 *
+	 * Called from eventloop::run() once per watch().
+	 */
+	virtual void ready() = 0;
+};
+
+/**
+ * \brief detectionformats event loop class
+ *
+ * The detectionformats eventloop class waits on many descriptors at once
+ * with epoll and calls the waiter registered for each descriptor when it
+ * becomes readable.  Each watch() is one shot: the waiter is called once,
+ * and must watch() again to hear about more data.
+ *
+ * run() and the waiters all run on the calling thread, so one thread
+ * serves every stream watched.  Linux only.
+ */
+class eventloop {
+public:
+	/**
+	 * \brief eventloop constructor
+	 *
+	 * Throws std::runtime_error if the epoll instance cannot be created.
+	 */
+	eventloop();
+
+	/**
+	 * \brief eventloop destructor
+	 */
+	~eventloop();
+
+	/**
+	 * \brief Watch a descriptor
+	 *
+	 * Calls waiter.ready() from run() once descriptor is readable, or at
+	 * the end of its stream.  A descriptor has at most one waiter at a
+	 * time.  Throws std::runtime_error on failure.
+	 * \param descriptor - The descriptor to watch
+	 * \param waiter - The waiter to call
+	 */
+	void watch(int descriptor, eventwaiter &waiter);
+
+	/**
+	 * \brief Stop watching a descriptor
+	 *
+	 * Must be called before a watched descriptor is closed.  The waiter is
+	 * not called.
+	 * \param descriptor - The descriptor to forget
+	 */
+	void forget(int descriptor);
+
+	/**
+	 * \brief Run the event loop
+	 *
+	 * Calls waiters as their descriptors become readable, until stop() is
+	 * called or no waiter is left waiting.
+	 */
+	void run();
+
+	/**
+	 * \brief Stop the event loop
+	 *
+	 * Makes run() return.  May be called from any thread.
+	 */
+	void stop();
+
+private:
+	// disallow copying, the loop owns its epoll instance
+	eventloop(const eventloop &);
+	eventloop & operator=(const eventloop &);
+
+	/**
+	 * \brief The epoll instance
+	 */
+	int epolldescriptor;
+
+	/**
+	 * \brief The eventfd used to wake run() for stop()
+	 */
+	int wakedescriptor;
+
+	/**
+	 * \brief The waiter for each watched descriptor, NULL once called
+	 */
+	std::vector<eventwaiter *> waiters;
+
+	/**
+	 * \brief The number of watches not yet called
+	 */
+	size_t waiting;
+
+	/**
+	 * \brief Set by stop()
+	 */
+	std::atomic<bool> stopping;
+};
+
+#ifdef DETECTION_HAVE_COROUTINES
+/**
+ * \brief detectionformats asynchronous task type
+ *
+ * The return type for a coroutine that reads an asyncmessagestream.  The
+ * coroutine starts running as soon as it is called, and frees itself when
+ * it returns.  An exception escaping the coroutine terminates the program.
+ *
+ * Only available when compiled as C++20 or later.
+ */
+struct asynctask {
+	/**
+	 * \brief The coroutine promise
+	 */
+	struct promise_type {
+		asynctask get_return_object() {
+			return (asynctask());
+		}
+		std::suspend_never initial_suspend() noexcept {
+			return (std::suspend_never());
+		}
+		std::suspend_never final_suspend() noexcept {
+			return (std::suspend_never());
+		}
+		void return_void() {
+		}
+		void unhandled_exception() {
+			std::terminate();
+		}
+	};
+};
+
+/**
+ * \brief detectionformats asynchronous message stream class
+ *
+ * The detectionformats asyncmessagestream class lets a coroutine read the
+ * messages from a descriptor with co_await:
+ *
+ * \code
+ * detectionformats::asynctask consume(
+ *		detectionformats::asyncmessagestream &stream) {
+ *	while (std::optional<detectionformats::parseresult> message =
+ *			co_await stream.next()) {
+ *		// use *message
+ *	}
+ * }
+ * \endcode
+ *
+ * When no message is buffered the coroutine is suspended, and resumed from
+ * eventloop::run() once the descriptor has delivered the next message.  So
+ * hundreds of feeds can be read by coroutines on one event loop thread,
+ * rather than a thread per feed.
+ *
+ * Only available when compiled as C++20 or later; the rest of the library
+ * does not need to be.
+ */
+class asyncmessagestream {
+public:
+	/**
+	 * \brief The awaitable returned by next()
+	 */
+	class nextawaiter : public eventwaiter {
+	public:
+		/**
+		 * \brief nextawaiter constructor
+		 *
+		 * \param newowner - The stream to read
+		 */
+		explicit nextawaiter(asyncmessagestream &newowner)
+				: owner(newowner),
+					status(messagestream::wouldblock) {
+		}
+
+		/**
+		 * \brief Check for a buffered message
+		 *
+		 * \return Returns true if there is no need to suspend
+		 */
+		bool await_ready() {
+			try {
+				status = owner.stream.trynext(result);
+			} catch (...) {
+				error = std::current_exception();
+				return (true);
+			}
+			return (status != messagestream::wouldblock);
+		}
+
+		/**
+		 * \brief Suspend until the descriptor is readable
+		 *
+		 * \param newhandle - The suspended coroutine
+		 */
+		void await_suspend(std::coroutine_handle<> newhandle) {
+			handle = newhandle;
+			owner.loop.watch(owner.stream.getdescriptor(), *this);
+		}
+
+		/**
+		 * \brief Get the message
+		 *
+		 * Rethrows any read error.
+		 * \return Returns the message, or nothing at the end of the stream
+		 */
+		std::optional<parseresult> await_resume() {
+			if (error != NULL) {
+				std::rethrow_exception(error);
+			}
+			if (status != messagestream::ready) {
+				return (std::nullopt);
+			}
+			return (std::optional<parseresult>(std::move(result)));
+		}
+
+		/**
+		 * \brief The descriptor is readable
+		 *
+		 * Resumes the coroutine once a whole message has arrived, or
+		 * watches the descriptor again if only part of one has.
+		 */
+		void ready() override {
+			if (await_ready() == false) {
+				owner.loop.watch(owner.stream.getdescriptor(), *this);
+				return;
+			}
+			// the coroutine may destroy this awaiter, so resume last
+			handle.resume();
+		}
+
+	private:
+		asyncmessagestream &owner;
+		std::coroutine_handle<> handle;
+		int status;
+		parseresult result;
+		std::exception_ptr error;
+	};
+
+	/**
+	 * \brief asyncmessagestream constructor
+	 *
+	 * \param newloop - The event loop to wait on
+	 * \param descriptor - The non blocking descriptor to read, not owned
+	 */
+	asyncmessagestream(eventloop &newloop, int descriptor)
+			: loop(newloop),
+				stream(descriptor) {
+	}
+
+	/**
+	 * \brief Get the next message
+	 *
+	 * \return Returns an awaitable that gives the next message, or nothing
+	 * at the end of the stream
+	 */
+	nextawaiter next() {
+		return (nextawaiter(*this));
+	}
+
+private:
+	/**
+	 * \brief The event loop to wait on
+	 */
+	eventloop &loop;
+
+	/**
+	 * \brief The stream being read
+	 */
+	messagestream stream;
+};
+#endif
+}
+#endif
+#endif
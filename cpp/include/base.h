@@ -48,7 +48,7 @@ namespace detectionformats
 		* \param jsondocument - a reference to the json document to fill in with the class contents.
 		* \return Returns 1 if successful, 0 otherwise
 		*/
-		virtual rapidjson::Value & tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) = 0;
+		virtual rapidjson::Value & tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const = 0;
 
 		/**
 		* \brief Validates the values in the class
@@ -56,7 +56,7 @@ namespace detectionformats
 		* Validates the values contained in the class
 		* \return Returns 1 if successful, 0 otherwise
 		*/
-		virtual bool isvalid();
+		virtual bool isvalid() const;
 
 		/**
 		* \brief Gets any errors in the class
@@ -64,7 +64,7 @@ namespace detectionformats
 		* Gets any formatting errors in the class
 		* \return Returns a std::vector<std::string> containing the errors
 		*/
-		virtual std::vector<std::string> geterrors() = 0;
+		virtual std::vector<std::string> geterrors() const = 0;
 
 		/**
 		* \brief type identifier
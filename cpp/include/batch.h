@@ -0,0 +1,134 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_BATCH_H
+#define DETECTION_BATCH_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base.h"
+#include "parsecontext.h"
+#include "threadpool.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats batch parse result
+ *
+ * The result of parsing one message of a batch.  If the message parsed,
+ * object holds the parsed format object and error is empty; otherwise
+ * object is empty and error describes why the message could not be parsed.
+ */
+struct parseresult {
+	/**
+	 * \brief parseresult constructor
+	 *
+	 * Initilizes to an unknown type with no object.
+	 */
+	parseresult()
+			: type(formattypes::unknown) {
+	}
+
+	/**
+	 * \brief Check if parsed
+	 *
+	 * \return Returns true if the message parsed into an object
+	 */
+	bool isparsed() const {
+		return (object != NULL);
+	}
+
+	/**
+	 * \brief Get the typed object
+	 *
+	 * \return Returns the parsed object as a T, or an empty pointer if the
+	 * message did not parse or is not a T
+	 */
+	template<class T>
+	std::shared_ptr<T> get() const {
+		return (std::dynamic_pointer_cast<T>(object));
+	}
+
+	/**
+	 * \brief The message format type, one of the formattypes enum values
+	 */
+	int type;
+
+	/**
+	 * \brief The parsed object
+	 */
+	std::shared_ptr<detectionbase> object;
+
+	/**
+	 * \brief The reason the message did not parse
+	 */
+	std::string error;
+};
+
+/**
+ * \brief Parse a message
+ *
+ * Parses one serialized json message of any of the pick, correlation,
+ * detection, retract, stationInfo, and stationInfoRequest formats, routing
+ * on its Type.  Errors are recorded in result rather than thrown.
+ * \param buffer - A pointer to the serialized json message
+ * \param length - The number of characters in buffer
+ * \param document - A json document to parse into, reused between calls to
+ * avoid allocating a new one for each message
+ * \param result - The parseresult to fill in
+ */
+void ParseMessage(const char *buffer, size_t length,
+		rapidjson::Document &document, parseresult &result);
+
+/**
+ * \brief Parse a message with a parse context
+ *
+ * Parses one serialized json message as ParseMessage above, using the
+ * document and buffers of context so that nothing is allocated for the
+ * json itself.
+ * \param buffer - A pointer to the serialized json message
+ * \param length - The number of characters in buffer
+ * \param context - The parsecontext to parse with, such as
+ * parsecontext::local()
+ * \param result - The parseresult to fill in
+ */
+void ParseMessage(const char *buffer, size_t length, parsecontext &context,
+		parseresult &result);
+
+/**
+ * \brief Parse a batch of messages
+ *
+ * Parses a batch of serialized json messages of any mix of the pick,
+ * correlation, detection, retract, stationInfo, and stationInfoRequest
+ * formats on the provided thread pool.  The results are in the same order
+ * as the messages.  A message that does not parse, or has an unknown Type,
+ * produces a result with an error rather than failing the batch.
+ *
+ * Must not be called from a task running on pool.
+ * \param messages - A std::vector<std::string> containing the messages
+ * \param pool - The thread pool to parse on
+ * \return Returns a std::vector<parseresult> with one result per message
+ */
+std::vector<parseresult> ParseBatch(const std::vector<std::string> &messages,
+		threadpool &pool);
+
+/**
+ * \brief Parse a batch of message buffers
+ *
+ * Parses a batch of serialized json messages held in caller owned buffers,
+ * without copying them into std::strings; see ParseBatch above.
+ * \param buffers - An array of pointers to the serialized json messages
+ * \param lengths - An array of the number of characters in each buffer
+ * \param count - The number of messages
+ * \param pool - The thread pool to parse on
+ * \return Returns a std::vector<parseresult> with one result per message
+ */
+std::vector<parseresult> ParseBatch(const char * const *buffers,
+		const size_t *lengths, size_t count, threadpool &pool);
+}
+#endif
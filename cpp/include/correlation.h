@@ -255,6 +255,37 @@ public:
 	 */
 	~correlation();
 
+	/**
+	 * \brief correlation reset function
+	 *
+	 * Overwrites the members of this correlation in place from the provided
+	 * json::Object, reusing the capacity of the existing strings instead of
+	 * constructing new ones.
+	 * \param json - A json object.
+	 */
+	void resetfrom(rapidjson::Value &json);
+
+	/**
+	 * \brief correlation reset from buffer function
+	 *
+	 * Parses the provided serialized json into jsondocument and overwrites
+	 * the members of this correlation in place from it.  Throws
+	 * std::invalid_argument if the buffer does not parse.
+	 * \param jsonbuffer - A pointer to the serialized json
+	 * \param length - The number of characters in jsonbuffer
+	 * \param jsondocument - A rapidjson::Document to parse into
+	 */
+	void resetfrom(const char *jsonbuffer, size_t length,
+			rapidjson::Document &jsondocument);
+
+	/**
+	 * \brief correlation clear function
+	 *
+	 * Resets the members of this correlation to null values, retaining the
+	 * capacity of the existing strings.
+	 */
+	void clear();
+
 	/**
 	 * \brief Convert to json object function
 	 *
@@ -262,16 +293,56 @@ public:
 	 * \return Returns a json::Object containing the class contents
 	 */
 	virtual rapidjson::Value & tojson(rapidjson::Value &json,
-			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator)
+			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const
 					override;
 
+	/**
+	 * \brief Convert to binary function
+	 *
+	 * Appends the compact binary encoding of the class to buffer.  The encoding
+	 * holds the fields in a fixed order without keys, and is only intended for
+	 * exchange between programs built with the same version of this library.
+	 * \param buffer - The std::string to append to
+	 */
+	void tobinary(std::string &buffer) const;
+
+	/**
+	 * \brief Convert from binary function
+	 *
+	 * Overwrites the members of this correlation from its binary
+	 * encoding.  Throws std::invalid_argument if the buffer is truncated or
+	 * corrupt.
+	 * \param buffer - A pointer to the encoded buffer
+	 * \param length - The number of characters in buffer
+	 * \return Returns the number of characters consumed
+	 */
+	size_t frombinary(const char *buffer, size_t length);
+
+	/**
+	 * \brief Equality operator
+	 *
+	 * Compares every member of this correlation to the provided one,
+	 * missing values compare equal
+	 * \param other - The correlation to compare to
+	 * \return Returns true if all the members are equal
+	 */
+	bool operator==(const correlation &other) const;
+
+	/**
+	 * \brief Inequality operator
+	 *
+	 * \param other - The correlation to compare to
+	 * \return Returns true if any member differs
+	 */
+	bool operator!=(const correlation &other) const;
+
 	/**
 	 * \brief Gets any errors in the class
 	 *
 	 * Gets any formatting errors in the class
 	 * \return Returns a std::vector<std::string> containing the errors
 	 */
-	virtual std::vector<std::string> geterrors() override;
+	virtual std::vector<std::string> geterrors() const override;
 
 	/**
 	 * \brief correlation id
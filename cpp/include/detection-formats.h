@@ -13,5 +13,27 @@
 #include "retract.h"
 #include "stationInfo.h"
 #include "stationInfoRequest.h"
+#include "pool.h"
+#include "sharedvector.h"
+#include "threadpool.h"
+#include "batch.h"
+#include "queue.h"
+#include "pipeline.h"
+#include "ingestserver.h"
+#include "archivereader.h"
+#include "mappedarchive.h"
+#include "shmring.h"
+#include "asyncmessagestream.h"
+#include "parsecontext.h"
+#include "shardedprocessor.h"
+#include "stationinventory.h"
+#include "stationindex.h"
+#include "stationinforesponder.h"
+#include "pickwindow.h"
+#include "pickdedup.h"
+#include "retractionindex.h"
+#include "detectionstore.h"
+#include "detectiondiff.h"
+#include "messagelog.h"
 
 #endif
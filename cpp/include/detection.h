@@ -14,6 +14,8 @@
 #include "hypocenter.h"
 #include "pick.h"
 #include "correlation.h"
+#include "sharedvector.h"
+#include "threadpool.h"
 
 namespace detectionformats {
 /**
@@ -27,6 +29,12 @@ namespace detectionformats {
  * applications and organizations.
  *
  * detection uses the Source and Site common objects.
+ *
+ * The pick and correlation data are held in copy on write sharedvectors, so
+ * copying a detection shares its data with the original rather than copying
+ * every pick and correlation.  Accessing an entry through a non-const
+ * detection copies that entry if it is shared, so read the data through a
+ * const reference to keep it shared.
  */
 class detection: public detectionbase {
 public:
@@ -145,7 +153,8 @@ public:
 	 * \brief detection copy constructor
 	 *
 	 * The copy constructor for the detection class.
-	 * Copies the provided object from a detection, populating members
+	 * Copies the provided object from a detection, populating members.
+	 * The pick and correlation data are shared with newdetection, not copied.
 	 * \param newdetection - A detection.
 	 */
 	detection(const detection & newdetection);
@@ -157,6 +166,24 @@ public:
 	 */
 	~detection();
 
+	/**
+	 * \brief detection reset function
+	 *
+	 * Overwrites the members of this detection in place from the provided
+	 * json::Object, reusing the capacity of the existing strings instead of
+	 * constructing new ones.
+	 * \param json - A json object.
+	 */
+	void resetfrom(rapidjson::Value &json);
+
+	/**
+	 * \brief detection clear function
+	 *
+	 * Resets the members of this detection to null values, retaining the
+	 * capacity of the existing strings.
+	 */
+	void clear();
+
 	/**
 	 * \brief Convert to json object function
 	 *
@@ -164,16 +191,86 @@ public:
 	 * \return Returns a json::Object containing the class contents
 	 */
 	virtual rapidjson::Value & tojson(rapidjson::Value &json,
-			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator)
+			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const
 					override;
 
+	/**
+	 * \brief Convert to binary function
+	 *
+	 * Appends the compact binary encoding of the class to buffer.  The encoding
+	 * holds the fields in a fixed order without keys, and is only intended for
+	 * exchange between programs built with the same version of this library.
+	 * \param buffer - The std::string to append to
+	 */
+	void tobinary(std::string &buffer) const;
+
+	/**
+	 * \brief Convert from binary function
+	 *
+	 * Overwrites the members of this detection from its binary
+	 * encoding.  Throws std::invalid_argument if the buffer is truncated or
+	 * corrupt.
+	 * \param buffer - A pointer to the encoded buffer
+	 * \param length - The number of characters in buffer
+	 * \return Returns the number of characters consumed
+	 */
+	size_t frombinary(const char *buffer, size_t length);
+
+	/**
+	 * \brief Equality operator
+	 *
+	 * Compares every member of this detection to the provided one,
+	 * missing values compare equal
+	 * \param other - The detection to compare to
+	 * \return Returns true if all the members are equal
+	 */
+	bool operator==(const detection &other) const;
+
+	/**
+	 * \brief Inequality operator
+	 *
+	 * \param other - The detection to compare to
+	 * \return Returns true if any member differs
+	 */
+	bool operator!=(const detection &other) const;
+
 	/**
 	 * \brief Gets any errors in the class
 	 *
 	 * Gets any formatting errors in the class
 	 * \return Returns a std::vector<std::string> containing the errors
 	 */
-	virtual std::vector<std::string> geterrors() override;
+	virtual std::vector<std::string> geterrors() const override;
+
+	/**
+	 * \brief Gets any errors in the class in parallel
+	 *
+	 * Gets any formatting errors in the class, validating the pick and
+	 * correlation data on the provided thread pool.  The errors are
+	 * returned in the same order as geterrors().
+	 * \param pool - The thread pool to validate the data on
+	 * \return Returns a std::vector<std::string> containing the errors
+	 */
+	std::vector<std::string> geterrors(threadpool &pool) const;
+
+	/**
+	 * \brief Validates the class
+	 *
+	 * Validates the class, stopping at the first error found rather than
+	 * building the full list of errors.
+	 * \return Returns true if the class is valid
+	 */
+	virtual bool isvalid() const override;
+
+	/**
+	 * \brief Validates the class in parallel
+	 *
+	 * Validates the class, checking the pick and correlation data on the
+	 * provided thread pool and stopping as soon as any error is found.
+	 * \param pool - The thread pool to validate the data on
+	 * \return Returns true if the class is valid
+	 */
+	bool isvalid(threadpool &pool) const;
 
 	/**
 	 * \brief detection id
@@ -253,19 +350,35 @@ public:
 	/**
 	 * \brief pick data vector
 	 *
-	 * An optional vector of pick objects used to generate this detection
+	 * An optional vector of pick objects used to generate this detection,
+	 * shared with any copies of this detection until modified
 	 */
-	std::vector<detectionformats::pick> pickdata;
+	detectionformats::sharedvector<detectionformats::pick> pickdata;
 
 	/**
 	 * \brief correlation data vector
 	 *
-	 * An optional vector of correlation objects used to generate this detection
+	 * An optional vector of correlation objects used to generate this
+	 * detection, shared with any copies of this detection until modified
 	 */
-	std::vector<detectionformats::correlation> correlationdata;
+	detectionformats::sharedvector<detectionformats::correlation>
+			correlationdata;
 
 protected:
+	/**
+	 * \brief Gets any errors in the class other than in the data
+	 *
+	 * \param errorlist - The std::vector<std::string> to add errors to
+	 */
+	void getheadererrors(std::vector<std::string> &errorlist) const;
 
+	/**
+	 * \brief Validates one data entry
+	 *
+	 * \param index - The index of the entry, picks first then correlations
+	 * \return Returns true if the entry is valid
+	 */
+	bool isdatavalid(size_t index) const;
 };
 }
 #endif
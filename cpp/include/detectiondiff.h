@@ -0,0 +1,242 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_DETECTIONDIFF_H
+#define DETECTION_DETECTIONDIFF_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "correlation.h"
+#include "detection.h"
+#include "pick.h"
+#include "sharedvector.h"
+
+namespace detectionformats {
+
+/**
+ * \brief The detection fields a detectiondiff can change, other than the
+ * pick and correlation data
+ */
+enum detectiondifffield {
+	diffid,
+	diffsource,
+	diffdetectiontype,
+	diffdetectiontime,
+	diffeventtype,
+	diffbayes,
+	diffminimumdistance,
+	diffrms,
+	diffgap,
+	difflatitude,
+	difflongitude,
+	diffdepth,
+	difftime,
+	difflatitudeerror,
+	difflongitudeerror,
+	diffdeptherror,
+	difftimeerror,
+	difffieldcount
+};
+
+/**
+ * \brief detectionformats data changes struct
+ *
+ * The changes between two versions of a detection's pick or correlation
+ * data, matching the entries by id.
+ */
+template<class T>
+struct datachanges {
+	/**
+	 * \brief datachanges constructor
+	 */
+	datachanges()
+			: replaced(false) {
+	}
+
+	/**
+	 * \brief Check for changes
+	 *
+	 * \return Returns true if the data is unchanged
+	 */
+	bool empty() const {
+		return ((replaced == false) && (removed.empty() == true)
+				&& (modified.empty() == true) && (added.empty() == true)
+				&& (order.empty() == true));
+	}
+
+	/**
+	 * \brief Whether the data is replaced outright by added, since an id
+	 * was missing or repeated in either version
+	 */
+	bool replaced;
+
+	/**
+	 * \brief The ids of the entries removed
+	 */
+	std::vector<std::string> removed;
+
+	/**
+	 * \brief The new versions of the entries changed, each replacing the
+	 * entry with its id in place, shared with the detection they came from
+	 */
+	sharedvector<T> modified;
+
+	/**
+	 * \brief The entries added, appended in order after the kept ones,
+	 * shared with the detection they came from
+	 */
+	sharedvector<T> added;
+
+	/**
+	 * \brief The ids of every entry in their new order, empty if the
+	 * entries are in the order the changes leave them in
+	 */
+	std::vector<std::string> order;
+};
+
+/**
+ * \brief detectionformats detection diff class
+ *
+ * The detectionformats detectiondiff class holds the structural changes
+ * between two versions of a detection, such as successive updates of the
+ * same event, so that a publisher can send the changes instead of the full
+ * new version.
+ *
+ * The changed fields are held individually, the hypocenter's field by
+ * field, and the pick and correlation data are matched by id, so a version
+ * that relocates an event and adds a few picks diffs to those changes
+ * alone.  Unchanged data is not compared member by member when both
+ * versions share it, as copies of a detection do.
+ *
+ * A detectiondiff is written either as a JSON array of JSON Patch (RFC
+ * 6902) like operations, or in the compact binary encoding used by the
+ * format classes, and apply() rebuilds the new version from the old one.
+ */
+class detectiondiff {
+public:
+	/**
+	 * \brief detectiondiff constructor
+	 *
+	 * Constructs an empty detectiondiff, with no changes.
+	 */
+	detectiondiff();
+
+	/**
+	 * \brief detectiondiff constructor
+	 *
+	 * Constructs the changes from one version of a detection to another.
+	 * \param olddetection - The detection's previous version
+	 * \param newdetection - The detection's new version
+	 */
+	detectiondiff(const detection &olddetection,
+			const detection &newdetection);
+
+	/**
+	 * \brief detectiondiff constructor
+	 *
+	 * Constructs a detectiondiff from its json array of operations.  Throws
+	 * std::invalid_argument if an operation is not one a detectiondiff
+	 * writes.
+	 * \param json - A json array
+	 */
+	explicit detectiondiff(rapidjson::Value &json);
+
+	/**
+	 * \brief Apply the changes
+	 *
+	 * Throws std::invalid_argument if the detection does not hold an entry
+	 * the changes remove or modify, or the changes' order names an entry
+	 * it does not end up with.
+	 * \param olddetection - The version the changes were made from
+	 * \return Returns the new version, sharing its unchanged data with
+	 * olddetection
+	 */
+	detection apply(const detection &olddetection) const;
+
+	/**
+	 * \brief Check for changes
+	 *
+	 * \return Returns true if the versions were equal
+	 */
+	bool empty() const;
+
+	/**
+	 * \brief Check a field for changes
+	 *
+	 * \param field - The field to check
+	 * \return Returns true if the field changed
+	 */
+	bool ischanged(detectiondifffield field) const;
+
+	/**
+	 * \brief Convert to json array function
+	 *
+	 * Converts the changes to a json array of operations, each an object
+	 * with "op" and "path" members and, unless it removes something, a
+	 * "value".  A field becoming missing is removed, any other field
+	 * changing is replaced.  Data entries are added, replaced and removed
+	 * at "/Data/Pick/<id>" and "/Data/Correlation/<id>", with the id
+	 * escaped as in a JSON Pointer (RFC 6901); data replaced outright is
+	 * replaced at "/Data/Pick" or "/Data/Correlation", and a new order is
+	 * an "order" operation there whose value is the array of ids.
+	 * \param json - The json value to make the array
+	 * \param allocator - The allocator of the json document
+	 * \return Returns json
+	 */
+	rapidjson::Value & tojson(rapidjson::Value &json,
+			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const;
+
+	/**
+	 * \brief Convert to binary function
+	 *
+	 * Appends the compact binary encoding of the changes to buffer, only
+	 * intended for exchange between programs built with the same version
+	 * of this library.
+	 * \param buffer - The std::string to append to
+	 */
+	void tobinary(std::string &buffer) const;
+
+	/**
+	 * \brief Convert from binary function
+	 *
+	 * Overwrites the changes from their binary encoding.  Throws
+	 * std::invalid_argument if the buffer is truncated or corrupt.
+	 * \param buffer - A pointer to the encoded buffer
+	 * \param length - The number of characters in buffer
+	 * \return Returns the number of characters consumed
+	 */
+	size_t frombinary(const char *buffer, size_t length);
+
+	/**
+	 * \brief Remove all changes
+	 */
+	void clear();
+
+	/**
+	 * \brief The changed fields, a bit per detectiondifffield
+	 */
+	uint32_t changed;
+
+	/**
+	 * \brief The new values of the changed fields, the other fields and
+	 * the data being unused
+	 */
+	detection values;
+
+	/**
+	 * \brief The pick data changes
+	 */
+	datachanges<pick> picks;
+
+	/**
+	 * \brief The correlation data changes
+	 */
+	datachanges<correlation> correlations;
+};
+}
+#endif
@@ -0,0 +1,353 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_DETECTIONSTORE_H
+#define DETECTION_DETECTIONSTORE_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "detection.h"
+#include "retract.h"
+#include "retractionindex.h"
+#include "util.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats detection store metrics
+ */
+struct detectionstoremetrics {
+	/**
+	 * \brief detectionstoremetrics constructor
+	 */
+	detectionstoremetrics()
+			: messages(0),
+				created(0),
+				updated(0),
+				finalized(0),
+				retracted(0),
+				pending(0),
+				stale(0),
+				invalid(0),
+				expired(0) {
+	}
+
+	/**
+	 * \brief The number of messages applied or ignored
+	 */
+	uint64_t messages;
+
+	/**
+	 * \brief The number of detections created
+	 */
+	uint64_t created;
+
+	/**
+	 * \brief The number of New or Update messages replacing a detection
+	 */
+	uint64_t updated;
+
+	/**
+	 * \brief The number of Final messages applied
+	 */
+	uint64_t finalized;
+
+	/**
+	 * \brief The number of retractions applied
+	 */
+	uint64_t retracted;
+
+	/**
+	 * \brief The number of retractions for detections not yet seen, kept
+	 * to retract the detections when they arrive
+	 */
+	uint64_t pending;
+
+	/**
+	 * \brief The number of messages ignored as older than the detection's
+	 * current version, or as following a Final or Retract
+	 */
+	uint64_t stale;
+
+	/**
+	 * \brief The number of messages ignored for having no id or an unknown
+	 * detection type
+	 */
+	uint64_t invalid;
+
+	/**
+	 * \brief The number of detections removed by expire()
+	 */
+	uint64_t expired;
+};
+
+/**
+ * \brief detectionformats detection store class
+ *
+ * The detectionformats detectionstore class keeps the current version of
+ * each detection, by id, applying detection messages according to their
+ * detection type.
+ *
+ * A New or Update message replaces the current version, or creates the
+ * detection if it has not been seen, since the Update can arrive first.  A
+ * Final message replaces it and makes it final, after which only a later
+ * Final or a retraction is applied.  A Retract message, or a retract
+ * message from the detection's source, makes it retracted, after which
+ * nothing is applied; the detection is kept so that late messages for it
+ * are still ignored.  Retractions are also remembered in a retractionindex,
+ * so one arriving before its detection retracts the detection as it is
+ * created.  A message whose detection time is older than the
+ * current version's is ignored, so versions arriving out of order leave
+ * the newest in place; messages without a detection time are applied in
+ * arrival order.
+ *
+ * Each version is held as an immutable shared detection, so lookups return
+ * it without copying and it stays valid however the store changes.  A
+ * bounded number of replaced versions can be kept as history.
+ *
+ * The store is split into shards by id hash, each with its own mutex and
+ * its own index by origin time, so messages for different detections are
+ * applied in parallel.  Every method may be called on any thread.
+ */
+class detectionstore {
+public:
+	/**
+	 * \brief A shared, immutable version of a detection
+	 */
+	typedef std::shared_ptr<const detection> version;
+
+	/**
+	 * \brief detectionstore constructor
+	 *
+	 * \param newhistorylimit - The number of replaced versions to keep for
+	 * each detection
+	 * \param shardcount - The number of shards, rounded up to a power of
+	 * two
+	 * \param expectedretractions - The number of retractions the
+	 * retractionindex is sized for
+	 */
+	explicit detectionstore(size_t newhistorylimit = 0,
+			size_t shardcount = 64, size_t expectedretractions = 1 << 16);
+
+	/**
+	 * \brief Apply a detection message
+	 *
+	 * The detection is not validated.
+	 * \param newdetection - The detection message
+	 * \return Returns true if the store changed
+	 */
+	bool apply(const detection &newdetection);
+
+	/**
+	 * \brief Apply a retract message
+	 *
+	 * The retraction is remembered whether or not its detection has been
+	 * seen.
+	 * \param retraction - The retract message
+	 * \return Returns true if a detection from the retraction's source was
+	 * retracted
+	 */
+	bool apply(const retract &retraction);
+
+	/**
+	 * \brief Find a detection
+	 *
+	 * \param id - The detection id
+	 * \return Returns the current version, or an empty pointer if the
+	 * detection is unknown or retracted
+	 */
+	version find(const std::string &id) const;
+
+	/**
+	 * \brief Get a detection's state
+	 *
+	 * \param id - The detection id
+	 * \param state - Set to the type of the last message applied, retract
+	 * messages counting as retractdetection
+	 * \return Returns false if the detection is unknown
+	 */
+	bool getstate(const std::string &id, detectiontypeindex &state) const;
+
+	/**
+	 * \brief Get a detection's versions
+	 *
+	 * \param id - The detection id
+	 * \return Returns the kept replaced versions and then the current one,
+	 * oldest first, empty if the detection is unknown
+	 */
+	std::vector<version> gethistory(const std::string &id) const;
+
+	/**
+	 * \brief Find the detections with origin times in a range
+	 *
+	 * \param starttime - The earliest origin time
+	 * \param endtime - The latest origin time
+	 * \param results - The vector to append the current versions of the
+	 * detections with hypocenter times in [starttime, endtime] to, ordered
+	 * by origin time, leaving out retracted detections
+	 * \return Returns the number of detections appended
+	 */
+	size_t within(double starttime, double endtime,
+			std::vector<version> &results) const;
+
+	/**
+	 * \brief Remove old detections
+	 *
+	 * Detections without an origin time are removed by the second call
+	 * after they were last replaced, so each is kept for at least the time
+	 * between two calls.
+	 * \param before - The origin time before which detections, including
+	 * retracted ones, are removed
+	 * \return Returns the number of detections removed
+	 */
+	size_t expire(double before);
+
+	/**
+	 * \brief Get the number of detections
+	 *
+	 * \return Returns the number of detections held, including retracted
+	 * ones
+	 */
+	size_t size() const;
+
+	/**
+	 * \brief Get the metrics
+	 *
+	 * \return Returns the running counts of messages and their outcomes
+	 */
+	detectionstoremetrics getmetrics() const;
+
+private:
+	/**
+	 * \brief A detection's versions and state
+	 */
+	struct record {
+		/**
+		 * \brief The current version
+		 */
+		version current;
+
+		/**
+		 * \brief The kept replaced versions, oldest first, a vector since
+		 * an empty deque still allocates and most stores keep none
+		 */
+		std::vector<version> history;
+
+		/**
+		 * \brief The type of the last message applied
+		 */
+		detectiontypeindex state;
+
+		/**
+		 * \brief Whether the record is in one of its shard's indexes
+		 */
+		bool indexed;
+
+		/**
+		 * \brief Whether the record's index is the origin time one rather
+		 * than the untimed one
+		 */
+		bool timed;
+
+		/**
+		 * \brief The record's place in its shard's index
+		 */
+		std::multimap<double, record *>::iterator position;
+	};
+
+	/**
+	 * \brief A part of the store, guarded by its own mutex
+	 */
+	struct shard {
+		/**
+		 * \brief shard constructor
+		 */
+		shard()
+				: expirations(0) {
+		}
+
+		/**
+		 * \brief Guards the shard
+		 */
+		mutable std::mutex mutex;
+
+		/**
+		 * \brief The detections, by id
+		 */
+		std::unordered_map<std::string, record> records;
+
+		/**
+		 * \brief The detections with origin times, by origin time
+		 */
+		std::multimap<double, record *> times;
+
+		/**
+		 * \brief The detections without origin times, by the number of
+		 * expire() calls before they were last replaced
+		 */
+		std::multimap<double, record *> untimed;
+
+		/**
+		 * \brief The number of expire() calls
+		 */
+		uint64_t expirations;
+
+		/**
+		 * \brief The shard's running counts
+		 */
+		detectionstoremetrics metrics;
+	};
+
+	/**
+	 * \brief Get the shard an id belongs to
+	 *
+	 * \param id - The detection id
+	 * \return Returns the shard
+	 */
+	shard & getshard(const std::string &id) const;
+
+	/**
+	 * \brief Replace a record's current version, the caller holding its
+	 * shard's mutex
+	 *
+	 * \param owner - The record's shard
+	 * \param target - The record
+	 * \param newversion - The new current version
+	 * \param state - The record's new state
+	 * \return Returns the version no longer held, if any, for the caller
+	 * to release after letting go of the mutex
+	 */
+	version replace(shard &owner, record &target, const version &newversion,
+			detectiontypeindex state);
+
+	// disallow copying, the shards hold mutexes
+	detectionstore(const detectionstore &);
+	detectionstore & operator=(const detectionstore &);
+
+	/**
+	 * \brief The number of replaced versions kept per detection
+	 */
+	size_t historylimit;
+
+	/**
+	 * \brief The shards
+	 */
+	std::vector<std::unique_ptr<shard>> shards;
+
+	/**
+	 * \brief The retractions applied, including those for detections not
+	 * yet seen
+	 */
+	retractionindex retractions;
+};
+}
+#endif
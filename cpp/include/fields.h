@@ -0,0 +1,869 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_FIELDS_H
+#define DETECTION_FIELDS_H
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "util.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats binary reader class
+ *
+ * The detectionformats binaryreader class reads the values written by the
+ * field descriptors' binary encoding from a character buffer, throwing
+ * std::invalid_argument if the buffer is too short.
+ */
+class binaryreader {
+public:
+	/**
+	 * \brief binaryreader constructor
+	 *
+	 * \param newbuffer - A pointer to the encoded buffer
+	 * \param newlength - The number of characters in newbuffer
+	 */
+	binaryreader(const char *newbuffer, size_t newlength)
+			: buffer(newbuffer),
+				length(newlength),
+				offset(0) {
+	}
+
+	/**
+	 * \brief Read raw bytes
+	 *
+	 * \param destination - The memory to copy count bytes into
+	 * \param count - The number of bytes to read
+	 */
+	void read(void *destination, size_t count) {
+		check(count);
+		memcpy(destination, buffer + offset, count);
+		offset += count;
+	}
+
+	/**
+	 * \brief Read an unsigned LEB128 encoded length
+	 *
+	 * \return Returns the decoded length
+	 */
+	size_t readlength() {
+		size_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			check(1);
+			unsigned char byte = static_cast<unsigned char>(buffer[offset++]);
+			value |= static_cast<size_t>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0) {
+				return (value);
+			}
+		}
+		throw std::invalid_argument("Invalid length in binary buffer.");
+	}
+
+	/**
+	 * \brief Read a length prefixed string
+	 *
+	 * \param value - The std::string to assign the characters to
+	 */
+	void readstring(std::string &value) {
+		size_t count = readlength();
+		check(count);
+		value.assign(buffer + offset, count);
+		offset += count;
+	}
+
+	/**
+	 * \brief Get the unread part of the buffer
+	 *
+	 * \return Returns a pointer to the first unread character
+	 */
+	const char * current() const {
+		return (buffer + offset);
+	}
+
+	/**
+	 * \brief Get the unread length
+	 *
+	 * \return Returns the number of unread characters
+	 */
+	size_t remaining() const {
+		return (length - offset);
+	}
+
+	/**
+	 * \brief Skip characters consumed elsewhere
+	 *
+	 * \param count - The number of characters to skip
+	 */
+	void skip(size_t count) {
+		check(count);
+		offset += count;
+	}
+
+	/**
+	 * \brief Get the read position
+	 *
+	 * \return Returns the number of characters read so far
+	 */
+	size_t position() const {
+		return (offset);
+	}
+
+private:
+	void check(size_t count) const {
+		if (count > length - offset) {
+			throw std::invalid_argument("Truncated binary buffer.");
+		}
+	}
+
+	const char *buffer;
+	size_t length;
+	size_t offset;
+};
+
+/**
+ * \brief Write an unsigned LEB128 encoded length
+ *
+ * \param value - The length to write
+ * \param buffer - The std::string to append to
+ */
+inline void WriteBinaryLength(size_t value, std::string &buffer) {
+	while (value >= 0x80) {
+		buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back(static_cast<char>(value));
+}
+
+/**
+ * \brief Write raw bytes
+ *
+ * \param source - The memory to append
+ * \param count - The number of bytes to append
+ * \param buffer - The std::string to append to
+ */
+inline void WriteBinaryBytes(const void *source, size_t count,
+		std::string &buffer) {
+	buffer.append(static_cast<const char *>(source), count);
+}
+
+/**
+ * \brief Compare two doubles, treating two missing (NaN) values as equal
+ */
+inline bool IsEqualDouble(double a, double b) {
+	return ((a == b) || ((std::isnan(a) == true) && (std::isnan(b) == true)));
+}
+
+/**
+ * \brief detectionformats field descriptor base
+ *
+ * The key of a field, its hash, computed at compile time, and whether the
+ * field is required.  Each descriptor type below adds a member pointer and
+ * the parse, write, encode, decode, compare and missing operations for one
+ * kind of member.
+ */
+struct fielddescriptor {
+	constexpr fielddescriptor(const char *newkey, size_t newlength)
+			: key(newkey),
+				length(newlength),
+				hash(HashJSONKey(newkey, newlength)),
+				required(false) {
+	}
+
+	/**
+	 * \brief Check if a required field is missing from an object, a field
+	 * that cannot be missing never is
+	 */
+	template<class C>
+	bool ismissing(const C &) const {
+		return (false);
+	}
+
+	/**
+	 * \brief Make the error for a required field missing from an object
+	 *
+	 * \param classname - The name of the object's class
+	 */
+	std::string missingerror(const char *classname) const {
+		return ("Missing " + std::string(key, length) + " in "
+				+ std::string(classname) + " class.");
+	}
+
+	/**
+	 * \brief Check if a json member name whose hash matched is this field's
+	 * key
+	 */
+	bool matches(const rapidjson::Value &name) const {
+		return ((name.GetStringLength() == length)
+				&& (memcmp(name.GetString(), key, length) == 0));
+	}
+
+	/**
+	 * \brief Make the key json value, the key is a string literal so it is
+	 * not copied
+	 */
+	rapidjson::Value jsonkey() const {
+		return (rapidjson::Value(
+				rapidjson::StringRef(key,
+						static_cast<rapidjson::SizeType>(length))));
+	}
+
+	const char *key;
+	size_t length;
+	uint32_t hash;
+	bool required;
+};
+
+/**
+ * \brief std::string field, written if not empty (or always for the type)
+ */
+template<class C>
+struct stringdescriptor : fielddescriptor {
+	constexpr stringdescriptor(const char *newkey, size_t newlength,
+			std::string C::*newmember, bool newalwayswrite)
+			: fielddescriptor(newkey, newlength),
+				member(newmember),
+				alwayswrite(newalwayswrite) {
+	}
+
+	void parse(C &object, rapidjson::Value &value) const {
+		if (value.IsString() == true)
+			(object.*member).assign(value.GetString(), value.GetStringLength());
+	}
+
+	void write(const C &object, rapidjson::Value &json,
+			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+		const std::string &value = object.*member;
+		if ((alwayswrite == true) || (value.empty() == false)) {
+			rapidjson::Value stringvalue;
+			stringvalue.SetString(value.c_str(),
+					static_cast<rapidjson::SizeType>(value.length()),
+					allocator);
+			json.AddMember(jsonkey(), stringvalue, allocator);
+		}
+	}
+
+	void encode(const C &object, std::string &buffer) const {
+		const std::string &value = object.*member;
+		WriteBinaryLength(value.length(), buffer);
+		buffer.append(value);
+	}
+
+	void decode(C &object, binaryreader &reader) const {
+		reader.readstring(object.*member);
+	}
+
+	bool equal(const C &a, const C &b) const {
+		return (a.*member == b.*member);
+	}
+
+	bool ismissing(const C &object) const {
+		return ((object.*member).empty());
+	}
+
+	std::string C::*member;
+	bool alwayswrite;
+};
+
+/**
+ * \brief double field, written if not NaN
+ */
+template<class C>
+struct numberdescriptor : fielddescriptor {
+	constexpr numberdescriptor(const char *newkey, size_t newlength,
+			double C::*newmember)
+			: fielddescriptor(newkey, newlength),
+				member(newmember) {
+	}
+
+	void parse(C &object, rapidjson::Value &value) const {
+		if ((value.IsNumber() == true) && (value.IsDouble() == true))
+			object.*member = value.GetDouble();
+	}
+
+	void write(const C &object, rapidjson::Value &json,
+			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+		if (std::isnan(object.*member) != true)
+			json.AddMember(jsonkey(), rapidjson::Value(object.*member),
+					allocator);
+	}
+
+	void encode(const C &object, std::string &buffer) const {
+		WriteBinaryBytes(&(object.*member), sizeof(double), buffer);
+	}
+
+	void decode(C &object, binaryreader &reader) const {
+		reader.read(&(object.*member), sizeof(double));
+	}
+
+	bool equal(const C &a, const C &b) const {
+		return (IsEqualDouble(a.*member, b.*member));
+	}
+
+	bool ismissing(const C &object) const {
+		return (std::isnan(object.*member));
+	}
+
+	double C::*member;
+};
+
+/**
+ * \brief epoch time field, held as a double and written as an iso8601
+ * string if not NaN
+ */
+template<class C>
+struct timedescriptor : numberdescriptor<C> {
+	constexpr timedescriptor(const char *newkey, size_t newlength,
+			double C::*newmember)
+			: numberdescriptor<C>(newkey, newlength, newmember) {
+	}
+
+	void parse(C &object, rapidjson::Value &value) const {
+		if (value.IsString() == true)
+			object.*(this->member) = ConvertISO8601ToEpochTime(
+					value.GetString(), value.GetStringLength());
+	}
+
+	void write(const C &object, rapidjson::Value &json,
+			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+		if (std::isnan(object.*(this->member)) != true) {
+			std::string timestring = ConvertEpochTimeToISO8601(
+					object.*(this->member));
+			rapidjson::Value timevalue;
+			timevalue.SetString(timestring.c_str(),
+					static_cast<rapidjson::SizeType>(timestring.length()),
+					allocator);
+			json.AddMember(this->jsonkey(), timevalue, allocator);
+		}
+	}
+};
+
+/**
+ * \brief bool field, always written
+ */
+template<class C>
+struct booldescriptor : fielddescriptor {
+	constexpr booldescriptor(const char *newkey, size_t newlength,
+			bool C::*newmember)
+			: fielddescriptor(newkey, newlength),
+				member(newmember) {
+	}
+
+	void parse(C &object, rapidjson::Value &value) const {
+		if (value.IsBool() == true)
+			object.*member = value.GetBool();
+	}
+
+	void write(const C &object, rapidjson::Value &json,
+			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+		json.AddMember(jsonkey(), rapidjson::Value(object.*member),
+				allocator);
+	}
+
+	void encode(const C &object, std::string &buffer) const {
+		buffer.push_back((object.*member == true) ? 1 : 0);
+	}
+
+	void decode(C &object, binaryreader &reader) const {
+		char value = 0;
+		reader.read(&value, 1);
+		object.*member = (value != 0);
+	}
+
+	bool equal(const C &a, const C &b) const {
+		return (a.*member == b.*member);
+	}
+
+	bool C::*member;
+};
+
+/**
+ * \brief nested detectionformats object field, always written when
+ * required, and only if not empty when optional
+ *
+ * T must provide resetfrom(), tojson(), tobinary(), frombinary() and
+ * operator==, and isempty() if the field is optional.
+ */
+template<class C, class T, bool Optional>
+struct objectdescriptor : fielddescriptor {
+	constexpr objectdescriptor(const char *newkey, size_t newlength,
+			T C::*newmember)
+			: fielddescriptor(newkey, newlength),
+				member(newmember) {
+	}
+
+	void parse(C &object, rapidjson::Value &value) const {
+		if (value.IsObject() == true)
+			(object.*member).resetfrom(value);
+	}
+
+	void write(const C &object, rapidjson::Value &json,
+			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+		if (iswritten(object.*member,
+				std::integral_constant<bool, Optional>()) == true) {
+			rapidjson::Value objectvalue(rapidjson::kObjectType);
+			(object.*member).tojson(objectvalue, allocator);
+			json.AddMember(jsonkey(), objectvalue, allocator);
+		}
+	}
+
+	void encode(const C &object, std::string &buffer) const {
+		(object.*member).tobinary(buffer);
+	}
+
+	void decode(C &object, binaryreader &reader) const {
+		reader.skip(
+				(object.*member).frombinary(reader.current(),
+						reader.remaining()));
+	}
+
+	bool equal(const C &a, const C &b) const {
+		return (a.*member == b.*member);
+	}
+
+	/**
+	 * \brief A required object is missing unless it is present and valid
+	 */
+	bool ismissing(const C &object) const {
+		return ((object.*member).isvalid() == false);
+	}
+
+	std::string missingerror(const char *classname) const {
+		return (std::string(key, length) + " object did not validate in "
+				+ std::string(classname) + " class.");
+	}
+
+	T C::*member;
+
+private:
+	static bool iswritten(const T &, std::false_type) {
+		return (true);
+	}
+
+	static bool iswritten(const T &value, std::true_type) {
+		return (value.isempty() == false);
+	}
+};
+
+/**
+ * \brief std::vector of nested detectionformats objects field, written if
+ * not empty
+ */
+template<class C, class T>
+struct arraydescriptor : fielddescriptor {
+	constexpr arraydescriptor(const char *newkey, size_t newlength,
+			std::vector<T> C::*newmember)
+			: fielddescriptor(newkey, newlength),
+				member(newmember) {
+	}
+
+	void parse(C &object, rapidjson::Value &value) const {
+		if (value.IsArray() == false)
+			return;
+
+		// resize rather than rebuild so that existing elements are
+		// overwritten in place
+		std::vector<T> &elements = object.*member;
+		elements.resize(value.Size());
+		for (rapidjson::SizeType i = 0; i < value.Size(); i++) {
+			if (value[i].IsObject() == true)
+				elements[i].resetfrom(value[i]);
+			else
+				elements[i].clear();
+		}
+	}
+
+	void write(const C &object, rapidjson::Value &json,
+			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+		const std::vector<T> &elements = object.*member;
+		if (elements.empty() == true)
+			return;
+
+		rapidjson::Value arrayvalue(rapidjson::kArrayType);
+		arrayvalue.Reserve(static_cast<rapidjson::SizeType>(elements.size()),
+				allocator);
+		for (size_t i = 0; i < elements.size(); i++) {
+			rapidjson::Value elementvalue(rapidjson::kObjectType);
+			elements[i].tojson(elementvalue, allocator);
+			arrayvalue.PushBack(elementvalue, allocator);
+		}
+		json.AddMember(jsonkey(), arrayvalue, allocator);
+	}
+
+	void encode(const C &object, std::string &buffer) const {
+		const std::vector<T> &elements = object.*member;
+		WriteBinaryLength(elements.size(), buffer);
+		for (size_t i = 0; i < elements.size(); i++) {
+			elements[i].tobinary(buffer);
+		}
+	}
+
+	void decode(C &object, binaryreader &reader) const {
+		std::vector<T> &elements = object.*member;
+		size_t count = reader.readlength();
+
+		// every element takes at least one byte, so a count larger than the
+		// remaining buffer is corrupt and must not be used to resize
+		if (count > reader.remaining()) {
+			throw std::invalid_argument(
+					"Invalid array count in binary buffer.");
+		}
+
+		elements.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			reader.skip(
+					elements[i].frombinary(reader.current(),
+							reader.remaining()));
+		}
+	}
+
+	bool equal(const C &a, const C &b) const {
+		return (a.*member == b.*member);
+	}
+
+	bool ismissing(const C &object) const {
+		return ((object.*member).empty());
+	}
+
+	std::vector<T> C::*member;
+};
+
+/**
+ * \brief Describe a std::string field
+ *
+ * \param key - The json key string literal
+ * \param member - The member pointer
+ * \param alwayswrite - Write the key even when the string is empty
+ */
+template<class C, size_t N>
+constexpr stringdescriptor<C> stringfield(const char (&key)[N],
+		std::string C::*member, bool alwayswrite = false) {
+	return (stringdescriptor<C>(key, N - 1, member, alwayswrite));
+}
+
+/**
+ * \brief Describe a double field
+ */
+template<class C, size_t N>
+constexpr numberdescriptor<C> numberfield(const char (&key)[N],
+		double C::*member) {
+	return (numberdescriptor<C>(key, N - 1, member));
+}
+
+/**
+ * \brief Describe an epoch time field serialized as iso8601
+ */
+template<class C, size_t N>
+constexpr timedescriptor<C> timefield(const char (&key)[N],
+		double C::*member) {
+	return (timedescriptor<C>(key, N - 1, member));
+}
+
+/**
+ * \brief Describe a bool field
+ */
+template<class C, size_t N>
+constexpr booldescriptor<C> boolfield(const char (&key)[N],
+		bool C::*member) {
+	return (booldescriptor<C>(key, N - 1, member));
+}
+
+/**
+ * \brief Describe a required nested object field
+ */
+template<class C, class T, size_t N>
+constexpr objectdescriptor<C, T, false> objectfield(const char (&key)[N],
+		T C::*member) {
+	return (objectdescriptor<C, T, false>(key, N - 1, member));
+}
+
+/**
+ * \brief Describe an optional nested object field
+ */
+template<class C, class T, size_t N>
+constexpr objectdescriptor<C, T, true> optionalobjectfield(
+		const char (&key)[N], T C::*member) {
+	return (objectdescriptor<C, T, true>(key, N - 1, member));
+}
+
+/**
+ * \brief Describe a std::vector of nested objects field
+ */
+template<class C, class T, size_t N>
+constexpr arraydescriptor<C, T> arrayfield(const char (&key)[N],
+		std::vector<T> C::*member) {
+	return (arraydescriptor<C, T>(key, N - 1, member));
+}
+
+/**
+ * \brief Round up to a power of two
+ *
+ * \param value - The value to round up, at least 1
+ * \return Returns the least power of two not less than value
+ */
+constexpr size_t RoundUpPowerOfTwo(size_t value) {
+	size_t power = 1;
+	while (power < value) {
+		power <<= 1;
+	}
+	return (power);
+}
+
+/**
+ * \brief Mark a described field as required
+ *
+ * \param field - The field descriptor
+ * \return Returns a copy of field that CheckRequiredFields reports when
+ * missing
+ */
+template<class Descriptor>
+constexpr Descriptor requiredfield(Descriptor field) {
+	field.required = true;
+	return (field);
+}
+
+/**
+ * \brief Apply a function to each field until it returns true
+ *
+ * \return Returns true if the function returned true for any field
+ */
+template<size_t I = 0, class Tuple, class Function>
+typename std::enable_if<(I == std::tuple_size<Tuple>::value), bool>::type
+AnyField(const Tuple &, Function &) {
+	return (false);
+}
+
+template<size_t I = 0, class Tuple, class Function>
+typename std::enable_if<(I < std::tuple_size<Tuple>::value), bool>::type
+AnyField(const Tuple &fields, Function &function) {
+	if (function(std::get<I>(fields)) == true) {
+		return (true);
+	}
+	return (AnyField<I + 1>(fields, function));
+}
+
+/**
+ * \brief detectionformats field lookup table
+ *
+ * An open addressing table from the key hashes of a class's field
+ * descriptors to functions parsing each field, sized to at least four slots
+ * per field so that a json member is almost always matched to its field, or
+ * to none, by the first slot its name's hash indexes, rather than by
+ * comparing it to every field.
+ */
+template<class C, class Tuple>
+class fieldtable {
+public:
+	/**
+	 * \brief fieldtable constructor
+	 *
+	 * \param fields - The std::tuple of field descriptors for the class
+	 */
+	explicit fieldtable(const Tuple &fields)
+			: entries() {
+		add(fields, std::make_index_sequence<std::tuple_size<Tuple>::value>());
+	}
+
+	/**
+	 * \brief Parse a json member into the field its name matches
+	 *
+	 * Members that do not match a field are ignored.
+	 * \param object - The object to populate
+	 * \param name - The json member name
+	 * \param value - The json member value
+	 * \param fields - The std::tuple of field descriptors the table was
+	 * built from
+	 */
+	void parse(C &object, const rapidjson::Value &name, rapidjson::Value &value,
+			const Tuple &fields) const {
+		uint32_t namehash = HashJSONKey(name);
+		for (size_t slot = namehash & (slots - 1); entries[slot].parse != NULL;
+				slot = (slot + 1) & (slots - 1)) {
+			if ((entries[slot].hash == namehash)
+					&& (entries[slot].parse(object, name, value, fields)
+							== true)) {
+				return;
+			}
+		}
+	}
+
+private:
+	static constexpr size_t slots = RoundUpPowerOfTwo(
+			4 * std::tuple_size<Tuple>::value);
+
+	typedef bool (*parser)(C &, const rapidjson::Value &, rapidjson::Value &,
+			const Tuple &);
+
+	struct entry {
+		uint32_t hash;
+		parser parse;
+	};
+
+	template<size_t... I>
+	void add(const Tuple &fields, std::index_sequence<I...>) {
+		int expand[] = { 0, (add(std::get<I>(fields).hash, &parsefield<I>),
+				0)... };
+		(void) expand;
+	}
+
+	void add(uint32_t hash, parser parse) {
+		size_t slot = hash & (slots - 1);
+		while (entries[slot].parse != NULL) {
+			slot = (slot + 1) & (slots - 1);
+		}
+		entries[slot].hash = hash;
+		entries[slot].parse = parse;
+	}
+
+	template<size_t I>
+	static bool parsefield(C &object, const rapidjson::Value &name,
+			rapidjson::Value &value, const Tuple &fields) {
+		const auto &field = std::get<I>(fields);
+		if (field.matches(name) == false)
+			return (false);
+		field.parse(object, value);
+		return (true);
+	}
+
+	std::array<entry, slots> entries;
+};
+
+/**
+ * \brief Populate an object from json using its field descriptors
+ *
+ * Walks the members of json once, finding each member's field in a table of
+ * the fields by the hash of their keys, built on the first call for the
+ * class.  Members that do not match a field, or whose value is of the
+ * wrong type, are ignored.
+ * \param object - The object to populate, already cleared
+ * \param json - A json object
+ * \param fields - The std::tuple of field descriptors for the object, the
+ * same for every call with the same class
+ */
+template<class C, class Tuple>
+void ParseFields(C &object, rapidjson::Value &json, const Tuple &fields) {
+	static const fieldtable<C, Tuple> table(fields);
+
+	for (rapidjson::Value::MemberIterator member = json.MemberBegin();
+			member != json.MemberEnd(); ++member) {
+		table.parse(object, member->name, member->value, fields);
+	}
+}
+
+/**
+ * \brief Write an object to json using its field descriptors
+ *
+ * \param object - The object to write
+ * \param json - The json object to add members to
+ * \param allocator - The json allocator
+ * \param fields - The std::tuple of field descriptors for the object
+ * \return Returns json
+ */
+template<class C, class Tuple>
+rapidjson::Value & WriteFields(const C &object, rapidjson::Value &json,
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator,
+		const Tuple &fields) {
+	json.SetObject();
+
+	auto write = [&](const auto &field) {
+		field.write(object, json, allocator);
+		return (false);
+	};
+	AnyField(fields, write);
+
+	return (json);
+}
+
+/**
+ * \brief Append the binary encoding of an object using its field descriptors
+ *
+ * The encoding is the untagged sequence of the fields in descriptor order,
+ * so it can only be decoded by the same version of this library.
+ * \param object - The object to encode
+ * \param buffer - The std::string to append to
+ * \param fields - The std::tuple of field descriptors for the object
+ */
+template<class C, class Tuple>
+void EncodeFields(const C &object, std::string &buffer, const Tuple &fields) {
+	auto encode = [&](const auto &field) {
+		field.encode(object, buffer);
+		return (false);
+	};
+	AnyField(fields, encode);
+}
+
+/**
+ * \brief Populate an object from its binary encoding using its field
+ * descriptors
+ *
+ * Throws std::invalid_argument if the buffer is truncated or corrupt.
+ * \param object - The object to populate
+ * \param buffer - A pointer to the encoded buffer
+ * \param length - The number of characters in buffer
+ * \param fields - The std::tuple of field descriptors for the object
+ * \return Returns the number of characters consumed
+ */
+template<class C, class Tuple>
+size_t DecodeFields(C &object, const char *buffer, size_t length,
+		const Tuple &fields) {
+	binaryreader reader(buffer, length);
+
+	auto decode = [&](const auto &field) {
+		field.decode(object, reader);
+		return (false);
+	};
+	AnyField(fields, decode);
+
+	return (reader.position());
+}
+
+/**
+ * \brief Compare two objects field by field using their field descriptors
+ *
+ * \return Returns true if every field is equal, missing (NaN) numbers
+ * compare equal to each other
+ */
+template<class C, class Tuple>
+bool EqualFields(const C &a, const C &b, const Tuple &fields) {
+	auto differs = [&](const auto &field) {
+		return (field.equal(a, b) == false);
+	};
+	return (AnyField(fields, differs) == false);
+}
+
+/**
+ * \brief Check an object for missing required fields using its field
+ * descriptors
+ *
+ * A required string, number, time or array is missing when it is empty or
+ * NaN, and a required nested object when it does not validate.
+ * \param object - The object to check
+ * \param classname - The name of the object's class, for the errors
+ * \param fields - The std::tuple of field descriptors for the object
+ * \param errorlist - The std::vector to append an error to for each
+ * missing field, in descriptor order
+ */
+template<class C, class Tuple>
+void CheckRequiredFields(const C &object, const char *classname,
+		const Tuple &fields, std::vector<std::string> &errorlist) {
+	auto check = [&](const auto &field) {
+		if ((field.required == true) && (field.ismissing(object) == true))
+			errorlist.push_back(field.missingerror(classname));
+		return (false);
+	};
+	AnyField(fields, check);
+}
+}
+#endif
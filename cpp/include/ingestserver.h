@@ -0,0 +1,339 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_INGESTSERVER_H
+#define DETECTION_INGESTSERVER_H
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "batch.h"
+#include "queue.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats ingest server statistics
+ */
+struct ingeststatistics {
+	/**
+	 * \brief ingeststatistics constructor
+	 */
+	ingeststatistics()
+			: connections(0),
+				bytes(0),
+				messages(0),
+				errors(0),
+				pauses(0),
+				depth(0) {
+	}
+
+	/**
+	 * \brief The number of connections accepted
+	 */
+	uint64_t connections;
+
+	/**
+	 * \brief The number of bytes read
+	 */
+	uint64_t bytes;
+
+	/**
+	 * \brief The number of messages handed to the callback
+	 */
+	uint64_t messages;
+
+	/**
+	 * \brief The number of messages that did not parse
+	 */
+	uint64_t errors;
+
+	/**
+	 * \brief The number of times reading was paused for backpressure
+	 */
+	uint64_t pauses;
+
+	/**
+	 * \brief The number of parsed messages waiting for the callback
+	 */
+	size_t depth;
+};
+
+/**
+ * \brief detectionformats ingest server class
+ *
+ * The detectionformats ingestserver class accepts newline delimited json
+ * detection format messages over Unix domain sockets and localhost TCP,
+ * parses them, and hands the results to a user callback.
+ *
+ * A single event loop thread, run(), reads every connection with epoll.
+ * Each read takes as much as is available, up to the read size, and every
+ * complete line in it is parsed straight out of the connection's buffer.
+ * The parsed messages are queued to callback threads, which validate them
+ * and call the callback.
+ *
+ * When the callbacks fall behind and the queue reaches its high water
+ * mark, the event loop stops reading until the queue drains below the low
+ * water mark.  Unread data then backs up in the socket buffers, so senders
+ * are slowed by the normal socket flow control rather than the server
+ * buffering without bound.  The event loop never waits on the queue; the
+ * messages of a read that finds it full are held in a small overflow, at
+ * most one read per connection, until there is room.
+ *
+ * Linux only.
+ */
+class ingestserver {
+public:
+	/**
+	 * \brief message callback type
+	 *
+	 * Called with each message's parseresult, and whether the message
+	 * parsed and passed isvalid().  Called from the callback threads, so
+	 * must be thread safe if there is more than one.
+	 */
+	typedef std::function<void(parseresult &result, bool valid)> callback;
+
+	/**
+	 * \brief ingestserver constructor
+	 *
+	 * The constructor for the ingestserver class.  Starts the callback
+	 * threads; call listenunix() and/or listentcp(), then run().
+	 * \param handler - The callback to hand messages to
+	 * \param queuecapacity - The most parsed messages to queue for the
+	 * callback before reading is paused
+	 * \param callbackthreads - The number of callback threads, at least 1
+	 */
+	explicit ingestserver(callback handler, size_t queuecapacity = 4096,
+			size_t callbackthreads = 1);
+
+	/**
+	 * \brief ingestserver destructor
+	 *
+	 * The destructor for the ingestserver class.  Closes every socket, and
+	 * waits for the callback threads to finish the messages already queued.
+	 * run() must have returned.
+	 */
+	~ingestserver();
+
+	/**
+	 * \brief Listen on a Unix domain socket
+	 *
+	 * Creates a stream socket at path.  A socket already at path is
+	 * replaced only if nothing is listening on it; a live server's socket,
+	 * or any other file, makes this throw std::runtime_error, as does any
+	 * other failure.
+	 * \param path - The socket path
+	 */
+	void listenunix(const std::string &path);
+
+	/**
+	 * \brief Listen on localhost TCP
+	 *
+	 * Listens on 127.0.0.1.  Throws std::runtime_error on failure.
+	 * \param port - The port to listen on, 0 to pick a free port
+	 * \return Returns the port listened on
+	 */
+	uint16_t listentcp(uint16_t port);
+
+	/**
+	 * \brief Run the event loop
+	 *
+	 * Accepts connections and reads messages until stop() is called.
+	 */
+	void run();
+
+	/**
+	 * \brief Stop the event loop
+	 *
+	 * Makes run() return.  May be called from any thread, including from
+	 * the callback.
+	 */
+	void stop();
+
+	/**
+	 * \brief Get the statistics
+	 *
+	 * \return Returns the server statistics
+	 */
+	ingeststatistics getstatistics() const;
+
+private:
+	/**
+	 * \brief A client connection
+	 */
+	struct connection {
+		int descriptor;
+		std::vector<char> buffer;
+		size_t used;
+	};
+
+	/**
+	 * \brief Accept pending connections on a listening socket
+	 *
+	 * \param listener - The listening socket
+	 */
+	void acceptconnections(int listener);
+
+	/**
+	 * \brief Read from a connection
+	 *
+	 * \param client - The connection to read
+	 * \return Returns false if the connection was closed
+	 */
+	bool readconnection(connection &client);
+
+	/**
+	 * \brief Parse and queue the complete lines in a buffer
+	 *
+	 * \param buffer - The buffered data
+	 * \param length - The number of buffered characters
+	 * \return Returns the number of characters consumed
+	 */
+	size_t processlines(const char *buffer, size_t length);
+
+	/**
+	 * \brief Parse and queue one message
+	 *
+	 * \param buffer - The message
+	 * \param length - The number of characters in the message
+	 */
+	void processmessage(const char *buffer, size_t length);
+
+	/**
+	 * \brief Move overflow messages to the queue while it has room
+	 */
+	void flushoverflow();
+
+	/**
+	 * \brief Check if the callbacks are behind
+	 *
+	 * \return Returns true if there is overflow or the queue is at its high
+	 * water mark
+	 */
+	bool isbehind() const;
+
+	/**
+	 * \brief Add a connection to epoll for reading
+	 *
+	 * \param descriptor - The connection's socket
+	 */
+	void watchconnection(int descriptor);
+
+	/**
+	 * \brief Close a connection
+	 *
+	 * \param client - The connection to close
+	 */
+	void closeconnection(connection &client);
+
+	/**
+	 * \brief Pause or resume reading every connection
+	 *
+	 * \param pause - True to stop reading, false to resume
+	 */
+	void setpaused(bool pause);
+
+	/**
+	 * \brief Callback thread function
+	 */
+	void callbackstage();
+
+	// disallow copying, the server owns its sockets and threads
+	ingestserver(const ingestserver &);
+	ingestserver & operator=(const ingestserver &);
+
+	/**
+	 * \brief The message callback
+	 */
+	callback handler;
+
+	/**
+	 * \brief Parsed messages waiting for the callback
+	 */
+	mpmcqueue<std::unique_ptr<parseresult>> parsedqueue;
+
+	/**
+	 * \brief Parsed messages read while the queue was full, in order, only
+	 * used by the event loop
+	 */
+	std::deque<std::unique_ptr<parseresult>> overflow;
+
+	/**
+	 * \brief The queue depth at which reading is paused
+	 */
+	size_t highwater;
+
+	/**
+	 * \brief The queue depth at which paused reading resumes
+	 */
+	size_t lowwater;
+
+	/**
+	 * \brief The epoll instance
+	 */
+	int epolldescriptor;
+
+	/**
+	 * \brief The eventfd used to wake the event loop for stop()
+	 */
+	int wakedescriptor;
+
+	/**
+	 * \brief The listening sockets
+	 */
+	std::vector<int> listeners;
+
+	/**
+	 * \brief The Unix domain socket paths, removed on destruction
+	 */
+	std::vector<std::string> socketpaths;
+
+	/**
+	 * \brief The open connections, keyed by descriptor
+	 */
+	std::vector<std::unique_ptr<connection>> connections;
+
+	/**
+	 * \brief Whether reading is paused for backpressure
+	 */
+	bool paused;
+
+	/**
+	 * \brief Set by stop()
+	 */
+	std::atomic<bool> stopping;
+
+	/**
+	 * \brief Set by the destructor to stop the callback threads once the
+	 * queue is empty
+	 */
+	std::atomic<bool> finished;
+
+	/**
+	 * \brief Statistics counters
+	 */
+	std::atomic<uint64_t> connectioncount;
+	std::atomic<uint64_t> bytecount;
+	std::atomic<uint64_t> messagecount;
+	std::atomic<uint64_t> errorcount;
+	std::atomic<uint64_t> pausecount;
+
+	/**
+	 * \brief The callback threads
+	 */
+	std::vector<std::thread> threads;
+};
+}
+#endif
+#endif
@@ -0,0 +1,221 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_MAPPEDARCHIVE_H
+#define DETECTION_MAPPEDARCHIVE_H
+
+#if !defined(_WIN32)
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pick.h"
+#include "correlation.h"
+#include "detection.h"
+#include "threadpool.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats archive range
+ *
+ * A range of a mapped archive holding only whole lines.
+ */
+struct archiverange {
+	/**
+	 * \brief The offset of the first character in the range
+	 */
+	uint64_t begin;
+
+	/**
+	 * \brief The offset one past the last character in the range
+	 */
+	uint64_t end;
+};
+
+/**
+ * \brief detectionformats archive contents
+ *
+ * The messages parsed from one range of a mapped archive.
+ */
+struct archivecontents {
+	/**
+	 * \brief archivecontents constructor
+	 */
+	archivecontents()
+			: lines(0),
+				errors(0),
+				others(0) {
+	}
+
+	/**
+	 * \brief The picks in the range, in archive order
+	 */
+	std::vector<pick> picks;
+
+	/**
+	 * \brief The correlations in the range, in archive order
+	 */
+	std::vector<correlation> correlations;
+
+	/**
+	 * \brief The detections in the range, in archive order
+	 */
+	std::vector<detection> detections;
+
+	/**
+	 * \brief The number of non blank lines in the range
+	 */
+	uint64_t lines;
+
+	/**
+	 * \brief The number of lines that did not parse
+	 */
+	uint64_t errors;
+
+	/**
+	 * \brief The number of messages of other types, which are not kept
+	 */
+	uint64_t others;
+};
+
+/**
+ * \brief detectionformats archive validation summary
+ */
+struct archivesummary {
+	/**
+	 * \brief archivesummary constructor
+	 */
+	archivesummary()
+			: lines(0),
+				errors(0),
+				invalid(0) {
+	}
+
+	/**
+	 * \brief The number of non blank lines in the archive
+	 */
+	uint64_t lines;
+
+	/**
+	 * \brief The number of lines that did not parse
+	 */
+	uint64_t errors;
+
+	/**
+	 * \brief The number of messages that parsed but failed isvalid()
+	 */
+	uint64_t invalid;
+
+	/**
+	 * \brief The offsets of the first lines that did not parse or failed
+	 * isvalid(), in archive order, at most 100
+	 */
+	std::vector<uint64_t> failures;
+};
+
+/**
+ * \brief detectionformats mapped archive class
+ *
+ * The detectionformats mappedarchive class maps a whole newline delimited
+ * json archive file into memory for batch tools that convert or validate
+ * entire archives.
+ *
+ * split() cuts the archive into ranges of whole lines by finding the
+ * newline after each evenly spaced offset, so splitting costs a line per
+ * range rather than a scan of the archive.  parse() and validate() then
+ * work through the ranges on a threadpool, each range with its own
+ * rapidjson document and output, so the threads share nothing while
+ * parsing.
+ *
+ * parse() keeps every pick, correlation, and detection, so is only
+ * suitable for archives that fit in memory once parsed; validate() keeps
+ * only counts, so works on archives of any size.
+ */
+class mappedarchive {
+public:
+	/**
+	 * \brief mappedarchive constructor
+	 *
+	 * Maps the archive read only.  Throws std::runtime_error if the file
+	 * cannot be opened or mapped.
+	 * \param path - The archive file path
+	 */
+	explicit mappedarchive(const std::string &path);
+
+	/**
+	 * \brief mappedarchive destructor
+	 */
+	~mappedarchive();
+
+	/**
+	 * \brief Get the archive data
+	 *
+	 * \return Returns the start of the mapped archive, NULL if it is empty
+	 */
+	const char *data() const;
+
+	/**
+	 * \brief Get the archive size
+	 *
+	 * \return Returns the size of the archive in bytes
+	 */
+	uint64_t size() const;
+
+	/**
+	 * \brief Split the archive
+	 *
+	 * Splits the archive into at most count ranges of whole lines, of
+	 * roughly equal size.  Ranges that would be empty, because a line is
+	 * longer than the spacing, are left out.
+	 * \param count - The number of ranges wanted, at least 1
+	 * \return Returns the ranges, in archive order, covering the archive
+	 */
+	std::vector<archiverange> split(size_t count) const;
+
+	/**
+	 * \brief Parse the archive
+	 *
+	 * Parses every line of the archive on pool.
+	 * \param pool - The threadpool to parse on
+	 * \param count - The number of ranges to split the archive into, 0 for
+	 * four per thread in pool
+	 * \return Returns the contents of each range, in archive order
+	 */
+	std::vector<archivecontents> parse(threadpool &pool,
+			size_t count = 0) const;
+
+	/**
+	 * \brief Validate the archive
+	 *
+	 * Parses every line of the archive on pool and checks each message with
+	 * isvalid(), keeping only counts.
+	 * \param pool - The threadpool to validate on
+	 * \param count - The number of ranges to split the archive into, 0 for
+	 * four per thread in pool
+	 * \return Returns the validation summary
+	 */
+	archivesummary validate(threadpool &pool, size_t count = 0) const;
+
+private:
+	// disallow copying, the archive owns its mapping
+	mappedarchive(const mappedarchive &);
+	mappedarchive & operator=(const mappedarchive &);
+
+	/**
+	 * \brief The mapped archive
+	 */
+	char *mapping;
+
+	/**
+	 * \brief The archive size in bytes
+	 */
+	uint64_t mappingsize;
+};
+}
+#endif
+#endif
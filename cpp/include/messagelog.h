@@ -0,0 +1,515 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_MESSAGELOG_H
+#define DETECTION_MESSAGELOG_H
+
+#if !defined(_WIN32)
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "correlation.h"
+#include "detection.h"
+#include "pick.h"
+#include "retract.h"
+#include "util.h"
+
+namespace detectionformats {
+
+/**
+ * \brief The encodings of the messages in a messagelog
+ */
+enum messagelogencoding {
+	jsonencoding = 0,
+	binaryencoding = 1
+};
+
+/**
+ * \brief detectionformats message log entry
+ *
+ * Where a message is in a messagelog, and what it is.
+ */
+struct messagelogentry {
+	/**
+	 * \brief messagelogentry constructor
+	 */
+	messagelogentry()
+			: segment(0),
+				offset(0),
+				length(0),
+				type(formattypes::unknown),
+				encoding(jsonencoding),
+				time(std::numeric_limits<double>::quiet_NaN()) {
+	}
+
+	/**
+	 * \brief The message id
+	 */
+	std::string id;
+
+	/**
+	 * \brief The number of the segment holding the message
+	 */
+	uint32_t segment;
+
+	/**
+	 * \brief The offset of the message in its segment
+	 */
+	uint64_t offset;
+
+	/**
+	 * \brief The number of characters in the message
+	 */
+	uint32_t length;
+
+	/**
+	 * \brief The message format type, one of the formattypes enum values
+	 */
+	int type;
+
+	/**
+	 * \brief The message encoding
+	 */
+	messagelogencoding encoding;
+
+	/**
+	 * \brief The message time, the pick or correlation time or the
+	 * detection's origin time, NaN if it has none
+	 */
+	double time;
+};
+
+/**
+ * \brief detectionformats message log index class
+ *
+ * The in memory index of a messagelog's entries, by id and by time.
+ */
+class messagelogindex {
+public:
+	/**
+	 * \brief Add an entry
+	 *
+	 * \param entry - The entry, after those already added
+	 */
+	void add(const messagelogentry &entry);
+
+	/**
+	 * \brief Find the messages with an id
+	 *
+	 * \param id - The message id
+	 * \param results - The vector to append the entries to, in the order
+	 * they were logged
+	 * \return Returns the number of entries appended
+	 */
+	size_t find(const std::string &id,
+			std::vector<messagelogentry> &results) const;
+
+	/**
+	 * \brief Find the messages with times in a range
+	 *
+	 * \param starttime - The earliest time
+	 * \param endtime - The latest time
+	 * \param results - The vector to append the entries with times in
+	 * [starttime, endtime] to, ordered by time
+	 * \return Returns the number of entries appended
+	 */
+	size_t within(double starttime, double endtime,
+			std::vector<messagelogentry> &results) const;
+
+	/**
+	 * \brief Get an entry
+	 *
+	 * \param position - The entry's position, in the order added
+	 * \return Returns the entry
+	 */
+	const messagelogentry & get(size_t position) const;
+
+	/**
+	 * \brief Get the number of entries
+	 *
+	 * \return Returns the number of entries
+	 */
+	size_t size() const;
+
+	/**
+	 * \brief Remove all entries
+	 */
+	void clear();
+
+private:
+	/**
+	 * \brief The entries, in the order added
+	 */
+	std::vector<messagelogentry> entries;
+
+	/**
+	 * \brief The positions of the entries with each id
+	 */
+	std::unordered_map<std::string, std::vector<size_t>> ids;
+
+	/**
+	 * \brief The positions of the entries with times, by time
+	 */
+	std::multimap<double, size_t> times;
+};
+
+/**
+ * \brief detectionformats message log class
+ *
+ * The detectionformats messagelog class appends messages to numbered
+ * segment files in a directory, rolling over to a new segment when one
+ * reaches its size limit, and indexes them by id and by time, so that
+ * finding a message is a lookup and reading it a single read rather than a
+ * scan of the archive.
+ *
+ * Each record in a segment holds the message's id, type, encoding and time
+ * ahead of the message and a checksum over all of them, so the index can
+ * be rebuilt from the segments alone.  Each segment has a sidecar index
+ * file, written when the segment is sealed, on sync() and when the log is
+ * closed, by writing a temporary file and renaming it over the old one.
+ * On opening, the sidecars are loaded and any records written after a
+ * sidecar are found by scanning from where it ends; a record left partly
+ * written by a crash fails its checksum and is cut off.
+ *
+ * Appends are written straight to the segment, so they survive the
+ * process exiting but only survive the system failing once sync() has
+ * returned.  Every method may be called on any thread.
+ */
+class messagelog {
+public:
+	/**
+	 * \brief messagelog constructor
+	 *
+	 * Opens the log in the directory, creating the directory if it does
+	 * not exist, recovering any messages appended after the last sidecar
+	 * index was written.  Throws std::runtime_error if the directory or a
+	 * segment cannot be opened.
+	 * \param newdirectory - The path to the log's directory
+	 * \param newsegmentsize - The size at which a segment is sealed
+	 * \param newencoding - The encoding of the messages appended as
+	 * objects
+	 */
+	explicit messagelog(const std::string &newdirectory,
+			uint64_t newsegmentsize = 64 * 1024 * 1024,
+			messagelogencoding newencoding = binaryencoding);
+
+	/**
+	 * \brief messagelog destructor
+	 *
+	 * Writes the active segment's sidecar index and closes the segments.
+	 */
+	~messagelog();
+
+	/**
+	 * \brief Append a pick, indexed by its id and time
+	 *
+	 * Throws std::runtime_error if the message cannot be written.
+	 * \param message - The pick
+	 * \return Returns the entry of the appended message
+	 */
+	messagelogentry append(const pick &message);
+
+	/**
+	 * \brief Append a correlation, indexed by its id and time
+	 *
+	 * \param message - The correlation
+	 * \return Returns the entry of the appended message
+	 */
+	messagelogentry append(const correlation &message);
+
+	/**
+	 * \brief Append a detection, indexed by its id and origin time
+	 *
+	 * \param message - The detection
+	 * \return Returns the entry of the appended message
+	 */
+	messagelogentry append(const detection &message);
+
+	/**
+	 * \brief Append a retract, indexed by its id
+	 *
+	 * \param message - The retract
+	 * \return Returns the entry of the appended message
+	 */
+	messagelogentry append(const retract &message);
+
+	/**
+	 * \brief Append an encoded message
+	 *
+	 * Throws std::invalid_argument if the id is too long, and
+	 * std::runtime_error if the message cannot be written.
+	 * \param type - The message format type, one of the formattypes enum
+	 * values
+	 * \param id - The id to index the message by
+	 * \param time - The time to index the message by, NaN for none
+	 * \param messageencoding - The message's encoding
+	 * \param message - A pointer to the encoded message
+	 * \param length - The number of characters in message
+	 * \return Returns the entry of the appended message
+	 */
+	messagelogentry append(int type, const std::string &id, double time,
+			messagelogencoding messageencoding, const char *message,
+			size_t length);
+
+	/**
+	 * \brief Make the appended messages durable
+	 *
+	 * Flushes the active segment to storage and writes its sidecar index.
+	 * Throws std::runtime_error if either fails.
+	 */
+	void sync();
+
+	/**
+	 * \brief Find the messages with an id
+	 *
+	 * \param id - The message id
+	 * \param results - The vector to append the entries to, in the order
+	 * they were logged
+	 * \return Returns the number of entries appended
+	 */
+	size_t find(const std::string &id,
+			std::vector<messagelogentry> &results) const;
+
+	/**
+	 * \brief Find the messages with times in a range
+	 *
+	 * \param starttime - The earliest time
+	 * \param endtime - The latest time
+	 * \param results - The vector to append the entries with times in
+	 * [starttime, endtime] to, ordered by time
+	 * \return Returns the number of entries appended
+	 */
+	size_t within(double starttime, double endtime,
+			std::vector<messagelogentry> &results) const;
+
+	/**
+	 * \brief Read a message
+	 *
+	 * \param entry - The message's entry
+	 * \param message - The std::string to assign the encoded message to
+	 * \return Returns false if the entry is not in the log or cannot be
+	 * read
+	 */
+	bool read(const messagelogentry &entry, std::string &message) const;
+
+	/**
+	 * \brief Get the number of messages
+	 *
+	 * \return Returns the number of messages in the log
+	 */
+	size_t size() const;
+
+	/**
+	 * \brief Get the number of segments
+	 *
+	 * \return Returns the number of segment files
+	 */
+	size_t getsegmentcount() const;
+
+	/**
+	 * \brief Get the number of characters cut off on opening
+	 *
+	 * \return Returns the number of characters of partly written records
+	 * removed from the end of the last segment when the log was opened
+	 */
+	uint64_t getdiscarded() const;
+
+private:
+	/**
+	 * \brief Start a new segment, the caller holding the mutex
+	 *
+	 * \param segment - The new segment's number
+	 */
+	void opensegment(uint32_t segment);
+
+	/**
+	 * \brief Flush the active segment and then write its sidecar index,
+	 * the caller holding the mutex
+	 */
+	void writesidecar();
+
+	/**
+	 * \brief Append an object's encoding
+	 *
+	 * \param object - The object
+	 * \param type - The object's format type
+	 * \param id - The object's id
+	 * \param time - The object's time
+	 * \return Returns the entry of the appended message
+	 */
+	template<class T>
+	messagelogentry appendobject(const T &object, int type,
+			const std::string &id, double time);
+
+	// disallow copying, the log owns its segment files
+	messagelog(const messagelog &);
+	messagelog & operator=(const messagelog &);
+
+	/**
+	 * \brief The log's directory
+	 */
+	std::string directory;
+
+	/**
+	 * \brief The size at which a segment is sealed
+	 */
+	uint64_t segmentsize;
+
+	/**
+	 * \brief The encoding of the messages appended as objects
+	 */
+	messagelogencoding encoding;
+
+	/**
+	 * \brief Guards the log
+	 */
+	mutable std::mutex mutex;
+
+	/**
+	 * \brief The index of every segment's messages
+	 */
+	messagelogindex index;
+
+	/**
+	 * \brief The open segment files, by segment number
+	 */
+	std::map<uint32_t, int> descriptors;
+
+	/**
+	 * \brief The number of the segment appended to
+	 */
+	uint32_t activesegment;
+
+	/**
+	 * \brief The size of the segment appended to
+	 */
+	uint64_t activesize;
+
+	/**
+	 * \brief The position in the index of the active segment's first
+	 * entry
+	 */
+	size_t activefirst;
+
+	/**
+	 * \brief The number of characters cut off on opening
+	 */
+	uint64_t discarded;
+
+	/**
+	 * \brief Reused for building records
+	 */
+	std::string record;
+};
+
+/**
+ * \brief detectionformats message log reader class
+ *
+ * The detectionformats messagelogreader class maps every segment of a
+ * messagelog into memory and indexes the messages in them, so that a found
+ * message is read in place, without copying.  It reads the log as it was
+ * when the reader was constructed, loading the sidecar indexes and
+ * scanning what they do not cover, and never writes to the log; a record
+ * that fails its checksum ends its segment.  Every method may be called on
+ * any thread.
+ */
+class messagelogreader {
+public:
+	/**
+	 * \brief messagelogreader constructor
+	 *
+	 * Throws std::runtime_error if the directory or a segment cannot be
+	 * opened or mapped.
+	 * \param directory - The path to the log's directory
+	 */
+	explicit messagelogreader(const std::string &directory);
+
+	/**
+	 * \brief messagelogreader destructor
+	 */
+	~messagelogreader();
+
+	/**
+	 * \brief Find the messages with an id
+	 *
+	 * \param id - The message id
+	 * \param results - The vector to append the entries to, in the order
+	 * they were logged
+	 * \return Returns the number of entries appended
+	 */
+	size_t find(const std::string &id,
+			std::vector<messagelogentry> &results) const;
+
+	/**
+	 * \brief Find the messages with times in a range
+	 *
+	 * \param starttime - The earliest time
+	 * \param endtime - The latest time
+	 * \param results - The vector to append the entries with times in
+	 * [starttime, endtime] to, ordered by time
+	 * \return Returns the number of entries appended
+	 */
+	size_t within(double starttime, double endtime,
+			std::vector<messagelogentry> &results) const;
+
+	/**
+	 * \brief Get a message in place
+	 *
+	 * \param entry - The message's entry
+	 * \param data - Set to the encoded message, valid for the reader's
+	 * lifetime
+	 * \param length - Set to the number of characters in the message
+	 * \return Returns false if the entry is not in the mapped segments
+	 */
+	bool get(const messagelogentry &entry, const char *&data,
+			size_t &length) const;
+
+	/**
+	 * \brief Get the number of messages
+	 *
+	 * \return Returns the number of messages read
+	 */
+	size_t size() const;
+
+private:
+	/**
+	 * \brief A mapped segment
+	 */
+	struct mapping {
+		/**
+		 * \brief The segment's characters, NULL if it is empty
+		 */
+		char *data;
+
+		/**
+		 * \brief The number of characters mapped
+		 */
+		uint64_t size;
+	};
+
+	// disallow copying, the reader owns its mappings
+	messagelogreader(const messagelogreader &);
+	messagelogreader & operator=(const messagelogreader &);
+
+	/**
+	 * \brief The index of every segment's messages
+	 */
+	messagelogindex index;
+
+	/**
+	 * \brief The mapped segments, by segment number
+	 */
+	std::map<uint32_t, mapping> mappings;
+};
+}
+#endif
+#endif
@@ -0,0 +1,161 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_PARSECONTEXT_H
+#define DETECTION_PARSECONTEXT_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats parse context class
+ *
+ * The detectionformats parsecontext class holds everything needed to parse
+ * and serialize messages: a rapidjson document, the pool its values are
+ * allocated from, the pool for the parser's stacks, and a reusable output
+ * buffer and writer.
+ *
+ * Both pools start from buffers owned by the context and are reset, not
+ * freed, between messages, so once the buffers have grown to the largest
+ * message seen, parsing and serializing allocate nothing.  A message too
+ * large for the current buffers spills into ordinary chunks, and the
+ * buffers are enlarged to fit it before the next message.
+ *
+ * A parsecontext is used by one thread at a time.  local() gives each
+ * thread its own, which the library uses wherever it previously made a
+ * document per call.  Any library call that parses may therefore overwrite
+ * the document of local(), so a caller holding a document across library
+ * calls should parse with its own parsecontext.
+ */
+class parsecontext {
+public:
+	/**
+	 * \brief The document type, a rapidjson::Document whose parse stack is
+	 * also taken from a pool
+	 */
+	typedef rapidjson::GenericDocument<rapidjson::UTF8<>,
+			rapidjson::MemoryPoolAllocator<>, rapidjson::MemoryPoolAllocator<>> document;
+
+	/**
+	 * \brief parsecontext constructor
+	 *
+	 * \param valuesize - The initial size of the value pool buffer
+	 * \param stacksize - The initial size of the stack pool buffer
+	 */
+	explicit parsecontext(size_t valuesize = 64 * 1024,
+			size_t stacksize = 16 * 1024);
+
+	/**
+	 * \brief parsecontext destructor
+	 */
+	~parsecontext();
+
+	/**
+	 * \brief Parse a message
+	 *
+	 * Parses buffer into the context's document, replacing whatever it
+	 * held.  The buffer does not need to be null terminated.
+	 * \param buffer - A pointer to the serialized json
+	 * \param length - The number of characters in buffer
+	 * \return Returns the document, check HasParseError() for failure
+	 */
+	document & parse(const char *buffer, size_t length);
+
+	/**
+	 * \brief Reset the document
+	 *
+	 * Empties the document and its pools, for building a new json value.
+	 * \return Returns the document
+	 */
+	document & reset();
+
+	/**
+	 * \brief Serialize a message
+	 *
+	 * Converts object to a json string using the context's document and
+	 * output buffer, replacing whatever the document held.
+	 * \param object - The message to serialize
+	 * \param json - The std::string to store the json in, reusing its
+	 * capacity
+	 */
+	void serialize(detectionbase &object, std::string &json);
+
+	/**
+	 * \brief Get the buffer size
+	 *
+	 * \return Returns the combined size of the value and stack pool
+	 * buffers, which grows to fit the largest message seen
+	 */
+	size_t capacity() const;
+
+	/**
+	 * \brief Get this thread's context
+	 *
+	 * The library parses with this context too, for example in
+	 * ParseMessage() batches, the readers and the servers, so its document
+	 * is only valid until the next library call on this thread.
+	 * \return Returns the parsecontext for the calling thread, created on
+	 * first use and destroyed when the thread exits
+	 */
+	static parsecontext & local();
+
+private:
+	/**
+	 * \brief Rebuild the pools and document
+	 *
+	 * Enlarges the buffers if the last message spilled out of them, and
+	 * empties the pools.
+	 */
+	void rebuild();
+
+	// disallow copying, the document points into the context's buffers
+	parsecontext(const parsecontext &);
+	parsecontext & operator=(const parsecontext &);
+
+	/**
+	 * \brief The buffer the value pool starts from
+	 */
+	std::vector<char> valuebuffer;
+
+	/**
+	 * \brief The buffer the stack pool starts from
+	 */
+	std::vector<char> stackbuffer;
+
+	/**
+	 * \brief The pool document values are allocated from
+	 */
+	std::unique_ptr<rapidjson::MemoryPoolAllocator<>> valueallocator;
+
+	/**
+	 * \brief The pool the parser stacks are allocated from
+	 */
+	std::unique_ptr<rapidjson::MemoryPoolAllocator<>> stackallocator;
+
+	/**
+	 * \brief The document
+	 */
+	std::unique_ptr<document> jsondocument;
+
+	/**
+	 * \brief The serialization output buffer
+	 */
+	rapidjson::StringBuffer output;
+
+	/**
+	 * \brief The serialization writer, whose nesting stack is kept
+	 */
+	rapidjson::Writer<rapidjson::StringBuffer> writer;
+};
+}
+#endif
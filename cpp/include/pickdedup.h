@@ -0,0 +1,258 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_PICKDEDUP_H
+#define DETECTION_PICKDEDUP_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pick.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats pick deduplication status enum
+ */
+enum pickdedupstatus {
+	uniquepick = 0,
+	duplicatepick = 1,
+	updatedpick = 2
+};
+
+/**
+ * \brief detectionformats pick deduplication metrics
+ */
+struct pickdedupmetrics {
+	/**
+	 * \brief pickdedupmetrics constructor
+	 */
+	pickdedupmetrics()
+			: picks(0),
+				unique(0),
+				duplicates(0),
+				repicks(0),
+				updates(0),
+				outliers(0) {
+	}
+
+	/**
+	 * \brief The number of picks checked
+	 */
+	uint64_t picks;
+
+	/**
+	 * \brief The number of picks not seen before
+	 */
+	uint64_t unique;
+
+	/**
+	 * \brief The number of picks identical to one seen with the same id
+	 */
+	uint64_t duplicates;
+
+	/**
+	 * \brief The number of picks with a new id matching one seen at the same
+	 * site and phase within the tolerance
+	 */
+	uint64_t repicks;
+
+	/**
+	 * \brief The number of picks changing one seen with the same id
+	 */
+	uint64_t updates;
+
+	/**
+	 * \brief The number of picks with times too far from the current
+	 * generations to move them
+	 */
+	uint64_t outliers;
+};
+
+/**
+ * \brief detectionformats pick deduplication class
+ *
+ * The detectionformats pickdedup class recognizes picks that have been seen
+ * before, either the same pick relayed again, or the same arrival picked
+ * again under a new id.
+ *
+ * A pick whose id has been seen is a duplicate if every field matches what
+ * was seen, otherwise it is an update.  A pick with a new id is also a
+ * duplicate if a pick at the same site with the same phase was seen within
+ * the tolerance of its time.
+ *
+ * Ids, and sites with phases and times bucketed by the tolerance, are kept
+ * as 64 bit hashes in open addressing tables, so a check makes no
+ * allocation.  Picks are forgotten between one and two expiry periods
+ * after they are seen, measured in pick time: the tables are kept in two
+ * generations, and the older is dropped whole each period.  A pick more
+ * than a period outside the two generations is more likely a bad time than
+ * the stream moving on, so it only moves the generations once several
+ * picks in a row agree with it.
+ *
+ * A pickdedup is used by one thread at a time.
+ */
+class pickdedup {
+public:
+	/**
+	 * \brief pickdedup constructor
+	 *
+	 * \param newexpiry - The least number of seconds of pick time a pick is
+	 * remembered for
+	 * \param newtolerance - The greatest number of seconds between the
+	 * times of picks that are the same arrival
+	 */
+	explicit pickdedup(double newexpiry = 600.0, double newtolerance = 0.5);
+
+	/**
+	 * \brief Check a pick
+	 *
+	 * Checks the pick against those seen, then remembers it.
+	 * \param newpick - The pick to check
+	 * \return Returns uniquepick, duplicatepick, or updatedpick
+	 */
+	pickdedupstatus check(const pick &newpick);
+
+	/**
+	 * \brief Forget every pick
+	 */
+	void clear();
+
+	/**
+	 * \brief Get the number of picks remembered
+	 *
+	 * \return Returns the number of ids remembered, an id in both
+	 * generations counting twice
+	 */
+	size_t size() const;
+
+	/**
+	 * \brief Get the metrics
+	 *
+	 * \return Returns the running counts of picks checked and of each
+	 * status
+	 */
+	pickdedupmetrics getmetrics() const;
+
+private:
+	/**
+	 * \brief An open addressing table from 64 bit hashes to 64 bit values
+	 */
+	struct table {
+		/**
+		 * \brief table constructor
+		 */
+		table();
+
+		/**
+		 * \brief Find a hash
+		 *
+		 * \param hash - The hash, which must not be 0
+		 * \param value - Set to the hash's value if it is found
+		 * \return Returns true if the hash was found
+		 */
+		bool find(uint64_t hash, uint64_t &value) const;
+
+		/**
+		 * \brief Add or replace a hash
+		 *
+		 * \param hash - The hash, which must not be 0
+		 * \param value - The hash's value
+		 */
+		void set(uint64_t hash, uint64_t value);
+
+		/**
+		 * \brief Remove every hash, keeping the storage
+		 */
+		void clear();
+
+		/**
+		 * \brief The hashes by slot, 0 where empty
+		 */
+		std::vector<uint64_t> hashes;
+
+		/**
+		 * \brief The values by slot
+		 */
+		std::vector<uint64_t> values;
+
+		/**
+		 * \brief The number of hashes held
+		 */
+		size_t count;
+	};
+
+	/**
+	 * \brief Check the proximity tables for a pick of the same arrival
+	 *
+	 * \param arrival - The hash of the pick's site and phase
+	 * \param time - The pick's time
+	 * \return Returns true if a pick within the tolerance was seen
+	 */
+	bool isrepick(uint64_t arrival, double time) const;
+
+	/**
+	 * \brief Remember a pick's time for its arrival
+	 *
+	 * \param arrival - The hash of the pick's site and phase
+	 * \param time - The pick's time
+	 */
+	void remember(uint64_t arrival, double time);
+
+	/**
+	 * \brief Start a new generation if the pick time has moved on a period
+	 *
+	 * \param time - The pick's time
+	 */
+	void rotate(double time);
+
+	/**
+	 * \brief The least number of seconds a pick is remembered for
+	 */
+	double expiry;
+
+	/**
+	 * \brief The number of seconds between picks of the same arrival
+	 */
+	double tolerance;
+
+	/**
+	 * \brief The pick time the current generation started at, NaN before
+	 * the first pick
+	 */
+	double generationstart;
+
+	/**
+	 * \brief The number of picks in a row with times too far from the
+	 * generations to move them
+	 */
+	size_t outlierpicks;
+
+	/**
+	 * \brief The content hashes of picks, by id hash, current then older
+	 * generation
+	 */
+	table ids[2];
+
+	/**
+	 * \brief The times of picks, by site, phase, and time bucket hash,
+	 * current then older generation
+	 */
+	table arrivals[2];
+
+	/**
+	 * \brief A reused buffer for encoding picks
+	 */
+	std::string buffer;
+
+	/**
+	 * \brief The running counts
+	 */
+	pickdedupmetrics metrics;
+};
+}
+#endif
@@ -0,0 +1,269 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_PICKWINDOW_H
+#define DETECTION_PICKWINDOW_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pick.h"
+#include "site.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats pick window class
+ *
+ * The detectionformats pickwindow class holds the picks of the most recent
+ * duration seconds, ordered by time, for an associator to search.
+ *
+ * Picks are kept in fixed size chunks, each holding its picks' times and
+ * interned site IDs in parallel arrays beside the picks themselves, so that
+ * range queries scan contiguous arrays and only touch the picks they
+ * return.  A pick arriving in time order is appended to the last chunk; one
+ * arriving out of order is placed by binary search, shifting at most one
+ * chunk.  Picks older than duration seconds before the newest are evicted
+ * from the front, a whole chunk at a time where possible, and evicted
+ * chunks are reused, along with the strings of the picks they held, so a
+ * window at steady state does little allocation.
+ *
+ * A pick more than duration seconds after the newest time seen is more
+ * likely a bad time than the stream moving on, and adding it would evict
+ * every pick and refuse those that follow, so it is refused unless several
+ * such picks arrive in a row.  A window following a clock can call
+ * expire() to move on without refusing any.
+ *
+ * A pickwindow is used by one thread at a time.
+ */
+class pickwindow {
+public:
+	/**
+	 * \brief pickwindow constructor
+	 *
+	 * \param newduration - The number of seconds of picks to hold
+	 */
+	explicit pickwindow(double newduration);
+
+	/**
+	 * \brief Add a pick
+	 *
+	 * Adds the pick in time order after any picks with the same time, and
+	 * evicts the picks that are then more than duration seconds older than
+	 * the newest.  The pick is not validated.
+	 * \param newpick - The pick to add
+	 * \return Returns false, without adding it, if the pick is already
+	 * older than the window, or is more than duration seconds after the
+	 * newest time seen and too few picks in a row have been
+	 */
+	bool add(const pick &newpick);
+
+	/**
+	 * \brief Evict old picks
+	 *
+	 * Evicts the picks more than duration seconds older than now, for
+	 * windows following a clock rather than the newest pick.  Picks up to
+	 * duration seconds after now are then accepted.
+	 * \param now - The current time
+	 * \return Returns the number of picks evicted
+	 */
+	size_t expire(double now);
+
+	/**
+	 * \brief Find the picks in a time range
+	 *
+	 * \param starttime - The earliest time
+	 * \param endtime - The latest time
+	 * \param results - The vector to append the picks with times in
+	 * [starttime, endtime] to, in time order, valid until the window is
+	 * next changed
+	 * \return Returns the number of picks appended
+	 */
+	size_t query(double starttime, double endtime,
+			std::vector<const pick *> &results) const;
+
+	/**
+	 * \brief Find a site's picks in a time range
+	 *
+	 * \param starttime - The earliest time
+	 * \param endtime - The latest time
+	 * \param picksite - The site to find picks for, matched on all four
+	 * codes
+	 * \param results - The vector to append the picks with times in
+	 * [starttime, endtime] to, in time order, valid until the window is
+	 * next changed
+	 * \return Returns the number of picks appended
+	 */
+	size_t query(double starttime, double endtime, const site &picksite,
+			std::vector<const pick *> &results) const;
+
+	/**
+	 * \brief Remove every pick
+	 */
+	void clear();
+
+	/**
+	 * \brief Get the number of picks
+	 *
+	 * \return Returns the number of picks held
+	 */
+	size_t size() const;
+
+	/**
+	 * \brief Get the duration
+	 *
+	 * \return Returns the number of seconds of picks held
+	 */
+	double getduration() const;
+
+	/**
+	 * \brief Get the oldest time
+	 *
+	 * \return Returns the time of the oldest pick held, NaN if there are
+	 * none
+	 */
+	double getoldest() const;
+
+	/**
+	 * \brief Get the newest time
+	 *
+	 * \return Returns the time of the newest pick held, NaN if there are
+	 * none
+	 */
+	double getnewest() const;
+
+private:
+	/**
+	 * \brief A run of picks in time order
+	 */
+	struct chunk {
+		/**
+		 * \brief chunk constructor
+		 */
+		chunk();
+
+		/**
+		 * \brief The slots in use, [begin, end)
+		 */
+		size_t begin;
+		size_t end;
+
+		/**
+		 * \brief Each pick's time, by slot
+		 */
+		std::vector<double> times;
+
+		/**
+		 * \brief Each pick's interned site ID, by slot
+		 */
+		std::vector<uint32_t> sites;
+
+		/**
+		 * \brief The picks, by slot, every slot holding a pick of its own
+		 * whether in use or not, so picks move between slots and chunks
+		 * by pointer and a reused slot's strings keep their storage
+		 */
+		std::vector<std::unique_ptr<pick>> picks;
+
+	private:
+		// disallow copying, the chunk owns its picks
+		chunk(const chunk &);
+		chunk & operator=(const chunk &);
+	};
+
+	/**
+	 * \brief Insert a pick into a chunk
+	 *
+	 * \param target - The chunk, which must have a free slot
+	 * \param position - The slot to insert at
+	 * \param newpick - The pick to insert
+	 * \param siteid - The pick's interned site ID
+	 */
+	void insert(chunk *target, size_t position, const pick &newpick,
+			uint32_t siteid);
+
+	/**
+	 * \brief Evict the picks older than a time
+	 *
+	 * \param cutoff - The oldest time to keep
+	 * \return Returns the number of picks evicted
+	 */
+	size_t evict(double cutoff);
+
+	/**
+	 * \brief Forget the sites of evicted picks, renumbering the rest
+	 */
+	void prunesites();
+
+	/**
+	 * \brief Get an empty chunk, reusing an evicted one if there is one
+	 */
+	std::unique_ptr<chunk> allocate();
+
+	/**
+	 * \brief Append the picks in a time range to results
+	 *
+	 * \param siteid - The interned site ID to match, or ANYSITE for any
+	 * site
+	 */
+	size_t collect(double starttime, double endtime, uint32_t siteid,
+			std::vector<const pick *> &results) const;
+
+	// disallow copying, the chunks are owned through unique pointers
+	pickwindow(const pickwindow &);
+	pickwindow & operator=(const pickwindow &);
+
+	/**
+	 * \brief The number of seconds of picks held
+	 */
+	double duration;
+
+	/**
+	 * \brief The oldest time still held, picks before it are refused
+	 */
+	double horizon;
+
+	/**
+	 * \brief The newest time added or expired to, NaN before the first
+	 */
+	double latest;
+
+	/**
+	 * \brief The number of picks in a row refused as too far after latest
+	 */
+	size_t outlierpicks;
+
+	/**
+	 * \brief The chunks in time order, none of them empty
+	 */
+	std::deque<std::unique_ptr<chunk>> chunks;
+
+	/**
+	 * \brief Evicted chunks kept for reuse
+	 */
+	std::vector<std::unique_ptr<chunk>> spares;
+
+	/**
+	 * \brief Each site's interned ID, by site key
+	 */
+	std::unordered_map<std::string, uint32_t> siteids;
+
+	/**
+	 * \brief A reused buffer for building site keys
+	 */
+	std::string keybuffer;
+
+	/**
+	 * \brief The number of picks held
+	 */
+	size_t count;
+};
+}
+#endif
@@ -0,0 +1,331 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_PIPELINE_H
+#define DETECTION_PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "batch.h"
+#include "queue.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats pipeline message
+ *
+ * A message as it moves through a pipeline, accumulating the output of
+ * each stage.
+ */
+struct pipelinemessage {
+	/**
+	 * \brief pipelinemessage constructor
+	 */
+	pipelinemessage()
+			: sequence(0),
+				valid(false) {
+	}
+
+	/**
+	 * \brief The order the message was pushed in, starting at 0
+	 */
+	uint64_t sequence;
+
+	/**
+	 * \brief When the message was pushed
+	 */
+	std::chrono::steady_clock::time_point received;
+
+	/**
+	 * \brief The serialized json message as pushed
+	 */
+	std::string raw;
+
+	/**
+	 * \brief The output of the parse stage
+	 */
+	parseresult result;
+
+	/**
+	 * \brief The output of the validate stage, true if the message parsed
+	 * and isvalid() returned true
+	 */
+	bool valid;
+
+	/**
+	 * \brief The output of the serialize stage, the parsed object written
+	 * back out as json, empty if the message did not parse
+	 */
+	std::string json;
+};
+
+/**
+ * \brief detectionformats pipeline stage metrics
+ */
+struct stagemetrics {
+	/**
+	 * \brief stagemetrics constructor
+	 */
+	stagemetrics()
+			: depth(0),
+				maxdepth(0),
+				processed(0) {
+	}
+
+	/**
+	 * \brief The number of messages waiting for the stage
+	 */
+	size_t depth;
+
+	/**
+	 * \brief The most messages seen waiting for the stage
+	 */
+	size_t maxdepth;
+
+	/**
+	 * \brief The number of messages the stage has completed
+	 */
+	uint64_t processed;
+};
+
+/**
+ * \brief detectionformats pipeline metrics
+ */
+struct pipelinemetrics {
+	/**
+	 * \brief The parse stage, depth is pushed messages not yet parsed
+	 */
+	stagemetrics parse;
+
+	/**
+	 * \brief The validate stage
+	 */
+	stagemetrics validate;
+
+	/**
+	 * \brief The serialize stage
+	 */
+	stagemetrics serialize;
+
+	/**
+	 * \brief The output, processed is messages popped
+	 */
+	stagemetrics output;
+};
+
+/**
+ * \brief detectionformats message pipeline class
+ *
+ * The detectionformats pipeline class is a reference parse, validate, and
+ * serialize pipeline.  Messages pushed by any number of reading threads are
+ * parsed by a pool of parse threads, validated by a pool of validate
+ * threads, and written back out to json by a serialize thread, and the
+ * finished messages are popped by a single consuming thread.
+ *
+ * Stages are connected by bounded lock free queues carrying message
+ * handles, so a message is never copied between stages.  A full queue
+ * makes the stage feeding it wait, which pushes back up to push().
+ *
+ * With more than one parse or validate thread messages can be finished out
+ * of order; use pipelinemessage::sequence to restore it.
+ */
+class pipeline {
+public:
+	/**
+	 * \brief message handle type
+	 */
+	typedef std::unique_ptr<pipelinemessage> handle;
+
+	/**
+	 * \brief pipeline constructor
+	 *
+	 * The constructor for the pipeline class.  Starts the stage threads.
+	 * \param queuecapacity - The capacity of each queue between stages
+	 * \param parsethreads - The number of parse threads, at least 1
+	 * \param validatethreads - The number of validate threads, at least 1
+	 */
+	explicit pipeline(size_t queuecapacity = 1024, size_t parsethreads = 1,
+			size_t validatethreads = 1);
+
+	/**
+	 * \brief pipeline destructor
+	 *
+	 * The destructor for the pipeline class.  Closes the pipeline and stops
+	 * the stage threads, discarding any messages that have not been popped.
+	 */
+	~pipeline();
+
+	/**
+	 * \brief Push a message
+	 *
+	 * Adds a serialized json message to the pipeline, waiting while the
+	 * parse queue is full.  May be called from any number of threads.
+	 * \param message - The serialized json message
+	 * \return Returns false if the pipeline has been closed
+	 */
+	bool push(std::string message);
+
+	/**
+	 * \brief Pop a finished message
+	 *
+	 * Waits for a message to finish the pipeline.  Must only be called from
+	 * one thread at a time.
+	 * \param message - Set to the finished message
+	 * \return Returns false once the pipeline is closed and every pushed
+	 * message has been popped
+	 */
+	bool pop(handle &message);
+
+	/**
+	 * \brief Close the pipeline
+	 *
+	 * Stops accepting pushes.  Messages already pushed continue through the
+	 * pipeline and can still be popped.
+	 */
+	void close();
+
+	/**
+	 * \brief Get the metrics
+	 *
+	 * \return Returns the current depth, maximum depth, and completed count
+	 * of each stage
+	 */
+	pipelinemetrics getmetrics() const;
+
+	/**
+	 * \brief stage counters
+	 *
+	 * The counters behind a stage's metrics, updated by the stage threads.
+	 */
+	struct stagecounters {
+		stagecounters()
+				: maxdepth(0),
+					processed(0) {
+		}
+
+		/**
+		 * \brief The most messages seen waiting for the stage
+		 */
+		std::atomic<size_t> maxdepth;
+
+		/**
+		 * \brief The number of messages the stage has completed
+		 */
+		std::atomic<uint64_t> processed;
+	};
+
+private:
+	/**
+	 * \brief Parse stage thread function
+	 */
+	void parsestage();
+
+	/**
+	 * \brief Validate stage thread function
+	 */
+	void validatestage();
+
+	/**
+	 * \brief Serialize stage thread function
+	 */
+	void serializestage();
+
+	// disallow copying, the pipeline owns its threads
+	pipeline(const pipeline &);
+	pipeline & operator=(const pipeline &);
+
+	/**
+	 * \brief Pushed messages waiting to be parsed
+	 */
+	mpmcqueue<handle> rawqueue;
+
+	/**
+	 * \brief Parsed messages waiting to be validated
+	 */
+	mpmcqueue<handle> parsedqueue;
+
+	/**
+	 * \brief Validated messages waiting to be serialized
+	 */
+	mpmcqueue<handle> validatedqueue;
+
+	/**
+	 * \brief Finished messages waiting to be popped
+	 */
+	spscqueue<handle> outputqueue;
+
+	/**
+	 * \brief Per stage counters
+	 */
+	stagecounters parsecounters;
+	stagecounters validatecounters;
+	stagecounters serializecounters;
+	stagecounters outputcounters;
+
+	/**
+	 * \brief The sequence number of the next pushed message
+	 */
+	std::atomic<uint64_t> nextsequence;
+
+	/**
+	 * \brief The number of push() calls in progress
+	 */
+	std::atomic<size_t> pushing;
+
+	/**
+	 * \brief Set by close(), rejects further pushes
+	 */
+	std::atomic<bool> closed;
+
+	/**
+	 * \brief Set once closed and no push is in progress
+	 */
+	std::atomic<bool> inputdone;
+
+	/**
+	 * \brief Set when the last parse thread exits
+	 */
+	std::atomic<bool> parsedone;
+
+	/**
+	 * \brief Set when the last validate thread exits
+	 */
+	std::atomic<bool> validatedone;
+
+	/**
+	 * \brief Set when the serialize thread exits
+	 */
+	std::atomic<bool> serializedone;
+
+	/**
+	 * \brief Set by the destructor, stages discard messages rather than
+	 * wait on a full queue
+	 */
+	std::atomic<bool> aborting;
+
+	/**
+	 * \brief The number of running parse threads
+	 */
+	std::atomic<size_t> parsersrunning;
+
+	/**
+	 * \brief The number of running validate threads
+	 */
+	std::atomic<size_t> validatorsrunning;
+
+	/**
+	 * \brief The stage threads
+	 */
+	std::vector<std::thread> threads;
+};
+}
+#endif
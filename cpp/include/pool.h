@@ -0,0 +1,239 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_POOL_H
+#define DETECTION_POOL_H
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "pick.h"
+#include "correlation.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats object pool class
+ *
+ * The detectionformats objectpool class hands out pre-constructed format
+ * objects so that a high rate parser can overwrite existing objects in place
+ * with resetfrom() instead of constructing new ones for every message.
+ *
+ * The pool keeps a json document backed by fixed buffers, so once the pool
+ * and the objects in it have grown to fit the incoming messages,
+ * acquire(jsonbuffer, length) performs no heap allocation.
+ *
+ * Objects are owned by the pool and remain valid for the lifetime of the
+ * pool.  objectpool is not thread safe, use one pool per parsing thread.
+ *
+ * T must provide resetfrom(rapidjson::Value &) and clear().
+ */
+template<class T>
+class objectpool {
+public:
+	/**
+	 * \brief objectpool constructor
+	 *
+	 * The constructor for the objectpool class.
+	 * \param initialsize - The number of objects to pre-construct
+	 * \param parsebuffersize - The number of bytes to reserve for parsing
+	 * json buffers, messages larger than this will allocate while parsing
+	 */
+	explicit objectpool(size_t initialsize = 0, size_t parsebuffersize =
+			65536)
+			: valuebuffer(parsebuffersize),
+				stackbuffer(parsebuffersize / 4),
+				valueallocator(valuebuffer.data(), valuebuffer.size(),
+						parsebuffersize, &baseallocator),
+				stackallocator(stackbuffer.data(), stackbuffer.size(),
+						parsebuffersize, &baseallocator),
+				jsondocument(&valueallocator, stackbuffer.size() / 2,
+						&stackallocator) {
+		grow(initialsize);
+	}
+
+	/**
+	 * \brief objectpool destructor
+	 *
+	 * The destructor for the objectpool class.  Destroys every object
+	 * constructed by the pool, whether or not it has been released.
+	 */
+	~objectpool() {
+	}
+
+	/**
+	 * \brief Acquire an object
+	 *
+	 * Takes an object from the pool, constructing a new one if the pool is
+	 * empty.  The object is returned with its members set to null values.
+	 * \return Returns a pointer to the object
+	 */
+	T * acquire() {
+		if (freeobjects.empty() == true) {
+			grow(objects.size() > 0 ? objects.size() : 1);
+		}
+
+		T * object = freeobjects.back();
+		freeobjects.pop_back();
+		return (object);
+	}
+
+	/**
+	 * \brief Acquire an object populated from json
+	 *
+	 * Takes an object from the pool and overwrites its members in place from
+	 * the provided json::Object.
+	 * \param json - A json object.
+	 * \return Returns a pointer to the object
+	 */
+	T * acquire(rapidjson::Value &json) {
+		T * object = acquire();
+		object->resetfrom(json);
+		return (object);
+	}
+
+	/**
+	 * \brief Acquire an object populated from a json buffer
+	 *
+	 * Parses the provided serialized json into the pool's buffered document
+	 * and overwrites the members of an object from the pool in place from
+	 * it.  Throws std::invalid_argument if the buffer does not parse.
+	 * \param jsonbuffer - A pointer to the serialized json
+	 * \param length - The number of characters in jsonbuffer
+	 * \return Returns a pointer to the object
+	 */
+	T * acquire(const char *jsonbuffer, size_t length) {
+		// reclaim the buffers used by the previous message; the document is
+		// overwritten by the parse so nothing still points into them
+		valueallocator.Clear();
+		stackallocator.Clear();
+
+		if (jsondocument.Parse(jsonbuffer, length).HasParseError()) {
+			throw std::invalid_argument(
+					"Error parsing JSON string into document.");
+		}
+		if (jsondocument.IsObject() == false) {
+			throw std::invalid_argument(
+					"JSON string did not parse into valid JSON.");
+		}
+
+		return (acquire(jsondocument));
+	}
+
+	/**
+	 * \brief Release an object
+	 *
+	 * Returns an object to the pool for reuse.  The object must have been
+	 * acquired from this pool, and must not be used after it is released.
+	 * \param object - A pointer to the object to release
+	 */
+	void release(T *object) {
+		if (object == NULL) {
+			return;
+		}
+
+		object->clear();
+
+		// capacity for every object was reserved in grow(), so this does not
+		// allocate
+		freeobjects.push_back(object);
+	}
+
+	/**
+	 * \brief Get the pool size
+	 *
+	 * \return Returns the total number of objects constructed by the pool
+	 */
+	size_t size() const {
+		return (objects.size());
+	}
+
+	/**
+	 * \brief Get the available count
+	 *
+	 * \return Returns the number of objects available to be acquired
+	 * without constructing new ones
+	 */
+	size_t available() const {
+		return (freeobjects.size());
+	}
+
+private:
+	/**
+	 * \brief Grow the pool
+	 *
+	 * Constructs count new objects and adds them to the pool
+	 * \param count - The number of objects to construct
+	 */
+	void grow(size_t count) {
+		objects.reserve(objects.size() + count);
+		freeobjects.reserve(objects.size() + count);
+
+		for (size_t i = 0; i < count; i++) {
+			objects.push_back(std::unique_ptr<T>(new T()));
+			freeobjects.push_back(objects.back().get());
+		}
+	}
+
+	// disallow copying, the pool owns its objects and buffers
+	objectpool(const objectpool &);
+	objectpool & operator=(const objectpool &);
+
+	/**
+	 * \brief The objects owned by this pool
+	 */
+	std::vector<std::unique_ptr<T>> objects;
+
+	/**
+	 * \brief The objects currently available to be acquired
+	 */
+	std::vector<T *> freeobjects;
+
+	/**
+	 * \brief Fixed buffer backing the parsed json values
+	 */
+	std::vector<char> valuebuffer;
+
+	/**
+	 * \brief Fixed buffer backing the json parse stack
+	 */
+	std::vector<char> stackbuffer;
+
+	/**
+	 * \brief Allocator used only when a message outgrows the fixed buffers
+	 */
+	rapidjson::CrtAllocator baseallocator;
+
+	/**
+	 * \brief Allocator for the parsed json values
+	 */
+	rapidjson::MemoryPoolAllocator<> valueallocator;
+
+	/**
+	 * \brief Allocator for the json parse stack
+	 */
+	rapidjson::MemoryPoolAllocator<> stackallocator;
+
+	/**
+	 * \brief The buffered document json buffers are parsed into
+	 */
+	rapidjson::GenericDocument<rapidjson::UTF8<>,
+			rapidjson::MemoryPoolAllocator<>,
+			rapidjson::MemoryPoolAllocator<>> jsondocument;
+};
+
+/**
+ * \brief detectionformats pick pool
+ */
+typedef objectpool<detectionformats::pick> pickpool;
+
+/**
+ * \brief detectionformats correlation pool
+ */
+typedef objectpool<detectionformats::correlation> correlationpool;
+}
+#endif
@@ -0,0 +1,373 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_QUEUE_H
+#define DETECTION_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// assumed cache line size, used to keep indices written by different
+// threads on different lines
+#define QUEUE_CACHELINE 64
+
+namespace detectionformats {
+
+/**
+ * \brief Round a queue capacity up to a power of two
+ *
+ * \param capacity - The requested capacity
+ * \return Returns the smallest power of two at least capacity, and at
+ * least 2
+ */
+inline size_t QueueCapacity(size_t capacity) {
+	size_t rounded = 2;
+	while (rounded < capacity) {
+		rounded *= 2;
+	}
+	return (rounded);
+}
+
+/**
+ * \brief detectionformats wait backoff class
+ *
+ * Used by a thread polling a lock free queue.  Spins briefly, then yields,
+ * then sleeps, so that a stage waiting on an idle queue does not hold a
+ * core while a busy one responds quickly.
+ */
+class backoff {
+public:
+	/**
+	 * \brief backoff constructor
+	 */
+	backoff()
+			: count(0) {
+	}
+
+	/**
+	 * \brief Wait before polling again
+	 */
+	void pause() {
+		if (count < 64) {
+			// spin
+		} else if (count < 128) {
+			std::this_thread::yield();
+		} else {
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+		count++;
+	}
+
+	/**
+	 * \brief Reset after making progress
+	 */
+	void reset() {
+		count = 0;
+	}
+
+private:
+	/**
+	 * \brief The number of times pause() was called since the last reset
+	 */
+	size_t count;
+};
+
+/**
+ * \brief detectionformats single producer single consumer queue class
+ *
+ * A bounded lock free ring buffer for passing elements from exactly one
+ * producing thread to exactly one consuming thread.  The capacity is
+ * rounded up to a power of two.
+ */
+template<class T>
+class spscqueue {
+public:
+	/**
+	 * \brief spscqueue constructor
+	 *
+	 * \param newcapacity - The maximum number of queued elements
+	 */
+	explicit spscqueue(size_t newcapacity)
+			: slots(QueueCapacity(newcapacity)),
+				mask(slots.size() - 1),
+				head(0),
+				cachedtail(0),
+				tail(0),
+				cachedhead(0) {
+	}
+
+	/**
+	 * \brief Add an element
+	 *
+	 * Called only from the producing thread.
+	 * \param element - The element to move into the queue
+	 * \return Returns false if the queue is full, in which case element is
+	 * unchanged
+	 */
+	bool trypush(T &&element) {
+		size_t position = tail.load(std::memory_order_relaxed);
+		if (position - cachedhead == slots.size()) {
+			cachedhead = head.load(std::memory_order_acquire);
+			if (position - cachedhead == slots.size()) {
+				return (false);
+			}
+		}
+
+		slots[position & mask] = std::move(element);
+		tail.store(position + 1, std::memory_order_release);
+		return (true);
+	}
+
+	/**
+	 * \brief Remove an element
+	 *
+	 * Called only from the consuming thread.
+	 * \param element - Set to the element removed
+	 * \return Returns false if the queue is empty
+	 */
+	bool trypop(T &element) {
+		size_t position = head.load(std::memory_order_relaxed);
+		if (position == cachedtail) {
+			cachedtail = tail.load(std::memory_order_acquire);
+			if (position == cachedtail) {
+				return (false);
+			}
+		}
+
+		element = std::move(slots[position & mask]);
+		head.store(position + 1, std::memory_order_release);
+		return (true);
+	}
+
+	/**
+	 * \brief Get the queue depth
+	 *
+	 * \return Returns the number of queued elements, which may be stale by
+	 * the time it is used if the other thread is active
+	 */
+	size_t size() const {
+		size_t position = head.load(std::memory_order_acquire);
+		return (tail.load(std::memory_order_acquire) - position);
+	}
+
+	/**
+	 * \brief Get the capacity
+	 *
+	 * \return Returns the maximum number of queued elements
+	 */
+	size_t capacity() const {
+		return (slots.size());
+	}
+
+private:
+	// disallow copying
+	spscqueue(const spscqueue &);
+	spscqueue & operator=(const spscqueue &);
+
+	/**
+	 * \brief The ring buffer
+	 */
+	std::vector<T> slots;
+
+	/**
+	 * \brief Index mask, capacity - 1
+	 */
+	size_t mask;
+
+	/**
+	 * \brief The next position to pop, written by the consumer
+	 */
+	std::atomic<size_t> head;
+
+	/**
+	 * \brief The consumer's last read of tail
+	 */
+	size_t cachedtail;
+
+	char consumerpadding[QUEUE_CACHELINE];
+
+	/**
+	 * \brief The next position to push, written by the producer
+	 */
+	std::atomic<size_t> tail;
+
+	/**
+	 * \brief The producer's last read of head
+	 */
+	size_t cachedhead;
+
+	char producerpadding[QUEUE_CACHELINE];
+};
+
+/**
+ * \brief detectionformats multiple producer multiple consumer queue class
+ *
+ * A bounded lock free ring buffer that any number of threads may push to
+ * and pop from.  Each slot carries a sequence number that tells producers
+ * and consumers whether it is free or full, so a push or pop only contends
+ * on a single index.  The capacity is rounded up to a power of two.
+ */
+template<class T>
+class mpmcqueue {
+public:
+	/**
+	 * \brief mpmcqueue constructor
+	 *
+	 * \param newcapacity - The maximum number of queued elements
+	 */
+	explicit mpmcqueue(size_t newcapacity)
+			: slotcount(QueueCapacity(newcapacity)),
+				mask(slotcount - 1),
+				slots(new slot[slotcount]),
+				pushposition(0),
+				popposition(0) {
+		for (size_t i = 0; i < slotcount; i++) {
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * \brief Add an element
+	 *
+	 * \param element - The element to move into the queue
+	 * \return Returns false if the queue is full, in which case element is
+	 * unchanged
+	 */
+	bool trypush(T &&element) {
+		size_t position = pushposition.load(std::memory_order_relaxed);
+		slot * target;
+		while (true) {
+			target = &slots[position & mask];
+			size_t sequence = target->sequence.load(std::memory_order_acquire);
+			intptr_t difference = static_cast<intptr_t>(sequence)
+					- static_cast<intptr_t>(position);
+
+			if (difference == 0) {
+				// the slot is free, claim it
+				if (pushposition.compare_exchange_weak(position, position + 1,
+						std::memory_order_relaxed) == true) {
+					break;
+				}
+			} else if (difference < 0) {
+				// the slot still holds an element from a lap ago, full
+				return (false);
+			} else {
+				// another producer claimed it, try the next
+				position = pushposition.load(std::memory_order_relaxed);
+			}
+		}
+
+		target->element = std::move(element);
+		target->sequence.store(position + 1, std::memory_order_release);
+		return (true);
+	}
+
+	/**
+	 * \brief Remove an element
+	 *
+	 * \param element - Set to the element removed
+	 * \return Returns false if the queue is empty
+	 */
+	bool trypop(T &element) {
+		size_t position = popposition.load(std::memory_order_relaxed);
+		slot * target;
+		while (true) {
+			target = &slots[position & mask];
+			size_t sequence = target->sequence.load(std::memory_order_acquire);
+			intptr_t difference = static_cast<intptr_t>(sequence)
+					- static_cast<intptr_t>(position + 1);
+
+			if (difference == 0) {
+				// the slot is full, claim it
+				if (popposition.compare_exchange_weak(position, position + 1,
+						std::memory_order_relaxed) == true) {
+					break;
+				}
+			} else if (difference < 0) {
+				// the slot has not been filled yet, empty
+				return (false);
+			} else {
+				// another consumer claimed it, try the next
+				position = popposition.load(std::memory_order_relaxed);
+			}
+		}
+
+		element = std::move(target->element);
+		target->sequence.store(position + mask + 1, std::memory_order_release);
+		return (true);
+	}
+
+	/**
+	 * \brief Get the queue depth
+	 *
+	 * \return Returns the approximate number of queued elements
+	 */
+	size_t size() const {
+		size_t popped = popposition.load(std::memory_order_acquire);
+		size_t pushed = pushposition.load(std::memory_order_acquire);
+		return ((pushed > popped) ? pushed - popped : 0);
+	}
+
+	/**
+	 * \brief Get the capacity
+	 *
+	 * \return Returns the maximum number of queued elements
+	 */
+	size_t capacity() const {
+		return (slotcount);
+	}
+
+private:
+	/**
+	 * \brief A queue slot
+	 */
+	struct slot {
+		std::atomic<size_t> sequence;
+		T element;
+	};
+
+	// disallow copying
+	mpmcqueue(const mpmcqueue &);
+	mpmcqueue & operator=(const mpmcqueue &);
+
+	/**
+	 * \brief The number of slots
+	 */
+	size_t slotcount;
+
+	/**
+	 * \brief Index mask, capacity - 1
+	 */
+	size_t mask;
+
+	/**
+	 * \brief The ring buffer
+	 */
+	std::unique_ptr<slot[]> slots;
+
+	char sharedpadding[QUEUE_CACHELINE];
+
+	/**
+	 * \brief The next position to push
+	 */
+	std::atomic<size_t> pushposition;
+
+	char pushpadding[QUEUE_CACHELINE];
+
+	/**
+	 * \brief The next position to pop
+	 */
+	std::atomic<size_t> popposition;
+
+	char poppadding[QUEUE_CACHELINE];
+};
+}
+#endif
@@ -0,0 +1,199 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_RETRACTIONINDEX_H
+#define DETECTION_RETRACTIONINDEX_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "retract.h"
+#include "source.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats retraction index class
+ *
+ * The detectionformats retractionindex class records the ids retracted by
+ * retract messages, with the source retracting each, and answers whether an
+ * id has been retracted.
+ *
+ * Nearly every id asked about has not been, so each lookup first checks a
+ * blocked Bloom filter: the id's bits all lie in one cache line, read with
+ * relaxed atomic loads and no lock, and an id whose bits are not all set is
+ * answered at once.  Only the ids that pass, the retracted ones and a small
+ * fraction of false positives, go on to the exact set under a mutex.
+ *
+ * Retractions are forgotten between one and two time to live periods after
+ * they are added.  The filters and sets are kept in two generations, each
+ * lookup checks both, and when a period has passed the older is cleared and
+ * becomes the newer.  The filters have a fixed size, chosen for the
+ * expected number of retractions in a generation; more than that raises the
+ * false positive rate but never gives a wrong answer.
+ *
+ * Lookups may run on any number of threads at once, along with one thread
+ * adding.
+ */
+class retractionindex {
+public:
+	/**
+	 * \brief The clock retractions are timed with
+	 */
+	typedef std::chrono::steady_clock clock;
+
+	/**
+	 * \brief retractionindex constructor
+	 *
+	 * \param expected - The number of retractions a generation is sized for
+	 * \param newtimetolive - How long a retraction is remembered at least
+	 */
+	explicit retractionindex(size_t expected = 1 << 20,
+			clock::duration newtimetolive = std::chrono::hours(24));
+
+	/**
+	 * \brief Add a retraction
+	 *
+	 * \param retraction - The retract message, which is not validated
+	 * \param now - The current time
+	 * \return Returns false if the retraction has no id or was already
+	 * recorded in the current generation
+	 */
+	bool add(const retract &retraction, clock::time_point now = clock::now());
+
+	/**
+	 * \brief Check if an id has been retracted by any source
+	 *
+	 * \param id - The id to check
+	 * \return Returns true if the id has been retracted
+	 */
+	bool isretracted(const std::string &id) const;
+
+	/**
+	 * \brief Check if an id has been retracted by a source
+	 *
+	 * \param id - The id to check
+	 * \param retractsource - The source, matched on agency id and author
+	 * \return Returns true if the id has been retracted by the source
+	 */
+	bool isretracted(const std::string &id,
+			const source &retractsource) const;
+
+	/**
+	 * \brief Forget old retractions
+	 *
+	 * Starts a new generation if a time to live has passed since the
+	 * current one started, forgetting the older.  Adding does this too.
+	 * \param now - The current time
+	 * \return Returns true if a generation was forgotten
+	 */
+	bool expire(clock::time_point now = clock::now());
+
+	/**
+	 * \brief Forget every retraction
+	 */
+	void clear();
+
+	/**
+	 * \brief Get the number of retractions
+	 *
+	 * \return Returns the number of retracted ids remembered, one in both
+	 * generations counting twice
+	 */
+	size_t size() const;
+
+private:
+	/**
+	 * \brief One generation's exact set, the sources retracting each id
+	 */
+	typedef std::unordered_map<std::string, std::vector<source>> retractionset;
+
+	/**
+	 * \brief Check the filters for an id
+	 *
+	 * \param hash - The id's hash
+	 * \return Returns false if the id has certainly not been retracted
+	 */
+	bool mayberetracted(uint64_t hash) const;
+
+	/**
+	 * \brief Set an id's bits in a filter
+	 *
+	 * \param generation - The filter to set, 0 or 1
+	 * \param hash - The id's hash
+	 */
+	void setbits(unsigned int generation, uint64_t hash);
+
+	/**
+	 * \brief Start a new generation, the caller holding the mutex
+	 *
+	 * \param now - The time the generation starts
+	 */
+	void rotate(clock::time_point now);
+
+	/**
+	 * \brief Empty a generation's filter and exact set, the caller holding
+	 * the mutex
+	 *
+	 * \param generation - The generation to empty, 0 or 1
+	 */
+	void cleargeneration(unsigned int generation);
+
+	// disallow copying, the filters are atomics
+	retractionindex(const retractionindex &);
+	retractionindex & operator=(const retractionindex &);
+
+	/**
+	 * \brief How long a retraction is remembered at least
+	 */
+	clock::duration timetolive;
+
+	/**
+	 * \brief When the current generation started
+	 */
+	clock::time_point generationstart;
+
+	/**
+	 * \brief The number of cache line blocks in each filter, a power of
+	 * two
+	 */
+	size_t blockcount;
+
+	/**
+	 * \brief The storage of the two generations' filters
+	 */
+	std::unique_ptr<std::atomic<uint64_t>[]> filterstorage[2];
+
+	/**
+	 * \brief The two generations' filters, each blockcount blocks of eight
+	 * words, aligned in their storage to cache lines
+	 */
+	std::atomic<uint64_t> *filters[2];
+
+	/**
+	 * \brief The two generations' exact sets
+	 */
+	retractionset sets[2];
+
+	/**
+	 * \brief Which generation is current, 0 or 1, lookups check both so
+	 * only adding needs it
+	 */
+	unsigned int current;
+
+	/**
+	 * \brief Guards the exact sets and the generations
+	 */
+	mutable std::mutex mutex;
+};
+}
+#endif
@@ -0,0 +1,261 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_SHARDEDPROCESSOR_H
+#define DETECTION_SHARDEDPROCESSOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pipeline.h"
+#include "queue.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats shard metrics
+ */
+struct shardmetrics {
+	/**
+	 * \brief shardmetrics constructor
+	 */
+	shardmetrics()
+			: cpu(-1),
+				node(-1),
+				depth(0),
+				maxdepth(0),
+				processed(0) {
+	}
+
+	/**
+	 * \brief The cpu the shard thread is pinned to, -1 if not pinned
+	 */
+	int cpu;
+
+	/**
+	 * \brief The NUMA node of that cpu, -1 if unknown
+	 */
+	int node;
+
+	/**
+	 * \brief The number of messages waiting for the shard
+	 */
+	size_t depth;
+
+	/**
+	 * \brief The most messages seen waiting for the shard
+	 */
+	size_t maxdepth;
+
+	/**
+	 * \brief The number of messages the shard has completed
+	 */
+	uint64_t processed;
+};
+
+/**
+ * \brief detectionformats sharded processor metrics
+ */
+struct shardedmetrics {
+	/**
+	 * \brief shardedmetrics constructor
+	 */
+	shardedmetrics()
+			: imbalance(0) {
+	}
+
+	/**
+	 * \brief Each shard's metrics
+	 */
+	std::vector<shardmetrics> shards;
+
+	/**
+	 * \brief The busiest shard's processed count over the mean, 1 when
+	 * the load is even, 0 before anything is processed
+	 */
+	double imbalance;
+};
+
+/**
+ * \brief detectionformats sharded message processor class
+ *
+ * The detectionformats shardedprocessor class parses and validates
+ * messages on a fixed set of shard threads, sending every message for a
+ * site to the same shard, so that messages for one station are handled in
+ * the order they were pushed while different stations are spread across
+ * the cores.
+ *
+ * A message's shard is chosen from its top level Site, read with a
+ * rapidjson SAX pass that stops at the end of the Site object, or from its
+ * ID if it has no Site, such as a detection or retract.
+ *
+ * Each shard thread is pinned to its own allowed cpu.  The shard's parse
+ * buffers are its thread's parsecontext, created after pinning, so first
+ * touch places them on the memory node local to that cpu.  Finished
+ * messages are passed to the handler on the shard thread.
+ *
+ * Per station ordering holds for messages pushed from one thread; pushes
+ * racing from several threads are ordered however they land.
+ */
+class shardedprocessor {
+public:
+	/**
+	 * \brief message handler type, called on the shard thread with each
+	 * parsed and validated message, must not throw
+	 */
+	typedef std::function<void(pipelinemessage &)> handler;
+
+	/**
+	 * \brief shardedprocessor constructor
+	 *
+	 * Starts the shard threads.
+	 * \param newhandler - The handler for finished messages
+	 * \param shardcount - The number of shards, 0 for one per allowed cpu
+	 * \param queuecapacity - The capacity of each shard's queue
+	 * \param pin - Whether to pin each shard thread to a cpu
+	 */
+	explicit shardedprocessor(handler newhandler, size_t shardcount = 0,
+			size_t queuecapacity = 1024, bool pin = true);
+
+	/**
+	 * \brief shardedprocessor destructor
+	 *
+	 * Closes the processor, waiting for the messages already pushed.
+	 */
+	~shardedprocessor();
+
+	/**
+	 * \brief Push a message
+	 *
+	 * Queues a serialized json message on its shard, waiting while that
+	 * shard's queue is full.  May be called from any number of threads.
+	 * \param message - The serialized json message
+	 * \return Returns false if the processor has been closed
+	 */
+	bool push(std::string message);
+
+	/**
+	 * \brief Get a message's shard
+	 *
+	 * \param message - The serialized json message
+	 * \return Returns the index of the shard that handles message
+	 */
+	size_t getshard(const std::string &message) const;
+
+	/**
+	 * \brief Close the processor
+	 *
+	 * Stops accepting pushes and waits for the shards to finish the
+	 * messages already pushed.
+	 */
+	void close();
+
+	/**
+	 * \brief Get the number of shards
+	 *
+	 * \return Returns the number of shards
+	 */
+	size_t getshardcount() const;
+
+	/**
+	 * \brief Get the metrics
+	 *
+	 * \return Returns the load on each shard, and how uneven it is
+	 */
+	shardedmetrics getmetrics() const;
+
+private:
+	/**
+	 * \brief One shard's queue, thread, and counters
+	 */
+	struct shard {
+		explicit shard(size_t queuecapacity)
+				: queue(queuecapacity),
+					cpu(-1),
+					node(-1),
+					maxdepth(0),
+					processed(0) {
+		}
+
+		/**
+		 * \brief Messages waiting for the shard
+		 */
+		mpmcqueue<pipeline::handle> queue;
+
+		/**
+		 * \brief The cpu to pin to, -1 for none
+		 */
+		int cpu;
+
+		/**
+		 * \brief The NUMA node the thread found itself on
+		 */
+		std::atomic<int> node;
+
+		/**
+		 * \brief The most messages seen waiting
+		 */
+		std::atomic<size_t> maxdepth;
+
+		/**
+		 * \brief The number of messages completed
+		 */
+		std::atomic<uint64_t> processed;
+
+		/**
+		 * \brief The shard thread
+		 */
+		std::thread thread;
+	};
+
+	/**
+	 * \brief Shard thread function
+	 *
+	 * \param worker - The shard to run
+	 */
+	void run(shard &worker);
+
+	// disallow copying, the processor owns its threads
+	shardedprocessor(const shardedprocessor &);
+	shardedprocessor & operator=(const shardedprocessor &);
+
+	/**
+	 * \brief The message handler
+	 */
+	handler messagehandler;
+
+	/**
+	 * \brief The shards
+	 */
+	std::vector<std::unique_ptr<shard>> shards;
+
+	/**
+	 * \brief The sequence number of the next pushed message
+	 */
+	std::atomic<uint64_t> nextsequence;
+
+	/**
+	 * \brief The number of push() calls in progress
+	 */
+	std::atomic<size_t> pushing;
+
+	/**
+	 * \brief Set by close(), rejects further pushes
+	 */
+	std::atomic<bool> closed;
+
+	/**
+	 * \brief Set once closed and no push is in progress
+	 */
+	std::atomic<bool> inputdone;
+};
+}
+#endif
@@ -0,0 +1,547 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_SHAREDVECTOR_H
+#define DETECTION_SHAREDVECTOR_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats copy on write vector class
+ *
+ * The detectionformats sharedvector class is a vector of reference counted
+ * elements.  Copying a sharedvector copies the element handles rather than
+ * the elements, so successive versions of a message, or several messages
+ * referencing the same data, share a single copy of each element.
+ *
+ * An element is copied (detached) the first time it is accessed through a
+ * non-const accessor (operator[], at(), front(), back() or a dereferenced
+ * iterator) while it is shared, so modifying one sharedvector never changes
+ * the contents of another.  Note that this includes reads through a
+ * non-const sharedvector; use a const reference, cbegin()/cend(), or
+ * shared() to read without copying.  Detaching is the only way to get a
+ * writable element: the handles shared between sharedvectors are read
+ * only.
+ *
+ * The reference counts are thread safe, but as with std::vector a single
+ * sharedvector must not be modified while another thread is using it.
+ */
+template<class T>
+class sharedvector {
+public:
+	/**
+	 * \brief element handle type
+	 *
+	 * A reference counted, read only handle to a single element, used to
+	 * share an element between sharedvectors without copying it.
+	 */
+	typedef std::shared_ptr<const T> handle;
+
+	/**
+	 * \brief sharedvector iterator class
+	 *
+	 * A random access iterator over the elements of a sharedvector.  The
+	 * writable iterator detaches an element when it is dereferenced, the
+	 * read only iterator never does.
+	 */
+	template<bool writable>
+	class basic_iterator {
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef T value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef typename std::conditional<writable, T *, const T *>::type
+				pointer;
+		typedef typename std::conditional<writable, T &, const T &>::type
+				reference;
+		typedef typename std::conditional<writable,
+				typename std::vector<handle>::iterator,
+				typename std::vector<handle>::const_iterator>::type position;
+
+		basic_iterator() {
+		}
+		explicit basic_iterator(position newcurrent)
+				: current(newcurrent) {
+		}
+		// writable iterators convert to read only ones
+		template<bool otherwritable>
+		basic_iterator(const basic_iterator<otherwritable> &other)
+				: current(other.getposition()) {
+		}
+
+		reference operator*() const {
+			return (access(*current));
+		}
+		pointer operator->() const {
+			return (&**this);
+		}
+		reference operator[](difference_type offset) const {
+			return (*(*this + offset));
+		}
+
+		basic_iterator & operator++() {
+			++current;
+			return (*this);
+		}
+		basic_iterator operator++(int) {
+			basic_iterator previous(*this);
+			++current;
+			return (previous);
+		}
+		basic_iterator & operator--() {
+			--current;
+			return (*this);
+		}
+		basic_iterator operator--(int) {
+			basic_iterator previous(*this);
+			--current;
+			return (previous);
+		}
+		basic_iterator & operator+=(difference_type offset) {
+			current += offset;
+			return (*this);
+		}
+		basic_iterator & operator-=(difference_type offset) {
+			current -= offset;
+			return (*this);
+		}
+		basic_iterator operator+(difference_type offset) const {
+			return (basic_iterator(current + offset));
+		}
+		basic_iterator operator-(difference_type offset) const {
+			return (basic_iterator(current - offset));
+		}
+		difference_type operator-(const basic_iterator &other) const {
+			return (current - other.current);
+		}
+
+		bool operator==(const basic_iterator &other) const {
+			return (current == other.current);
+		}
+		bool operator!=(const basic_iterator &other) const {
+			return (current != other.current);
+		}
+		bool operator<(const basic_iterator &other) const {
+			return (current < other.current);
+		}
+		bool operator>(const basic_iterator &other) const {
+			return (current > other.current);
+		}
+		bool operator<=(const basic_iterator &other) const {
+			return (current <= other.current);
+		}
+		bool operator>=(const basic_iterator &other) const {
+			return (current >= other.current);
+		}
+
+		/**
+		 * \brief Get the underlying handle position
+		 */
+		position getposition() const {
+			return (current);
+		}
+
+	private:
+		static T & access(handle &element) {
+			return (detach(element));
+		}
+		static const T & access(const handle &element) {
+			return (*element);
+		}
+
+		position current;
+	};
+
+	/**
+	 * \brief writable iterator type
+	 */
+	typedef basic_iterator<true> iterator;
+
+	/**
+	 * \brief read only iterator type
+	 */
+	typedef basic_iterator<false> const_iterator;
+
+	/**
+	 * \brief element type
+	 */
+	typedef T value_type;
+
+	/**
+	 * \brief sharedvector constructor
+	 *
+	 * The constructor for the sharedvector class.
+	 * Initilizes to an empty vector.
+	 */
+	sharedvector() {
+	}
+
+	/**
+	 * \brief sharedvector vector constructor
+	 *
+	 * Copies each element of the provided vector into its own shared handle.
+	 * \param newdata - A std::vector<T> containing the elements to copy
+	 */
+	sharedvector(const std::vector<T> &newdata) {
+		elements.reserve(newdata.size());
+		for (size_t i = 0; i < newdata.size(); i++) {
+			elements.push_back(std::make_shared<T>(newdata[i]));
+		}
+	}
+
+	/**
+	 * \brief Get the number of elements
+	 *
+	 * \return Returns the number of elements in the vector
+	 */
+	size_t size() const {
+		return (elements.size());
+	}
+
+	/**
+	 * \brief Check if empty
+	 *
+	 * \return Returns true if the vector has no elements
+	 */
+	bool empty() const {
+		return (elements.empty());
+	}
+
+	/**
+	 * \brief Remove all elements
+	 *
+	 * Releases this vector's references to its elements, elements still
+	 * referenced elsewhere are not destroyed.
+	 */
+	void clear() {
+		elements.clear();
+	}
+
+	/**
+	 * \brief Reserve capacity
+	 *
+	 * \param count - The number of element handles to reserve space for
+	 */
+	void reserve(size_t count) {
+		elements.reserve(count);
+	}
+
+	/**
+	 * \brief Add a copy of an element
+	 *
+	 * \param element - The element to copy onto the end of the vector
+	 */
+	void push_back(const T &element) {
+		elements.push_back(std::make_shared<T>(element));
+	}
+
+	/**
+	 * \brief Add an element by handle
+	 *
+	 * Adds an already shared element without copying it.  The element is
+	 * copied before it is first written through this vector, unless this
+	 * vector holds the only handle to it; a handle made by std::make_shared
+	 * with a const T must not be added.
+	 * \param element - The handle to add to the end of the vector
+	 */
+	void push_back(const handle &element) {
+		elements.push_back(element);
+	}
+
+	/**
+	 * \brief Construct an element in place
+	 *
+	 * Constructs a new element from the provided arguments on the end of the
+	 * vector.
+	 * \param args - The arguments to pass to the element constructor
+	 * \return Returns a reference to the new element
+	 */
+	template<class ... Args>
+	T & emplace_back(Args && ... args) {
+		std::shared_ptr<T> element = std::make_shared<T>(
+				std::forward<Args>(args)...);
+		elements.push_back(element);
+		return (*element);
+	}
+
+	/**
+	 * \brief Insert a copy of an element
+	 *
+	 * \param position - The position to insert before
+	 * \param element - The element to copy into the vector
+	 * \return Returns an iterator to the new element
+	 */
+	iterator insert(const_iterator position, const T &element) {
+		return (insert(position, std::make_shared<T>(element)));
+	}
+
+	/**
+	 * \brief Insert an element by handle
+	 *
+	 * Inserts an already shared element without copying it.
+	 * \param position - The position to insert before
+	 * \param element - The handle to insert
+	 * \return Returns an iterator to the new element
+	 */
+	iterator insert(const_iterator position, const handle &element) {
+		return (iterator(elements.insert(position.getposition(), element)));
+	}
+
+	/**
+	 * \brief Remove an element
+	 *
+	 * \param position - The position of the element to remove
+	 * \return Returns an iterator to the element after the removed one
+	 */
+	iterator erase(const_iterator position) {
+		return (iterator(elements.erase(position.getposition())));
+	}
+
+	/**
+	 * \brief Remove a range of elements
+	 *
+	 * \param first - The position of the first element to remove
+	 * \param last - The position after the last element to remove
+	 * \return Returns an iterator to the element after the removed ones
+	 */
+	iterator erase(const_iterator first, const_iterator last) {
+		return (iterator(
+				elements.erase(first.getposition(), last.getposition())));
+	}
+
+	/**
+	 * \brief Remove the last element
+	 */
+	void pop_back() {
+		elements.pop_back();
+	}
+
+	/**
+	 * \brief Change the number of elements
+	 *
+	 * Removes elements from the end, or adds default constructed elements.
+	 * \param count - The new number of elements
+	 */
+	void resize(size_t count) {
+		resize(count, T());
+	}
+
+	/**
+	 * \brief Change the number of elements
+	 *
+	 * Removes elements from the end, or adds copies of the provided element.
+	 * \param count - The new number of elements
+	 * \param element - The element to copy into each added position
+	 */
+	void resize(size_t count, const T &element) {
+		if (count < elements.size()) {
+			elements.resize(count);
+			return;
+		}
+		elements.reserve(count);
+		while (elements.size() < count) {
+			elements.push_back(std::make_shared<T>(element));
+		}
+	}
+
+	/**
+	 * \brief Get the reserved capacity
+	 *
+	 * \return Returns the number of element handles space is reserved for
+	 */
+	size_t capacity() const {
+		return (elements.capacity());
+	}
+
+	/**
+	 * \brief Exchange contents
+	 *
+	 * \param other - The sharedvector to exchange elements with
+	 */
+	void swap(sharedvector &other) {
+		elements.swap(other.elements);
+	}
+
+	/**
+	 * \brief Get a writable iterator to the first element
+	 */
+	iterator begin() {
+		return (iterator(elements.begin()));
+	}
+
+	/**
+	 * \brief Get a writable iterator past the last element
+	 */
+	iterator end() {
+		return (iterator(elements.end()));
+	}
+
+	/**
+	 * \brief Get a read only iterator to the first element
+	 */
+	const_iterator begin() const {
+		return (const_iterator(elements.begin()));
+	}
+
+	/**
+	 * \brief Get a read only iterator past the last element
+	 */
+	const_iterator end() const {
+		return (const_iterator(elements.end()));
+	}
+
+	/**
+	 * \brief Get a read only iterator to the first element
+	 */
+	const_iterator cbegin() const {
+		return (const_iterator(elements.begin()));
+	}
+
+	/**
+	 * \brief Get a read only iterator past the last element
+	 */
+	const_iterator cend() const {
+		return (const_iterator(elements.end()));
+	}
+
+	/**
+	 * \brief Read only element access
+	 *
+	 * \param index - The index of the element
+	 * \return Returns a const reference to the element
+	 */
+	const T & operator[](size_t index) const {
+		return (*elements[index]);
+	}
+
+	/**
+	 * \brief Writable element access
+	 *
+	 * Copies the element first if it is shared with another sharedvector,
+	 * so that changes are only seen through this vector.
+	 * \param index - The index of the element
+	 * \return Returns a reference to the element
+	 */
+	T & operator[](size_t index) {
+		return (detach(elements[index]));
+	}
+
+	/**
+	 * \brief Bounds checked read only element access
+	 *
+	 * \param index - The index of the element
+	 * \return Returns a const reference to the element
+	 * \throw Throws std::out_of_range if index is past the end
+	 */
+	const T & at(size_t index) const {
+		return (*elements.at(index));
+	}
+
+	/**
+	 * \brief Bounds checked writable element access
+	 *
+	 * Copies the element first if it is shared.
+	 * \param index - The index of the element
+	 * \return Returns a reference to the element
+	 * \throw Throws std::out_of_range if index is past the end
+	 */
+	T & at(size_t index) {
+		return (detach(elements.at(index)));
+	}
+
+	/**
+	 * \brief Read only first element access
+	 */
+	const T & front() const {
+		return (*elements.front());
+	}
+
+	/**
+	 * \brief Writable first element access, copies the element if shared
+	 */
+	T & front() {
+		return (detach(elements.front()));
+	}
+
+	/**
+	 * \brief Read only last element access
+	 */
+	const T & back() const {
+		return (*elements.back());
+	}
+
+	/**
+	 * \brief Writable last element access, copies the element if shared
+	 */
+	T & back() {
+		return (detach(elements.back()));
+	}
+
+	/**
+	 * \brief Shared element access
+	 *
+	 * Reads an element of a writable sharedvector without copying it, even
+	 * if it is shared.
+	 * \param index - The index of the element
+	 * \return Returns a const reference to the shared element
+	 */
+	const T & shared(size_t index) const {
+		return (*elements[index]);
+	}
+
+	/**
+	 * \brief Get an element handle
+	 *
+	 * \param index - The index of the element
+	 * \return Returns the handle to the element, for adding to another
+	 * sharedvector without copying
+	 */
+	const handle & gethandle(size_t index) const {
+		return (elements[index]);
+	}
+
+	/**
+	 * \brief Check if an element is shared
+	 *
+	 * \param index - The index of the element
+	 * \return Returns true if the element is referenced by more than one
+	 * handle
+	 */
+	bool isshared(size_t index) const {
+		return (elements[index].use_count() > 1);
+	}
+
+private:
+	/**
+	 * \brief Detach an element
+	 *
+	 * Replaces a shared element with a private copy.  Every element this
+	 * vector creates is a non-const T, and one held by a single handle is
+	 * written in place.
+	 * \param element - The handle of the element
+	 * \return Returns a writable reference to the element
+	 */
+	static T & detach(handle &element) {
+		if (element.use_count() > 1) {
+			element = std::make_shared<T>(*element);
+		}
+		return (const_cast<T &>(*element));
+	}
+
+	/**
+	 * \brief The element handles
+	 */
+	std::vector<handle> elements;
+};
+}
+#endif
@@ -0,0 +1,298 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_SHMRING_H
+#define DETECTION_SHMRING_H
+
+#if defined(__linux__)
+
+#include <cstdint>
+#include <string>
+
+#include "batch.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats shared memory ring class
+ *
+ * The detectionformats shmring class carries detection format messages
+ * between processes on the same host through a ring buffer in POSIX shared
+ * memory, so that messages are copied once into the ring and once out of
+ * it rather than through the kernel socket buffers.
+ *
+ * One process creates the ring by name and the others open it.  Any number
+ * of threads in any number of processes may push, each message either as
+ * json or in the compact binary encoding of its class.  Producers claim
+ * space with a compare and swap on the shared tail, copy the message in,
+ * then mark it committed, so producers never block each other while
+ * copying.  A single reader, in one process, pops the messages in the
+ * order their space was claimed and gets each back parsed into a
+ * parseresult.
+ *
+ * Waiting is done with futexes on counters in the shared memory: a reader
+ * finding the ring empty sleeps until a producer commits, and producers
+ * finding it full sleep until the reader frees space.  Neither side makes
+ * a system call while the other is not waiting.
+ *
+ * A record is only visible to the reader once its producer commits it, and
+ * the reader pops in claim order.  A producer that dies between claiming
+ * space and committing leaves a record that is never committed, so the
+ * reader stalls at it forever and the ring must be recreated.
+ *
+ * A shmring object is used by one thread at a time; threads that push
+ * concurrently each open their own shmring on the ring's name.  The binary
+ * encoding is only for exchange between programs built with the same
+ * version of this library.  Linux only.
+ */
+class shmring {
+public:
+	/**
+	 * \brief shmring create constructor
+	 *
+	 * Creates a ring in shared memory.  The name is removed again when this
+	 * shmring is destroyed.  Throws std::runtime_error on failure, including
+	 * when the name already exists, unless replacestale is set and the name
+	 * holds a ring whose creating process has exited.
+	 * \param name - The shared memory name, such as "/detections"
+	 * \param capacity - The ring size in bytes, rounded up to a power of two,
+	 * at most 1 GB
+	 * \param replacestale - Whether to replace a ring left behind by a
+	 * process that exited without destroying it
+	 */
+	shmring(const std::string &name, size_t capacity,
+			bool replacestale = false);
+
+	/**
+	 * \brief shmring open constructor
+	 *
+	 * Opens a ring created by another shmring.  Throws std::runtime_error if
+	 * there is no such ring or it was not created by a shmring.
+	 * \param name - The shared memory name
+	 */
+	explicit shmring(const std::string &name);
+
+	/**
+	 * \brief shmring destructor
+	 *
+	 * Unmaps the ring, and removes its name if this shmring created it.
+	 * Processes that already opened the ring keep using it.
+	 */
+	~shmring();
+
+	/**
+	 * \brief Try to push a json message
+	 *
+	 * \param buffer - The serialized json message
+	 * \param length - The number of characters in buffer
+	 * \return Returns false if the ring is full, or if the message is empty
+	 * or longer than a quarter of the ring and so never fits
+	 */
+	bool trypushjson(const char *buffer, size_t length);
+
+	/**
+	 * \brief Push a json message
+	 *
+	 * Waits for space if the ring is full.  Throws std::invalid_argument if
+	 * the message is empty or longer than a quarter of the ring.
+	 * \param buffer - The serialized json message
+	 * \param length - The number of characters in buffer
+	 * \param timeoutms - The most milliseconds to wait, -1 to wait forever
+	 * \return Returns false if the wait timed out
+	 */
+	bool pushjson(const char *buffer, size_t length, int timeoutms = -1);
+
+	/**
+	 * \brief Try to push a message in binary
+	 *
+	 * Encodes message with its tobinary().
+	 * \param message - The pick, correlation, detection, retract,
+	 * stationInfo, or stationInfoRequest to push
+	 * \return Returns false if the ring is full, or if the encoded message
+	 * is longer than a quarter of the ring
+	 */
+	template<class T>
+	bool trypush(const T &message) {
+		encoded.clear();
+		message.tobinary(encoded);
+		return (trypushbinary(message.type, encoded.data(), encoded.length()));
+	}
+
+	/**
+	 * \brief Push a message in binary
+	 *
+	 * Encodes message with its tobinary(), and waits for space if the ring
+	 * is full.  Throws std::invalid_argument if the encoded message is
+	 * longer than a quarter of the ring.
+	 * \param message - The pick, correlation, detection, retract,
+	 * stationInfo, or stationInfoRequest to push
+	 * \param timeoutms - The most milliseconds to wait, -1 to wait forever
+	 * \return Returns false if the wait timed out
+	 */
+	template<class T>
+	bool push(const T &message, int timeoutms = -1) {
+		encoded.clear();
+		message.tobinary(encoded);
+		return (pushbinary(message.type, encoded.data(), encoded.length(),
+				timeoutms));
+	}
+
+	/**
+	 * \brief Try to pop a message
+	 *
+	 * Only one thread, in one process, may pop from a ring.
+	 * \param result - The parseresult to fill with the message
+	 * \return Returns false if the ring is empty
+	 */
+	bool trypop(parseresult &result);
+
+	/**
+	 * \brief Pop a message
+	 *
+	 * Waits for a message if the ring is empty.  Only one thread, in one
+	 * process, may pop from a ring.
+	 * \param result - The parseresult to fill with the message
+	 * \param timeoutms - The most milliseconds to wait, -1 to wait forever
+	 * \return Returns false if the wait timed out
+	 */
+	bool pop(parseresult &result, int timeoutms = -1);
+
+	/**
+	 * \brief Get the ring size
+	 *
+	 * \return Returns the ring size in bytes
+	 */
+	size_t capacity() const;
+
+	/**
+	 * \brief Get the bytes in use
+	 *
+	 * \return Returns the number of bytes claimed by messages not yet
+	 * popped, an estimate while other threads are pushing or popping
+	 */
+	size_t size() const;
+
+private:
+	/**
+	 * \brief The shared ring header, defined in shmring.cpp
+	 */
+	struct ringheader;
+
+	/**
+	 * \brief Check if a name holds a ring whose creator has exited
+	 *
+	 * \param name - The shared memory name
+	 * \return Returns true if the name holds a shmring, of this version,
+	 * created by a process that no longer exists
+	 */
+	static bool isstale(const std::string &name);
+
+	/**
+	 * \brief Map the ring
+	 *
+	 * \param descriptor - The shared memory descriptor
+	 * \param length - The number of bytes to map
+	 */
+	void map(int descriptor, size_t length);
+
+	/**
+	 * \brief Try to push a binary message
+	 *
+	 * \param type - The message's class type name, such as "Pick"
+	 * \param buffer - The encoded message
+	 * \param length - The number of characters in buffer
+	 * \return Returns false if the ring is full
+	 */
+	bool trypushbinary(const std::string &type, const char *buffer,
+			size_t length);
+
+	/**
+	 * \brief Push a binary message, waiting for space
+	 *
+	 * \param type - The message's class type name, such as "Pick"
+	 * \param buffer - The encoded message
+	 * \param length - The number of characters in buffer
+	 * \param timeoutms - The most milliseconds to wait, -1 to wait forever
+	 * \return Returns false if the wait timed out
+	 */
+	bool pushbinary(const std::string &type, const char *buffer,
+			size_t length, int timeoutms);
+
+	/**
+	 * \brief Try to push a record
+	 *
+	 * \param format - The record format
+	 * \param type - The formattypes of a binary message
+	 * \param buffer - The record payload
+	 * \param length - The number of characters in buffer
+	 * \return Returns false if the ring is full, or the payload is empty or
+	 * longer than a quarter of the ring
+	 */
+	bool trypushrecord(uint16_t format, int16_t type, const char *buffer,
+			size_t length);
+
+	/**
+	 * \brief Push a record, waiting for space
+	 *
+	 * Throws std::invalid_argument if the payload is empty or longer than a
+	 * quarter of the ring, rather than waiting for space it never gets.
+	 * \param format - The record format
+	 * \param type - The formattypes of a binary message
+	 * \param buffer - The record payload
+	 * \param length - The number of characters in buffer
+	 * \param timeoutms - The most milliseconds to wait, -1 to wait forever
+	 * \return Returns false if the wait timed out
+	 */
+	bool pushrecord(uint16_t format, int16_t type, const char *buffer,
+			size_t length, int timeoutms);
+
+	// disallow copying, the shmring owns its mapping
+	shmring(const shmring &);
+	shmring & operator=(const shmring &);
+
+	/**
+	 * \brief The shared memory name
+	 */
+	std::string ringname;
+
+	/**
+	 * \brief Whether this shmring created the ring, and so removes the name
+	 */
+	bool owner;
+
+	/**
+	 * \brief The mapped shared memory
+	 */
+	void *mapping;
+
+	/**
+	 * \brief The number of bytes mapped
+	 */
+	size_t mappingsize;
+
+	/**
+	 * \brief The shared ring header, at the start of the mapping
+	 */
+	ringheader *header;
+
+	/**
+	 * \brief The ring data, following the header
+	 */
+	char *ring;
+
+	/**
+	 * \brief The ring size in bytes, a power of two
+	 */
+	uint64_t ringsize;
+
+	/**
+	 * \brief The binary encoding of the message being pushed, reused
+	 */
+	std::string encoded;
+};
+}
+#endif
+#endif
@@ -68,6 +68,24 @@ namespace detectionformats
 		*/
 		~source();
 
+		/**
+		* \brief source reset function
+		*
+		* Overwrites the members of this source in place from the provided
+		* json::Object, reusing the capacity of the existing strings instead of
+		* constructing new ones.
+		* \param json - A json object.
+		*/
+		void resetfrom(rapidjson::Value &json);
+
+		/**
+		* \brief source clear function
+		*
+		* Resets the members of this source to null values, retaining the
+		* capacity of the existing strings.
+		*/
+		void clear();
+
 		/**
 		* \brief Convert to json value function
 		*
@@ -75,7 +93,47 @@ namespace detectionformats
 		* \param jsondocument - a reference to the json document to fill in with the class contents.
 		* \return Returns rapidjson::Value & if successful
 		*/
-		virtual rapidjson::Value & tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) override;
+		virtual rapidjson::Value & tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const override;
+
+		/**
+		* \brief Convert to binary function
+		*
+		* Appends the compact binary encoding of the class to buffer.  The encoding
+		* holds the fields in a fixed order without keys, and is only intended for
+		* exchange between programs built with the same version of this library.
+		* \param buffer - The std::string to append to
+		*/
+		void tobinary(std::string &buffer) const;
+
+		/**
+		* \brief Convert from binary function
+		*
+		* Overwrites the members of this source from its binary
+		* encoding.  Throws std::invalid_argument if the buffer is truncated or
+		* corrupt.
+		* \param buffer - A pointer to the encoded buffer
+		* \param length - The number of characters in buffer
+		* \return Returns the number of characters consumed
+		*/
+		size_t frombinary(const char *buffer, size_t length);
+
+		/**
+		* \brief Equality operator
+		*
+		* Compares every member of this source to the provided one,
+		* missing values compare equal
+		* \param other - The source to compare to
+		* \return Returns true if all the members are equal
+		*/
+		bool operator==(const source &other) const;
+
+		/**
+		* \brief Inequality operator
+		*
+		* \param other - The source to compare to
+		* \return Returns true if any member differs
+		*/
+		bool operator!=(const source &other) const;
 
 		/**
 		* \brief Gets any errors in the class
@@ -83,7 +141,7 @@ namespace detectionformats
 		* Gets any formatting errors in the class
 		* \return Returns a std::vector<std::string> containing the errors
 		*/
-		virtual std::vector<std::string> geterrors() override;
+		virtual std::vector<std::string> geterrors() const override;
 
 		/**
 		* \brief Empty check
@@ -91,7 +149,7 @@ namespace detectionformats
 		* Checks to see if this object is empty
 		* \return Returns true if empty, false otherwise.
 		*/
-		bool isempty();
+		bool isempty() const;
 
 		/**
 		* \brief source agency identifyer
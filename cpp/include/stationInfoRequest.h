@@ -92,6 +92,24 @@ public:
 	 */
 	~stationInfoRequest();
 
+	/**
+	 * \brief stationInfoRequest reset function
+	 *
+	 * Overwrites the members of this stationInfoRequest in place from the
+	 * provided json::Object, reusing the capacity of the existing strings
+	 * instead of constructing new ones.
+	 * \param json - A json object.
+	 */
+	void resetfrom(rapidjson::Value &json);
+
+	/**
+	 * \brief stationInfoRequest clear function
+	 *
+	 * Resets the members of this stationInfoRequest to null values,
+	 * retaining the capacity of the existing strings.
+	 */
+	void clear();
+
 	/**
 	 * \brief Convert to json object function
 	 *
@@ -99,16 +117,56 @@ public:
 	 * \return Returns a json::Object containing the class contents
 	 */
 	virtual rapidjson::Value & tojson(rapidjson::Value &json,
-			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator)
+			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const
 					override;
 
+	/**
+	 * \brief Convert to binary function
+	 *
+	 * Appends the compact binary encoding of the class to buffer.  The encoding
+	 * holds the fields in a fixed order without keys, and is only intended for
+	 * exchange between programs built with the same version of this library.
+	 * \param buffer - The std::string to append to
+	 */
+	void tobinary(std::string &buffer) const;
+
+	/**
+	 * \brief Convert from binary function
+	 *
+	 * Overwrites the members of this stationInfoRequest from its binary
+	 * encoding.  Throws std::invalid_argument if the buffer is truncated or
+	 * corrupt.
+	 * \param buffer - A pointer to the encoded buffer
+	 * \param length - The number of characters in buffer
+	 * \return Returns the number of characters consumed
+	 */
+	size_t frombinary(const char *buffer, size_t length);
+
+	/**
+	 * \brief Equality operator
+	 *
+	 * Compares every member of this stationInfoRequest to the provided one,
+	 * missing values compare equal
+	 * \param other - The stationInfoRequest to compare to
+	 * \return Returns true if all the members are equal
+	 */
+	bool operator==(const stationInfoRequest &other) const;
+
+	/**
+	 * \brief Inequality operator
+	 *
+	 * \param other - The stationInfoRequest to compare to
+	 * \return Returns true if any member differs
+	 */
+	bool operator!=(const stationInfoRequest &other) const;
+
 	/**
 	 * \brief Gets any errors in the class
 	 *
 	 * Gets any formatting errors in the class
 	 * \return Returns a std::vector<std::string> containing the errors
 	 */
-	virtual std::vector<std::string> geterrors() override;
+	virtual std::vector<std::string> geterrors() const override;
 
 	/**
 	 * \brief stationInfoRequest site
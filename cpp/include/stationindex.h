@@ -0,0 +1,198 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_STATIONINDEX_H
+#define DETECTION_STATIONINDEX_H
+
+#include <cstdint>
+#include <vector>
+
+#include "hypocenter.h"
+#include "stationinventory.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats station distance
+ *
+ * A station found by a stationindex query.
+ */
+struct stationdistance {
+	/**
+	 * \brief The station's stationinventory ID
+	 */
+	uint32_t id;
+
+	/**
+	 * \brief The great circle distance from the query point to the
+	 * station, in degrees
+	 */
+	double distance;
+
+	/**
+	 * \brief The azimuth from the query point to the station, in degrees
+	 * clockwise from north, from 0 up to 360
+	 */
+	double azimuth;
+};
+
+/**
+ * \brief detectionformats station spatial index class
+ *
+ * The detectionformats stationindex class finds the enabled stations of a
+ * stationinventory nearest to, or within a distance of, a point such as a
+ * hypocenter.  Only the teleseismic stations can be asked for.
+ *
+ * Stations are held as unit vectors in earth centered coordinates in a
+ * static k-d tree, so that nearness is the straight line distance between
+ * vectors, which orders stations exactly as great circle distance does
+ * without any trigonometry in the search.  Each leaf keeps its stations'
+ * coordinates in parallel arrays, and distances and azimuths are computed
+ * in branch free loops over those arrays, which the compiler vectorizes.
+ *
+ * Distances are epicentral; a hypocenter's depth is ignored.  The index is
+ * built from the inventory as it was at construction, rebuild it after
+ * adding stations.  Queries may run on any number of threads.
+ */
+class stationindex {
+public:
+	/**
+	 * \brief stationindex constructor
+	 *
+	 * Indexes the stations in inventory that are enabled.
+	 * \param inventory - The inventory to index
+	 */
+	explicit stationindex(const stationinventory &inventory);
+
+	/**
+	 * \brief Find the nearest stations
+	 *
+	 * \param latitude - The query latitude in degrees
+	 * \param longitude - The query longitude in degrees
+	 * \param count - The number of stations to find
+	 * \param teleseismic - Only consider stations used for teleseismic
+	 * \return Returns up to count stations, nearest first
+	 */
+	std::vector<stationdistance> nearest(double latitude, double longitude,
+			size_t count, bool teleseismic = false) const;
+
+	/**
+	 * \brief Find the nearest stations to a hypocenter
+	 *
+	 * \param origin - The hypocenter
+	 * \param count - The number of stations to find
+	 * \param teleseismic - Only consider stations used for teleseismic
+	 * \return Returns up to count stations, nearest first
+	 */
+	std::vector<stationdistance> nearest(const hypocenter &origin,
+			size_t count, bool teleseismic = false) const;
+
+	/**
+	 * \brief Find the stations within a distance
+	 *
+	 * \param latitude - The query latitude in degrees
+	 * \param longitude - The query longitude in degrees
+	 * \param distance - The greatest great circle distance in degrees
+	 * \param teleseismic - Only consider stations used for teleseismic
+	 * \return Returns the stations within distance, nearest first
+	 */
+	std::vector<stationdistance> within(double latitude, double longitude,
+			double distance, bool teleseismic = false) const;
+
+	/**
+	 * \brief Find the stations within a distance of a hypocenter
+	 *
+	 * \param origin - The hypocenter
+	 * \param distance - The greatest great circle distance in degrees
+	 * \param teleseismic - Only consider stations used for teleseismic
+	 * \return Returns the stations within distance, nearest first
+	 */
+	std::vector<stationdistance> within(const hypocenter &origin,
+			double distance, bool teleseismic = false) const;
+
+	/**
+	 * \brief Get the number of stations
+	 *
+	 * \return Returns the number of stations indexed
+	 */
+	size_t size() const;
+
+private:
+	/**
+	 * \brief A k-d tree node
+	 */
+	struct node {
+		/**
+		 * \brief The node's stations, [begin, end) in the arrays
+		 */
+		uint32_t begin;
+		uint32_t end;
+
+		/**
+		 * \brief The index of the right child, 0 for a leaf, the left
+		 * child is the next node
+		 */
+		uint32_t right;
+
+		/**
+		 * \brief The axis split on, 0 to 2 for x to z
+		 */
+		uint32_t axis;
+
+		/**
+		 * \brief The split coordinate, the left child is at or below it
+		 */
+		double split;
+	};
+
+	/**
+	 * \brief Build the tree over stations [begin, end)
+	 *
+	 * \param order - The stations' positions in the arrays, reordered into
+	 * tree order
+	 * \param begin - The first position in order to build over
+	 * \param end - One past the last position in order to build over
+	 * \return Returns the index of the node built
+	 */
+	uint32_t build(std::vector<uint32_t> &order, uint32_t begin,
+			uint32_t end);
+
+	/**
+	 * \brief Compute the distances and azimuths of candidates
+	 *
+	 * \param latitude - The query latitude in degrees
+	 * \param longitude - The query longitude in degrees
+	 * \param candidates - The positions of the candidates in the arrays
+	 * \param results - Filled with the results, in candidate order
+	 */
+	void measure(double latitude, double longitude,
+			const std::vector<uint32_t> &candidates,
+			std::vector<stationdistance> &results) const;
+
+	/**
+	 * \brief The tree, the root first
+	 */
+	std::vector<node> nodes;
+
+	/**
+	 * \brief Each station's unit vector, in tree order
+	 */
+	std::vector<double> xs;
+	std::vector<double> ys;
+	std::vector<double> zs;
+
+	/**
+	 * \brief Each station's inventory ID, in tree order
+	 */
+	std::vector<uint32_t> ids;
+
+	/**
+	 * \brief Each station's use for teleseismic flag, in tree order
+	 */
+	std::vector<uint8_t> teleseismics;
+};
+}
+#endif
@@ -0,0 +1,209 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_STATIONINFORESPONDER_H
+#define DETECTION_STATIONINFORESPONDER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "site.h"
+#include "source.h"
+#include "stationInfoRequest.h"
+#include "stationinventory.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats station info responder metrics
+ */
+struct respondermetrics {
+	/**
+	 * \brief respondermetrics constructor
+	 */
+	respondermetrics()
+			: requests(0),
+				coalesced(0),
+				invalid(0),
+				lookups(0),
+				unknown(0),
+				responses(0) {
+	}
+
+	/**
+	 * \brief The number of requests added
+	 */
+	uint64_t requests;
+
+	/**
+	 * \brief The number of requests dropped as duplicates of a pending one
+	 */
+	uint64_t coalesced;
+
+	/**
+	 * \brief The number of requests dropped for having no station or
+	 * network
+	 */
+	uint64_t invalid;
+
+	/**
+	 * \brief The number of inventory lookups made
+	 */
+	uint64_t lookups;
+
+	/**
+	 * \brief The number of requests for sites not in the inventory
+	 */
+	uint64_t unknown;
+
+	/**
+	 * \brief The number of responses produced
+	 */
+	uint64_t responses;
+};
+
+/**
+ * \brief detectionformats station info responder class
+ *
+ * The detectionformats stationinforesponder class answers stationInfoRequest
+ * messages from a stationinventory, in batches.
+ *
+ * Requests are held for a time window after the first arrives.  A request
+ * for the same site from the same source as one already held is dropped,
+ * and requests for the same site from different sources share one
+ * inventory lookup and one serialization of the station, each response
+ * adding only its own informationRequestor.  Requests for sites not in the
+ * inventory get no response.
+ *
+ * A stationinforesponder is used by one thread at a time.
+ */
+class stationinforesponder {
+public:
+	/**
+	 * \brief The clock requests are timed with
+	 */
+	typedef std::chrono::steady_clock clock;
+
+	/**
+	 * \brief stationinforesponder constructor
+	 *
+	 * \param newinventory - The inventory to answer from, which must
+	 * outlive the responder
+	 * \param newwindow - How long to hold requests after the first arrives
+	 */
+	explicit stationinforesponder(const stationinventory &newinventory,
+			clock::duration newwindow = std::chrono::milliseconds(100));
+
+	/**
+	 * \brief Add a request
+	 *
+	 * \param request - The request to answer
+	 * \param received - When the request arrived
+	 * \return Returns false if the request was dropped, as a duplicate or
+	 * for having no station or network
+	 */
+	bool add(const stationInfoRequest &request, clock::time_point received =
+			clock::now());
+
+	/**
+	 * \brief Check if the held requests are due
+	 *
+	 * \param now - The current time
+	 * \return Returns true if requests are held and the window since the
+	 * first has passed
+	 */
+	bool isready(clock::time_point now = clock::now()) const;
+
+	/**
+	 * \brief Answer the held requests if they are due
+	 *
+	 * \param responses - The vector to append the serialized stationInfo
+	 * responses to
+	 * \param now - The current time
+	 * \return Returns the number of responses appended
+	 */
+	size_t poll(std::vector<std::string> &responses, clock::time_point now =
+			clock::now());
+
+	/**
+	 * \brief Answer the held requests now
+	 *
+	 * \param responses - The vector to append the serialized stationInfo
+	 * responses to
+	 * \return Returns the number of responses appended
+	 */
+	size_t flush(std::vector<std::string> &responses);
+
+	/**
+	 * \brief Get the number of held requests
+	 *
+	 * \return Returns the number of distinct requests held
+	 */
+	size_t getpending() const;
+
+	/**
+	 * \brief Get the metrics
+	 *
+	 * \return Returns the running request, lookup, and response counts
+	 */
+	respondermetrics getmetrics() const;
+
+private:
+	/**
+	 * \brief The held requests for one site
+	 */
+	struct requestgroup {
+		/**
+		 * \brief The site requested
+		 */
+		site requestsite;
+
+		/**
+		 * \brief The distinct sources requesting it
+		 */
+		std::vector<source> requesters;
+	};
+
+	/**
+	 * \brief The inventory answered from
+	 */
+	const stationinventory &inventory;
+
+	/**
+	 * \brief How long requests are held
+	 */
+	clock::duration window;
+
+	/**
+	 * \brief When the first held request arrived
+	 */
+	clock::time_point oldest;
+
+	/**
+	 * \brief The held requests, by site
+	 */
+	std::vector<requestgroup> groups;
+
+	/**
+	 * \brief Each held site's position in groups, by site key
+	 */
+	std::unordered_map<std::string, size_t> groupindex;
+
+	/**
+	 * \brief The number of distinct requests held
+	 */
+	size_t pending;
+
+	/**
+	 * \brief The running counts
+	 */
+	respondermetrics metrics;
+};
+}
+#endif
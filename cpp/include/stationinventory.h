@@ -0,0 +1,342 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_STATIONINVENTORY_H
+#define DETECTION_STATIONINVENTORY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "site.h"
+#include "stationInfo.h"
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats station inventory class
+ *
+ * The detectionformats stationinventory class keeps the latest location,
+ * quality, and flags of every station it has seen a stationInfo message
+ * for, keyed by site.
+ *
+ * Each site is interned on first sight: it is given a small integer ID that
+ * never changes, and its values are kept in parallel arrays indexed by that
+ * ID, so code looking up many stations, such as an associator placing each
+ * pick, touches only the arrays it reads.  Sites are found by an open
+ * addressing hash table of IDs, without building a key string.
+ *
+ * The inventory can be saved as a binary snapshot, which a later process
+ * maps and uses in place, with no parsing and no per station allocation.
+ * A loaded snapshot is copied out of the mapping the first time a station
+ * is added.
+ *
+ * Stations are never removed; a later stationInfo with enable false
+ * disables one.  Lookups may run on any number of threads while nothing is
+ * being added.
+ */
+class stationinventory {
+public:
+	/**
+	 * \brief The ID returned when a site is not in the inventory
+	 */
+	static const uint32_t npos;
+
+	/**
+	 * \brief stationinventory constructor
+	 *
+	 * \param expected - The number of stations to make room for
+	 */
+	explicit stationinventory(size_t expected = 1024);
+
+	/**
+	 * \brief stationinventory destructor
+	 */
+	~stationinventory();
+
+	/**
+	 * \brief Add a station
+	 *
+	 * Adds the station, or replaces the values of a site already in the
+	 * inventory.  The station is not validated.
+	 * \param station - The stationInfo to add
+	 * \return Returns the site's ID
+	 */
+	uint32_t add(const stationInfo &station);
+
+	/**
+	 * \brief Find a site
+	 *
+	 * \param station - The station code
+	 * \param channel - The channel code
+	 * \param network - The network code
+	 * \param location - The location code
+	 * \return Returns the site's ID, or npos if it is not in the inventory
+	 */
+	uint32_t find(const std::string &station, const std::string &channel,
+			const std::string &network, const std::string &location) const;
+
+	/**
+	 * \brief Find a site
+	 *
+	 * \param newsite - The site to find
+	 * \return Returns the site's ID, or npos if it is not in the inventory
+	 */
+	uint32_t find(const site &newsite) const;
+
+	/**
+	 * \brief Find a site by key
+	 *
+	 * \param key - The site's key, as returned by getkey()
+	 * \return Returns the site's ID, or npos if it is not in the inventory
+	 */
+	uint32_t find(const std::string &key) const;
+
+	/**
+	 * \brief Remove every station
+	 */
+	void clear();
+
+	/**
+	 * \brief Get the number of stations
+	 *
+	 * \return Returns the number of stations, one more than the largest ID
+	 */
+	size_t size() const;
+
+	/**
+	 * \brief Get a site's key
+	 *
+	 * \param id - The site's ID
+	 * \return Returns the site as "station.channel.network.location"
+	 */
+	std::string getkey(uint32_t id) const;
+
+	/**
+	 * \brief Get a station
+	 *
+	 * \param id - The site's ID
+	 * \return Returns a stationInfo holding the site and its latest values,
+	 * with no informationRequestor
+	 */
+	stationInfo getstation(uint32_t id) const;
+
+	/**
+	 * \brief Get the latitudes
+	 *
+	 * \return Returns the latitude of every station, indexed by ID
+	 */
+	const double * getlatitudes() const;
+
+	/**
+	 * \brief Get the longitudes
+	 *
+	 * \return Returns the longitude of every station, indexed by ID
+	 */
+	const double * getlongitudes() const;
+
+	/**
+	 * \brief Get the elevations
+	 *
+	 * \return Returns the elevation of every station, indexed by ID
+	 */
+	const double * getelevations() const;
+
+	/**
+	 * \brief Get the qualities
+	 *
+	 * \return Returns the quality of every station, indexed by ID, NaN
+	 * where a station gave none
+	 */
+	const double * getqualities() const;
+
+	/**
+	 * \brief Check if a station is enabled
+	 *
+	 * \param id - The site's ID
+	 * \return Returns the station's latest enable flag
+	 */
+	bool isenabled(uint32_t id) const;
+
+	/**
+	 * \brief Check if a station is used for teleseismic
+	 *
+	 * \param id - The site's ID
+	 * \return Returns the station's latest use for teleseismic flag
+	 */
+	bool isteleseismic(uint32_t id) const;
+
+	/**
+	 * \brief Save a snapshot
+	 *
+	 * Writes the inventory to a binary snapshot, replacing the file
+	 * atomically.  Throws std::runtime_error if it cannot be written.
+	 * \param path - The snapshot file to write
+	 */
+	void save(const std::string &path) const;
+
+	/**
+	 * \brief Load a snapshot
+	 *
+	 * Maps a snapshot written by save() and uses it in place, replacing
+	 * the inventory's contents.  The snapshot is rejected if it is from
+	 * another version or byte order, fails its checksum, or holds a
+	 * station that would not pass stationInfo validation.
+	 * \param path - The snapshot file to load
+	 * \return Returns false, leaving the inventory unchanged, if the file
+	 * is missing or rejected
+	 */
+	bool loadsnapshot(const std::string &path);
+
+	/**
+	 * \brief Load stationInfo messages
+	 *
+	 * Adds each valid stationInfo message in a newline delimited json
+	 * file; other messages are skipped.  Throws std::runtime_error if the
+	 * file cannot be read.
+	 * \param path - The json file to load
+	 * \return Returns the number of stations added
+	 */
+	size_t loadjson(const std::string &path);
+
+	/**
+	 * \brief Load a snapshot, or fall back to json
+	 *
+	 * Loads the snapshot if it is usable, otherwise replaces the inventory
+	 * with the stations in the json file and tries to write a new
+	 * snapshot for next time.  Throws std::runtime_error if neither file
+	 * can be read.
+	 * \param snapshotpath - The snapshot file
+	 * \param jsonpath - The newline delimited stationInfo json file
+	 * \return Returns true if the snapshot was used
+	 */
+	bool load(const std::string &snapshotpath, const std::string &jsonpath);
+
+	/**
+	 * \brief Build a site key
+	 *
+	 * \param newsite - The site
+	 * \return Returns the site as "station.channel.network.location"
+	 */
+	static std::string makekey(const site &newsite);
+
+private:
+	/**
+	 * \brief Find the table slot for a site
+	 *
+	 * \return Returns the slot holding the site's ID, or the empty slot it
+	 * would go in
+	 */
+	size_t findslot(uint64_t hash, const std::string &station,
+			const std::string &channel, const std::string &network,
+			const std::string &location) const;
+
+	/**
+	 * \brief Double the table and reinsert every ID
+	 */
+	void grow();
+
+	/**
+	 * \brief Point the views at the owned arrays
+	 */
+	void attach();
+
+	/**
+	 * \brief Copy a mapped snapshot into the owned arrays and unmap it
+	 */
+	void detach();
+
+	/**
+	 * \brief Unmap any snapshot
+	 */
+	void unmap();
+
+	// disallow copying, the views point into the inventory's own arrays
+	stationinventory(const stationinventory &);
+	stationinventory & operator=(const stationinventory &);
+
+	/**
+	 * \brief The owned hash table, each slot an ID or npos
+	 */
+	std::vector<uint32_t> slots;
+
+	/**
+	 * \brief Each station's key hash, by ID
+	 */
+	std::vector<uint64_t> hashes;
+
+	/**
+	 * \brief Each station's latitude, by ID
+	 */
+	std::vector<double> latitudes;
+
+	/**
+	 * \brief Each station's longitude, by ID
+	 */
+	std::vector<double> longitudes;
+
+	/**
+	 * \brief Each station's elevation, by ID
+	 */
+	std::vector<double> elevations;
+
+	/**
+	 * \brief Each station's quality, by ID
+	 */
+	std::vector<double> qualities;
+
+	/**
+	 * \brief Each station's enable and use for teleseismic flags, by ID
+	 */
+	std::vector<uint8_t> flags;
+
+	/**
+	 * \brief Where each station's key starts in keydata, by ID, with the
+	 * end of the last key at the end
+	 */
+	std::vector<uint32_t> keyoffsets;
+
+	/**
+	 * \brief Every station's key, one after another
+	 */
+	std::string keydata;
+
+	/**
+	 * \brief The arrays in use, either the owned arrays or a mapped
+	 * snapshot
+	 */
+	const uint32_t *slotview;
+	const uint64_t *hashview;
+	const double *latitudeview;
+	const double *longitudeview;
+	const double *elevationview;
+	const double *qualityview;
+	const uint8_t *flagview;
+	const uint32_t *keyoffsetview;
+	const char *keyview;
+
+	/**
+	 * \brief The number of table slots in use
+	 */
+	size_t tablesize;
+
+	/**
+	 * \brief The number of stations
+	 */
+	size_t count;
+
+	/**
+	 * \brief The mapped snapshot, NULL if the owned arrays are in use
+	 */
+	void *mapping;
+
+	/**
+	 * \brief The size of the mapped snapshot
+	 */
+	size_t mappingsize;
+};
+}
+#endif
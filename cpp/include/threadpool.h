@@ -0,0 +1,179 @@
+/*****************************************
+ * This file is documented for Doxygen.
+ * If you modify this file please update
+ * the comments so that Doxygen will still
+ * be able to work.
+ ****************************************/
+#ifndef DETECTION_THREADPOOL_H
+#define DETECTION_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace detectionformats {
+
+/**
+ * \brief detectionformats work stealing thread pool class
+ *
+ * The detectionformats threadpool class runs tasks on a fixed set of worker
+ * threads.  Each worker has its own task queue; submitted tasks are spread
+ * across the queues, a worker runs tasks from the back of its own queue and,
+ * once that is empty, steals tasks from the front of the other workers'
+ * queues, so that a worker that drew cheap tasks keeps busy while another is
+ * still working through expensive ones.
+ *
+ * Tasks passed to submit() must not throw; wrap the work in a try/catch and
+ * record any error where the submitter can find it.  run() catches what its
+ * function throws and rethrows it to the caller, and may be called from
+ * inside a task, in which case the worker runs queued tasks while it waits.
+ */
+class threadpool {
+public:
+	/**
+	 * \brief threadpool constructor
+	 *
+	 * The constructor for the threadpool class.  Starts the worker threads.
+	 * \param threadcount - The number of worker threads to start, 0 to
+	 * start one per hardware thread
+	 */
+	explicit threadpool(size_t threadcount = 0);
+
+	/**
+	 * \brief threadpool destructor
+	 *
+	 * The destructor for the threadpool class.  Waits for any submitted
+	 * tasks to finish and stops the worker threads.
+	 */
+	~threadpool();
+
+	/**
+	 * \brief Submit a task
+	 *
+	 * Queues a task to be run on one of the worker threads.
+	 * \param task - The task to run
+	 */
+	void submit(std::function<void()> task);
+
+	/**
+	 * \brief Run a range of work
+	 *
+	 * Splits the indices from 0 to count into chunks of chunksize, runs
+	 * function(begin, end) for each chunk on the worker threads, and waits
+	 * for every chunk to finish.  If function throws, the chunks not yet
+	 * started are skipped and the first exception is rethrown once the
+	 * running ones finish.  Called on one of this pool's workers, the worker
+	 * runs queued tasks, this call's chunks among them, instead of blocking.
+	 * \param count - The number of indices to process
+	 * \param chunksize - The number of indices in each task, 0 to choose a
+	 * size that gives each worker several chunks to balance with
+	 * \param function - The callable to run for each chunk
+	 */
+	void run(size_t count, size_t chunksize,
+			const std::function<void(size_t, size_t)> &function);
+
+	/**
+	 * \brief Wait for tasks
+	 *
+	 * Blocks until every submitted task has finished.
+	 */
+	void wait();
+
+	/**
+	 * \brief Get the thread count
+	 *
+	 * \return Returns the number of worker threads
+	 */
+	size_t size() const;
+
+private:
+	/**
+	 * \brief A worker's task queue
+	 */
+	struct workqueue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	/**
+	 * \brief Worker thread function
+	 *
+	 * \param index - The index of the worker's own queue
+	 */
+	void work(size_t index);
+
+	/**
+	 * \brief Take and run one task
+	 *
+	 * \param index - The index of the worker's own queue
+	 * \return Returns true if a task was run
+	 */
+	bool runtask(size_t index);
+
+	/**
+	 * \brief Take a task
+	 *
+	 * Takes a task from the back of the worker's own queue, or failing that
+	 * from the front of another worker's queue.
+	 * \param index - The index of the worker's own queue
+	 * \param task - Set to the task taken
+	 * \return Returns true if a task was taken
+	 */
+	bool take(size_t index, std::function<void()> &task);
+
+	// disallow copying, the pool owns its threads
+	threadpool(const threadpool &);
+	threadpool & operator=(const threadpool &);
+
+	/**
+	 * \brief The per worker task queues
+	 */
+	std::vector<std::unique_ptr<workqueue>> queues;
+
+	/**
+	 * \brief The worker threads
+	 */
+	std::vector<std::thread> threads;
+
+	/**
+	 * \brief The queue the next submitted task is added to
+	 */
+	std::atomic<size_t> nextqueue;
+
+	/**
+	 * \brief The number of tasks queued but not yet taken
+	 */
+	std::atomic<size_t> queued;
+
+	/**
+	 * \brief The number of tasks submitted but not yet finished
+	 */
+	std::atomic<size_t> pending;
+
+	/**
+	 * \brief Whether the workers should exit
+	 */
+	bool stopping;
+
+	/**
+	 * \brief Mutex protecting the sleep and completion conditions
+	 */
+	std::mutex statemutex;
+
+	/**
+	 * \brief Signalled when a task is submitted or the pool is stopping
+	 */
+	std::condition_variable workavailable;
+
+	/**
+	 * \brief Signalled when the last pending task finishes
+	 */
+	std::condition_variable workfinished;
+};
+}
+#endif
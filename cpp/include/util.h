@@ -7,7 +7,10 @@
 #ifndef DETECTION_UTIL_H
 #define DETECTION_UTIL_H
 
+#include <cstdint>
+#include <cstring>
 #include <exception>
+#include <stdexcept>
 #include <string>
 #include "rapidjson/document.h"
 #include "rapidjson/writer.h"
@@ -27,6 +30,10 @@
 #define STATIONINFO_TYPE "StationInfo"
 #define STATIONINFOREQUEST_TYPE "StationInfoRequest"
 
+// 64 bit FNV-1a constants
+#define FNV64OFFSETBASIS 14695981039346656037ULL
+#define FNV64PRIME 1099511628211ULL
+
 /**
 * @namespace detectionformats
 * The namespace containing a collection of classes and functions that
@@ -112,6 +119,17 @@ namespace detectionformats
 	*/
 	double ConvertISO8601ToEpochTime(std::string TimeString);
 
+	/**
+	* \brief Convert iso8601 time buffer to decimal epoch seconds
+	*
+	* Converts the provided iso8601 character buffer to decimal epoch seconds
+	* without allocating a temporary std::string
+	* \param TimeBuffer - A pointer to the iso8601 characters
+	* \param TimeLength - The number of characters in TimeBuffer
+	* \return Returns a double containing the decimal epoch seconds
+	*/
+	double ConvertISO8601ToEpochTime(const char *TimeBuffer, size_t TimeLength);
+
 	/**
 	* \brief Convert decimal epoch seconds to iso8601 time string
 	*
@@ -137,5 +155,123 @@ namespace detectionformats
 	*/
 	rapidjson::Document & FromJSONString(std::string jsonstring, rapidjson::Document & jsondocument);
 
+	/**
+	* \brief Convert from json buffer function
+	*
+	* Converts the provided character buffer from serialized json, populating
+	* the provided document.  The buffer does not need to be null terminated.
+	* \param jsonbuffer - A pointer to the serialized json
+	* \param length - The number of characters in jsonbuffer
+	* \param jsondocument - The rapidjson::Document to parse into
+	* \return Returns a reference to jsondocument if successful, throws
+	* std::invalid_argument otherwise
+	*/
+	rapidjson::Document & FromJSONString(const char *jsonbuffer, size_t length, rapidjson::Document & jsondocument);
+
+	/**
+	* \brief Build an error for a failed system call
+	*
+	* Describes the current errno, for the callers of open(), mmap(),
+	* epoll_wait() and the like
+	* \param what - What failed, usually the call and the path it was given
+	* \return Returns a std::runtime_error containing what and the errno
+	* description
+	*/
+	std::runtime_error SystemError(const std::string &what);
+
+	/**
+	* \brief Hash a json key
+	*
+	* Computes the 32 bit FNV-1a hash of the provided key.  The hash can be
+	* evaluated at compile time, so that the members of a json object can be
+	* dispatched in a single pass with a switch on the hash of each key.
+	* \param key - A pointer to the key characters
+	* \param length - The number of characters in key
+	* \return Returns a uint32_t containing the hash of the key
+	*/
+	constexpr uint32_t HashJSONKey(const char *key, size_t length)
+	{
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < length; i++)
+		{
+			hash = (hash ^ static_cast<unsigned char>(key[i])) * 16777619u;
+		}
+		return (hash);
+	}
+
+	/**
+	* \brief Hash a json key literal
+	*
+	* Computes the hash of a key string literal, for use as a case label
+	* \param key - The key string literal
+	* \return Returns a uint32_t containing the hash of the key
+	*/
+	template<size_t N>
+	constexpr uint32_t HashJSONKey(const char (&key)[N])
+	{
+		return (HashJSONKey(key, N - 1));
+	}
+
+	/**
+	* \brief Hash a json member name
+	*
+	* Computes the hash of a json member name
+	* \param name - The json string value containing the member name
+	* \return Returns a uint32_t containing the hash of the name
+	*/
+	inline uint32_t HashJSONKey(const rapidjson::Value &name)
+	{
+		return (HashJSONKey(name.GetString(), name.GetStringLength()));
+	}
+
+	/**
+	* \brief Hash characters
+	*
+	* Computes the 64 bit FNV-1a hash of the provided characters, or adds
+	* them to a hash already started.  Unlike std::hash the result is the
+	* same on every platform, so it can be stored in files or used to pick
+	* shards.
+	* \param buffer - A pointer to the characters
+	* \param length - The number of characters in buffer
+	* \param hash - The hash of any preceding characters
+	* \return Returns a uint64_t containing the hash
+	*/
+	constexpr uint64_t HashBytes(const char *buffer, size_t length, uint64_t hash = FNV64OFFSETBASIS)
+	{
+		for (size_t i = 0; i < length; i++)
+		{
+			hash = (hash ^ static_cast<unsigned char>(buffer[i])) * FNV64PRIME;
+		}
+		return (hash);
+	}
+
+	/**
+	* \brief Hash a string
+	*
+	* Computes the 64 bit FNV-1a hash of a string, or adds it to a hash
+	* already started
+	* \param value - The string to hash
+	* \param hash - The hash of any preceding characters
+	* \return Returns a uint64_t containing the hash
+	*/
+	inline uint64_t HashBytes(const std::string &value, uint64_t hash = FNV64OFFSETBASIS)
+	{
+		return (HashBytes(value.data(), value.length(), hash));
+	}
+
+	/**
+	* \brief Compare a json member name to a key
+	*
+	* Confirms that a member name whose hash matched a key is that key
+	* \param name - The json string value containing the member name
+	* \param key - The key string literal
+	* \return Returns true if the name is the key, false otherwise
+	*/
+	template<size_t N>
+	inline bool IsJSONKey(const rapidjson::Value &name, const char (&key)[N])
+	{
+		return ((name.GetStringLength() == N - 1) && (memcmp(name.GetString(), key, N - 1) == 0));
+	}
+
 }
 #endif
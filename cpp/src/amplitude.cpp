@@ -1,4 +1,5 @@
 #include "amplitude.h"
+#include "fields.h"
 
 #include <limits>
 
@@ -9,6 +10,12 @@
 
 namespace detectionformats
 {
+	// field descriptors, in the order the fields are written to json
+	static constexpr auto fields = std::make_tuple(
+			detectionformats::numberfield(AMPLITUDE_KEY, &amplitude::ampvalue),
+			detectionformats::numberfield(PERIOD_KEY, &amplitude::period),
+			detectionformats::numberfield(SNR_KEY, &amplitude::snr));
+
 	amplitude::amplitude()
 	{
 		ampvalue = std::numeric_limits<double>::quiet_NaN();
@@ -25,24 +32,7 @@ namespace detectionformats
 
 	amplitude::amplitude(rapidjson::Value &json)
 	{
-		// optional values
-		// ampvalue
-		if ((json.HasMember(AMPLITUDE_KEY) == true) && (json[AMPLITUDE_KEY].IsNumber() == true) && (json[AMPLITUDE_KEY].IsDouble() == true))
-			ampvalue = json[AMPLITUDE_KEY].GetDouble();
-		else
-			ampvalue = std::numeric_limits<double>::quiet_NaN();
-
-		// period
-		if ((json.HasMember(PERIOD_KEY) == true) && (json[PERIOD_KEY].IsNumber() == true) && (json[PERIOD_KEY].IsDouble() == true))
-			period = json[PERIOD_KEY].GetDouble();
-		else
-			period = std::numeric_limits<double>::quiet_NaN();
-
-		// snr
-		if ((json.HasMember(SNR_KEY) == true) && (json[SNR_KEY].IsNumber() == true) && (json[SNR_KEY].IsDouble() == true))
-			snr = json[SNR_KEY].GetDouble();
-		else
-			snr = std::numeric_limits<double>::quiet_NaN();
+		resetfrom(json);
 	}
 
 	amplitude::amplitude(const amplitude & newamplitude)
@@ -56,33 +46,52 @@ namespace detectionformats
 	{
 	}
 
-	rapidjson::Value & amplitude::tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator)
+	void amplitude::resetfrom(rapidjson::Value &json)
 	{
-		json.SetObject();
+		clear();
 
-		// optional values
-		// ampvalue
-		if (std::isnan(ampvalue) != true)
-			json.AddMember(AMPLITUDE_KEY, ampvalue, allocator);
+		detectionformats::ParseFields(*this, json, fields);
+	}
 
-		// period
-		if (std::isnan(period) != true)
-			json.AddMember(PERIOD_KEY, period, allocator);
+	void amplitude::clear()
+	{
+		ampvalue = std::numeric_limits<double>::quiet_NaN();
+		period = std::numeric_limits<double>::quiet_NaN();
+		snr = std::numeric_limits<double>::quiet_NaN();
+	}
 
-		// snr
-		if (std::isnan(snr) != true)
-			json.AddMember(SNR_KEY, snr, allocator);
+	rapidjson::Value & amplitude::tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const
+	{
+		return (detectionformats::WriteFields(*this, json, allocator, fields));
+	}
+
+	void amplitude::tobinary(std::string &buffer) const
+	{
+		detectionformats::EncodeFields(*this, buffer, fields);
+	}
 
-		return(json);
+	size_t amplitude::frombinary(const char *buffer, size_t length)
+	{
+		return (detectionformats::DecodeFields(*this, buffer, length, fields));
+	}
+
+	bool amplitude::operator==(const amplitude &other) const
+	{
+		return (detectionformats::EqualFields(*this, other, fields));
+	}
+
+	bool amplitude::operator!=(const amplitude &other) const
+	{
+		return (!(*this == other));
 	}
 
-	std::vector<std::string> amplitude::geterrors()
+	std::vector<std::string> amplitude::geterrors() const
 	{
 		// nothing to check
 		return (std::vector<std::string>());
 	}
 
-	bool amplitude::isempty()
+	bool amplitude::isempty() const
 	{
 		if (std::isnan(ampvalue) != true)
 			return(false);
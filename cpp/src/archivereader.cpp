@@ -0,0 +1,468 @@
+#include "archivereader.h"
+
+#if !defined(_WIN32)
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "util.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define DETECTION_HAVE_IO_URING
+#endif
+#endif
+
+#ifdef DETECTION_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace detectionformats {
+
+// reads exactly length bytes at offset unless the file ends first
+static size_t ReadFully(int descriptor, char *buffer, size_t length,
+		uint64_t offset) {
+	size_t total = 0;
+	while (total < length) {
+		ssize_t count = pread(descriptor, buffer + total, length - total,
+				static_cast<off_t>(offset + total));
+		if (count < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw SystemError("pread");
+		}
+		if (count == 0) {
+			break;
+		}
+		total += count;
+	}
+	return (total);
+}
+
+// io_uring, driven directly through the system calls so that liburing is
+// not a dependency
+struct archivereader::uring {
+	uring()
+			: descriptor(-1),
+				sqhead(NULL),
+				sqtail(NULL),
+				sqmask(NULL),
+				sqarray(NULL),
+				cqhead(NULL),
+				cqtail(NULL),
+				cqmask(NULL),
+				sqring(NULL),
+				sqringsize(0),
+				cqring(NULL),
+				cqringsize(0),
+#ifdef DETECTION_HAVE_IO_URING
+				sqes(NULL),
+				cqes(NULL),
+				sqessize(0),
+#endif
+				inflight(0) {
+	}
+
+#ifdef DETECTION_HAVE_IO_URING
+	// sets up the ring with room for entries reads, returns false if
+	// io_uring is not available
+	bool setup(unsigned entries);
+
+	// unmaps and closes the ring
+	void teardown();
+
+	// takes one completion off the ring, waiting for one if none are ready
+	void reap();
+#endif
+
+	int descriptor;
+	unsigned *sqhead;
+	unsigned *sqtail;
+	unsigned *sqmask;
+	unsigned *sqarray;
+	unsigned *cqhead;
+	unsigned *cqtail;
+	unsigned *cqmask;
+	void *sqring;
+	size_t sqringsize;
+	void *cqring;
+	size_t cqringsize;
+#ifdef DETECTION_HAVE_IO_URING
+	io_uring_sqe *sqes;
+	io_uring_cqe *cqes;
+	size_t sqessize;
+#endif
+
+	// per buffer read state
+	std::vector<iovec> iovecs;
+	std::vector<int> results;
+	std::vector<char> completed;
+	size_t inflight;
+};
+
+#ifdef DETECTION_HAVE_IO_URING
+bool archivereader::uring::setup(unsigned entries) {
+	io_uring_params parameters;
+	std::memset(&parameters, 0, sizeof(parameters));
+	descriptor = static_cast<int>(syscall(__NR_io_uring_setup, entries,
+			&parameters));
+	if (descriptor < 0) {
+		return (false);
+	}
+
+	sqringsize = parameters.sq_off.array
+			+ (parameters.sq_entries * sizeof(unsigned));
+	cqringsize = parameters.cq_off.cqes
+			+ (parameters.cq_entries * sizeof(io_uring_cqe));
+	bool singlemap = (parameters.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singlemap == true) {
+		sqringsize = cqringsize = std::max(sqringsize,
+				cqringsize);
+	}
+
+	sqring = mmap(NULL, sqringsize, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQ_RING);
+	if (sqring == MAP_FAILED) {
+		sqring = NULL;
+		return (false);
+	}
+	if (singlemap == true) {
+		cqring = sqring;
+	} else {
+		cqring = mmap(NULL, cqringsize, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, descriptor,
+				IORING_OFF_CQ_RING);
+		if (cqring == MAP_FAILED) {
+			cqring = NULL;
+			return (false);
+		}
+	}
+
+	sqessize = parameters.sq_entries * sizeof(io_uring_sqe);
+	void *sqesmap = mmap(NULL, sqessize, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQES);
+	if (sqesmap == MAP_FAILED) {
+		return (false);
+	}
+	sqes = static_cast<io_uring_sqe *>(sqesmap);
+
+	char *sqbase = static_cast<char *>(sqring);
+	sqhead = reinterpret_cast<unsigned *>(sqbase + parameters.sq_off.head);
+	sqtail = reinterpret_cast<unsigned *>(sqbase + parameters.sq_off.tail);
+	sqmask = reinterpret_cast<unsigned *>(sqbase
+			+ parameters.sq_off.ring_mask);
+	sqarray = reinterpret_cast<unsigned *>(sqbase
+			+ parameters.sq_off.array);
+
+	char *cqbase = static_cast<char *>(cqring);
+	cqhead = reinterpret_cast<unsigned *>(cqbase + parameters.cq_off.head);
+	cqtail = reinterpret_cast<unsigned *>(cqbase + parameters.cq_off.tail);
+	cqmask = reinterpret_cast<unsigned *>(cqbase
+			+ parameters.cq_off.ring_mask);
+	cqes = reinterpret_cast<io_uring_cqe *>(cqbase
+			+ parameters.cq_off.cqes);
+
+	return (true);
+}
+
+void archivereader::uring::teardown() {
+	if (sqes != NULL) {
+		munmap(sqes, sqessize);
+	}
+	if ((cqring != NULL) && (cqring != sqring)) {
+		munmap(cqring, cqringsize);
+	}
+	if (sqring != NULL) {
+		munmap(sqring, sqringsize);
+	}
+	if (descriptor >= 0) {
+		close(descriptor);
+	}
+}
+
+void archivereader::uring::reap() {
+	while (true) {
+		unsigned head = *cqhead;
+		if (head != __atomic_load_n(cqtail, __ATOMIC_ACQUIRE)) {
+			io_uring_cqe &completion = cqes[head & *cqmask];
+			size_t index = static_cast<size_t>(completion.user_data);
+			results[index] = completion.res;
+			completed[index] = 1;
+			inflight--;
+			__atomic_store_n(cqhead, head + 1, __ATOMIC_RELEASE);
+			return;
+		}
+
+		if ((syscall(__NR_io_uring_enter, descriptor, 0, 1,
+				IORING_ENTER_GETEVENTS, NULL, 0) < 0) && (errno != EINTR)) {
+			throw SystemError("io_uring_enter");
+		}
+	}
+}
+#endif
+
+archivereader::archivereader(const std::string &path, size_t newblocksize,
+		size_t depth, bool useuring)
+		: descriptor(-1),
+			filesize(0),
+			blocksize(std::max(static_cast<size_t>(1), newblocksize)),
+			blockcount(0),
+			nextread(0),
+			currentblock(static_cast<uint64_t>(-1)),
+			currentlength(0),
+			position(0) {
+	descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (descriptor < 0) {
+		throw SystemError("open " + path);
+	}
+
+	struct stat status;
+	if (fstat(descriptor, &status) < 0) {
+		std::runtime_error error = SystemError("fstat " + path);
+		close(descriptor);
+		throw error;
+	}
+	filesize = static_cast<uint64_t>(status.st_size);
+	blockcount = (filesize + blocksize - 1) / blocksize;
+
+	depth = std::max(static_cast<size_t>(1), depth);
+	buffers.resize(depth);
+	for (size_t i = 0; i < depth; i++) {
+		buffers[i].resize(blocksize);
+	}
+
+#ifdef DETECTION_HAVE_IO_URING
+	if (useuring == true) {
+		ring.reset(new uring());
+		if (ring->setup(static_cast<unsigned>(depth)) == false) {
+			ring->teardown();
+			ring.reset();
+		} else {
+			ring->iovecs.resize(depth);
+			ring->results.resize(depth, 0);
+			ring->completed.resize(depth, 0);
+		}
+	}
+#else
+	(void) useuring;
+#endif
+
+	if (ring == NULL) {
+		posix_fadvise(descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+	}
+
+	// fill the pipeline
+	while ((nextread < blockcount) && (nextread < depth)) {
+		startread(nextread++);
+	}
+}
+
+archivereader::~archivereader() {
+#ifdef DETECTION_HAVE_IO_URING
+	if (ring != NULL) {
+		// the kernel is still writing into the buffers of reads in flight
+		try {
+			while (ring->inflight > 0) {
+				ring->reap();
+			}
+		} catch (const std::exception &) {
+		}
+		ring->teardown();
+	}
+#endif
+	close(descriptor);
+}
+
+bool archivereader::next(const char *&data, size_t &length) {
+	while (true) {
+		if ((currentblock < blockcount) && (position < currentlength)) {
+			const char *start = buffers[currentblock % buffers.size()].data()
+					+ position;
+			size_t remaining = currentlength - position;
+
+			if (carry.empty() == false) {
+				// finish the line started in an earlier block
+				const char *newline = static_cast<const char *>(std::memchr(
+						start, '\n', remaining));
+				if (newline == NULL) {
+					carry.insert(carry.end(), start, start + remaining);
+					position = currentlength;
+					continue;
+				}
+
+				size_t count = (newline - start) + 1;
+				carry.insert(carry.end(), start, start + count);
+				position += count;
+
+				joined.swap(carry);
+				carry.clear();
+				data = joined.data();
+				length = joined.size();
+				return (true);
+			}
+
+			// hand out every complete line left in the block in place
+			size_t end = remaining;
+			while ((end > 0) && (start[end - 1] != '\n')) {
+				end--;
+			}
+			if (end == 0) {
+				carry.assign(start, start + remaining);
+				position = currentlength;
+				continue;
+			}
+
+			data = start;
+			length = end;
+			position += end;
+			return (true);
+		}
+
+		// the current block is used up, reuse its buffer for the next block
+		// to read and move on to the following block
+		if ((currentblock < blockcount) && (nextread < blockcount)) {
+			startread(nextread++);
+		}
+		currentblock++;
+
+		if (currentblock >= blockcount) {
+			currentblock = blockcount;
+
+			// the last line of the file need not end with a newline
+			if (carry.empty() == false) {
+				joined.swap(carry);
+				carry.clear();
+				data = joined.data();
+				length = joined.size();
+				return (true);
+			}
+			return (false);
+		}
+
+		currentlength = waitread(currentblock);
+		position = 0;
+	}
+}
+
+uint64_t archivereader::readmessages(
+		const std::function<void(parseresult &)> &handler) {
+	uint64_t count = 0;
+	const char *data;
+	size_t length;
+	while (next(data, length) == true) {
+		const char *end = data + length;
+		while (data < end) {
+			const char *newline = static_cast<const char *>(std::memchr(data,
+					'\n', end - data));
+			const char *lineend = (newline != NULL) ? newline : end;
+
+			// skip carriage returns and blank lines
+			size_t linelength = lineend - data;
+			while ((linelength > 0) && (data[linelength - 1] == '\r')) {
+				linelength--;
+			}
+			if (linelength > 0) {
+				parseresult result;
+				ParseMessage(data, linelength, parsecontext::local(), result);
+				handler(result);
+				count++;
+			}
+
+			data = (newline != NULL) ? newline + 1 : end;
+		}
+	}
+	return (count);
+}
+
+bool archivereader::isuring() const {
+	return (ring != NULL);
+}
+
+uint64_t archivereader::size() const {
+	return (filesize);
+}
+
+void archivereader::startread(uint64_t block) {
+	size_t index = block % buffers.size();
+	uint64_t offset = block * blocksize;
+	size_t length = static_cast<size_t>(std::min(
+			static_cast<uint64_t>(blocksize), filesize - offset));
+
+#ifdef DETECTION_HAVE_IO_URING
+	if (ring != NULL) {
+		ring->completed[index] = 0;
+		ring->iovecs[index].iov_base = buffers[index].data();
+		ring->iovecs[index].iov_len = length;
+
+		unsigned tail = *ring->sqtail;
+		unsigned slot = tail & *ring->sqmask;
+		io_uring_sqe &submission = ring->sqes[slot];
+		std::memset(&submission, 0, sizeof(submission));
+		submission.opcode = IORING_OP_READV;
+		submission.fd = descriptor;
+		submission.addr = reinterpret_cast<uint64_t>(&ring->iovecs[index]);
+		submission.len = 1;
+		submission.off = offset;
+		submission.user_data = index;
+		ring->sqarray[slot] = slot;
+		__atomic_store_n(ring->sqtail, tail + 1, __ATOMIC_RELEASE);
+
+		while (syscall(__NR_io_uring_enter, ring->descriptor, 1, 0, 0, NULL, 0)
+				< 0) {
+			if (errno != EINTR) {
+				throw SystemError("io_uring_enter");
+			}
+		}
+		ring->inflight++;
+		return;
+	}
+#endif
+
+	// ask the kernel to start reading the block in the background
+	posix_fadvise(descriptor, static_cast<off_t>(offset),
+			static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+}
+
+size_t archivereader::waitread(uint64_t block) {
+	size_t index = block % buffers.size();
+	uint64_t offset = block * blocksize;
+	size_t length = static_cast<size_t>(std::min(
+			static_cast<uint64_t>(blocksize), filesize - offset));
+
+#ifdef DETECTION_HAVE_IO_URING
+	if (ring != NULL) {
+		while (ring->completed[index] == 0) {
+			ring->reap();
+		}
+
+		int result = ring->results[index];
+		if (result < 0) {
+			errno = -result;
+			throw SystemError("io_uring read");
+		}
+
+		// a short read is finished synchronously
+		size_t count = static_cast<size_t>(result);
+		if ((count < length) && (count > 0)) {
+			count += ReadFully(descriptor, buffers[index].data() + count,
+					length - count, offset + count);
+		}
+		return (count);
+	}
+#endif
+
+	return (ReadFully(descriptor, buffers[index].data(), length, offset));
+}
+}
+#endif
@@ -1,4 +1,5 @@
 #include "associated.h"
+#include "fields.h"
 
 #include <limits>
 
@@ -11,6 +12,14 @@
 
 namespace detectionformats
 {
+	// field descriptors, in the order the fields are written to json
+	static constexpr auto fields = std::make_tuple(
+			detectionformats::stringfield(PHASE_KEY, &associated::phase),
+			detectionformats::numberfield(DISTANCE_KEY, &associated::distance),
+			detectionformats::numberfield(AZIMUTH_KEY, &associated::azimuth),
+			detectionformats::numberfield(RESIDUAL_KEY, &associated::residual),
+			detectionformats::numberfield(SIGMA_KEY, &associated::sigma));
+
 	associated::associated()
 	{
 		phase = "";
@@ -31,37 +40,7 @@ namespace detectionformats
 
 	associated::associated(rapidjson::Value &json)
 	{
-
-		// optional values
-		// phase
-		if ((json.HasMember(PHASE_KEY) == true) && (json[PHASE_KEY].IsString() == true))
-			phase = std::string(json[PHASE_KEY].GetString(), json[PHASE_KEY].GetStringLength());
-		else
-			phase = "";
-
-		// distance
-		if ((json.HasMember(DISTANCE_KEY) == true) && (json[DISTANCE_KEY].IsNumber() == true) && (json[DISTANCE_KEY].IsDouble() == true))
-			distance = json[DISTANCE_KEY].GetDouble();
-		else
-			distance = std::numeric_limits<double>::quiet_NaN();
-
-		// azimuth
-		if ((json.HasMember(AZIMUTH_KEY) == true) && (json[AZIMUTH_KEY].IsNumber() == true) && (json[AZIMUTH_KEY].IsDouble() == true))
-			azimuth = json[AZIMUTH_KEY].GetDouble();
-		else
-			azimuth = std::numeric_limits<double>::quiet_NaN();
-
-		// residual
-		if ((json.HasMember(RESIDUAL_KEY) == true) && (json[RESIDUAL_KEY].IsNumber() == true) && (json[RESIDUAL_KEY].IsDouble() == true))
-			residual = json[RESIDUAL_KEY].GetDouble();
-		else
-			residual = std::numeric_limits<double>::quiet_NaN();
-
-		// sigma
-		if ((json.HasMember(SIGMA_KEY) == true) && (json[SIGMA_KEY].IsNumber() == true) && (json[SIGMA_KEY].IsDouble() == true))
-			sigma = json[SIGMA_KEY].GetDouble();
-		else
-			sigma = std::numeric_limits<double>::quiet_NaN();
+		resetfrom(json);
 	}
 
 	associated::associated(const associated & newassociated)
@@ -77,39 +56,48 @@ namespace detectionformats
 	{
 	}
 
-	rapidjson::Value & associated::tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator)
+	void associated::resetfrom(rapidjson::Value &json)
 	{
-		json.SetObject();
+		clear();
 
-		// optional values
-		// phase
-		if (phase != "")
-		{
-			rapidjson::Value phasevalue;
-			phasevalue.SetString(rapidjson::StringRef(phase.c_str()), allocator);
-			json.AddMember(PHASE_KEY, phasevalue, allocator);
-		}
+		detectionformats::ParseFields(*this, json, fields);
+	}
 
-		// distance
-		if (std::isnan(distance) != true)
-			json.AddMember(DISTANCE_KEY, distance, allocator);
+	void associated::clear()
+	{
+		phase.clear();
+		distance = std::numeric_limits<double>::quiet_NaN();
+		azimuth = std::numeric_limits<double>::quiet_NaN();
+		residual = std::numeric_limits<double>::quiet_NaN();
+		sigma = std::numeric_limits<double>::quiet_NaN();
+	}
 
-		// azimuth
-		if (std::isnan(azimuth) != true)
-			json.AddMember(AZIMUTH_KEY, azimuth, allocator);
+	rapidjson::Value & associated::tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const
+	{
+		return (detectionformats::WriteFields(*this, json, allocator, fields));
+	}
 
-		// residual
-		if (std::isnan(residual) != true)
-			json.AddMember(RESIDUAL_KEY, residual, allocator);
+	void associated::tobinary(std::string &buffer) const
+	{
+		detectionformats::EncodeFields(*this, buffer, fields);
+	}
 
-		// sigma
-		if (std::isnan(sigma) != true)
-			json.AddMember(SIGMA_KEY, sigma, allocator);
+	size_t associated::frombinary(const char *buffer, size_t length)
+	{
+		return (detectionformats::DecodeFields(*this, buffer, length, fields));
+	}
 
-		return(json);
+	bool associated::operator==(const associated &other) const
+	{
+		return (detectionformats::EqualFields(*this, other, fields));
+	}
+
+	bool associated::operator!=(const associated &other) const
+	{
+		return (!(*this == other));
 	}
 
-	std::vector<std::string> associated::geterrors()
+	std::vector<std::string> associated::geterrors() const
 	{
 		std::vector<std::string> errorlist;
 
@@ -124,7 +112,7 @@ namespace detectionformats
 		return (errorlist);
 	}
 
-	bool associated::isempty()
+	bool associated::isempty() const
 	{
 		if (phase != "")
 			return(false);
@@ -0,0 +1,218 @@
+#include "asyncmessagestream.h"
+
+#if defined(__linux__)
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "util.h"
+
+// the most read from a stream at once
+#define READSIZE 65536
+
+// the longest message accepted
+#define MAXMESSAGELENGTH (16 * 1024 * 1024)
+
+// the most events handled per epoll_wait
+#define MAXEVENTS 64
+
+namespace detectionformats {
+
+messagestream::messagestream(int newdescriptor)
+		: descriptor(newdescriptor),
+			buffer(READSIZE),
+			start(0),
+			used(0),
+			ended(false) {
+}
+
+int messagestream::trynext(parseresult &result) {
+	while (true) {
+		// parse the next complete line already buffered
+		const char *newline = static_cast<const char *>(std::memchr(
+				buffer.data() + start, '\n', used - start));
+		if (newline != NULL) {
+			size_t length = newline - (buffer.data() + start);
+			bool parsed = parseline(length, result);
+			start += length + 1;
+			if (parsed == true) {
+				return (ready);
+			}
+			continue;
+		}
+
+		// the last line of the stream need not end with a newline
+		if (ended == true) {
+			if (start < used) {
+				size_t length = used - start;
+				bool parsed = parseline(length, result);
+				start = used;
+				if (parsed == true) {
+					return (ready);
+				}
+			}
+			return (finished);
+		}
+
+		// make room for a full read after the partial line
+		if (start > 0) {
+			std::memmove(buffer.data(), buffer.data() + start, used - start);
+			used -= start;
+			start = 0;
+		}
+		if (buffer.size() - used < READSIZE) {
+			if (used > MAXMESSAGELENGTH) {
+				throw std::runtime_error("message longer than 16 MB");
+			}
+			buffer.resize(used + READSIZE);
+		}
+
+		ssize_t count = read(descriptor, buffer.data() + used, READSIZE);
+		if (count < 0) {
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+				return (wouldblock);
+			}
+			if (errno == EINTR) {
+				continue;
+			}
+			throw SystemError("read");
+		}
+		if (count == 0) {
+			ended = true;
+		}
+		used += count;
+	}
+}
+
+int messagestream::getdescriptor() const {
+	return (descriptor);
+}
+
+bool messagestream::parseline(size_t length, parseresult &result) {
+	// skip blank lines and carriage returns
+	const char *line = buffer.data() + start;
+	while ((length > 0) && (line[length - 1] == '\r')) {
+		length--;
+	}
+	if (length == 0) {
+		return (false);
+	}
+
+	result.type = formattypes::unknown;
+	result.object.reset();
+	result.error.clear();
+	ParseMessage(line, length, parsecontext::local(), result);
+	return (true);
+}
+
+eventloop::eventloop()
+		: epolldescriptor(-1),
+			wakedescriptor(-1),
+			waiting(0),
+			stopping(false) {
+	epolldescriptor = epoll_create1(EPOLL_CLOEXEC);
+	if (epolldescriptor < 0) {
+		throw SystemError("epoll_create1");
+	}
+
+	wakedescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wakedescriptor < 0) {
+		close(epolldescriptor);
+		throw SystemError("eventfd");
+	}
+
+	epoll_event event;
+	std::memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = wakedescriptor;
+	epoll_ctl(epolldescriptor, EPOLL_CTL_ADD, wakedescriptor, &event);
+}
+
+eventloop::~eventloop() {
+	close(wakedescriptor);
+	close(epolldescriptor);
+}
+
+void eventloop::watch(int descriptor, eventwaiter &waiter) {
+	epoll_event event;
+	std::memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | EPOLLONESHOT;
+	event.data.fd = descriptor;
+
+	// a descriptor watched before is still registered, but disarmed
+	if ((epoll_ctl(epolldescriptor, EPOLL_CTL_MOD, descriptor, &event) < 0)
+			&& ((errno != ENOENT)
+					|| (epoll_ctl(epolldescriptor, EPOLL_CTL_ADD, descriptor,
+							&event) < 0))) {
+		throw SystemError("epoll_ctl");
+	}
+
+	if (static_cast<size_t>(descriptor) >= waiters.size()) {
+		waiters.resize(descriptor + 1, NULL);
+	}
+	if (waiters[descriptor] == NULL) {
+		waiting++;
+	}
+	waiters[descriptor] = &waiter;
+}
+
+void eventloop::forget(int descriptor) {
+	epoll_ctl(epolldescriptor, EPOLL_CTL_DEL, descriptor, NULL);
+	if ((static_cast<size_t>(descriptor) < waiters.size())
+			&& (waiters[descriptor] != NULL)) {
+		waiters[descriptor] = NULL;
+		waiting--;
+	}
+}
+
+void eventloop::run() {
+	epoll_event events[MAXEVENTS];
+
+	while ((stopping.load() == false) && (waiting > 0)) {
+		int count = epoll_wait(epolldescriptor, events, MAXEVENTS, -1);
+		if (count < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw SystemError("epoll_wait");
+		}
+
+		for (int i = 0; i < count; i++) {
+			int descriptor = events[i].data.fd;
+			if (descriptor == wakedescriptor) {
+				uint64_t value;
+				while (read(wakedescriptor, &value, sizeof(value)) > 0) {
+				}
+				continue;
+			}
+
+			// a waiter earlier in this batch may have forgotten descriptor
+			if ((static_cast<size_t>(descriptor) >= waiters.size())
+					|| (waiters[descriptor] == NULL)) {
+				continue;
+			}
+
+			// the watch is spent, the waiter may watch again from ready()
+			eventwaiter *waiter = waiters[descriptor];
+			waiters[descriptor] = NULL;
+			waiting--;
+			waiter->ready();
+		}
+	}
+}
+
+void eventloop::stop() {
+	stopping.store(true);
+
+	uint64_t value = 1;
+	ssize_t written = write(wakedescriptor, &value, sizeof(value));
+	(void) written;
+}
+}
+#endif
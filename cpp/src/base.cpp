@@ -16,7 +16,7 @@ namespace detectionformats
 	{
 	}
 
-	bool detectionbase::isvalid()
+	bool detectionbase::isvalid() const
 	{
 		std::vector<std::string> errorlist = geterrors();
 		std::string errorstring = "";
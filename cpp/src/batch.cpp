@@ -0,0 +1,120 @@
+#include "batch.h"
+#include "pick.h"
+#include "correlation.h"
+#include "detection.h"
+#include "retract.h"
+#include "stationInfo.h"
+#include "stationInfoRequest.h"
+
+#include <exception>
+
+// JSON Keys
+#define TYPE_KEY "Type"
+
+namespace detectionformats {
+
+// fills result from document, which buffer has just been parsed into
+template<class D>
+static void ParseDocument(const char *buffer, D &document,
+		parseresult &result) {
+	if ((buffer == NULL) || (document.HasParseError() == true)) {
+		result.error = "Error parsing JSON string into document.";
+		return;
+	}
+	if (document.IsObject() == false) {
+		result.error = "JSON string did not parse into valid JSON.";
+		return;
+	}
+
+	rapidjson::Value::ConstMemberIterator typemember = document.FindMember(
+			TYPE_KEY);
+	if ((typemember == document.MemberEnd())
+			|| (typemember->value.IsString() == false)) {
+		result.error = "Missing or invalid Type.";
+		return;
+	}
+
+	const rapidjson::Value &type = typemember->value;
+	try {
+		if (IsJSONKey(type, PICK_TYPE) == true) {
+			result.type = formattypes::picktype;
+			result.object = std::make_shared<pick>(document);
+		} else if (IsJSONKey(type, CORRELATION_TYPE) == true) {
+			result.type = formattypes::correlationtype;
+			result.object = std::make_shared<correlation>(document);
+		} else if (IsJSONKey(type, DETECTION_TYPE) == true) {
+			result.type = formattypes::detectiontype;
+			result.object = std::make_shared<detection>(document);
+		} else if (IsJSONKey(type, RETRACT_TYPE) == true) {
+			result.type = formattypes::retracttype;
+			result.object = std::make_shared<retract>(document);
+		} else if (IsJSONKey(type, STATIONINFO_TYPE) == true) {
+			result.type = formattypes::stationinfotype;
+			result.object = std::make_shared<stationInfo>(document);
+		} else if (IsJSONKey(type, STATIONINFOREQUEST_TYPE) == true) {
+			result.type = formattypes::stationinforequesttype;
+			result.object = std::make_shared<stationInfoRequest>(document);
+		} else {
+			result.error = "Unknown Type.";
+		}
+	} catch (const std::exception &e) {
+		result.object.reset();
+		result.error = e.what();
+	}
+}
+
+void ParseMessage(const char *buffer, size_t length,
+		rapidjson::Document &document, parseresult &result) {
+	// reclaim the previous message's values, a failed parse leaves the root
+	// alone so empty it first so nothing still points into them
+	document.SetNull();
+	document.GetAllocator().Clear();
+
+	if (buffer != NULL) {
+		document.Parse(buffer, length);
+	}
+	ParseDocument(buffer, document, result);
+}
+
+void ParseMessage(const char *buffer, size_t length, parsecontext &context,
+		parseresult &result) {
+	if (buffer == NULL) {
+		result.error = "Error parsing JSON string into document.";
+		return;
+	}
+	ParseDocument(buffer, context.parse(buffer, length), result);
+}
+
+std::vector<parseresult> ParseBatch(const std::vector<std::string> &messages,
+		threadpool &pool) {
+	std::vector<parseresult> results(messages.size());
+
+	pool.run(messages.size(), 0,
+			[&messages, &results](size_t begin, size_t end) {
+				// the worker's context, reused for every message it parses
+				parsecontext &context = parsecontext::local();
+				for (size_t i = begin; i < end; i++) {
+					ParseMessage(messages[i].c_str(), messages[i].length(),
+							context, results[i]);
+				}
+			});
+
+	return (results);
+}
+
+std::vector<parseresult> ParseBatch(const char * const *buffers,
+		const size_t *lengths, size_t count, threadpool &pool) {
+	std::vector<parseresult> results(count);
+
+	pool.run(count, 0,
+			[buffers, lengths, &results](size_t begin, size_t end) {
+				// the worker's context, reused for every message it parses
+				parsecontext &context = parsecontext::local();
+				for (size_t i = begin; i < end; i++) {
+					ParseMessage(buffers[i], lengths[i], context, results[i]);
+				}
+			});
+
+	return (results);
+}
+}
@@ -1,4 +1,5 @@
 #include "beam.h"
+#include "fields.h"
 
 #include <limits>
 
@@ -11,6 +12,20 @@
 #define POWERRATIOERROR_KEY "PowerRatioError"
 
 namespace detectionformats {
+// field descriptors, in the order the fields are written to json
+static constexpr auto fields = std::make_tuple(
+		detectionformats::requiredfield(
+				detectionformats::numberfield(BACKAZIMUTH_KEY,
+						&beam::backazimuth)),
+		detectionformats::requiredfield(
+				detectionformats::numberfield(SLOWNESS_KEY, &beam::slowness)),
+		detectionformats::numberfield(POWERRATIO_KEY, &beam::powerratio),
+		detectionformats::numberfield(BACKAZIMUTHERROR_KEY,
+				&beam::backazimutherror),
+		detectionformats::numberfield(SLOWNESSERROR_KEY, &beam::slownesserror),
+		detectionformats::numberfield(POWERRATIOERROR_KEY,
+				&beam::powerratioerror));
+
 beam::beam() {
 	backazimuth = std::numeric_limits<double>::quiet_NaN();
 	backazimutherror = std::numeric_limits<double>::quiet_NaN();
@@ -32,55 +47,7 @@ beam::beam(double newbackazimuth, double newbackazimutherror,
 }
 
 beam::beam(rapidjson::Value &json) {
-	// required values
-	// backazimuth
-	if ((json.HasMember(BACKAZIMUTH_KEY) == true)
-			&& (json[BACKAZIMUTH_KEY].IsNumber() == true)
-			&& (json[BACKAZIMUTH_KEY].IsDouble() == true))
-		backazimuth = json[BACKAZIMUTH_KEY].GetDouble();
-	else
-		backazimuth = std::numeric_limits<double>::quiet_NaN();
-
-	// slowness
-	if ((json.HasMember(SLOWNESS_KEY) == true)
-			&& (json[SLOWNESS_KEY].IsNumber() == true)
-			&& (json[SLOWNESS_KEY].IsDouble() == true))
-		slowness = json[SLOWNESS_KEY].GetDouble();
-	else
-		slowness = std::numeric_limits<double>::quiet_NaN();
-
-	// optional values
-	// power ratio
-	if ((json.HasMember(POWERRATIO_KEY) == true)
-			&& (json[POWERRATIO_KEY].IsNumber() == true)
-			&& (json[POWERRATIO_KEY].IsDouble() == true))
-		powerratio = json[POWERRATIO_KEY].GetDouble();
-	else
-		powerratio = std::numeric_limits<double>::quiet_NaN();
-
-	// backazimutherror
-	if ((json.HasMember(BACKAZIMUTHERROR_KEY) == true)
-			&& (json[BACKAZIMUTHERROR_KEY].IsNumber() == true)
-			&& (json[BACKAZIMUTHERROR_KEY].IsDouble() == true))
-		backazimutherror = json[BACKAZIMUTHERROR_KEY].GetDouble();
-	else
-		backazimutherror = std::numeric_limits<double>::quiet_NaN();
-
-	// slownesserror
-	if ((json.HasMember(SLOWNESSERROR_KEY) == true)
-			&& (json[SLOWNESSERROR_KEY].IsNumber() == true)
-			&& (json[SLOWNESSERROR_KEY].IsDouble() == true))
-		slownesserror = json[SLOWNESSERROR_KEY].GetDouble();
-	else
-		slownesserror = std::numeric_limits<double>::quiet_NaN();
-
-	// powerratioerror
-	if ((json.HasMember(POWERRATIOERROR_KEY) == true)
-			&& (json[POWERRATIOERROR_KEY].IsNumber() == true)
-			&& (json[POWERRATIOERROR_KEY].IsDouble() == true))
-		powerratioerror = json[POWERRATIOERROR_KEY].GetDouble();
-	else
-		powerratioerror = std::numeric_limits<double>::quiet_NaN();
+	resetfrom(json);
 }
 
 beam::beam(const beam &newbeam) {
@@ -96,57 +63,55 @@ beam::beam(const beam &newbeam) {
 beam::~beam() {
 }
 
-rapidjson::Value & beam::tojson(rapidjson::Value &json,
-		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) {
-	json.SetObject();
+void beam::resetfrom(rapidjson::Value &json) {
+	clear();
 
-	// required values
-	// backazimuth
-	if (std::isnan(backazimuth) != true)
-		json.AddMember(BACKAZIMUTH_KEY, backazimuth, allocator);
+	detectionformats::ParseFields(*this, json, fields);
+}
 
-	// slowness
-	if (std::isnan(slowness) != true)
-		json.AddMember(SLOWNESS_KEY, slowness, allocator);
+void beam::clear() {
+	backazimuth = std::numeric_limits<double>::quiet_NaN();
+	backazimutherror = std::numeric_limits<double>::quiet_NaN();
+	slowness = std::numeric_limits<double>::quiet_NaN();
+	slownesserror = std::numeric_limits<double>::quiet_NaN();
+	powerratio = std::numeric_limits<double>::quiet_NaN();
+	powerratioerror = std::numeric_limits<double>::quiet_NaN();
+}
 
-	// optional values
-	// powerratio
-	if (std::isnan(powerratio) != true)
-		json.AddMember(POWERRATIO_KEY, powerratio, allocator);
+rapidjson::Value & beam::tojson(rapidjson::Value &json,
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+	return (detectionformats::WriteFields(*this, json, allocator, fields));
+}
 
-	// backazimutherror
-	if (std::isnan(backazimutherror) != true)
-		json.AddMember(BACKAZIMUTHERROR_KEY, backazimutherror, allocator);
+void beam::tobinary(std::string &buffer) const {
+	detectionformats::EncodeFields(*this, buffer, fields);
+}
 
-	// slownesserror
-	if (std::isnan(slownesserror) != true)
-		json.AddMember(SLOWNESSERROR_KEY, slownesserror, allocator);
+size_t beam::frombinary(const char *buffer, size_t length) {
+	return (detectionformats::DecodeFields(*this, buffer, length, fields));
+}
 
-	// powerratioerror
-	if (std::isnan(powerratioerror) != true)
-		json.AddMember(POWERRATIOERROR_KEY, powerratioerror, allocator);
+bool beam::operator==(const beam &other) const {
+	return (detectionformats::EqualFields(*this, other, fields));
+}
 
-	return (json);
+bool beam::operator!=(const beam &other) const {
+	return (!(*this == other));
 }
 
-std::vector<std::string> beam::geterrors() {
+std::vector<std::string> beam::geterrors() const {
 	std::vector<std::string> errorlist;
 
 	// check required data
+	// backazimuth and slowness
+	detectionformats::CheckRequiredFields(*this, "beam", fields, errorlist);
+
 	// backazimuth
-	if (std::isnan(backazimuth) == true) {
-		// backazimuth not found
-		errorlist.push_back("No BackAzimuth in beam class.");
-	}
 	if (backazimuth < 0) {
 		errorlist.push_back("Invalid BackAzimuth in beam class.");
 	}
 
 	// slowness
-	if (std::isnan(slowness) == true) {
-		// slowness not found
-		errorlist.push_back("No Slowness in beam class.");
-	}
 	if (slowness < 0) {
 		errorlist.push_back("Invalid Slowness in beam class.");
 	}
@@ -182,7 +147,7 @@ std::vector<std::string> beam::geterrors() {
 	return (errorlist);
 }
 
-bool beam::isempty()
+bool beam::isempty() const
 {
 	if (std::isnan(backazimuth) != true)
 		return(false);
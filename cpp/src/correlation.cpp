@@ -1,4 +1,5 @@
 #include "correlation.h"
+#include "fields.h"
 
 #include <limits>
 
@@ -20,6 +21,37 @@
 #define ASSOCIATIONINFO_KEY "AssociationInfo"
 
 namespace detectionformats {
+// field descriptors, in the order the fields are written to json
+static constexpr auto fields = std::make_tuple(
+		detectionformats::stringfield(TYPE_KEY, &correlation::type, true),
+		detectionformats::requiredfield(
+				detectionformats::stringfield(ID_KEY, &correlation::id)),
+		detectionformats::requiredfield(
+				detectionformats::objectfield(SITE_KEY, &correlation::site)),
+		detectionformats::requiredfield(
+				detectionformats::objectfield(SOURCE_KEY,
+						&correlation::source)),
+		detectionformats::requiredfield(
+				detectionformats::stringfield(PHASE_KEY, &correlation::phase)),
+		detectionformats::requiredfield(
+				detectionformats::timefield(TIME_KEY, &correlation::time)),
+		detectionformats::requiredfield(
+				detectionformats::numberfield(CORRELATION_KEY,
+						&correlation::correlationvalue)),
+		detectionformats::requiredfield(
+				detectionformats::objectfield(HYPOCENTER_KEY,
+						&correlation::hypocenter)),
+		detectionformats::stringfield(EVENTTYPE_KEY, &correlation::eventtype),
+		detectionformats::numberfield(MAGNITUDE_KEY, &correlation::magnitude),
+		detectionformats::numberfield(SNR_KEY, &correlation::snr),
+		detectionformats::numberfield(ZSCORE_KEY, &correlation::zscore),
+		detectionformats::numberfield(DETECTIONTHRESHOLD_KEY,
+				&correlation::detectionthreshold),
+		detectionformats::stringfield(THRESHOLDTYPE_KEY,
+				&correlation::thresholdtype),
+		detectionformats::optionalobjectfield(ASSOCIATIONINFO_KEY,
+				&correlation::associationinfo));
+
 correlation::correlation() {
 	type = CORRELATION_TYPE;
 	id = "";
@@ -148,126 +180,7 @@ correlation::correlation(std::string newid, detectionformats::site newsite,
 }
 
 correlation::correlation(rapidjson::Value &json) {
-	// required values
-	// type
-	if ((json.HasMember(TYPE_KEY) == true)
-			&& (json[TYPE_KEY].IsString() == true))
-		type = std::string(json[TYPE_KEY].GetString(),
-				json[TYPE_KEY].GetStringLength());
-	else
-		type = "";
-
-	// id
-	if ((json.HasMember(ID_KEY) == true) && (json[ID_KEY].IsString() == true))
-		id = std::string(json[ID_KEY].GetString(),
-				json[ID_KEY].GetStringLength());
-	else
-		id = "";
-
-	// site
-	if ((json.HasMember(SITE_KEY) == true)
-			&& (json[SITE_KEY].IsObject() == true)) {
-		rapidjson::Value & sitevalue = json["Site"];
-		site = detectionformats::site(sitevalue);
-	} else
-		site = detectionformats::site();
-
-	// source
-	if ((json.HasMember(SOURCE_KEY) == true)
-			&& (json[SOURCE_KEY].IsObject() == true)) {
-		rapidjson::Value & sourcevalue = json[SOURCE_KEY];
-		source = detectionformats::source(sourcevalue);
-	} else
-		source = detectionformats::source();
-
-	// phase
-	if ((json.HasMember(PHASE_KEY) == true)
-			&& (json[PHASE_KEY].IsString() == true))
-		phase = std::string(json[PHASE_KEY].GetString(),
-				json[PHASE_KEY].GetStringLength());
-	else
-		phase = "";
-
-	// time
-	if ((json.HasMember(TIME_KEY) == true)
-			&& (json[TIME_KEY].IsString() == true))
-		time = detectionformats::ConvertISO8601ToEpochTime(
-				std::string(json[TIME_KEY].GetString(),
-						json[TIME_KEY].GetStringLength()));
-	else
-		time = std::numeric_limits<double>::quiet_NaN();
-
-	// correlation
-	if ((json.HasMember(CORRELATION_KEY) == true)
-			&& (json[CORRELATION_KEY].IsNumber() == true)
-			&& (json[CORRELATION_KEY].IsDouble() == true))
-		correlationvalue = json[CORRELATION_KEY].GetDouble();
-	else
-		correlationvalue = std::numeric_limits<double>::quiet_NaN();
-
-	// hypocenter
-	if ((json.HasMember(HYPOCENTER_KEY) == true)
-			&& (json[HYPOCENTER_KEY].IsObject() == true)) {
-		rapidjson::Value & hypocentervalue = json[HYPOCENTER_KEY];
-		hypocenter = detectionformats::hypocenter(hypocentervalue);
-	} else
-		hypocenter = detectionformats::hypocenter();
-
-	// optional values
-	// eventtype
-	if ((json.HasMember(EVENTTYPE_KEY) == true)
-			&& (json[EVENTTYPE_KEY].IsString() == true))
-		eventtype = std::string(json[EVENTTYPE_KEY].GetString(),
-				json[EVENTTYPE_KEY].GetStringLength());
-	else
-		eventtype = "";
-
-	// magnitude
-	if ((json.HasMember(MAGNITUDE_KEY) == true)
-			&& (json[MAGNITUDE_KEY].IsNumber() == true)
-			&& (json[MAGNITUDE_KEY].IsDouble() == true))
-		magnitude = json[MAGNITUDE_KEY].GetDouble();
-	else
-		magnitude = std::numeric_limits<double>::quiet_NaN();
-
-	// snr
-	if ((json.HasMember(SNR_KEY) == true) && (json[SNR_KEY].IsNumber() == true)
-			&& (json[SNR_KEY].IsDouble() == true))
-		snr = json[SNR_KEY].GetDouble();
-	else
-		snr = std::numeric_limits<double>::quiet_NaN();
-
-	// zscore
-	if ((json.HasMember(ZSCORE_KEY) == true)
-			&& (json[ZSCORE_KEY].IsNumber() == true)
-			&& (json[ZSCORE_KEY].IsDouble() == true))
-		zscore = json[ZSCORE_KEY].GetDouble();
-	else
-		zscore = std::numeric_limits<double>::quiet_NaN();
-
-	// detectionthreshold
-	if ((json.HasMember(DETECTIONTHRESHOLD_KEY) == true)
-			&& (json[DETECTIONTHRESHOLD_KEY].IsNumber() == true)
-			&& (json[DETECTIONTHRESHOLD_KEY].IsDouble() == true))
-		detectionthreshold = json[DETECTIONTHRESHOLD_KEY].GetDouble();
-	else
-		detectionthreshold = std::numeric_limits<double>::quiet_NaN();
-
-	// thresholdtype
-	if ((json.HasMember(THRESHOLDTYPE_KEY) == true)
-			&& (json[THRESHOLDTYPE_KEY].IsString() == true))
-		thresholdtype = std::string(json[THRESHOLDTYPE_KEY].GetString(),
-				json[THRESHOLDTYPE_KEY].GetStringLength());
-	else
-		thresholdtype = "";
-
-	// associated
-	if ((json.HasMember(ASSOCIATIONINFO_KEY) == true)
-			&& (json[ASSOCIATIONINFO_KEY].IsObject() == true)) {
-		rapidjson::Value & associatedvalue = json[ASSOCIATIONINFO_KEY];
-		associationinfo = detectionformats::associated(associatedvalue);
-	} else
-		associationinfo = detectionformats::associated();
+	resetfrom(json);
 }
 
 correlation::correlation(const correlation &newcorrelation) {
@@ -291,103 +204,59 @@ correlation::correlation(const correlation &newcorrelation) {
 correlation::~correlation() {
 }
 
-rapidjson::Value & correlation::tojson(rapidjson::Value &json,
-		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) {
-	json.SetObject();
-
-	// required values
-	// type
-	rapidjson::Value typevalue;
-	typevalue.SetString(rapidjson::StringRef(type.c_str()), allocator);
-	json.AddMember(TYPE_KEY, typevalue, allocator);
-
-	// id
-	if (id != "") {
-		rapidjson::Value idvalue;
-		idvalue.SetString(rapidjson::StringRef(id.c_str()), allocator);
-		json.AddMember(ID_KEY, idvalue, allocator);
-	}
-
-	// site
-	rapidjson::Value sitevalue(rapidjson::kObjectType);
-	site.tojson(sitevalue, allocator);
-	json.AddMember(SITE_KEY, sitevalue, allocator);
+void correlation::resetfrom(rapidjson::Value &json) {
+	clear();
+	type.clear();
 
-	// source
-	rapidjson::Value sourcevalue(rapidjson::kObjectType);
-	source.tojson(sourcevalue, allocator);
-	json.AddMember(SOURCE_KEY, sourcevalue, allocator);
-
-	// phase
-	if (phase != "") {
-		rapidjson::Value phasevalue;
-		phasevalue.SetString(rapidjson::StringRef(phase.c_str()), allocator);
-		json.AddMember(PHASE_KEY, phasevalue, allocator);
-	}
+	detectionformats::ParseFields(*this, json, fields);
+}
 
-	// time
-	if (std::isnan(time) != true) {
-		std::string timestring = detectionformats::ConvertEpochTimeToISO8601(
-				time);
-		rapidjson::Value timevalue;
-		timevalue.SetString(rapidjson::StringRef(timestring.c_str()),
-				allocator);
-		json.AddMember(TIME_KEY, timevalue, allocator);
-	}
+void correlation::resetfrom(const char *jsonbuffer, size_t length,
+		rapidjson::Document &jsondocument) {
+	resetfrom(detectionformats::FromJSONString(jsonbuffer, length,
+			jsondocument));
+}
 
-	// correlation
-	if (std::isnan(correlationvalue) != true)
-		json.AddMember(CORRELATION_KEY, correlationvalue, allocator);
+void correlation::clear() {
+	type = CORRELATION_TYPE;
+	id.clear();
+	site.clear();
+	source.clear();
+	phase.clear();
+	time = std::numeric_limits<double>::quiet_NaN();
+	correlationvalue = std::numeric_limits<double>::quiet_NaN();
+	hypocenter.clear();
+	eventtype.clear();
+	magnitude = std::numeric_limits<double>::quiet_NaN();
+	snr = std::numeric_limits<double>::quiet_NaN();
+	zscore = std::numeric_limits<double>::quiet_NaN();
+	detectionthreshold = std::numeric_limits<double>::quiet_NaN();
+	thresholdtype.clear();
+	associationinfo.clear();
+}
 
-	// hypocenter
-	rapidjson::Value hypocentervalue(rapidjson::kObjectType);
-	hypocenter.tojson(hypocentervalue, allocator);
-	json.AddMember(HYPOCENTER_KEY, hypocentervalue, allocator);
+rapidjson::Value & correlation::tojson(rapidjson::Value &json,
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+	return (detectionformats::WriteFields(*this, json, allocator, fields));
+}
 
-	// optional values
-	// eventtype
-	if (eventtype != "") {
-		rapidjson::Value eventtypevalue;
-		eventtypevalue.SetString(rapidjson::StringRef(eventtype.c_str()),
-				allocator);
-		json.AddMember(EVENTTYPE_KEY, eventtypevalue, allocator);
-	}
+void correlation::tobinary(std::string &buffer) const {
+	detectionformats::EncodeFields(*this, buffer, fields);
+}
 
-	// magnitude
-	if (std::isnan(magnitude) != true)
-		json.AddMember(MAGNITUDE_KEY, magnitude, allocator);
-
-	// snr
-	if (std::isnan(snr) != true)
-		json.AddMember(SNR_KEY, snr, allocator);
-
-	// zscore
-	if (std::isnan(zscore) != true)
-		json.AddMember(ZSCORE_KEY, zscore, allocator);
-
-	// detectionthreshold
-	if (std::isnan(detectionthreshold) != true)
-		json.AddMember(DETECTIONTHRESHOLD_KEY, detectionthreshold, allocator);
-
-	// thresholdtype
-	if (thresholdtype != "") {
-		rapidjson::Value thresholdtypevalue;
-		thresholdtypevalue.SetString(
-				rapidjson::StringRef(thresholdtype.c_str()), allocator);
-		json.AddMember(THRESHOLDTYPE_KEY, thresholdtypevalue, allocator);
-	}
+size_t correlation::frombinary(const char *buffer, size_t length) {
+	return (detectionformats::DecodeFields(*this, buffer, length, fields));
+}
 
-	// associated
-	if (associationinfo.isempty() == false) {
-		rapidjson::Value associatedvalue(rapidjson::kObjectType);
-		associationinfo.tojson(associatedvalue, allocator);
-		json.AddMember(ASSOCIATIONINFO_KEY, associatedvalue, allocator);
-	}
+bool correlation::operator==(const correlation &other) const {
+	return (detectionformats::EqualFields(*this, other, fields));
+}
 
-	return (json);
+bool correlation::operator!=(const correlation &other) const {
+	return (!(*this == other));
 }
 
-std::vector<std::string> correlation::geterrors() {
+std::vector<std::string> correlation::geterrors() const {
 	std::vector<std::string> errorlist;
 
 	// check required data
@@ -397,38 +266,17 @@ std::vector<std::string> correlation::geterrors() {
 		errorlist.push_back("Non-correlation type in correlation class.");
 	}
 
-	// id
-	if (id == "") {
-		// empty id
-		errorlist.push_back("Empty ID in correlation class.");
-	}
-
-	// site
-	if (site.isvalid() != true) {
-		// site not found
-		errorlist.push_back(
-				"Site object did not validate in correlation class.");
-	}
-
-	// source
-	if (source.isvalid() != true) {
-		// bad source
-		errorlist.push_back(
-				"Source object did not validate in correlation class.");
-	}
+	// id, site, source, phase, time, correlationvalue, and hypocenter
+	detectionformats::CheckRequiredFields(*this, "correlation", fields,
+			errorlist);
 
 	// phase
-	if (phase == "") {
-		errorlist.push_back("Empty Phase in correlation class.");
-	}
-	if (detectionformats::IsStringAlpha(phase) == false) {
+	if ((phase != "") && (detectionformats::IsStringAlpha(phase) == false)) {
 		errorlist.push_back("Phase did not validate in correlation class.");
 	}
 
 	// time
-	if (std::isnan(time) == true) {
-		errorlist.push_back("Time is missing in correlation class.");
-	} else {
+	if (std::isnan(time) != true) {
 		try {
 			if (detectionformats::IsStringISO8601(
 					detectionformats::ConvertEpochTimeToISO8601(time))
@@ -442,21 +290,10 @@ std::vector<std::string> correlation::geterrors() {
 	}
 
 	// correlationvalue
-	if (std::isnan(correlationvalue) == true) {
-		// correlationvalue not found
-		errorlist.push_back("No Correlation in correlation class.");
-	}
 	if (correlationvalue < 0) {
 		errorlist.push_back("Invalid Correlation in correlation class.");
 	}
 
-	// hypocenter
-	if (hypocenter.isvalid() != true) {
-		// hypocenter not found
-		errorlist.push_back(
-				"hypocenter object did not validate in correlation class.");
-	}
-
 	// optional data
 	// eventtype
 	if (eventtype != "") {
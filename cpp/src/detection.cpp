@@ -1,5 +1,7 @@
 #include "detection.h"
+#include "fields.h"
 
+#include <atomic>
 #include <limits>
 
 // JSON Keys
@@ -17,6 +19,171 @@
 #define DATA_KEY "Data"
 
 namespace detectionformats {
+// the Data array, holding both the pick and correlation data
+struct datadescriptor : detectionformats::fielddescriptor {
+	constexpr datadescriptor()
+			: fielddescriptor(DATA_KEY, sizeof(DATA_KEY) - 1) {
+	}
+
+	// returns the Type string of a Data entry, or NULL if the entry is not
+	// an object with a string Type
+	static const rapidjson::Value * datatype(const rapidjson::Value &value) {
+		if (value.IsObject() == false)
+			return (NULL);
+
+		rapidjson::Value::ConstMemberIterator typemember = value.FindMember(
+				TYPE_KEY);
+		if ((typemember == value.MemberEnd())
+				|| (typemember->value.IsString() == false))
+			return (NULL);
+
+		return (&typemember->value);
+	}
+
+	void parse(detection &object, rapidjson::Value &value) const {
+		if (value.IsArray() == false)
+			return;
+
+		// first pass, count each type so that the vectors are sized exactly
+		size_t pickcount = 0;
+		size_t correlationcount = 0;
+		for (rapidjson::Value::ConstValueIterator data = value.Begin();
+				data != value.End(); ++data) {
+			const rapidjson::Value * type = datatype(*data);
+			if (type == NULL)
+				continue;
+
+			if (detectionformats::IsJSONKey(*type, PICK_TYPE) == true)
+				pickcount++;
+			else if (detectionformats::IsJSONKey(*type, CORRELATION_TYPE)
+					== true)
+				correlationcount++;
+		}
+		object.pickdata.reserve(object.pickdata.size() + pickcount);
+		object.correlationdata.reserve(
+				object.correlationdata.size() + correlationcount);
+
+		// second pass, construct each entry in place from its json
+		for (rapidjson::Value::ValueIterator data = value.Begin();
+				data != value.End(); ++data) {
+			const rapidjson::Value * type = datatype(*data);
+			if (type == NULL)
+				continue;
+
+			if (detectionformats::IsJSONKey(*type, PICK_TYPE) == true)
+				object.pickdata.emplace_back(*data);
+			else if (detectionformats::IsJSONKey(*type, CORRELATION_TYPE)
+					== true)
+				object.correlationdata.emplace_back(*data);
+		}
+	}
+
+	void write(const detection &object, rapidjson::Value &json,
+			rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+		if ((object.pickdata.empty() == true)
+				&& (object.correlationdata.empty() == true))
+			return;
+
+		rapidjson::Value dataarray(rapidjson::kArrayType);
+		dataarray.Reserve(
+				static_cast<rapidjson::SizeType>(object.pickdata.size()
+						+ object.correlationdata.size()), allocator);
+
+		// pickdata, read through the const object so that the data is not copied
+		for (size_t i = 0; i < object.pickdata.size(); i++) {
+			rapidjson::Value pickvalue(rapidjson::kObjectType);
+			object.pickdata[i].tojson(pickvalue, allocator);
+			dataarray.PushBack(pickvalue, allocator);
+		}
+
+		// correlationdata
+		for (size_t i = 0; i < object.correlationdata.size(); i++) {
+			rapidjson::Value correlationvalue(rapidjson::kObjectType);
+			object.correlationdata[i].tojson(correlationvalue,
+					allocator);
+			dataarray.PushBack(correlationvalue, allocator);
+		}
+
+		json.AddMember(jsonkey(), dataarray, allocator);
+	}
+
+	void encode(const detection &object, std::string &buffer) const {
+		detectionformats::WriteBinaryLength(object.pickdata.size(), buffer);
+		for (size_t i = 0; i < object.pickdata.size(); i++) {
+			object.pickdata[i].tobinary(buffer);
+		}
+
+		detectionformats::WriteBinaryLength(object.correlationdata.size(),
+				buffer);
+		for (size_t i = 0; i < object.correlationdata.size(); i++) {
+			object.correlationdata[i].tobinary(buffer);
+		}
+	}
+
+	void decode(detection &object,
+			detectionformats::binaryreader &reader) const {
+		object.pickdata.clear();
+		size_t count = reader.readlength();
+		for (size_t i = 0; i < count; i++) {
+			detectionformats::pick & newpick = object.pickdata.emplace_back();
+			reader.skip(
+					newpick.frombinary(reader.current(), reader.remaining()));
+		}
+
+		object.correlationdata.clear();
+		count = reader.readlength();
+		for (size_t i = 0; i < count; i++) {
+			detectionformats::correlation & newcorrelation =
+					object.correlationdata.emplace_back();
+			reader.skip(
+					newcorrelation.frombinary(reader.current(),
+							reader.remaining()));
+		}
+	}
+
+	bool equal(const detection &a, const detection &b) const {
+		if ((a.pickdata.size() != b.pickdata.size())
+				|| (a.correlationdata.size() != b.correlationdata.size()))
+			return (false);
+
+		// shared elements are equal without comparing their members
+		for (size_t i = 0; i < a.pickdata.size(); i++) {
+			if ((a.pickdata.gethandle(i) != b.pickdata.gethandle(i))
+					&& (a.pickdata[i] != b.pickdata[i]))
+				return (false);
+		}
+		for (size_t i = 0; i < a.correlationdata.size(); i++) {
+			if ((a.correlationdata.gethandle(i)
+					!= b.correlationdata.gethandle(i))
+					&& (a.correlationdata[i] != b.correlationdata[i]))
+				return (false);
+		}
+		return (true);
+	}
+};
+
+// field descriptors, in the order the fields are written to json
+static constexpr auto fields = std::make_tuple(
+		detectionformats::stringfield(TYPE_KEY, &detection::type, true),
+		detectionformats::requiredfield(
+				detectionformats::stringfield(ID_KEY, &detection::id)),
+		detectionformats::requiredfield(
+				detectionformats::objectfield(SOURCE_KEY, &detection::source)),
+		detectionformats::requiredfield(
+				detectionformats::objectfield(HYPOCENTER_KEY,
+						&detection::hypocenter)),
+		detectionformats::stringfield(DETECTIONTYPE_KEY,
+				&detection::detectiontype),
+		detectionformats::timefield(DETECTIONTIME_KEY,
+				&detection::detectiontime),
+		detectionformats::stringfield(EVENTTYPE_KEY, &detection::eventtype),
+		detectionformats::numberfield(BAYES_KEY, &detection::bayes),
+		detectionformats::numberfield(MINIMUMDISTANCE_KEY,
+				&detection::minimumdistance),
+		detectionformats::numberfield(RMS_KEY, &detection::rms),
+		detectionformats::numberfield(GAP_KEY, &detection::gap),
+		datadescriptor());
+
 detection::detection() {
 	type = DETECTION_TYPE;
 	id = "";
@@ -57,15 +224,8 @@ detection::detection(std::string newid, std::string newagencyid,
 	gap = newgap;
 
 	// copy data
-	pickdata.clear();
-	for (int i = 0; i < (int) newpickdata.size(); i++) {
-		pickdata.push_back(newpickdata[i]);
-	}
-
-	correlationdata.clear();
-	for (int i = 0; i < (int) newcorrelationdata.size(); i++) {
-		correlationdata.push_back(newcorrelationdata[i]);
-	}
+	pickdata = newpickdata;
+	correlationdata = newcorrelationdata;
 }
 
 detection::detection(std::string newid, detectionformats::source newsource,
@@ -88,137 +248,12 @@ detection::detection(std::string newid, detectionformats::source newsource,
 	gap = newgap;
 
 	// copy data
-	pickdata.clear();
-	for (int i = 0; i < (int) newpickdata.size(); i++) {
-		pickdata.push_back(newpickdata[i]);
-	}
-
-	correlationdata.clear();
-	for (int i = 0; i < (int) newcorrelationdata.size(); i++) {
-		correlationdata.push_back(newcorrelationdata[i]);
-	}
+	pickdata = newpickdata;
+	correlationdata = newcorrelationdata;
 }
 
 detection::detection(rapidjson::Value &json) {
-	// required values
-	// type
-	if ((json.HasMember(TYPE_KEY) == true)
-			&& (json[TYPE_KEY].IsString() == true))
-		type = std::string(json[TYPE_KEY].GetString(),
-				json[TYPE_KEY].GetStringLength());
-	else
-		type = "";
-
-	// id
-	if ((json.HasMember(ID_KEY) == true) && (json[ID_KEY].IsString() == true))
-		id = std::string(json[ID_KEY].GetString(),
-				json[ID_KEY].GetStringLength());
-	else
-		id = "";
-
-	// source
-	if ((json.HasMember(SOURCE_KEY) == true)
-			&& (json[SOURCE_KEY].IsObject() == true)) {
-		rapidjson::Value & sourcevalue = json[SOURCE_KEY];
-		source = detectionformats::source(sourcevalue);
-	} else
-		source = detectionformats::source();
-
-	// hypocenter
-	if ((json.HasMember(HYPOCENTER_KEY) == true)
-			&& (json[HYPOCENTER_KEY].IsObject() == true)) {
-		rapidjson::Value & hypocentervalue = json[HYPOCENTER_KEY];
-		hypocenter = detectionformats::hypocenter(hypocentervalue);
-	} else
-		hypocenter = detectionformats::hypocenter();
-
-	// optional values
-	// detectiontype
-	if ((json.HasMember(DETECTIONTYPE_KEY) == true)
-			&& (json[DETECTIONTYPE_KEY].IsString() == true))
-		detectiontype = std::string(json[DETECTIONTYPE_KEY].GetString(),
-				json[DETECTIONTYPE_KEY].GetStringLength());
-	else
-		detectiontype = "";
-
-	// detectiontime
-	if ((json.HasMember(DETECTIONTIME_KEY) == true)
-			&& (json[DETECTIONTIME_KEY].IsString() == true))
-		detectiontime = detectionformats::ConvertISO8601ToEpochTime(
-				std::string(json[DETECTIONTIME_KEY].GetString(),
-						json[DETECTIONTIME_KEY].GetStringLength()));
-	else
-		detectiontime = std::numeric_limits<double>::quiet_NaN();
-
-	// eventtype
-	if ((json.HasMember(EVENTTYPE_KEY) == true)
-			&& (json[EVENTTYPE_KEY].IsString() == true))
-		eventtype = std::string(json[EVENTTYPE_KEY].GetString(),
-				json[EVENTTYPE_KEY].GetStringLength());
-	else
-		eventtype = "";
-
-	// bayes
-	if ((json.HasMember(BAYES_KEY) == true)
-			&& (json[BAYES_KEY].IsNumber() == true)
-			&& (json[BAYES_KEY].IsDouble() == true))
-		bayes = json[BAYES_KEY].GetDouble();
-	else
-		bayes = std::numeric_limits<double>::quiet_NaN();
-
-	// minimumdistance
-	if ((json.HasMember(MINIMUMDISTANCE_KEY) == true)
-			&& (json[MINIMUMDISTANCE_KEY].IsNumber() == true)
-			&& (json[MINIMUMDISTANCE_KEY].IsDouble() == true))
-		minimumdistance = json[MINIMUMDISTANCE_KEY].GetDouble();
-	else
-		minimumdistance = std::numeric_limits<double>::quiet_NaN();
-
-	// rms
-	if ((json.HasMember(RMS_KEY) == true) && (json[RMS_KEY].IsNumber() == true)
-			&& (json[RMS_KEY].IsDouble() == true))
-		rms = json[RMS_KEY].GetDouble();
-	else
-		rms = std::numeric_limits<double>::quiet_NaN();
-
-	// gap
-	if ((json.HasMember(GAP_KEY) == true) && (json[GAP_KEY].IsNumber() == true)
-			&& (json[GAP_KEY].IsDouble() == true))
-		gap = json[GAP_KEY].GetDouble();
-	else
-		gap = std::numeric_limits<double>::quiet_NaN();
-
-	// data
-	pickdata.clear();
-	correlationdata.clear();
-
-	if ((json.HasMember(DATA_KEY) == true)
-			&& (json[DATA_KEY].IsArray() == true)) {
-		rapidjson::Value dataarray;
-		dataarray = json[DATA_KEY].GetArray();
-
-		for (rapidjson::SizeType i = 0; i < dataarray.Size(); i++) {
-			rapidjson::Value & datavalue = dataarray[i];
-			if (datavalue.HasMember(TYPE_KEY) == false)
-				continue;
-
-			// route based on typestring
-			std::string typestring = std::string(datavalue["Type"].GetString(),
-					datavalue["Type"].GetStringLength());
-			if (typestring == PICK_TYPE) {
-				detectionformats::pick newpickdata(datavalue);
-
-				// add to vector
-				pickdata.push_back(newpickdata);
-			} else if (typestring == CORRELATION_TYPE) {
-				detectionformats::correlation newcorrelationdata(datavalue);
-
-				// add to vector
-				correlationdata.push_back(newcorrelationdata);
-			} else
-				continue;
-		}
-	}
+	resetfrom(json);
 }
 
 detection::detection(const detection & newdetection) {
@@ -234,16 +269,9 @@ detection::detection(const detection & newdetection) {
 	rms = newdetection.rms;
 	gap = newdetection.gap;
 
-	// copy data
-	pickdata.clear();
-	for (int i = 0; i < (int) newdetection.pickdata.size(); i++) {
-		pickdata.push_back(newdetection.pickdata[i]);
-	}
-
-	correlationdata.clear();
-	for (int i = 0; i < (int) newdetection.correlationdata.size(); i++) {
-		correlationdata.push_back(newdetection.correlationdata[i]);
-	}
+	// share data, the elements are copied only when modified
+	pickdata = newdetection.pickdata;
+	correlationdata = newdetection.correlationdata;
 }
 
 detection::~detection() {
@@ -251,110 +279,152 @@ detection::~detection() {
 	correlationdata.clear();
 }
 
-rapidjson::Value & detection::tojson(rapidjson::Value &json,
-		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) {
-	json.SetObject();
-
-	// required values
-	// type
-	rapidjson::Value typevalue;
-	typevalue.SetString(rapidjson::StringRef(type.c_str()), allocator);
-	json.AddMember(TYPE_KEY, typevalue, allocator);
-
-	// id
-	if (id != "") {
-		rapidjson::Value idvalue;
-		idvalue.SetString(rapidjson::StringRef(id.c_str()), allocator);
-		json.AddMember(ID_KEY, idvalue, allocator);
-	}
+void detection::resetfrom(rapidjson::Value &json) {
+	clear();
+	type.clear();
 
-	// source
-	rapidjson::Value sourcevalue(rapidjson::kObjectType);
-	source.tojson(sourcevalue, allocator);
-	json.AddMember(SOURCE_KEY, sourcevalue, allocator);
-
-	// hypocenter
-	rapidjson::Value hypocentervalue(rapidjson::kObjectType);
-	hypocenter.tojson(hypocentervalue, allocator);
-	json.AddMember(HYPOCENTER_KEY, hypocentervalue, allocator);
+	detectionformats::ParseFields(*this, json, fields);
+}
 
-	// optional values
-	// detectiontype
-	if (detectiontype != "") {
-		rapidjson::Value detectiontypevalue;
-		detectiontypevalue.SetString(
-				rapidjson::StringRef(detectiontype.c_str()), allocator);
-		json.AddMember(DETECTIONTYPE_KEY, detectiontypevalue, allocator);
-	}
+void detection::clear() {
+	type = DETECTION_TYPE;
+	id.clear();
+	source.clear();
+	hypocenter.clear();
+	detectiontype.clear();
+	detectiontime = std::numeric_limits<double>::quiet_NaN();
+	eventtype.clear();
+	bayes = std::numeric_limits<double>::quiet_NaN();
+	minimumdistance = std::numeric_limits<double>::quiet_NaN();
+	rms = std::numeric_limits<double>::quiet_NaN();
+	gap = std::numeric_limits<double>::quiet_NaN();
+	pickdata.clear();
+	correlationdata.clear();
+}
 
-	// detectiontime
-	if (std::isnan(detectiontime) != true) {
-		std::string timestring = detectionformats::ConvertEpochTimeToISO8601(
-				detectiontime);
-		rapidjson::Value timevalue;
-		timevalue.SetString(rapidjson::StringRef(timestring.c_str()),
-				allocator);
-		json.AddMember(DETECTIONTIME_KEY, timevalue, allocator);
-	}
+rapidjson::Value & detection::tojson(rapidjson::Value &json,
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+	return (detectionformats::WriteFields(*this, json, allocator, fields));
+}
 
-	// eventtype
-	if (eventtype != "") {
-		rapidjson::Value eventtypevalue;
-		eventtypevalue.SetString(rapidjson::StringRef(eventtype.c_str()),
-				allocator);
-		json.AddMember(EVENTTYPE_KEY, eventtypevalue, allocator);
-	}
+void detection::tobinary(std::string &buffer) const {
+	detectionformats::EncodeFields(*this, buffer, fields);
+}
 
-	// bayes
-	if (std::isnan(bayes) != true)
-		json.AddMember(BAYES_KEY, bayes, allocator);
+size_t detection::frombinary(const char *buffer, size_t length) {
+	return (detectionformats::DecodeFields(*this, buffer, length, fields));
+}
 
-	// minimumdistance
-	if (std::isnan(minimumdistance) != true)
-		json.AddMember(MINIMUMDISTANCE_KEY, minimumdistance, allocator);
+bool detection::operator==(const detection &other) const {
+	return (detectionformats::EqualFields(*this, other, fields));
+}
 
-	// rms
-	if (std::isnan(rms) != true)
-		json.AddMember(RMS_KEY, rms, allocator);
+bool detection::operator!=(const detection &other) const {
+	return (!(*this == other));
+}
 
-	// gap
-	if (std::isnan(gap) != true)
-		json.AddMember(GAP_KEY, gap, allocator);
+std::vector<std::string> detection::geterrors() const {
+	std::vector<std::string> errorlist;
+	getheadererrors(errorlist);
 
 	// data
-	// build json array
-	rapidjson::Value dataarray(rapidjson::kArrayType);
-
 	// pickdata
-	if (pickdata.size() > 0) {
-		for (int i = 0; i < (int) pickdata.size(); i++) {
-			rapidjson::Value pickvalue(rapidjson::kObjectType);
-			pickdata[i].tojson(pickvalue, allocator);
-			dataarray.PushBack(pickvalue, allocator);
+	for (size_t i = 0; i < pickdata.size(); i++) {
+		if (pickdata[i].isvalid() != true) {
+			// bad pick
+			errorlist.push_back("Invalid pick in detection class.");
 		}
 	}
 
 	// correlationdata
-	if (correlationdata.size() > 0) {
-		for (int i = 0; i < (int) correlationdata.size(); i++) {
-			rapidjson::Value correlationvalue(rapidjson::kObjectType);
-			correlationdata[i].tojson(correlationvalue, allocator);
-			dataarray.PushBack(correlationvalue, allocator);
+	for (size_t i = 0; i < correlationdata.size(); i++) {
+		if (correlationdata[i].isvalid() != true) {
+			// bad correlation
+			errorlist.push_back("Invalid correlation in detection class.");
+		}
+	}
+
+	// return the list of errors
+	return (errorlist);
+}
+
+std::vector<std::string> detection::geterrors(threadpool &pool) const {
+	std::vector<std::string> errorlist;
+	getheadererrors(errorlist);
+
+	// validate every entry in parallel, recording each result by index so
+	// that the errors can be reported in the same order as geterrors()
+	size_t count = pickdata.size() + correlationdata.size();
+	std::vector<char> valid(count, 1);
+	pool.run(count, 0, [this, &valid](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			valid[i] = isdatavalid(i) ? 1 : 0;
+		}
+	});
+
+	for (size_t i = 0; i < count; i++) {
+		if (valid[i] == 0) {
+			if (i < pickdata.size()) {
+				errorlist.push_back("Invalid pick in detection class.");
+			} else {
+				errorlist.push_back("Invalid correlation in detection class.");
+			}
 		}
 	}
 
-	if (dataarray.Size() > 0) {
-		// data
-		json.AddMember(DATA_KEY, dataarray, allocator);
+	// return the list of errors
+	return (errorlist);
+}
+
+bool detection::isvalid() const {
+	std::vector<std::string> errorlist;
+	getheadererrors(errorlist);
+	if (errorlist.empty() == false) {
+		return (false);
 	}
 
-	// validate
-	return (json);
+	for (size_t i = 0; i < pickdata.size() + correlationdata.size(); i++) {
+		if (isdatavalid(i) == false) {
+			return (false);
+		}
+	}
+
+	return (true);
 }
 
-std::vector<std::string> detection::geterrors() {
+bool detection::isvalid(threadpool &pool) const {
 	std::vector<std::string> errorlist;
+	getheadererrors(errorlist);
+	if (errorlist.empty() == false) {
+		return (false);
+	}
+
+	// once any entry fails the remaining entries are skipped
+	std::atomic<bool> invalid(false);
+	pool.run(pickdata.size() + correlationdata.size(), 0,
+			[this, &invalid](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++) {
+					if (invalid.load(std::memory_order_relaxed) == true) {
+						return;
+					}
+					if (isdatavalid(i) == false) {
+						invalid.store(true, std::memory_order_relaxed);
+						return;
+					}
+				}
+			});
+
+	return (invalid.load() == false);
+}
+
+bool detection::isdatavalid(size_t index) const {
+	if (index < pickdata.size()) {
+		return (pickdata[index].isvalid());
+	}
+	return (correlationdata[index - pickdata.size()].isvalid());
+}
 
+void detection::getheadererrors(std::vector<std::string> &errorlist) const {
 	// check required data
 	// Type
 	if (type != DETECTION_TYPE) {
@@ -362,25 +432,9 @@ std::vector<std::string> detection::geterrors() {
 		errorlist.push_back("Non-detection type in detection class.");
 	}
 
-	// id
-	if (id == "") {
-		// empty id
-		errorlist.push_back("Empty ID in detection class.");
-	}
-
-	// source
-	if (source.isvalid() != true) {
-		// bad source
-		errorlist.push_back(
-				"Source object did not validate in detection class.");
-	}
-
-	// hypocenter
-	if (hypocenter.isvalid() != true) {
-		// hypocenter not found
-		errorlist.push_back(
-				"hypocenter object did not validate in detection class.");
-	}
+	// id, source, and hypocenter
+	detectionformats::CheckRequiredFields(*this, "detection", fields,
+			errorlist);
 
 	// optional keys
 	// detectiontype
@@ -459,30 +513,6 @@ std::vector<std::string> detection::geterrors() {
 			errorlist.push_back("Invalid Gap in detection class.");
 		}
 	}
-
-	// data
-	// pickdata
-	if (pickdata.size() > 0) {
-		for (int i = 0; i < (int) pickdata.size(); i++) {
-			if (pickdata[i].isvalid() != true) {
-				// bad source
-				errorlist.push_back("Invalid pick in detection class.");
-			}
-		}
-	}
-
-	// correlationdata
-	if (correlationdata.size() > 0) {
-		for (int i = 0; i < (int) correlationdata.size(); i++) {
-			if (correlationdata[i].isvalid() != true) {
-				// bad source
-				errorlist.push_back("Invalid correlation in detection class.");
-			}
-		}
-	}
-
-	// return the list of errors
-	return (errorlist);
 }
 
 }
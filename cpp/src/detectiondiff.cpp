@@ -0,0 +1,789 @@
+#include "detectiondiff.h"
+#include "fields.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+// JSON Keys
+#define OP_KEY "op"
+#define PATH_KEY "path"
+#define VALUE_KEY "value"
+
+// operations
+#define ADD_OP "add"
+#define REMOVE_OP "remove"
+#define REPLACE_OP "replace"
+#define ORDER_OP "order"
+
+// paths
+#define ID_PATH "/ID"
+#define SOURCE_PATH "/Source"
+#define DETECTIONTYPE_PATH "/DetectionType"
+#define DETECTIONTIME_PATH "/DetectionTime"
+#define EVENTTYPE_PATH "/EventType"
+#define BAYES_PATH "/Bayes"
+#define MINIMUMDISTANCE_PATH "/MinimumDistance"
+#define RMS_PATH "/RMS"
+#define GAP_PATH "/Gap"
+#define LATITUDE_PATH "/Hypocenter/Latitude"
+#define LONGITUDE_PATH "/Hypocenter/Longitude"
+#define DEPTH_PATH "/Hypocenter/Depth"
+#define TIME_PATH "/Hypocenter/Time"
+#define LATITUDEERROR_PATH "/Hypocenter/LatitudeError"
+#define LONGITUDEERROR_PATH "/Hypocenter/LongitudeError"
+#define DEPTHERROR_PATH "/Hypocenter/DepthError"
+#define TIMEERROR_PATH "/Hypocenter/TimeError"
+#define PICK_PATH "/Data/Pick"
+#define CORRELATION_PATH "/Data/Correlation"
+
+namespace detectionformats {
+
+// a changeable string field of the detection
+struct diffstringfield {
+	detectiondifffield field;
+	const char *path;
+	std::string detection::*member;
+};
+
+// a changeable double field of the detection, or of its hypocenter
+template<class C>
+struct diffnumberfield {
+	detectiondifffield field;
+	const char *path;
+	double C::*member;
+	bool istime;
+};
+
+static const diffstringfield stringfields[] = {
+	{ diffid, ID_PATH, &detection::id },
+	{ diffdetectiontype, DETECTIONTYPE_PATH, &detection::detectiontype },
+	{ diffeventtype, EVENTTYPE_PATH, &detection::eventtype } };
+
+static const diffnumberfield<detection> detectionfields[] = {
+	{ diffdetectiontime, DETECTIONTIME_PATH, &detection::detectiontime, true },
+	{ diffbayes, BAYES_PATH, &detection::bayes, false },
+	{ diffminimumdistance, MINIMUMDISTANCE_PATH, &detection::minimumdistance,
+			false },
+	{ diffrms, RMS_PATH, &detection::rms, false },
+	{ diffgap, GAP_PATH, &detection::gap, false } };
+
+static const diffnumberfield<hypocenter> hypocenterfields[] = {
+	{ difflatitude, LATITUDE_PATH, &hypocenter::latitude, false },
+	{ difflongitude, LONGITUDE_PATH, &hypocenter::longitude, false },
+	{ diffdepth, DEPTH_PATH, &hypocenter::depth, false },
+	{ difftime, TIME_PATH, &hypocenter::time, true },
+	{ difflatitudeerror, LATITUDEERROR_PATH, &hypocenter::latitudeerror,
+			false },
+	{ difflongitudeerror, LONGITUDEERROR_PATH, &hypocenter::longitudeerror,
+			false },
+	{ diffdeptherror, DEPTHERROR_PATH, &hypocenter::deptherror, false },
+	{ difftimeerror, TIMEERROR_PATH, &hypocenter::timeerror, false } };
+
+#define STRINGFIELDCOUNT (sizeof(stringfields) / sizeof(stringfields[0]))
+#define DETECTIONFIELDCOUNT \
+		(sizeof(detectionfields) / sizeof(detectionfields[0]))
+#define HYPOCENTERFIELDCOUNT \
+		(sizeof(hypocenterfields) / sizeof(hypocenterfields[0]))
+
+// gets the bit of a field
+static uint32_t FieldBit(detectiondifffield field) {
+	return (static_cast<uint32_t>(1) << field);
+}
+
+// escapes an id for a JSON Pointer, ~ as ~0 and / as ~1
+static std::string EscapePointer(const std::string &id) {
+	std::string escaped;
+	escaped.reserve(id.length());
+	for (size_t i = 0; i < id.length(); i++) {
+		if (id[i] == '~') {
+			escaped += "~0";
+		} else if (id[i] == '/') {
+			escaped += "~1";
+		} else {
+			escaped.push_back(id[i]);
+		}
+	}
+	return (escaped);
+}
+
+// reverses EscapePointer
+static std::string UnescapePointer(const char *pointer, size_t length) {
+	std::string id;
+	id.reserve(length);
+	for (size_t i = 0; i < length; i++) {
+		if ((pointer[i] == '~') && (i + 1 < length)
+				&& ((pointer[i + 1] == '0') || (pointer[i + 1] == '1'))) {
+			id.push_back((pointer[i + 1] == '0') ? '~' : '/');
+			i++;
+		} else {
+			id.push_back(pointer[i]);
+		}
+	}
+	return (id);
+}
+
+// appends an operation to the array, value may be NULL
+static void AddOperation(rapidjson::Value &json, const char *op,
+		rapidjson::Value &path, rapidjson::Value *value,
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) {
+	rapidjson::Value operation(rapidjson::kObjectType);
+	operation.AddMember(OP_KEY, rapidjson::StringRef(op), allocator);
+	operation.AddMember(PATH_KEY, path, allocator);
+	if (value != NULL) {
+		operation.AddMember(VALUE_KEY, *value, allocator);
+	}
+	json.PushBack(operation, allocator);
+}
+
+// makes a json string value, copying the characters
+static rapidjson::Value StringValue(const std::string &value,
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) {
+	return (rapidjson::Value(value.c_str(),
+			static_cast<rapidjson::SizeType>(value.length()), allocator));
+}
+
+// appends the operation setting a number, removing it if it is missing
+static void AddNumberOperation(rapidjson::Value &json, const char *path,
+		double number, bool istime,
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) {
+	rapidjson::Value pathvalue(rapidjson::StringRef(path));
+	if (std::isnan(number) == true) {
+		AddOperation(json, REMOVE_OP, pathvalue, NULL, allocator);
+		return;
+	}
+	rapidjson::Value value;
+	if (istime == true) {
+		value = StringValue(ConvertEpochTimeToISO8601(number), allocator);
+	} else {
+		value.SetDouble(number);
+	}
+	AddOperation(json, REPLACE_OP, pathvalue, &value, allocator);
+}
+
+// reads the value of an operation setting a number
+static double ParseNumber(const char *op, rapidjson::Value *value,
+		bool istime) {
+	if (strcmp(op, REMOVE_OP) == 0) {
+		return (std::numeric_limits<double>::quiet_NaN());
+	}
+	if ((istime == true) && (value != NULL) && (value->IsString() == true)) {
+		return (ConvertISO8601ToEpochTime(value->GetString(),
+				value->GetStringLength()));
+	}
+	if ((istime == false) && (value != NULL) && (value->IsNumber() == true)) {
+		return (value->GetDouble());
+	}
+	throw std::invalid_argument("Invalid value in detection diff.");
+}
+
+// finds the changes between two versions of a detection's data
+template<class T>
+static void DiffData(const sharedvector<T> &olddata,
+		const sharedvector<T> &newdata, datachanges<T> &changes) {
+	std::unordered_map<std::string, size_t> oldindex;
+	std::unordered_map<std::string, size_t> newindex;
+	oldindex.reserve(olddata.size());
+	newindex.reserve(newdata.size());
+	bool unique = true;
+	for (size_t i = 0; (i < olddata.size()) && (unique == true); i++) {
+		unique = (olddata[i].id.empty() == false)
+				&& (oldindex.insert(std::make_pair(olddata[i].id, i)).second
+						== true);
+	}
+	for (size_t i = 0; (i < newdata.size()) && (unique == true); i++) {
+		unique = (newdata[i].id.empty() == false)
+				&& (newindex.insert(std::make_pair(newdata[i].id, i)).second
+						== true);
+	}
+
+	// without unique ids the entries cannot be matched, so unless the data
+	// is unchanged it is replaced outright
+	if (unique == false) {
+		bool equal = (olddata.size() == newdata.size());
+		for (size_t i = 0; (i < newdata.size()) && (equal == true); i++) {
+			equal = (olddata.gethandle(i) == newdata.gethandle(i))
+					|| (olddata[i] == newdata[i]);
+		}
+		if (equal == false) {
+			changes.replaced = true;
+			for (size_t i = 0; i < newdata.size(); i++) {
+				changes.added.push_back(newdata.gethandle(i));
+			}
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < olddata.size(); i++) {
+		if (newindex.find(olddata[i].id) == newindex.end()) {
+			changes.removed.push_back(olddata[i].id);
+		}
+	}
+
+	// shared entries are the same entry, and are not compared
+	for (size_t i = 0; i < newdata.size(); i++) {
+		std::unordered_map<std::string, size_t>::const_iterator found =
+				oldindex.find(newdata[i].id);
+		if (found == oldindex.end()) {
+			changes.added.push_back(newdata.gethandle(i));
+		} else if ((olddata.gethandle(found->second) != newdata.gethandle(i))
+				&& ((olddata[found->second] == newdata[i]) == false)) {
+			changes.modified.push_back(newdata.gethandle(i));
+		}
+	}
+
+	// the changes leave the kept entries in their old order with the added
+	// ones after them, anything else needs the new order
+	size_t position = 0;
+	bool inorder = true;
+	for (size_t i = 0; (i < olddata.size()) && (inorder == true); i++) {
+		if (newindex.find(olddata[i].id) != newindex.end()) {
+			inorder = (newindex[olddata[i].id] == position++);
+		}
+	}
+	for (size_t i = 0; (i < changes.added.size()) && (inorder == true); i++) {
+		inorder = (changes.added.gethandle(i) == newdata.gethandle(position++));
+	}
+	if (inorder == false) {
+		for (size_t i = 0; i < newdata.size(); i++) {
+			changes.order.push_back(newdata[i].id);
+		}
+	}
+}
+
+// applies the changes to a detection's data
+template<class T>
+static void ApplyData(const datachanges<T> &changes, sharedvector<T> &data) {
+	if (changes.replaced == true) {
+		data.clear();
+		for (size_t i = 0; i < changes.added.size(); i++) {
+			data.push_back(changes.added.gethandle(i));
+		}
+		return;
+	}
+	if (changes.empty() == true) {
+		return;
+	}
+
+	std::unordered_set<std::string> removed(changes.removed.begin(),
+			changes.removed.end());
+	std::unordered_map<std::string, size_t> modified;
+	for (size_t i = 0; i < changes.modified.size(); i++) {
+		modified[changes.modified[i].id] = i;
+	}
+
+	sharedvector<T> result;
+	result.reserve(data.size() + changes.added.size());
+	size_t matched = 0;
+	for (size_t i = 0; i < data.size(); i++) {
+		const std::string &id = data.shared(i).id;
+		if (removed.count(id) > 0) {
+			matched++;
+			continue;
+		}
+		std::unordered_map<std::string, size_t>::const_iterator found =
+				modified.find(id);
+		if (found != modified.end()) {
+			result.push_back(changes.modified.gethandle(found->second));
+			matched++;
+		} else {
+			result.push_back(data.gethandle(i));
+		}
+	}
+	if (matched != removed.size() + modified.size()) {
+		throw std::invalid_argument(
+				"Detection diff does not apply, data entry not found.");
+	}
+	for (size_t i = 0; i < changes.added.size(); i++) {
+		result.push_back(changes.added.gethandle(i));
+	}
+
+	if (changes.order.empty() == false) {
+		if (changes.order.size() != result.size()) {
+			throw std::invalid_argument(
+					"Detection diff does not apply, data order mismatch.");
+		}
+		std::unordered_map<std::string, size_t> index;
+		for (size_t i = 0; i < result.size(); i++) {
+			index[result.shared(i).id] = i;
+		}
+		data.clear();
+		for (size_t i = 0; i < changes.order.size(); i++) {
+			std::unordered_map<std::string, size_t>::const_iterator found =
+					index.find(changes.order[i]);
+			if (found == index.end()) {
+				throw std::invalid_argument(
+						"Detection diff does not apply, data order mismatch.");
+			}
+			data.push_back(result.gethandle(found->second));
+		}
+		return;
+	}
+	data = result;
+}
+
+// appends the operations changing a detection's data
+template<class T>
+static void WriteData(const datachanges<T> &changes, const char *path,
+		rapidjson::Value &json,
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) {
+	std::string prefix = std::string(path) + "/";
+	if (changes.replaced == true) {
+		rapidjson::Value pathvalue(rapidjson::StringRef(path));
+		rapidjson::Value entries(rapidjson::kArrayType);
+		for (size_t i = 0; i < changes.added.size(); i++) {
+			rapidjson::Value entry(rapidjson::kObjectType);
+			changes.added[i].tojson(entry, allocator);
+			entries.PushBack(entry, allocator);
+		}
+		AddOperation(json, REPLACE_OP, pathvalue, &entries, allocator);
+		return;
+	}
+
+	for (size_t i = 0; i < changes.removed.size(); i++) {
+		rapidjson::Value pathvalue = StringValue(
+				prefix + EscapePointer(changes.removed[i]), allocator);
+		AddOperation(json, REMOVE_OP, pathvalue, NULL, allocator);
+	}
+	for (size_t i = 0; i < changes.modified.size(); i++) {
+		rapidjson::Value pathvalue = StringValue(
+				prefix + EscapePointer(changes.modified[i].id), allocator);
+		rapidjson::Value entry(rapidjson::kObjectType);
+		changes.modified[i].tojson(entry, allocator);
+		AddOperation(json, REPLACE_OP, pathvalue, &entry, allocator);
+	}
+	for (size_t i = 0; i < changes.added.size(); i++) {
+		rapidjson::Value pathvalue = StringValue(
+				prefix + EscapePointer(changes.added[i].id), allocator);
+		rapidjson::Value entry(rapidjson::kObjectType);
+		changes.added[i].tojson(entry, allocator);
+		AddOperation(json, ADD_OP, pathvalue, &entry, allocator);
+	}
+	if (changes.order.empty() == false) {
+		rapidjson::Value pathvalue(rapidjson::StringRef(path));
+		rapidjson::Value ids(rapidjson::kArrayType);
+		for (size_t i = 0; i < changes.order.size(); i++) {
+			ids.PushBack(StringValue(changes.order[i], allocator), allocator);
+		}
+		AddOperation(json, ORDER_OP, pathvalue, &ids, allocator);
+	}
+}
+
+// reads an operation on a detection's data, returning false if the path is
+// not under the data's
+template<class T>
+static bool ParseData(datachanges<T> &changes, const char *path,
+		const char *op, const rapidjson::Value &pathvalue,
+		rapidjson::Value *value) {
+	size_t length = strlen(path);
+	if ((pathvalue.GetStringLength() < length)
+			|| (memcmp(pathvalue.GetString(), path, length) != 0)) {
+		return (false);
+	}
+	const char *rest = pathvalue.GetString() + length;
+	size_t restlength = pathvalue.GetStringLength() - length;
+
+	if (restlength == 0) {
+		if ((value == NULL) || (value->IsArray() == false)) {
+			throw std::invalid_argument("Invalid value in detection diff.");
+		}
+		if (strcmp(op, REPLACE_OP) == 0) {
+			changes.replaced = true;
+			changes.added.clear();
+			for (rapidjson::Value::ValueIterator entry = value->Begin();
+					entry != value->End(); ++entry) {
+				changes.added.emplace_back(*entry);
+			}
+		} else if (strcmp(op, ORDER_OP) == 0) {
+			changes.order.clear();
+			for (rapidjson::Value::ConstValueIterator id = value->Begin();
+					id != value->End(); ++id) {
+				if (id->IsString() == false) {
+					throw std::invalid_argument(
+							"Invalid value in detection diff.");
+				}
+				changes.order.push_back(
+						std::string(id->GetString(), id->GetStringLength()));
+			}
+		} else {
+			throw std::invalid_argument("Invalid operation in detection diff.");
+		}
+		return (true);
+	}
+
+	if (rest[0] != '/') {
+		return (false);
+	}
+	if (strcmp(op, REMOVE_OP) == 0) {
+		changes.removed.push_back(UnescapePointer(rest + 1, restlength - 1));
+		return (true);
+	}
+	if ((value == NULL) || (value->IsObject() == false)) {
+		throw std::invalid_argument("Invalid value in detection diff.");
+	}
+	if (strcmp(op, REPLACE_OP) == 0) {
+		changes.modified.emplace_back(*value);
+	} else if (strcmp(op, ADD_OP) == 0) {
+		changes.added.emplace_back(*value);
+	} else {
+		throw std::invalid_argument("Invalid operation in detection diff.");
+	}
+	return (true);
+}
+
+// writes the binary encoding of a detection's data changes
+template<class T>
+static void EncodeData(const datachanges<T> &changes, std::string &buffer) {
+	buffer.push_back(static_cast<char>(changes.replaced));
+	WriteBinaryLength(changes.removed.size(), buffer);
+	for (size_t i = 0; i < changes.removed.size(); i++) {
+		WriteBinaryLength(changes.removed[i].length(), buffer);
+		WriteBinaryBytes(changes.removed[i].data(), changes.removed[i].length(),
+				buffer);
+	}
+	WriteBinaryLength(changes.modified.size(), buffer);
+	for (size_t i = 0; i < changes.modified.size(); i++) {
+		changes.modified[i].tobinary(buffer);
+	}
+	WriteBinaryLength(changes.added.size(), buffer);
+	for (size_t i = 0; i < changes.added.size(); i++) {
+		changes.added[i].tobinary(buffer);
+	}
+	WriteBinaryLength(changes.order.size(), buffer);
+	for (size_t i = 0; i < changes.order.size(); i++) {
+		WriteBinaryLength(changes.order[i].length(), buffer);
+		WriteBinaryBytes(changes.order[i].data(), changes.order[i].length(),
+				buffer);
+	}
+}
+
+// reads the entries of a binary encoded data change list
+template<class T>
+static void DecodeEntries(sharedvector<T> &entries, binaryreader &reader) {
+	size_t count = reader.readlength();
+	for (size_t i = 0; i < count; i++) {
+		T &entry = entries.emplace_back();
+		reader.skip(entry.frombinary(reader.current(), reader.remaining()));
+	}
+}
+
+// reads the ids of a binary encoded data change list
+static void DecodeIds(std::vector<std::string> &ids, binaryreader &reader) {
+	size_t count = reader.readlength();
+	for (size_t i = 0; i < count; i++) {
+		std::string id;
+		reader.readstring(id);
+		ids.push_back(id);
+	}
+}
+
+// reads the binary encoding of a detection's data changes
+template<class T>
+static void DecodeData(datachanges<T> &changes, binaryreader &reader) {
+	unsigned char replaced = 0;
+	reader.read(&replaced, 1);
+	if (replaced > 1) {
+		throw std::invalid_argument("Corrupt detection diff binary buffer.");
+	}
+	changes.replaced = (replaced == 1);
+	DecodeIds(changes.removed, reader);
+	DecodeEntries(changes.modified, reader);
+	DecodeEntries(changes.added, reader);
+	DecodeIds(changes.order, reader);
+}
+
+detectiondiff::detectiondiff()
+		: changed(0) {
+}
+
+detectiondiff::detectiondiff(const detection &olddetection,
+		const detection &newdetection)
+		: changed(0) {
+	for (size_t i = 0; i < STRINGFIELDCOUNT; i++) {
+		const diffstringfield &field = stringfields[i];
+		if (olddetection.*field.member != newdetection.*field.member) {
+			changed |= FieldBit(field.field);
+			values.*field.member = newdetection.*field.member;
+		}
+	}
+	for (size_t i = 0; i < DETECTIONFIELDCOUNT; i++) {
+		const diffnumberfield<detection> &field = detectionfields[i];
+		if (IsEqualDouble(olddetection.*field.member,
+				newdetection.*field.member) == false) {
+			changed |= FieldBit(field.field);
+			values.*field.member = newdetection.*field.member;
+		}
+	}
+	for (size_t i = 0; i < HYPOCENTERFIELDCOUNT; i++) {
+		const diffnumberfield<hypocenter> &field = hypocenterfields[i];
+		if (IsEqualDouble(olddetection.hypocenter.*field.member,
+				newdetection.hypocenter.*field.member) == false) {
+			changed |= FieldBit(field.field);
+			values.hypocenter.*field.member = newdetection.hypocenter
+					.*field.member;
+		}
+	}
+	if ((olddetection.source == newdetection.source) == false) {
+		changed |= FieldBit(diffsource);
+		values.source = newdetection.source;
+	}
+
+	DiffData(olddetection.pickdata, newdetection.pickdata, picks);
+	DiffData(olddetection.correlationdata, newdetection.correlationdata,
+			correlations);
+}
+
+detectiondiff::detectiondiff(rapidjson::Value &json)
+		: changed(0) {
+	if (json.IsArray() == false) {
+		throw std::invalid_argument("Detection diff is not an array.");
+	}
+
+	for (rapidjson::Value::ValueIterator operation = json.Begin();
+			operation != json.End(); ++operation) {
+		if (operation->IsObject() == false) {
+			throw std::invalid_argument("Invalid operation in detection diff.");
+		}
+		rapidjson::Value::MemberIterator opmember = operation->FindMember(
+				OP_KEY);
+		rapidjson::Value::MemberIterator pathmember = operation->FindMember(
+				PATH_KEY);
+		rapidjson::Value::MemberIterator valuemember = operation->FindMember(
+				VALUE_KEY);
+		if ((opmember == operation->MemberEnd())
+				|| (opmember->value.IsString() == false)
+				|| (pathmember == operation->MemberEnd())
+				|| (pathmember->value.IsString() == false)) {
+			throw std::invalid_argument("Invalid operation in detection diff.");
+		}
+		const char *op = opmember->value.GetString();
+		const rapidjson::Value &pathvalue = pathmember->value;
+		const char *path = pathvalue.GetString();
+		rapidjson::Value *value =
+				(valuemember == operation->MemberEnd()) ?
+						NULL : &valuemember->value;
+		bool remove = (strcmp(op, REMOVE_OP) == 0);
+		if ((remove == false) && (strcmp(op, REPLACE_OP) != 0)
+				&& (strcmp(op, ADD_OP) != 0) && (strcmp(op, ORDER_OP) != 0)) {
+			throw std::invalid_argument("Invalid operation in detection diff.");
+		}
+
+		if ((ParseData(picks, PICK_PATH, op, pathvalue, value) == true)
+				|| (ParseData(correlations, CORRELATION_PATH, op, pathvalue,
+						value) == true)) {
+			continue;
+		}
+
+		bool found = false;
+		for (size_t i = 0; (i < STRINGFIELDCOUNT) && (found == false); i++) {
+			const diffstringfield &field = stringfields[i];
+			if (strcmp(path, field.path) != 0) {
+				continue;
+			}
+			if (remove == true) {
+				(values.*field.member).clear();
+			} else if ((value != NULL) && (value->IsString() == true)) {
+				(values.*field.member).assign(value->GetString(),
+						value->GetStringLength());
+			} else {
+				throw std::invalid_argument("Invalid value in detection diff.");
+			}
+			changed |= FieldBit(field.field);
+			found = true;
+		}
+		for (size_t i = 0; (i < DETECTIONFIELDCOUNT) && (found == false); i++) {
+			const diffnumberfield<detection> &field = detectionfields[i];
+			if (strcmp(path, field.path) == 0) {
+				values.*field.member = ParseNumber(op, value, field.istime);
+				changed |= FieldBit(field.field);
+				found = true;
+			}
+		}
+		for (size_t i = 0; (i < HYPOCENTERFIELDCOUNT) && (found == false);
+				i++) {
+			const diffnumberfield<hypocenter> &field = hypocenterfields[i];
+			if (strcmp(path, field.path) == 0) {
+				values.hypocenter.*field.member = ParseNumber(op, value,
+						field.istime);
+				changed |= FieldBit(field.field);
+				found = true;
+			}
+		}
+		if ((found == false) && (strcmp(path, SOURCE_PATH) == 0)) {
+			if (remove == true) {
+				values.source = detectionformats::source();
+			} else if ((value != NULL) && (value->IsObject() == true)) {
+				values.source = detectionformats::source(*value);
+			} else {
+				throw std::invalid_argument("Invalid value in detection diff.");
+			}
+			changed |= FieldBit(diffsource);
+			found = true;
+		}
+		if (found == false) {
+			throw std::invalid_argument("Invalid path in detection diff.");
+		}
+	}
+}
+
+detection detectiondiff::apply(const detection &olddetection) const {
+	// the copy shares the old data, so only changed entries are new
+	detection newdetection(olddetection);
+	for (size_t i = 0; i < STRINGFIELDCOUNT; i++) {
+		const diffstringfield &field = stringfields[i];
+		if ((changed & FieldBit(field.field)) != 0) {
+			newdetection.*field.member = values.*field.member;
+		}
+	}
+	for (size_t i = 0; i < DETECTIONFIELDCOUNT; i++) {
+		const diffnumberfield<detection> &field = detectionfields[i];
+		if ((changed & FieldBit(field.field)) != 0) {
+			newdetection.*field.member = values.*field.member;
+		}
+	}
+	for (size_t i = 0; i < HYPOCENTERFIELDCOUNT; i++) {
+		const diffnumberfield<hypocenter> &field = hypocenterfields[i];
+		if ((changed & FieldBit(field.field)) != 0) {
+			newdetection.hypocenter.*field.member = values.hypocenter
+					.*field.member;
+		}
+	}
+	if ((changed & FieldBit(diffsource)) != 0) {
+		newdetection.source = values.source;
+	}
+
+	ApplyData(picks, newdetection.pickdata);
+	ApplyData(correlations, newdetection.correlationdata);
+	return (newdetection);
+}
+
+bool detectiondiff::empty() const {
+	return ((changed == 0) && (picks.empty() == true)
+			&& (correlations.empty() == true));
+}
+
+bool detectiondiff::ischanged(detectiondifffield field) const {
+	return ((changed & FieldBit(field)) != 0);
+}
+
+rapidjson::Value & detectiondiff::tojson(rapidjson::Value &json,
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+	json.SetArray();
+
+	for (size_t i = 0; i < STRINGFIELDCOUNT; i++) {
+		const diffstringfield &field = stringfields[i];
+		if ((changed & FieldBit(field.field)) == 0) {
+			continue;
+		}
+		rapidjson::Value pathvalue(rapidjson::StringRef(field.path));
+		if ((values.*field.member).empty() == true) {
+			AddOperation(json, REMOVE_OP, pathvalue, NULL, allocator);
+		} else {
+			rapidjson::Value value = StringValue(values.*field.member,
+					allocator);
+			AddOperation(json, REPLACE_OP, pathvalue, &value, allocator);
+		}
+	}
+	if ((changed & FieldBit(diffsource)) != 0) {
+		rapidjson::Value pathvalue(rapidjson::StringRef(SOURCE_PATH));
+		rapidjson::Value value(rapidjson::kObjectType);
+		values.source.tojson(value, allocator);
+		AddOperation(json, REPLACE_OP, pathvalue, &value, allocator);
+	}
+	for (size_t i = 0; i < DETECTIONFIELDCOUNT; i++) {
+		const diffnumberfield<detection> &field = detectionfields[i];
+		if ((changed & FieldBit(field.field)) != 0) {
+			AddNumberOperation(json, field.path, values.*field.member,
+					field.istime, allocator);
+		}
+	}
+	for (size_t i = 0; i < HYPOCENTERFIELDCOUNT; i++) {
+		const diffnumberfield<hypocenter> &field = hypocenterfields[i];
+		if ((changed & FieldBit(field.field)) != 0) {
+			AddNumberOperation(json, field.path,
+					values.hypocenter.*field.member, field.istime, allocator);
+		}
+	}
+
+	WriteData(picks, PICK_PATH, json, allocator);
+	WriteData(correlations, CORRELATION_PATH, json, allocator);
+	return (json);
+}
+
+void detectiondiff::tobinary(std::string &buffer) const {
+	WriteBinaryLength(changed, buffer);
+	for (size_t i = 0; i < STRINGFIELDCOUNT; i++) {
+		const diffstringfield &field = stringfields[i];
+		if ((changed & FieldBit(field.field)) != 0) {
+			const std::string &value = values.*field.member;
+			WriteBinaryLength(value.length(), buffer);
+			WriteBinaryBytes(value.data(), value.length(), buffer);
+		}
+	}
+	for (size_t i = 0; i < DETECTIONFIELDCOUNT; i++) {
+		const diffnumberfield<detection> &field = detectionfields[i];
+		if ((changed & FieldBit(field.field)) != 0) {
+			WriteBinaryBytes(&(values.*field.member), sizeof(double), buffer);
+		}
+	}
+	for (size_t i = 0; i < HYPOCENTERFIELDCOUNT; i++) {
+		const diffnumberfield<hypocenter> &field = hypocenterfields[i];
+		if ((changed & FieldBit(field.field)) != 0) {
+			WriteBinaryBytes(&(values.hypocenter.*field.member),
+					sizeof(double), buffer);
+		}
+	}
+	if ((changed & FieldBit(diffsource)) != 0) {
+		values.source.tobinary(buffer);
+	}
+
+	EncodeData(picks, buffer);
+	EncodeData(correlations, buffer);
+}
+
+size_t detectiondiff::frombinary(const char *buffer, size_t length) {
+	clear();
+	binaryreader reader(buffer, length);
+	size_t bits = reader.readlength();
+	if (bits >= FieldBit(difffieldcount)) {
+		throw std::invalid_argument("Corrupt detection diff binary buffer.");
+	}
+	changed = static_cast<uint32_t>(bits);
+
+	for (size_t i = 0; i < STRINGFIELDCOUNT; i++) {
+		const diffstringfield &field = stringfields[i];
+		if ((changed & FieldBit(field.field)) != 0) {
+			reader.readstring(values.*field.member);
+		}
+	}
+	for (size_t i = 0; i < DETECTIONFIELDCOUNT; i++) {
+		const diffnumberfield<detection> &field = detectionfields[i];
+		if ((changed & FieldBit(field.field)) != 0) {
+			reader.read(&(values.*field.member), sizeof(double));
+		}
+	}
+	for (size_t i = 0; i < HYPOCENTERFIELDCOUNT; i++) {
+		const diffnumberfield<hypocenter> &field = hypocenterfields[i];
+		if ((changed & FieldBit(field.field)) != 0) {
+			reader.read(&(values.hypocenter.*field.member), sizeof(double));
+		}
+	}
+	if ((changed & FieldBit(diffsource)) != 0) {
+		reader.skip(values.source.frombinary(reader.current(),
+				reader.remaining()));
+	}
+
+	DecodeData(picks, reader);
+	DecodeData(correlations, reader);
+	return (reader.position());
+}
+
+void detectiondiff::clear() {
+	changed = 0;
+	values.clear();
+	picks = datachanges<pick>();
+	correlations = datachanges<correlation>();
+}
+}
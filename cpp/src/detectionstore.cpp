@@ -0,0 +1,311 @@
+#include "detectionstore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace detectionformats {
+
+// finds the index of a detection type, detectiontypecount if it is not one
+static detectiontypeindex DetectionTypeIndex(const std::string &type) {
+	for (int i = 0; i < detectiontypeindex::detectiontypecount; i++) {
+		if (type == detectiontypevalues[i]) {
+			return (static_cast<detectiontypeindex>(i));
+		}
+	}
+	return (detectiontypeindex::detectiontypecount);
+}
+
+// checks whether a message is at least as new as the current version, by
+// detection time when both have one and by arrival otherwise
+static bool IsNewer(const detection &incoming, const detection &current) {
+	if ((std::isnan(incoming.detectiontime) == true)
+			|| (std::isnan(current.detectiontime) == true)) {
+		return (true);
+	}
+	return (incoming.detectiontime >= current.detectiontime);
+}
+
+// orders versions by origin time
+static bool OriginBefore(const detectionstore::version &first,
+		const detectionstore::version &second) {
+	return (first->hypocenter.time < second->hypocenter.time);
+}
+
+detectionstore::detectionstore(size_t newhistorylimit, size_t shardcount,
+		size_t expectedretractions)
+		: historylimit(newhistorylimit),
+			retractions(expectedretractions) {
+	size_t count = 1;
+	while (count < shardcount) {
+		count *= 2;
+	}
+	for (size_t i = 0; i < count; i++) {
+		shards.push_back(std::unique_ptr<shard>(new shard()));
+	}
+}
+
+bool detectionstore::apply(const detection &newdetection) {
+	shard &owner = getshard(newdetection.id);
+	detectiontypeindex type = DetectionTypeIndex(newdetection.detectiontype);
+
+	// the copy is made before taking the lock, and a replaced version is
+	// released after it is let go
+	version newversion;
+	version released;
+	if ((newdetection.id.empty() == false)
+			&& (type != detectiontypeindex::detectiontypecount)) {
+		newversion = std::make_shared<const detection>(newdetection);
+	}
+
+	std::lock_guard<std::mutex> guard(owner.mutex);
+	owner.metrics.messages++;
+	if (!newversion) {
+		owner.metrics.invalid++;
+		return (false);
+	}
+
+	// one lookup both finds a detection and makes room for a new one
+	std::pair<std::unordered_map<std::string, record>::iterator, bool> found =
+			owner.records.insert(std::make_pair(newdetection.id, record()));
+	if (found.second == true) {
+		record &created = found.first->second;
+		created.indexed = false;
+
+		// a retraction that arrived first was remembered, and retracts the
+		// detection as it is created
+		if ((type != detectiontypeindex::retractdetection)
+				&& (retractions.isretracted(newdetection.id,
+						newdetection.source) == true)) {
+			type = detectiontypeindex::retractdetection;
+		}
+		released = replace(owner, created, newversion, type);
+		owner.metrics.created++;
+		if (type == detectiontypeindex::final) {
+			owner.metrics.finalized++;
+		} else if (type == detectiontypeindex::retractdetection) {
+			owner.metrics.retracted++;
+		}
+		return (true);
+	}
+
+	// a retraction is the end of a detection, and a final one only takes
+	// another Final or a Retract
+	record &target = found.first->second;
+	if ((target.state == detectiontypeindex::retractdetection)
+			|| ((target.state == detectiontypeindex::final)
+					&& (type != detectiontypeindex::final)
+					&& (type != detectiontypeindex::retractdetection))
+			|| (IsNewer(newdetection, *target.current) == false)) {
+		owner.metrics.stale++;
+		return (false);
+	}
+
+	released = replace(owner, target, newversion, type);
+	if (type == detectiontypeindex::final) {
+		owner.metrics.finalized++;
+	} else if (type == detectiontypeindex::retractdetection) {
+		owner.metrics.retracted++;
+	} else {
+		owner.metrics.updated++;
+	}
+	return (true);
+}
+
+bool detectionstore::apply(const retract &retraction) {
+	shard &owner = getshard(retraction.id);
+	std::lock_guard<std::mutex> guard(owner.mutex);
+	owner.metrics.messages++;
+
+	// remembered under the shard's mutex, so a New for the same id applied
+	// at the same time either sees it or is created before it is looked for
+	retractions.add(retraction);
+
+	std::unordered_map<std::string, record>::iterator found =
+			owner.records.find(retraction.id);
+	if (found == owner.records.end()) {
+		if (retraction.id.empty() == true) {
+			owner.metrics.stale++;
+		} else {
+			owner.metrics.pending++;
+		}
+		return (false);
+	}
+	record &target = found->second;
+	if ((target.state == detectiontypeindex::retractdetection)
+			|| (target.current->source.agencyid != retraction.source.agencyid)
+			|| (target.current->source.author != retraction.source.author)) {
+		owner.metrics.stale++;
+		return (false);
+	}
+
+	// the current version stays, only the state changes
+	target.state = detectiontypeindex::retractdetection;
+	owner.metrics.retracted++;
+	return (true);
+}
+
+detectionstore::version detectionstore::find(const std::string &id) const {
+	shard &owner = getshard(id);
+	std::lock_guard<std::mutex> guard(owner.mutex);
+	std::unordered_map<std::string, record>::const_iterator found =
+			owner.records.find(id);
+	if ((found == owner.records.end())
+			|| (found->second.state == detectiontypeindex::retractdetection)) {
+		return (version());
+	}
+	return (found->second.current);
+}
+
+bool detectionstore::getstate(const std::string &id,
+		detectiontypeindex &state) const {
+	shard &owner = getshard(id);
+	std::lock_guard<std::mutex> guard(owner.mutex);
+	std::unordered_map<std::string, record>::const_iterator found =
+			owner.records.find(id);
+	if (found == owner.records.end()) {
+		return (false);
+	}
+	state = found->second.state;
+	return (true);
+}
+
+std::vector<detectionstore::version> detectionstore::gethistory(
+		const std::string &id) const {
+	std::vector<version> versions;
+	shard &owner = getshard(id);
+	std::lock_guard<std::mutex> guard(owner.mutex);
+	std::unordered_map<std::string, record>::const_iterator found =
+			owner.records.find(id);
+	if (found == owner.records.end()) {
+		return (versions);
+	}
+	versions.assign(found->second.history.begin(),
+			found->second.history.end());
+	versions.push_back(found->second.current);
+	return (versions);
+}
+
+size_t detectionstore::within(double starttime, double endtime,
+		std::vector<version> &results) const {
+	size_t first = results.size();
+	for (size_t i = 0; i < shards.size(); i++) {
+		shard &owner = *shards[i];
+		std::lock_guard<std::mutex> guard(owner.mutex);
+		std::multimap<double, record *>::const_iterator it =
+				owner.times.lower_bound(starttime);
+		for (; (it != owner.times.end()) && (it->first <= endtime); ++it) {
+			if (it->second->state != detectiontypeindex::retractdetection) {
+				results.push_back(it->second->current);
+			}
+		}
+	}
+
+	// each shard's are in order, the merged set is sorted once
+	std::stable_sort(results.begin() + first, results.end(), OriginBefore);
+	return (results.size() - first);
+}
+
+size_t detectionstore::expire(double before) {
+	size_t removed = 0;
+	for (size_t i = 0; i < shards.size(); i++) {
+		shard &owner = *shards[i];
+		std::lock_guard<std::mutex> guard(owner.mutex);
+		std::multimap<double, record *>::iterator end = owner.times.lower_bound(
+				before);
+		for (std::multimap<double, record *>::iterator it =
+				owner.times.begin(); it != end; ++it) {
+			owner.records.erase(it->second->current->id);
+			removed++;
+			owner.metrics.expired++;
+		}
+		owner.times.erase(owner.times.begin(), end);
+
+		// those without one go on the second call after they were last
+		// replaced
+		end = owner.untimed.lower_bound(
+				static_cast<double>(owner.expirations));
+		for (std::multimap<double, record *>::iterator it =
+				owner.untimed.begin(); it != end; ++it) {
+			owner.records.erase(it->second->current->id);
+			removed++;
+			owner.metrics.expired++;
+		}
+		owner.untimed.erase(owner.untimed.begin(), end);
+		owner.expirations++;
+	}
+	return (removed);
+}
+
+size_t detectionstore::size() const {
+	size_t count = 0;
+	for (size_t i = 0; i < shards.size(); i++) {
+		std::lock_guard<std::mutex> guard(shards[i]->mutex);
+		count += shards[i]->records.size();
+	}
+	return (count);
+}
+
+detectionstoremetrics detectionstore::getmetrics() const {
+	detectionstoremetrics total;
+	for (size_t i = 0; i < shards.size(); i++) {
+		std::lock_guard<std::mutex> guard(shards[i]->mutex);
+		const detectionstoremetrics &metrics = shards[i]->metrics;
+		total.messages += metrics.messages;
+		total.created += metrics.created;
+		total.updated += metrics.updated;
+		total.finalized += metrics.finalized;
+		total.retracted += metrics.retracted;
+		total.pending += metrics.pending;
+		total.stale += metrics.stale;
+		total.invalid += metrics.invalid;
+		total.expired += metrics.expired;
+	}
+	return (total);
+}
+
+detectionstore::shard & detectionstore::getshard(const std::string &id) const {
+	return (*shards[HashBytes(id) & (shards.size() - 1)]);
+}
+
+detectionstore::version detectionstore::replace(shard &owner,
+		record &target, const version &newversion, detectiontypeindex state) {
+	version released = target.current;
+	if ((target.current) && (historylimit > 0)) {
+		target.history.push_back(target.current);
+		released.reset();
+		if (target.history.size() > historylimit) {
+			released = target.history.front();
+			target.history.erase(target.history.begin());
+		}
+	}
+	target.current = newversion;
+	target.state = state;
+
+	// an update usually keeps its origin time, and then keeps its place; one
+	// without an origin time is moved up to the current expire() call
+	double time = newversion->hypocenter.time;
+	bool timed = (std::isnan(time) == false);
+	double key = (timed == true) ?
+			time : static_cast<double>(owner.expirations);
+	if ((target.indexed == true) && (target.timed == timed)
+			&& (target.position->first == key)) {
+		return (released);
+	}
+	if (target.indexed == true) {
+		if (target.timed == true) {
+			owner.times.erase(target.position);
+		} else {
+			owner.untimed.erase(target.position);
+		}
+	}
+	if (timed == true) {
+		target.position = owner.times.insert(std::make_pair(key, &target));
+	} else {
+		target.position = owner.untimed.insert(std::make_pair(key, &target));
+	}
+	target.timed = timed;
+	target.indexed = true;
+	return (released);
+}
+}
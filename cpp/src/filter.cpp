@@ -1,4 +1,5 @@
 #include "filter.h"
+#include "fields.h"
 
 #include <limits>
 
@@ -8,6 +9,11 @@
 
 namespace detectionformats
 {
+	// field descriptors, in the order the fields are written to json
+	static constexpr auto fields = std::make_tuple(
+			detectionformats::numberfield(HIGHPASS_KEY, &filter::highpass),
+			detectionformats::numberfield(LOWPASS_KEY, &filter::lowpass));
+
 	filter::filter()
 	{
 		highpass = std::numeric_limits<double>::quiet_NaN();
@@ -22,18 +28,7 @@ namespace detectionformats
 
 	filter::filter(rapidjson::Value &json)
 	{
-		// optional values
-		// highpass
-		if ((json.HasMember(HIGHPASS_KEY) == true) && (json[HIGHPASS_KEY].IsNumber() == true) && (json[HIGHPASS_KEY].IsDouble() == true))
-			highpass = json[HIGHPASS_KEY].GetDouble();
-		else
-			highpass = std::numeric_limits<double>::quiet_NaN();
-
-		// lowpass
-		if ((json.HasMember(LOWPASS_KEY) == true) && (json[LOWPASS_KEY].IsNumber() == true) && (json[LOWPASS_KEY].IsDouble() == true))
-			lowpass = json[LOWPASS_KEY].GetDouble();
-		else
-			lowpass = std::numeric_limits<double>::quiet_NaN();
+		resetfrom(json);
 	}
 
 
@@ -47,29 +42,51 @@ namespace detectionformats
 	{
 	}
 
-	rapidjson::Value & filter::tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator)
+	void filter::resetfrom(rapidjson::Value &json)
 	{
-		json.SetObject();
+		clear();
 
-		// optional values
-		// highpass
-		if (std::isnan(highpass) != true)
-			json.AddMember(HIGHPASS_KEY, highpass, allocator);
+		detectionformats::ParseFields(*this, json, fields);
+	}
 
-		// lowpass
-		if (std::isnan(lowpass) != true)
-			json.AddMember(LOWPASS_KEY, lowpass, allocator);
+	void filter::clear()
+	{
+		highpass = std::numeric_limits<double>::quiet_NaN();
+		lowpass = std::numeric_limits<double>::quiet_NaN();
+	}
+
+	rapidjson::Value & filter::tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const
+	{
+		return (detectionformats::WriteFields(*this, json, allocator, fields));
+	}
 
-		return(json);
+	void filter::tobinary(std::string &buffer) const
+	{
+		detectionformats::EncodeFields(*this, buffer, fields);
+	}
+
+	size_t filter::frombinary(const char *buffer, size_t length)
+	{
+		return (detectionformats::DecodeFields(*this, buffer, length, fields));
+	}
+
+	bool filter::operator==(const filter &other) const
+	{
+		return (detectionformats::EqualFields(*this, other, fields));
+	}
+
+	bool filter::operator!=(const filter &other) const
+	{
+		return (!(*this == other));
 	}
 
-	std::vector<std::string> filter::geterrors()
+	std::vector<std::string> filter::geterrors() const
 	{
 		// nothing to check
 		return (std::vector<std::string>());
 	}
 
-	bool filter::isempty()
+	bool filter::isempty() const
     {
 		if (std::isnan(highpass) != true)
 			return(false);
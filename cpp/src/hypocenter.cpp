@@ -1,4 +1,5 @@
 #include "hypocenter.h"
+#include "fields.h"
 
 #include <limits>
 
@@ -13,6 +14,26 @@
 #define TIME_ERROR_KEY "TimeError"
 
 namespace detectionformats {
+// field descriptors, in the order the fields are written to json
+static constexpr auto fields = std::make_tuple(
+		detectionformats::requiredfield(
+				detectionformats::numberfield(LATITUDE_KEY,
+						&hypocenter::latitude)),
+		detectionformats::requiredfield(
+				detectionformats::numberfield(LONGITUDE_KEY,
+						&hypocenter::longitude)),
+		detectionformats::requiredfield(
+				detectionformats::timefield(TIME_KEY, &hypocenter::time)),
+		detectionformats::requiredfield(
+				detectionformats::numberfield(DEPTH_KEY, &hypocenter::depth)),
+		detectionformats::numberfield(LATITUDE_ERROR_KEY,
+				&hypocenter::latitudeerror),
+		detectionformats::numberfield(LONGITUDE_ERROR_KEY,
+				&hypocenter::longitudeerror),
+		detectionformats::numberfield(TIME_ERROR_KEY, &hypocenter::timeerror),
+		detectionformats::numberfield(DEPTH_ERROR_KEY,
+				&hypocenter::deptherror));
+
 
 hypocenter::hypocenter() {
 	latitude = std::numeric_limits<double>::quiet_NaN();
@@ -39,72 +60,7 @@ hypocenter::hypocenter(double newlatitude, double newlongitude, double newtime,
 }
 
 hypocenter::hypocenter(rapidjson::Value &json) {
-	// required values
-	// latitude
-	if ((json.HasMember(LATITUDE_KEY) == true)
-			&& (json[LATITUDE_KEY].IsNumber() == true)
-			&& (json[LATITUDE_KEY].IsDouble() == true))
-		latitude = json[LATITUDE_KEY].GetDouble();
-	else
-		latitude = std::numeric_limits<double>::quiet_NaN();
-
-	// longitude
-	if ((json.HasMember(LONGITUDE_KEY) == true)
-			&& (json[LONGITUDE_KEY].IsNumber() == true)
-			&& (json[LONGITUDE_KEY].IsDouble() == true))
-		longitude = json[LONGITUDE_KEY].GetDouble();
-	else
-		longitude = std::numeric_limits<double>::quiet_NaN();
-
-	// time
-	if ((json.HasMember(TIME_KEY) == true)
-			&& (json[TIME_KEY].IsString() == true))
-		time = detectionformats::ConvertISO8601ToEpochTime(
-				std::string(json[TIME_KEY].GetString(),
-						json[TIME_KEY].GetStringLength()));
-	else
-		time = std::numeric_limits<double>::quiet_NaN();
-
-	// depth
-	if ((json.HasMember(DEPTH_KEY) == true)
-			&& (json[DEPTH_KEY].IsNumber() == true)
-			&& (json[DEPTH_KEY].IsDouble() == true))
-		depth = json[DEPTH_KEY].GetDouble();
-	else
-		depth = std::numeric_limits<double>::quiet_NaN();
-
-	// optional values
-	// latitude error
-	if ((json.HasMember(LATITUDE_ERROR_KEY) == true)
-			&& (json[LATITUDE_ERROR_KEY].IsNumber() == true)
-			&& (json[LATITUDE_ERROR_KEY].IsDouble() == true))
-		latitudeerror = json[LATITUDE_ERROR_KEY].GetDouble();
-	else
-		latitudeerror = std::numeric_limits<double>::quiet_NaN();
-
-	// longitude error
-	if ((json.HasMember(LONGITUDE_ERROR_KEY) == true)
-			&& (json[LONGITUDE_ERROR_KEY].IsNumber() == true)
-			&& (json[LONGITUDE_ERROR_KEY].IsDouble() == true))
-		longitudeerror = json[LONGITUDE_ERROR_KEY].GetDouble();
-	else
-		longitudeerror = std::numeric_limits<double>::quiet_NaN();
-
-	// time error
-	if ((json.HasMember(TIME_ERROR_KEY) == true)
-			&& (json[TIME_ERROR_KEY].IsNumber() == true)
-			&& (json[TIME_ERROR_KEY].IsDouble() == true))
-		timeerror = json[TIME_ERROR_KEY].GetDouble();
-	else
-		timeerror = std::numeric_limits<double>::quiet_NaN();
-
-	// depth error
-	if ((json.HasMember(DEPTH_ERROR_KEY) == true)
-			&& (json[DEPTH_ERROR_KEY].IsNumber() == true)
-			&& (json[DEPTH_ERROR_KEY].IsDouble() == true))
-		deptherror = json[DEPTH_ERROR_KEY].GetDouble();
-	else
-		deptherror = std::numeric_limits<double>::quiet_NaN();
+	resetfrom(json);
 }
 
 hypocenter::hypocenter(const hypocenter & newhypocenter) {
@@ -121,77 +77,64 @@ hypocenter::hypocenter(const hypocenter & newhypocenter) {
 hypocenter::~hypocenter() {
 }
 
-rapidjson::Value & hypocenter::tojson(rapidjson::Value &json,
-		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) {
-	json.SetObject();
+void hypocenter::resetfrom(rapidjson::Value &json) {
+	clear();
 
-	// required values
-	// latitude
-	if (std::isnan(latitude) != true)
-		json.AddMember(LATITUDE_KEY, latitude, allocator);
-
-	// longitude
-	if (std::isnan(longitude) != true)
-		json.AddMember(LONGITUDE_KEY, longitude, allocator);
-
-	// time
-	if (std::isnan(time) != true) {
-		std::string timestring = detectionformats::ConvertEpochTimeToISO8601(
-				time);
-		rapidjson::Value timevalue;
-		timevalue.SetString(rapidjson::StringRef(timestring.c_str()),
-				allocator);
-		json.AddMember(TIME_KEY, timevalue, allocator);
-	}
+	detectionformats::ParseFields(*this, json, fields);
+}
 
-	// depth
-	if (std::isnan(depth) != true)
-		json.AddMember(DEPTH_KEY, depth, allocator);
+void hypocenter::clear() {
+	latitude = std::numeric_limits<double>::quiet_NaN();
+	longitude = std::numeric_limits<double>::quiet_NaN();
+	depth = std::numeric_limits<double>::quiet_NaN();
+	time = std::numeric_limits<double>::quiet_NaN();
+	latitudeerror = std::numeric_limits<double>::quiet_NaN();
+	longitudeerror = std::numeric_limits<double>::quiet_NaN();
+	deptherror = std::numeric_limits<double>::quiet_NaN();
+	timeerror = std::numeric_limits<double>::quiet_NaN();
+}
 
-	// optional values
-	// latitude error
-	if (std::isnan(latitudeerror) != true)
-		json.AddMember(LATITUDE_ERROR_KEY, latitudeerror, allocator);
+rapidjson::Value & hypocenter::tojson(rapidjson::Value &json,
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+	return (detectionformats::WriteFields(*this, json, allocator, fields));
+}
 
-	// longitude error
-	if (std::isnan(longitudeerror) != true)
-		json.AddMember(LONGITUDE_ERROR_KEY, longitudeerror, allocator);
+void hypocenter::tobinary(std::string &buffer) const {
+	detectionformats::EncodeFields(*this, buffer, fields);
+}
 
-	// time error
-	if (std::isnan(timeerror) != true)
-		json.AddMember(TIME_ERROR_KEY, timeerror, allocator);
+size_t hypocenter::frombinary(const char *buffer, size_t length) {
+	return (detectionformats::DecodeFields(*this, buffer, length, fields));
+}
 
-	// depth error
-	if (std::isnan(deptherror) != true)
-		json.AddMember(DEPTH_ERROR_KEY, deptherror, allocator);
+bool hypocenter::operator==(const hypocenter &other) const {
+	return (detectionformats::EqualFields(*this, other, fields));
+}
 
-	return (json);
+bool hypocenter::operator!=(const hypocenter &other) const {
+	return (!(*this == other));
 }
 
-std::vector<std::string> hypocenter::geterrors() {
+std::vector<std::string> hypocenter::geterrors() const {
 	std::vector<std::string> errorlist;
 
 	// check required data
+	// latitude, longitude, time, and depth
+	detectionformats::CheckRequiredFields(*this, "hypocenter", fields,
+			errorlist);
+
 	// latitude
-	if (std::isnan(latitude) == true) {
-		// latitude not found
-		errorlist.push_back("No Latitude in hypocenter class.");
-	} else if ((latitude < -90) || (latitude > 90)) {
+	if ((latitude < -90) || (latitude > 90)) {
 		errorlist.push_back("Invalid Latitude in hypocenter class.");
 	}
 
 	// longitude
-	if (std::isnan(longitude) == true) {
-		// longitude not found
-		errorlist.push_back("No Longitude in hypocenter class.");
-	} else if ((longitude < -180) || (longitude > 180)) {
+	if ((longitude < -180) || (longitude > 180)) {
 		errorlist.push_back("Invalid Longitude in hypocenter class.");
 	}
 
 	// time
-	if (std::isnan(time) == true) {
-		errorlist.push_back("Time is missing in hypocenter class.");
-	} else {
+	if (std::isnan(time) != true) {
 		try {
 			if (detectionformats::IsStringISO8601(
 					detectionformats::ConvertEpochTimeToISO8601(time))
@@ -205,10 +148,7 @@ std::vector<std::string> hypocenter::geterrors() {
 	}
 
 	// depth
-	if (std::isnan(depth) == true) {
-		// depth not found
-		errorlist.push_back("No Depth in hypocenter class.");
-	} else if ((depth < -100) || (depth > 1500)) {
+	if ((depth < -100) || (depth > 1500)) {
 		errorlist.push_back("Invalid Depth in hypocenter class.");
 	}
 
@@ -0,0 +1,467 @@
+#include "ingestserver.h"
+
+#if defined(__linux__)
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "util.h"
+
+// the most read from a connection per readiness event, large enough to
+// take many messages per read
+#define READSIZE 65536
+
+// the longest message accepted, a connection sending a longer line is
+// closed rather than buffered without bound
+#define MAXMESSAGELENGTH (16 * 1024 * 1024)
+
+// the most events handled per epoll_wait
+#define MAXEVENTS 64
+
+// how long the event loop sleeps between queue checks while paused
+#define PAUSEDWAITMS 1
+
+namespace detectionformats {
+
+// checks whether the file at a Unix socket address is a socket nothing is
+// listening on, one left by a server that has exited
+static bool IsStaleSocket(const sockaddr_un &address) {
+	struct stat status;
+	if ((lstat(address.sun_path, &status) < 0)
+			|| (S_ISSOCK(status.st_mode) == false)) {
+		return (false);
+	}
+
+	int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (probe < 0) {
+		return (false);
+	}
+	bool refused = (connect(probe,
+			reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0)
+			&& (errno == ECONNREFUSED);
+	::close(probe);
+	return (refused);
+}
+
+ingestserver::ingestserver(callback newhandler, size_t queuecapacity,
+		size_t callbackthreads)
+		: handler(newhandler),
+			parsedqueue(queuecapacity),
+			highwater(parsedqueue.capacity() - (parsedqueue.capacity() / 8)),
+			lowwater(parsedqueue.capacity() / 2),
+			epolldescriptor(-1),
+			wakedescriptor(-1),
+			paused(false),
+			stopping(false),
+			finished(false),
+			connectioncount(0),
+			bytecount(0),
+			messagecount(0),
+			errorcount(0),
+			pausecount(0) {
+	epolldescriptor = epoll_create1(EPOLL_CLOEXEC);
+	if (epolldescriptor < 0) {
+		throw SystemError("epoll_create1");
+	}
+
+	wakedescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wakedescriptor < 0) {
+		::close(epolldescriptor);
+		throw SystemError("eventfd");
+	}
+
+	epoll_event event;
+	std::memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = wakedescriptor;
+	epoll_ctl(epolldescriptor, EPOLL_CTL_ADD, wakedescriptor, &event);
+
+	if (callbackthreads == 0) {
+		callbackthreads = 1;
+	}
+	for (size_t i = 0; i < callbackthreads; i++) {
+		threads.push_back(std::thread(&ingestserver::callbackstage, this));
+	}
+}
+
+ingestserver::~ingestserver() {
+	for (size_t i = 0; i < connections.size(); i++) {
+		if (connections[i] != NULL) {
+			closeconnection(*connections[i]);
+		}
+	}
+	for (size_t i = 0; i < listeners.size(); i++) {
+		::close(listeners[i]);
+	}
+	for (size_t i = 0; i < socketpaths.size(); i++) {
+		unlink(socketpaths[i].c_str());
+	}
+
+	// queue any overflow, then let the callback threads drain the queue
+	// and stop them
+	backoff wait;
+	while (overflow.empty() == false) {
+		flushoverflow();
+		wait.pause();
+	}
+	finished.store(true);
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+
+	::close(wakedescriptor);
+	::close(epolldescriptor);
+}
+
+void ingestserver::listenunix(const std::string &path) {
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	if (path.length() >= sizeof(address.sun_path)) {
+		throw std::runtime_error("Unix socket path too long: " + path);
+	}
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.c_str(), path.length());
+
+	int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+			0);
+	if (listener < 0) {
+		throw SystemError("socket");
+	}
+
+	// a socket left by a server that has exited is replaced, but anything
+	// else at the path, including a live server's socket, is not
+	int bound = bind(listener, reinterpret_cast<sockaddr *>(&address),
+			sizeof(address));
+	if ((bound < 0) && (errno == EADDRINUSE)) {
+		if (IsStaleSocket(address) == true) {
+			unlink(path.c_str());
+			bound = bind(listener, reinterpret_cast<sockaddr *>(&address),
+					sizeof(address));
+		} else {
+			errno = EADDRINUSE;
+		}
+	}
+	if ((bound < 0) || (listen(listener, SOMAXCONN) < 0)) {
+		std::runtime_error error = SystemError("bind " + path);
+		::close(listener);
+		throw error;
+	}
+
+	epoll_event event;
+	std::memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = listener;
+	epoll_ctl(epolldescriptor, EPOLL_CTL_ADD, listener, &event);
+
+	listeners.push_back(listener);
+	socketpaths.push_back(path);
+}
+
+uint16_t ingestserver::listentcp(uint16_t port) {
+	sockaddr_in address;
+	std::memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(port);
+
+	int listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+			0);
+	if (listener < 0) {
+		throw SystemError("socket");
+	}
+
+	int reuse = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	socklen_t addresslength = sizeof(address);
+	if ((bind(listener, reinterpret_cast<sockaddr *>(&address),
+			sizeof(address)) < 0) || (listen(listener, SOMAXCONN) < 0)
+			|| (getsockname(listener, reinterpret_cast<sockaddr *>(&address),
+					&addresslength) < 0)) {
+		std::runtime_error error = SystemError("bind tcp");
+		::close(listener);
+		throw error;
+	}
+
+	epoll_event event;
+	std::memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = listener;
+	epoll_ctl(epolldescriptor, EPOLL_CTL_ADD, listener, &event);
+
+	listeners.push_back(listener);
+	return (ntohs(address.sin_port));
+}
+
+void ingestserver::run() {
+	epoll_event events[MAXEVENTS];
+
+	while (stopping.load() == false) {
+		// apply backpressure, stop reading while the callbacks are behind
+		flushoverflow();
+		if ((paused == false) && (isbehind() == true)) {
+			setpaused(true);
+		} else if ((paused == true) && (overflow.empty() == true)
+				&& (parsedqueue.size() <= lowwater)) {
+			setpaused(false);
+		}
+
+		int count = epoll_wait(epolldescriptor, events, MAXEVENTS,
+				(paused == true) ? PAUSEDWAITMS : -1);
+		if (count < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw SystemError("epoll_wait");
+		}
+
+		for (int i = 0; i < count; i++) {
+			int descriptor = events[i].data.fd;
+
+			if (descriptor == wakedescriptor) {
+				uint64_t value;
+				while (read(wakedescriptor, &value, sizeof(value)) > 0) {
+				}
+				continue;
+			}
+
+			bool islistener = false;
+			for (size_t j = 0; j < listeners.size(); j++) {
+				if (listeners[j] == descriptor) {
+					islistener = true;
+					break;
+				}
+			}
+			if (islistener == true) {
+				acceptconnections(descriptor);
+				continue;
+			}
+
+			// stop reading part way through the events once behind, the
+			// unread connections are reported again after resuming
+			if ((paused == false) && (isbehind() == true)) {
+				setpaused(true);
+			}
+			if (paused == true) {
+				continue;
+			}
+
+			if ((static_cast<size_t>(descriptor) < connections.size())
+					&& (connections[descriptor] != NULL)) {
+				if (readconnection(*connections[descriptor]) == false) {
+					closeconnection(*connections[descriptor]);
+					connections[descriptor].reset();
+				}
+			}
+		}
+	}
+}
+
+void ingestserver::stop() {
+	stopping.store(true);
+
+	uint64_t value = 1;
+	ssize_t written = write(wakedescriptor, &value, sizeof(value));
+	(void) written;
+}
+
+ingeststatistics ingestserver::getstatistics() const {
+	ingeststatistics statistics;
+	statistics.connections = connectioncount.load();
+	statistics.bytes = bytecount.load();
+	statistics.messages = messagecount.load();
+	statistics.errors = errorcount.load();
+	statistics.pauses = pausecount.load();
+	statistics.depth = parsedqueue.size();
+	return (statistics);
+}
+
+void ingestserver::acceptconnections(int listener) {
+	while (true) {
+		int descriptor = accept4(listener, NULL, NULL,
+				SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (descriptor < 0) {
+			// EAGAIN once every pending connection is accepted
+			return;
+		}
+
+		if (static_cast<size_t>(descriptor) >= connections.size()) {
+			connections.resize(descriptor + 1);
+		}
+		connections[descriptor].reset(new connection());
+		connections[descriptor]->descriptor = descriptor;
+		connections[descriptor]->buffer.resize(READSIZE);
+		connections[descriptor]->used = 0;
+
+		// a paused connection is added when reading resumes
+		if (paused == false) {
+			watchconnection(descriptor);
+		}
+
+		connectioncount++;
+	}
+}
+
+bool ingestserver::readconnection(connection &client) {
+	// make room for a full read after any partial message left over
+	if (client.buffer.size() - client.used < READSIZE) {
+		if (client.used > MAXMESSAGELENGTH) {
+			// a message longer than we accept, drop the connection
+			errorcount++;
+			return (false);
+		}
+		client.buffer.resize(client.used + READSIZE);
+	}
+
+	ssize_t length = read(client.descriptor, &client.buffer[client.used],
+			READSIZE);
+	if (length < 0) {
+		return ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR));
+	}
+
+	if (length == 0) {
+		// end of stream, the last message may not have a trailing newline
+		if (client.used > 0) {
+			processmessage(client.buffer.data(), client.used);
+		}
+		return (false);
+	}
+
+	bytecount += length;
+	client.used += length;
+
+	// parse every complete message in place, and move the partial one left
+	// over to the front of the buffer
+	size_t consumed = processlines(client.buffer.data(), client.used);
+	if (consumed > 0) {
+		client.used -= consumed;
+		std::memmove(client.buffer.data(), client.buffer.data() + consumed,
+				client.used);
+	}
+
+	return (true);
+}
+
+size_t ingestserver::processlines(const char *buffer, size_t length) {
+	size_t start = 0;
+	while (start < length) {
+		const char *newline = static_cast<const char *>(std::memchr(
+				buffer + start, '\n', length - start));
+		if (newline == NULL) {
+			break;
+		}
+
+		size_t end = newline - buffer;
+		processmessage(buffer + start, end - start);
+		start = end + 1;
+	}
+	return (start);
+}
+
+void ingestserver::processmessage(const char *buffer, size_t length) {
+	// skip blank lines and carriage returns
+	while ((length > 0)
+			&& ((buffer[length - 1] == '\r') || (buffer[length - 1] == ' '))) {
+		length--;
+	}
+	if (length == 0) {
+		return;
+	}
+
+	std::unique_ptr<parseresult> result(new parseresult());
+	ParseMessage(buffer, length, parsecontext::local(), *result);
+	if (result->isparsed() == false) {
+		errorcount++;
+	}
+
+	// never wait on the callbacks here, a full queue is the event loop's
+	// cue to stop reading; keep later messages behind any overflow so each
+	// connection's messages stay in order
+	if ((overflow.empty() == false)
+			|| (parsedqueue.trypush(std::move(result)) == false)) {
+		overflow.push_back(std::move(result));
+	}
+}
+
+void ingestserver::flushoverflow() {
+	while ((overflow.empty() == false)
+			&& (parsedqueue.trypush(std::move(overflow.front())) == true)) {
+		overflow.pop_front();
+	}
+}
+
+bool ingestserver::isbehind() const {
+	return ((overflow.empty() == false)
+			|| (parsedqueue.size() >= highwater));
+}
+
+void ingestserver::watchconnection(int descriptor) {
+	epoll_event event;
+	std::memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = descriptor;
+	epoll_ctl(epolldescriptor, EPOLL_CTL_ADD, descriptor, &event);
+}
+
+void ingestserver::closeconnection(connection &client) {
+	if (paused == false) {
+		epoll_ctl(epolldescriptor, EPOLL_CTL_DEL, client.descriptor, NULL);
+	}
+	::close(client.descriptor);
+}
+
+void ingestserver::setpaused(bool pause) {
+	paused = pause;
+	if (pause == true) {
+		pausecount++;
+	}
+
+	// remove the connections from epoll rather than clearing their events,
+	// a hung up connection is reported even with no events requested
+	for (size_t i = 0; i < connections.size(); i++) {
+		if (connections[i] == NULL) {
+			continue;
+		}
+		if (pause == true) {
+			epoll_ctl(epolldescriptor, EPOLL_CTL_DEL,
+					connections[i]->descriptor, NULL);
+		} else {
+			watchconnection(connections[i]->descriptor);
+		}
+	}
+}
+
+void ingestserver::callbackstage() {
+	backoff wait;
+	std::unique_ptr<parseresult> result;
+	while (true) {
+		bool done = finished.load();
+
+		if (parsedqueue.trypop(result) == true) {
+			wait.reset();
+			bool valid = (result->isparsed() == true)
+					&& (result->object->isvalid() == true);
+			handler(*result, valid);
+			messagecount++;
+			continue;
+		}
+
+		if (done == true) {
+			return;
+		}
+		wait.pause();
+	}
+}
+}
+
+#endif
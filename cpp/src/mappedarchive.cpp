@@ -0,0 +1,253 @@
+#include "mappedarchive.h"
+
+#if !defined(_WIN32)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+#include "batch.h"
+#include "util.h"
+
+// JSON Keys
+#define TYPE_KEY "Type"
+
+// the most failure offsets kept in an archivesummary
+#define MAXFAILURES 100
+
+// ranges per pool thread when the caller does not say, more than one so
+// that a thread finishing a range of short lines can steal another
+#define RANGESPERTHREAD 4
+
+namespace detectionformats {
+
+// calls function(line, length, offset) for each non blank line in the
+// range, without its newline or trailing carriage return
+template<class F>
+static void ForEachLine(const char *archive, const archiverange &range,
+		F function) {
+	const char *position = archive + range.begin;
+	const char *end = archive + range.end;
+	while (position < end) {
+		// memchr is vectorized, so this is the newline scan
+		const char *newline = static_cast<const char *>(std::memchr(position,
+				'\n', end - position));
+		const char *lineend = (newline != NULL) ? newline : end;
+
+		size_t length = lineend - position;
+		while ((length > 0) && (position[length - 1] == '\r')) {
+			length--;
+		}
+		if (length > 0) {
+			function(position, length,
+					static_cast<uint64_t>(position - archive));
+		}
+
+		position = (newline != NULL) ? newline + 1 : end;
+	}
+}
+
+// parses one line into contents
+static void ParseLine(const char *line, size_t length,
+		parsecontext &context, archivecontents &contents) {
+	contents.lines++;
+
+	parsecontext::document &document = context.parse(line, length);
+	if ((document.HasParseError() == true)
+			|| (document.IsObject() == false)) {
+		contents.errors++;
+		return;
+	}
+
+	rapidjson::Value::ConstMemberIterator typemember = document.FindMember(
+			TYPE_KEY);
+	if ((typemember == document.MemberEnd())
+			|| (typemember->value.IsString() == false)) {
+		contents.errors++;
+		return;
+	}
+
+	// construct the messages in place, rather than through parseresult, to
+	// save an allocation and a copy per message
+	const rapidjson::Value &type = typemember->value;
+	try {
+		if (IsJSONKey(type, PICK_TYPE) == true) {
+			contents.picks.emplace_back(document);
+		} else if (IsJSONKey(type, CORRELATION_TYPE) == true) {
+			contents.correlations.emplace_back(document);
+		} else if (IsJSONKey(type, DETECTION_TYPE) == true) {
+			contents.detections.emplace_back(document);
+		} else if ((IsJSONKey(type, RETRACT_TYPE) == true)
+				|| (IsJSONKey(type, STATIONINFO_TYPE) == true)
+				|| (IsJSONKey(type, STATIONINFOREQUEST_TYPE) == true)) {
+			contents.others++;
+		} else {
+			contents.errors++;
+		}
+	} catch (const std::exception &) {
+		contents.errors++;
+	}
+}
+
+mappedarchive::mappedarchive(const std::string &path)
+		: mapping(NULL),
+			mappingsize(0) {
+	int descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (descriptor < 0) {
+		throw SystemError("open " + path);
+	}
+
+	struct stat status;
+	if (fstat(descriptor, &status) < 0) {
+		std::runtime_error error = SystemError("fstat " + path);
+		close(descriptor);
+		throw error;
+	}
+	mappingsize = static_cast<uint64_t>(status.st_size);
+
+	// an empty file cannot be mapped, and needs no mapping
+	if (mappingsize > 0) {
+		void *address = mmap(NULL, mappingsize, PROT_READ, MAP_PRIVATE,
+				descriptor, 0);
+		if (address == MAP_FAILED) {
+			std::runtime_error error = SystemError("mmap " + path);
+			close(descriptor);
+			throw error;
+		}
+		mapping = static_cast<char *>(address);
+
+		// each range is read front to back, so ask for aggressive read ahead
+		madvise(mapping, mappingsize, MADV_SEQUENTIAL);
+	}
+
+	// the mapping holds its own reference to the file
+	close(descriptor);
+}
+
+mappedarchive::~mappedarchive() {
+	if (mapping != NULL) {
+		munmap(mapping, mappingsize);
+	}
+}
+
+const char *mappedarchive::data() const {
+	return (mapping);
+}
+
+uint64_t mappedarchive::size() const {
+	return (mappingsize);
+}
+
+std::vector<archiverange> mappedarchive::split(size_t count) const {
+	std::vector<archiverange> ranges;
+	if (mappingsize == 0) {
+		return (ranges);
+	}
+	count = std::max(static_cast<size_t>(1), count);
+	ranges.reserve(count);
+
+	uint64_t begin = 0;
+	for (size_t i = 1; (i <= count) && (begin < mappingsize); i++) {
+		uint64_t end = mappingsize;
+		if (i < count) {
+			// move the even split point past the end of the line it is in
+			uint64_t target = std::max(begin, (mappingsize / count) * i);
+			const char *newline = static_cast<const char *>(std::memchr(
+					mapping + target, '\n', mappingsize - target));
+			end = (newline != NULL) ? (newline - mapping) + 1 : mappingsize;
+		}
+
+		archiverange range;
+		range.begin = begin;
+		range.end = end;
+		ranges.push_back(range);
+		begin = end;
+	}
+
+	return (ranges);
+}
+
+std::vector<archivecontents> mappedarchive::parse(threadpool &pool,
+		size_t count) const {
+	if (count == 0) {
+		count = pool.size() * RANGESPERTHREAD;
+	}
+	std::vector<archiverange> ranges = split(count);
+	std::vector<archivecontents> contents(ranges.size());
+
+	const char *archive = mapping;
+	pool.run(ranges.size(), 1,
+			[archive, &ranges, &contents](size_t begin, size_t end) {
+				parsecontext &context = parsecontext::local();
+				for (size_t i = begin; i < end; i++) {
+					archivecontents &output = contents[i];
+					ForEachLine(archive, ranges[i],
+							[&context, &output](const char *line,
+									size_t length, uint64_t) {
+								ParseLine(line, length, context, output);
+							});
+				}
+			});
+
+	return (contents);
+}
+
+archivesummary mappedarchive::validate(threadpool &pool, size_t count) const {
+	if (count == 0) {
+		count = pool.size() * RANGESPERTHREAD;
+	}
+	std::vector<archiverange> ranges = split(count);
+	std::vector<archivesummary> summaries(ranges.size());
+
+	const char *archive = mapping;
+	pool.run(ranges.size(), 1,
+			[archive, &ranges, &summaries](size_t begin, size_t end) {
+				parsecontext &context = parsecontext::local();
+				parseresult result;
+				for (size_t i = begin; i < end; i++) {
+					archivesummary &summary = summaries[i];
+					ForEachLine(archive, ranges[i],
+							[&context, &result, &summary](const char *line,
+									size_t length, uint64_t offset) {
+								result.object.reset();
+								result.error.clear();
+								ParseMessage(line, length, context, result);
+
+								summary.lines++;
+								if (result.isparsed() == false) {
+									summary.errors++;
+								} else if (result.object->isvalid() == false) {
+									summary.invalid++;
+								} else {
+									return;
+								}
+								if (summary.failures.size() < MAXFAILURES) {
+									summary.failures.push_back(offset);
+								}
+							});
+				}
+			});
+
+	// the ranges are in archive order, so the failures stay in order
+	archivesummary total;
+	for (size_t i = 0; i < summaries.size(); i++) {
+		total.lines += summaries[i].lines;
+		total.errors += summaries[i].errors;
+		total.invalid += summaries[i].invalid;
+		for (size_t j = 0; (j < summaries[i].failures.size())
+				&& (total.failures.size() < MAXFAILURES); j++) {
+			total.failures.push_back(summaries[i].failures[j]);
+		}
+	}
+
+	return (total);
+}
+}
+#endif
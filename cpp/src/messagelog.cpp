@@ -0,0 +1,743 @@
+#include "messagelog.h"
+
+#if !defined(_WIN32)
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "util.h"
+
+// file names
+#define SEGMENT_EXTENSION ".log"
+#define SIDECAR_EXTENSION ".idx"
+#define TEMPORARY_EXTENSION ".tmp"
+#define SEGMENTNAMEDIGITS 8
+
+// a record is its length, checksum, time, id length, type and encoding,
+// then the id and the message; the checksum covers everything after it
+#define RECORDHEADERSIZE 20
+#define RECORDCHECKED 8
+#define MAXIDLENGTH 65535
+
+// a sidecar is its magic, the length of the segment it covers and its
+// entry count, the entries, and a hash of everything before the hash
+#define SIDECARMAGIC "DFLOGIX1"
+#define SIDECARMAGICSIZE 8
+#define SIDECARHEADERSIZE 24
+#define SIDECARENTRYSIZE 24
+
+namespace detectionformats {
+
+// builds the path of a segment's file
+static std::string SegmentPath(const std::string &directory,
+		uint32_t segment, const char *extension) {
+	char name[32];
+	std::snprintf(name, sizeof(name), "/%0*u%s", SEGMENTNAMEDIGITS, segment,
+			extension);
+	return (directory + name);
+}
+
+// lists the segment numbers in a directory, in order
+static std::vector<uint32_t> ListSegments(const std::string &directory) {
+	DIR *listing = opendir(directory.c_str());
+	if (listing == NULL) {
+		throw SystemError("opendir " + directory);
+	}
+
+	std::vector<uint32_t> segments;
+	size_t extensionlength = std::strlen(SEGMENT_EXTENSION);
+	for (struct dirent *item = readdir(listing); item != NULL;
+			item = readdir(listing)) {
+		const char *name = item->d_name;
+		if ((std::strlen(name) != SEGMENTNAMEDIGITS + extensionlength)
+				|| (std::strcmp(name + SEGMENTNAMEDIGITS, SEGMENT_EXTENSION)
+						!= 0)) {
+			continue;
+		}
+		uint32_t segment = 0;
+		bool digits = true;
+		for (int i = 0; (i < SEGMENTNAMEDIGITS) && (digits == true); i++) {
+			digits = (name[i] >= '0') && (name[i] <= '9');
+			segment = segment * 10 + (name[i] - '0');
+		}
+		if (digits == true) {
+			segments.push_back(segment);
+		}
+	}
+	closedir(listing);
+
+	std::sort(segments.begin(), segments.end());
+	return (segments);
+}
+
+// writes all of a buffer at an offset
+static bool WriteAll(int descriptor, const char *data, size_t length,
+		uint64_t offset) {
+	while (length > 0) {
+		ssize_t written = pwrite(descriptor, data, length,
+				static_cast<off_t>(offset));
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return (false);
+		}
+		data += written;
+		length -= written;
+		offset += written;
+	}
+	return (true);
+}
+
+// reads all of a buffer from an offset
+static bool ReadAll(int descriptor, char *data, size_t length,
+		uint64_t offset) {
+	while (length > 0) {
+		ssize_t count = pread(descriptor, data, length,
+				static_cast<off_t>(offset));
+		if (count < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return (false);
+		}
+		if (count == 0) {
+			return (false);
+		}
+		data += count;
+		length -= count;
+		offset += count;
+	}
+	return (true);
+}
+
+// parses the record at offset into entry, setting next to the offset after
+// it, returning false if it is cut short or fails its checksum
+static bool ParseRecord(const char *data, uint64_t size, uint64_t offset,
+		uint32_t segment, messagelogentry &entry, uint64_t &next) {
+	if ((offset > size) || (size - offset < RECORDHEADERSIZE)) {
+		return (false);
+	}
+	const char *header = data + offset;
+	uint32_t length;
+	uint32_t checksum;
+	double time;
+	uint16_t idlength;
+	std::memcpy(&length, header, sizeof(length));
+	std::memcpy(&checksum, header + 4, sizeof(checksum));
+	std::memcpy(&time, header + 8, sizeof(time));
+	std::memcpy(&idlength, header + 16, sizeof(idlength));
+	int type = static_cast<unsigned char>(header[18]);
+	int messageencoding = static_cast<unsigned char>(header[19]);
+
+	// zeros, as a file system leaves after a crash, are not a record
+	uint64_t recordsize = static_cast<uint64_t>(RECORDHEADERSIZE) + idlength
+			+ length;
+	if ((length == 0) || (type > formattypes::stationinforequesttype)
+			|| (messageencoding > binaryencoding)
+			|| (size - offset < recordsize)) {
+		return (false);
+	}
+	if (static_cast<uint32_t>(HashBytes(header + RECORDCHECKED,
+			recordsize - RECORDCHECKED)) != checksum) {
+		return (false);
+	}
+
+	entry.id.assign(header + RECORDHEADERSIZE, idlength);
+	entry.segment = segment;
+	entry.offset = offset + RECORDHEADERSIZE + idlength;
+	entry.length = length;
+	entry.type = type;
+	entry.encoding = static_cast<messagelogencoding>(messageencoding);
+	entry.time = time;
+	next = offset + recordsize;
+	return (true);
+}
+
+// indexes the records of a segment from start, returning the offset after
+// the last whole record
+static uint64_t ScanSegment(const char *data, uint64_t size, uint64_t start,
+		uint32_t segment, messagelogindex &index) {
+	messagelogentry entry;
+	uint64_t offset = start;
+	uint64_t next = start;
+	while (ParseRecord(data, size, offset, segment, entry, next) == true) {
+		index.add(entry);
+		offset = next;
+	}
+	return (offset);
+}
+
+// loads a segment's sidecar into index, returning false, and adding
+// nothing, if it is missing, corrupt or covers more than the segment
+static bool LoadSidecar(const std::string &directory, uint32_t segment,
+		uint64_t size, messagelogindex &index, uint64_t &covered) {
+	int descriptor = open(
+			SegmentPath(directory, segment, SIDECAR_EXTENSION).c_str(),
+			O_RDONLY | O_CLOEXEC);
+	if (descriptor < 0) {
+		return (false);
+	}
+	struct stat status;
+	std::string sidecar;
+	bool loaded = (fstat(descriptor, &status) == 0);
+	if (loaded == true) {
+		sidecar.resize(static_cast<size_t>(status.st_size));
+		loaded = (sidecar.empty() == false)
+				&& (ReadAll(descriptor, &sidecar[0], sidecar.size(), 0)
+						== true);
+	}
+	close(descriptor);
+	if ((loaded == false)
+			|| (sidecar.size() < SIDECARHEADERSIZE + sizeof(uint64_t))
+			|| (sidecar.compare(0, SIDECARMAGICSIZE, SIDECARMAGIC) != 0)) {
+		return (false);
+	}
+
+	size_t hashed = sidecar.size() - sizeof(uint64_t);
+	uint64_t hash;
+	std::memcpy(&hash, sidecar.data() + hashed, sizeof(hash));
+	if (HashBytes(sidecar.data(), hashed) != hash) {
+		return (false);
+	}
+
+	uint64_t count;
+	std::memcpy(&covered, sidecar.data() + SIDECARMAGICSIZE, sizeof(covered));
+	std::memcpy(&count, sidecar.data() + SIDECARMAGICSIZE + 8, sizeof(count));
+	if (covered > size) {
+		return (false);
+	}
+
+	// the entries are checked before any is added
+	std::vector<messagelogentry> entries;
+	size_t position = SIDECARHEADERSIZE;
+	for (uint64_t i = 0; i < count; i++) {
+		if (hashed - position < SIDECARENTRYSIZE) {
+			return (false);
+		}
+		const char *field = sidecar.data() + position;
+		messagelogentry entry;
+		uint16_t idlength;
+		std::memcpy(&entry.offset, field, sizeof(entry.offset));
+		std::memcpy(&entry.length, field + 8, sizeof(entry.length));
+		std::memcpy(&entry.time, field + 12, sizeof(entry.time));
+		entry.type = static_cast<unsigned char>(field[20]);
+		entry.encoding = static_cast<messagelogencoding>(
+				static_cast<unsigned char>(field[21]));
+		std::memcpy(&idlength, field + 22, sizeof(idlength));
+		position += SIDECARENTRYSIZE;
+		if ((hashed - position < idlength) || (entry.offset > covered)
+				|| (covered - entry.offset < entry.length)) {
+			return (false);
+		}
+		entry.id.assign(sidecar.data() + position, idlength);
+		entry.segment = segment;
+		position += idlength;
+		entries.push_back(entry);
+	}
+	if (position != hashed) {
+		return (false);
+	}
+
+	for (size_t i = 0; i < entries.size(); i++) {
+		index.add(entries[i]);
+	}
+	return (true);
+}
+
+// writes the sidecar of a segment holding the index's entries in
+// [first, last), covering its first covered characters
+// flushes a directory's entries to storage, so a file created or renamed
+// in it survives the system failing
+static void SyncDirectory(const std::string &directory) {
+	int descriptor = open(directory.c_str(),
+			O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (descriptor < 0) {
+		throw SystemError("open " + directory);
+	}
+	if (fsync(descriptor) < 0) {
+		std::runtime_error error = SystemError("fsync " + directory);
+		close(descriptor);
+		throw error;
+	}
+	close(descriptor);
+}
+
+static void WriteSidecar(const std::string &directory, uint32_t segment,
+		const messagelogindex &index, size_t first, size_t last,
+		uint64_t covered) {
+	std::string sidecar(SIDECARMAGIC, SIDECARMAGICSIZE);
+	uint64_t count = last - first;
+	sidecar.append(reinterpret_cast<const char *>(&covered), sizeof(covered));
+	sidecar.append(reinterpret_cast<const char *>(&count), sizeof(count));
+	for (size_t i = first; i < last; i++) {
+		const messagelogentry &entry = index.get(i);
+		char field[SIDECARENTRYSIZE];
+		uint16_t idlength = static_cast<uint16_t>(entry.id.length());
+		std::memcpy(field, &entry.offset, sizeof(entry.offset));
+		std::memcpy(field + 8, &entry.length, sizeof(entry.length));
+		std::memcpy(field + 12, &entry.time, sizeof(entry.time));
+		field[20] = static_cast<char>(entry.type);
+		field[21] = static_cast<char>(entry.encoding);
+		std::memcpy(field + 22, &idlength, sizeof(idlength));
+		sidecar.append(field, SIDECARENTRYSIZE);
+		sidecar.append(entry.id);
+	}
+	uint64_t hash = HashBytes(sidecar.data(), sidecar.size());
+	sidecar.append(reinterpret_cast<const char *>(&hash), sizeof(hash));
+
+	// a crash leaves either the old sidecar or the new one, never a mix
+	std::string path = SegmentPath(directory, segment, SIDECAR_EXTENSION);
+	std::string temporary = path + TEMPORARY_EXTENSION;
+	int descriptor = open(temporary.c_str(),
+			O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (descriptor < 0) {
+		throw SystemError("open " + temporary);
+	}
+	if ((WriteAll(descriptor, sidecar.data(), sidecar.size(), 0) == false)
+			|| (fdatasync(descriptor) < 0)) {
+		std::runtime_error error = SystemError("write " + temporary);
+		close(descriptor);
+		throw error;
+	}
+	close(descriptor);
+	if (rename(temporary.c_str(), path.c_str()) < 0) {
+		throw SystemError("rename " + temporary);
+	}
+	SyncDirectory(directory);
+}
+
+// maps a whole file read only, NULL if it is empty
+static char * MapFile(int descriptor, uint64_t size, const std::string &path) {
+	if (size == 0) {
+		return (NULL);
+	}
+	void *address = mmap(NULL, size, PROT_READ, MAP_SHARED, descriptor, 0);
+	if (address == MAP_FAILED) {
+		throw SystemError("mmap " + path);
+	}
+	return (static_cast<char *>(address));
+}
+
+// gets the size of an open file
+static uint64_t FileSize(int descriptor, const std::string &path) {
+	struct stat status;
+	if (fstat(descriptor, &status) < 0) {
+		throw SystemError("fstat " + path);
+	}
+	return (static_cast<uint64_t>(status.st_size));
+}
+
+// indexes a mapped segment from its sidecar and whatever follows it,
+// returning the offset after the last whole record and setting current if
+// the sidecar covered all of them
+static uint64_t LoadSegment(const std::string &directory, uint32_t segment,
+		const char *data, uint64_t size, messagelogindex &index,
+		bool &current) {
+	uint64_t covered = 0;
+	if (LoadSidecar(directory, segment, size, index, covered) == false) {
+		covered = 0;
+	}
+	uint64_t end = ScanSegment(data, size, covered, segment, index);
+	current = (end == covered);
+	return (end);
+}
+
+void messagelogindex::add(const messagelogentry &entry) {
+	size_t position = entries.size();
+	entries.push_back(entry);
+	ids[entry.id].push_back(position);
+	if (std::isnan(entry.time) == false) {
+		times.insert(std::make_pair(entry.time, position));
+	}
+}
+
+size_t messagelogindex::find(const std::string &id,
+		std::vector<messagelogentry> &results) const {
+	std::unordered_map<std::string, std::vector<size_t>>::const_iterator found =
+			ids.find(id);
+	if (found == ids.end()) {
+		return (0);
+	}
+	for (size_t i = 0; i < found->second.size(); i++) {
+		results.push_back(entries[found->second[i]]);
+	}
+	return (found->second.size());
+}
+
+size_t messagelogindex::within(double starttime, double endtime,
+		std::vector<messagelogentry> &results) const {
+	size_t first = results.size();
+	std::multimap<double, size_t>::const_iterator it = times.lower_bound(
+			starttime);
+	for (; (it != times.end()) && (it->first <= endtime); ++it) {
+		results.push_back(entries[it->second]);
+	}
+	return (results.size() - first);
+}
+
+const messagelogentry & messagelogindex::get(size_t position) const {
+	return (entries[position]);
+}
+
+size_t messagelogindex::size() const {
+	return (entries.size());
+}
+
+void messagelogindex::clear() {
+	entries.clear();
+	ids.clear();
+	times.clear();
+}
+
+messagelog::messagelog(const std::string &newdirectory,
+		uint64_t newsegmentsize, messagelogencoding newencoding)
+		: directory(newdirectory),
+			segmentsize(newsegmentsize),
+			encoding(newencoding),
+			activesegment(0),
+			activesize(0),
+			activefirst(0),
+			discarded(0) {
+	if ((mkdir(directory.c_str(), 0755) < 0) && (errno != EEXIST)) {
+		throw SystemError("mkdir " + directory);
+	}
+
+	std::vector<uint32_t> segments = ListSegments(directory);
+	try {
+		for (size_t i = 0; i < segments.size(); i++) {
+			uint32_t segment = segments[i];
+			bool last = (i + 1 == segments.size());
+			std::string path = SegmentPath(directory, segment,
+					SEGMENT_EXTENSION);
+			int descriptor = open(path.c_str(),
+					(last == true) ? O_RDWR | O_CLOEXEC : O_RDONLY | O_CLOEXEC);
+			if (descriptor < 0) {
+				throw SystemError("open " + path);
+			}
+			descriptors[segment] = descriptor;
+
+			uint64_t size = FileSize(descriptor, path);
+			char *data = MapFile(descriptor, size, path);
+			size_t first = index.size();
+			bool current = false;
+			uint64_t end = LoadSegment(directory, segment, data, size, index,
+					current);
+			if (data != NULL) {
+				munmap(data, size);
+			}
+
+			// a sealed segment's rebuilt index is kept, the last one's is
+			// written as it grows, after cutting off a partly written record
+			if ((last == false) && (current == false)) {
+				WriteSidecar(directory, segment, index, first, index.size(),
+						end);
+			}
+			if ((last == true) && (end < size)) {
+				if (ftruncate(descriptor, static_cast<off_t>(end)) < 0) {
+					throw SystemError("ftruncate " + path);
+				}
+				discarded = size - end;
+			}
+			if (last == true) {
+				activesegment = segment;
+				activesize = end;
+				activefirst = first;
+			}
+		}
+		if (segments.empty() == true) {
+			opensegment(0);
+		}
+	} catch (...) {
+		for (std::map<uint32_t, int>::iterator it = descriptors.begin();
+				it != descriptors.end(); ++it) {
+			close(it->second);
+		}
+		throw;
+	}
+}
+
+messagelog::~messagelog() {
+	std::lock_guard<std::mutex> guard(mutex);
+	try {
+		writesidecar();
+	} catch (const std::exception &) {
+		// the index is rebuilt from the segment when the log is next opened
+	}
+	for (std::map<uint32_t, int>::iterator it = descriptors.begin();
+			it != descriptors.end(); ++it) {
+		close(it->second);
+	}
+}
+
+messagelogentry messagelog::append(const pick &message) {
+	return (appendobject(message, formattypes::picktype, message.id,
+			message.time));
+}
+
+messagelogentry messagelog::append(const correlation &message) {
+	return (appendobject(message, formattypes::correlationtype, message.id,
+			message.time));
+}
+
+messagelogentry messagelog::append(const detection &message) {
+	return (appendobject(message, formattypes::detectiontype, message.id,
+			message.hypocenter.time));
+}
+
+messagelogentry messagelog::append(const retract &message) {
+	return (appendobject(message, formattypes::retracttype, message.id,
+			std::numeric_limits<double>::quiet_NaN()));
+}
+
+messagelogentry messagelog::append(int type, const std::string &id,
+		double time, messagelogencoding messageencoding, const char *message,
+		size_t length) {
+	if ((type < formattypes::picktype)
+			|| (type > formattypes::stationinforequesttype)) {
+		throw std::invalid_argument("Invalid message type for message log.");
+	}
+	if ((id.length() > MAXIDLENGTH) || (length == 0)
+			|| (length > std::numeric_limits<uint32_t>::max())) {
+		throw std::invalid_argument("Invalid message for message log.");
+	}
+
+	messagelogentry entry;
+	entry.id = id;
+	entry.length = static_cast<uint32_t>(length);
+	entry.type = type;
+	entry.encoding = messageencoding;
+	entry.time = time;
+	uint16_t idlength = static_cast<uint16_t>(id.length());
+	uint64_t recordsize = static_cast<uint64_t>(RECORDHEADERSIZE) + idlength
+			+ length;
+
+	std::lock_guard<std::mutex> guard(mutex);
+
+	// a segment is sealed before it would pass its size, unless it is
+	// empty, so that a message larger than a segment still fits in one
+	if ((activesize > 0) && (activesize + recordsize > segmentsize)) {
+		writesidecar();
+		opensegment(activesegment + 1);
+	}
+
+	char header[RECORDHEADERSIZE];
+	unsigned char typebyte = static_cast<unsigned char>(type);
+	unsigned char encodingbyte = static_cast<unsigned char>(messageencoding);
+	std::memcpy(header, &entry.length, sizeof(entry.length));
+	std::memcpy(header + 8, &time, sizeof(time));
+	std::memcpy(header + 16, &idlength, sizeof(idlength));
+	std::memcpy(header + 18, &typebyte, 1);
+	std::memcpy(header + 19, &encodingbyte, 1);
+	record.assign(header, RECORDHEADERSIZE);
+	record.append(id);
+	record.append(message, length);
+	uint32_t checksum = static_cast<uint32_t>(HashBytes(
+			record.data() + RECORDCHECKED, record.size() - RECORDCHECKED));
+	std::memcpy(&record[4], &checksum, sizeof(checksum));
+
+	// a failed write leaves the size alone, so the next record overwrites
+	// whatever part of this one was written
+	if (WriteAll(descriptors[activesegment], record.data(), record.size(),
+			activesize) == false) {
+		throw SystemError(
+				"write " + SegmentPath(directory, activesegment,
+						SEGMENT_EXTENSION));
+	}
+
+	entry.segment = activesegment;
+	entry.offset = activesize + RECORDHEADERSIZE + idlength;
+	activesize += recordsize;
+	index.add(entry);
+	return (entry);
+}
+
+void messagelog::sync() {
+	std::lock_guard<std::mutex> guard(mutex);
+	writesidecar();
+}
+
+size_t messagelog::find(const std::string &id,
+		std::vector<messagelogentry> &results) const {
+	std::lock_guard<std::mutex> guard(mutex);
+	return (index.find(id, results));
+}
+
+size_t messagelog::within(double starttime, double endtime,
+		std::vector<messagelogentry> &results) const {
+	std::lock_guard<std::mutex> guard(mutex);
+	return (index.within(starttime, endtime, results));
+}
+
+bool messagelog::read(const messagelogentry &entry,
+		std::string &message) const {
+	// descriptors stay open for the log's lifetime, so the read itself
+	// needs no lock
+	int descriptor = -1;
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		std::map<uint32_t, int>::const_iterator found = descriptors.find(
+				entry.segment);
+		if (found == descriptors.end()) {
+			return (false);
+		}
+		descriptor = found->second;
+	}
+	message.resize(entry.length);
+	if ((entry.length > 0)
+			&& (ReadAll(descriptor, &message[0], entry.length, entry.offset)
+					== false)) {
+		message.clear();
+		return (false);
+	}
+	return (true);
+}
+
+size_t messagelog::size() const {
+	std::lock_guard<std::mutex> guard(mutex);
+	return (index.size());
+}
+
+size_t messagelog::getsegmentcount() const {
+	std::lock_guard<std::mutex> guard(mutex);
+	return (descriptors.size());
+}
+
+uint64_t messagelog::getdiscarded() const {
+	std::lock_guard<std::mutex> guard(mutex);
+	return (discarded);
+}
+
+void messagelog::opensegment(uint32_t segment) {
+	std::string path = SegmentPath(directory, segment, SEGMENT_EXTENSION);
+	int descriptor = open(path.c_str(),
+			O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (descriptor < 0) {
+		throw SystemError("open " + path);
+	}
+	descriptors[segment] = descriptor;
+	activesegment = segment;
+	activesize = 0;
+	activefirst = index.size();
+	SyncDirectory(directory);
+}
+
+void messagelog::writesidecar() {
+	// the sidecar's entries are trusted when the log is opened, so the
+	// records they point at must be on storage before it is
+	if (fdatasync(descriptors[activesegment]) < 0) {
+		throw SystemError("fdatasync " + directory);
+	}
+	WriteSidecar(directory, activesegment, index, activefirst, index.size(),
+			activesize);
+}
+
+template<class T>
+messagelogentry messagelog::appendobject(const T &object, int type,
+		const std::string &id, double time) {
+	std::string message;
+	if (encoding == binaryencoding) {
+		object.tobinary(message);
+	} else {
+		rapidjson::Document document;
+		message = ToJSONString(
+				object.tojson(document, document.GetAllocator()));
+	}
+	return (append(type, id, time, encoding, message.data(), message.size()));
+}
+
+messagelogreader::messagelogreader(const std::string &directory) {
+	std::vector<uint32_t> segments = ListSegments(directory);
+	try {
+		for (size_t i = 0; i < segments.size(); i++) {
+			uint32_t segment = segments[i];
+			std::string path = SegmentPath(directory, segment,
+					SEGMENT_EXTENSION);
+			int descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (descriptor < 0) {
+				throw SystemError("open " + path);
+			}
+			mapping segmentmapping;
+			segmentmapping.data = NULL;
+			segmentmapping.size = 0;
+			try {
+				segmentmapping.size = FileSize(descriptor, path);
+				segmentmapping.data = MapFile(descriptor, segmentmapping.size,
+						path);
+			} catch (...) {
+				close(descriptor);
+				throw;
+			}
+
+			// the mapping holds its own reference to the file
+			close(descriptor);
+			mappings[segment] = segmentmapping;
+
+			bool current = false;
+			LoadSegment(directory, segment, segmentmapping.data,
+					segmentmapping.size, index, current);
+
+			// lookups touch scattered messages, so read ahead is wasted
+			if (segmentmapping.data != NULL) {
+				madvise(segmentmapping.data, segmentmapping.size, MADV_RANDOM);
+			}
+		}
+	} catch (...) {
+		for (std::map<uint32_t, mapping>::iterator it = mappings.begin();
+				it != mappings.end(); ++it) {
+			if (it->second.data != NULL) {
+				munmap(it->second.data, it->second.size);
+			}
+		}
+		throw;
+	}
+}
+
+messagelogreader::~messagelogreader() {
+	for (std::map<uint32_t, mapping>::iterator it = mappings.begin();
+			it != mappings.end(); ++it) {
+		if (it->second.data != NULL) {
+			munmap(it->second.data, it->second.size);
+		}
+	}
+}
+
+size_t messagelogreader::find(const std::string &id,
+		std::vector<messagelogentry> &results) const {
+	return (index.find(id, results));
+}
+
+size_t messagelogreader::within(double starttime, double endtime,
+		std::vector<messagelogentry> &results) const {
+	return (index.within(starttime, endtime, results));
+}
+
+bool messagelogreader::get(const messagelogentry &entry, const char *&data,
+		size_t &length) const {
+	std::map<uint32_t, mapping>::const_iterator found = mappings.find(
+			entry.segment);
+	if ((found == mappings.end()) || (found->second.data == NULL)
+			|| (entry.offset > found->second.size)
+			|| (found->second.size - entry.offset < entry.length)) {
+		return (false);
+	}
+	data = found->second.data + entry.offset;
+	length = entry.length;
+	return (true);
+}
+
+size_t messagelogreader::size() const {
+	return (index.size());
+}
+}
+#endif
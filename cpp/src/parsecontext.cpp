@@ -0,0 +1,111 @@
+#include "parsecontext.h"
+
+#include <algorithm>
+
+// the parser's initial stack capacity
+#define STACKCAPACITY 1024
+
+// the size of the chunks a pool spills into when its buffer is full
+#define SPILLCHUNKSIZE (64 * 1024)
+
+namespace detectionformats {
+
+// gets the buffer size needed to hold what allocator spilled, or 0 if it
+// did not spill
+static size_t GrownSize(const rapidjson::MemoryPoolAllocator<> &allocator,
+		size_t buffersize) {
+	// a pool holding only its buffer has a capacity a header short of it
+	size_t capacity = allocator.Capacity();
+	if (capacity < buffersize) {
+		return (0);
+	}
+
+	size_t grown = buffersize;
+	while (grown <= capacity) {
+		grown *= 2;
+	}
+	return (grown);
+}
+
+parsecontext::parsecontext(size_t valuesize, size_t stacksize)
+		: valuebuffer(std::max(valuesize, static_cast<size_t>(1024))),
+			stackbuffer(std::max(stacksize, static_cast<size_t>(1024))),
+			writer(output) {
+	rebuild();
+}
+
+parsecontext::~parsecontext() {
+	// the document must go before the pools it points into
+	jsondocument.reset();
+}
+
+parsecontext::document & parsecontext::parse(const char *buffer,
+		size_t length) {
+	rebuild();
+
+	// a failed parse leaves the root alone, so empty it first
+	jsondocument->SetNull();
+	jsondocument->Parse(buffer, length);
+	return (*jsondocument);
+}
+
+parsecontext::document & parsecontext::reset() {
+	rebuild();
+	jsondocument->SetObject();
+	return (*jsondocument);
+}
+
+void parsecontext::serialize(detectionbase &object, std::string &json) {
+	document &serialized = reset();
+	object.tojson(serialized, serialized.GetAllocator());
+
+	output.Clear();
+	writer.Reset(output);
+	serialized.Accept(writer);
+	json.assign(output.GetString(), output.GetSize());
+}
+
+size_t parsecontext::capacity() const {
+	return (valuebuffer.size() + stackbuffer.size());
+}
+
+parsecontext & parsecontext::local() {
+	thread_local parsecontext context;
+	return (context);
+}
+
+void parsecontext::rebuild() {
+	if (jsondocument != NULL) {
+		size_t valuesize = GrownSize(*valueallocator, valuebuffer.size());
+		size_t stacksize = GrownSize(*stackallocator, stackbuffer.size());
+
+		if ((valuesize == 0) && (stacksize == 0)) {
+			// the usual case, reuse the buffers.  The parser stacks are
+			// emptied after each parse, and the document's root is
+			// overwritten before it is next read.
+			valueallocator->Clear();
+			stackallocator->Clear();
+			return;
+		}
+
+		// the last message spilled, enlarge the buffers to hold it.  The
+		// pools clear their buffers as they go, so go before them.
+		jsondocument.reset();
+		valueallocator.reset();
+		stackallocator.reset();
+		if (valuesize > 0) {
+			valuebuffer.assign(valuesize, 0);
+		}
+		if (stacksize > 0) {
+			stackbuffer.assign(stacksize, 0);
+		}
+	}
+
+	valueallocator.reset(new rapidjson::MemoryPoolAllocator<>(
+			valuebuffer.data(), valuebuffer.size(), SPILLCHUNKSIZE));
+	stackallocator.reset(new rapidjson::MemoryPoolAllocator<>(
+			stackbuffer.data(), stackbuffer.size(), SPILLCHUNKSIZE));
+	jsondocument.reset(new document(valueallocator.get(), STACKCAPACITY,
+			stackallocator.get()));
+}
+}
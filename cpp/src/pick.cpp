@@ -1,4 +1,5 @@
 #include "pick.h"
+#include "fields.h"
 
 #include <limits>
 
@@ -18,6 +19,27 @@
 #define ASSOCIATIONINFO_KEY "AssociationInfo"
 
 namespace detectionformats {
+// field descriptors, in the order the fields are written to json
+static constexpr auto fields = std::make_tuple(
+		detectionformats::stringfield(TYPE_KEY, &pick::type, true),
+		detectionformats::requiredfield(
+				detectionformats::stringfield(ID_KEY, &pick::id)),
+		detectionformats::requiredfield(
+				detectionformats::objectfield(SITE_KEY, &pick::site)),
+		detectionformats::requiredfield(
+				detectionformats::objectfield(SOURCE_KEY, &pick::source)),
+		detectionformats::requiredfield(
+				detectionformats::timefield(TIME_KEY, &pick::time)),
+		detectionformats::stringfield(PHASE_KEY, &pick::phase),
+		detectionformats::stringfield(POLARITY_KEY, &pick::polarity),
+		detectionformats::stringfield(ONSET_KEY, &pick::onset),
+		detectionformats::stringfield(PICKER_KEY, &pick::picker),
+		detectionformats::arrayfield(FILTER_KEY, &pick::filterdata),
+		detectionformats::optionalobjectfield(AMPLITUDE_KEY, &pick::amplitude),
+		detectionformats::optionalobjectfield(BEAM_KEY, &pick::beam),
+		detectionformats::optionalobjectfield(ASSOCIATIONINFO_KEY,
+				&pick::associationinfo));
+
 pick::pick() {
 	type = PICK_TYPE;
 	id = "";
@@ -158,120 +180,7 @@ pick::pick(std::string newid, detectionformats::site newsite, double newtime,
 }
 
 pick::pick(rapidjson::Value &json) {
-	// required values
-	// type
-	if ((json.HasMember(TYPE_KEY) == true)
-			&& (json[TYPE_KEY].IsString() == true))
-		type = std::string(json[TYPE_KEY].GetString(),
-				json[TYPE_KEY].GetStringLength());
-	else
-		type = "";
-
-	// id
-	if ((json.HasMember(ID_KEY) == true) && (json[ID_KEY].IsString() == true))
-		id = std::string(json[ID_KEY].GetString(),
-				json[ID_KEY].GetStringLength());
-	else
-		id = "";
-
-	// site
-	if ((json.HasMember(SITE_KEY) == true)
-			&& (json[SITE_KEY].IsObject() == true)) {
-		rapidjson::Value & sitevalue = json["Site"];
-		site = detectionformats::site(sitevalue);
-	} else
-		site = detectionformats::site();
-
-	// source
-	if ((json.HasMember(SOURCE_KEY) == true)
-			&& (json[SOURCE_KEY].IsObject() == true)) {
-		rapidjson::Value & sourcevalue = json[SOURCE_KEY];
-		source = detectionformats::source(sourcevalue);
-	} else
-		source = detectionformats::source();
-
-	// time
-	if ((json.HasMember(TIME_KEY) == true)
-			&& (json[TIME_KEY].IsString() == true))
-		time = detectionformats::ConvertISO8601ToEpochTime(
-				std::string(json[TIME_KEY].GetString(),
-						json[TIME_KEY].GetStringLength()));
-	else
-		time = std::numeric_limits<double>::quiet_NaN();
-
-	// optional values
-	// phase
-	if ((json.HasMember(PHASE_KEY) == true)
-			&& (json[PHASE_KEY].IsString() == true))
-		phase = std::string(json[PHASE_KEY].GetString(),
-				json[PHASE_KEY].GetStringLength());
-	else
-		phase = "";
-
-	// polarity
-	if ((json.HasMember(POLARITY_KEY) == true)
-			&& (json[POLARITY_KEY].IsString() == true))
-		polarity = std::string(json[POLARITY_KEY].GetString(),
-				json[POLARITY_KEY].GetStringLength());
-	else
-		polarity = "";
-
-	// onset
-	if ((json.HasMember(ONSET_KEY) == true)
-			&& (json[ONSET_KEY].IsString() == true))
-		onset = std::string(json[ONSET_KEY].GetString(),
-				json[ONSET_KEY].GetStringLength());
-	else
-		onset = "";
-
-	// picker
-	if ((json.HasMember(PICKER_KEY) == true)
-			&& (json[PICKER_KEY].IsString() == true))
-		picker = std::string(json[PICKER_KEY].GetString(),
-				json[PICKER_KEY].GetStringLength());
-	else
-		picker = "";
-
-	// filter
-	filterdata.clear();
-	if ((json.HasMember(FILTER_KEY) == true)
-			&& (json[FILTER_KEY].IsArray() == true)) {
-		rapidjson::Value dataarray;
-		dataarray = json[FILTER_KEY].GetArray();
-
-		for (rapidjson::SizeType i = 0; i < dataarray.Size(); i++) {
-			// parse
-			rapidjson::Value & datavalue = dataarray[i];
-			detectionformats::filter newfilter(datavalue);
-
-			// add to vector
-			filterdata.push_back(newfilter);
-		}
-	}
-
-	// amplitude
-	if ((json.HasMember(AMPLITUDE_KEY) == true)
-			&& (json[AMPLITUDE_KEY].IsObject() == true)) {
-		rapidjson::Value & amplitudevalue = json[AMPLITUDE_KEY];
-		amplitude = detectionformats::amplitude(amplitudevalue);
-	} else
-		amplitude = detectionformats::amplitude();
-
-	// beam
-	if ((json.HasMember(BEAM_KEY) == true)
-			&& (json[BEAM_KEY].IsObject() == true)) {
-		rapidjson::Value & beamvalue = json[BEAM_KEY];
-		beam = detectionformats::beam(beamvalue);
-	} else
-		beam = detectionformats::beam();
-
-	// associated
-	if ((json.HasMember(ASSOCIATIONINFO_KEY) == true)
-			&& (json[ASSOCIATIONINFO_KEY].IsObject() == true)) {
-		rapidjson::Value & associatedvalue = json[ASSOCIATIONINFO_KEY];
-		associationinfo = detectionformats::associated(associatedvalue);
-	} else
-		associationinfo = detectionformats::associated();
+	resetfrom(json);
 }
 
 pick::pick(const pick &newpick) {
@@ -300,114 +209,57 @@ pick::pick(const pick &newpick) {
 pick::~pick() {
 }
 
-rapidjson::Value & pick::tojson(rapidjson::Value &json,
-		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) {
-	json.SetObject();
-
-	// required values
-	// type
-	rapidjson::Value typevalue;
-	typevalue.SetString(rapidjson::StringRef(type.c_str()), allocator);
-	json.AddMember(TYPE_KEY, typevalue, allocator);
-
-	// id
-	if (id != "") {
-		rapidjson::Value idvalue;
-		idvalue.SetString(rapidjson::StringRef(id.c_str()), allocator);
-		json.AddMember(ID_KEY, idvalue, allocator);
-	}
-
-	// site
-	rapidjson::Value sitevalue(rapidjson::kObjectType);
-	site.tojson(sitevalue, allocator);
-	json.AddMember(SITE_KEY, sitevalue, allocator);
-
-	// source
-	rapidjson::Value sourcevalue(rapidjson::kObjectType);
-	source.tojson(sourcevalue, allocator);
-	json.AddMember(SOURCE_KEY, sourcevalue, allocator);
-
-	// time
-	if (std::isnan(time) != true) {
-		std::string timestring = detectionformats::ConvertEpochTimeToISO8601(
-				time);
-		rapidjson::Value timevalue;
-		timevalue.SetString(rapidjson::StringRef(timestring.c_str()),
-				allocator);
-		json.AddMember(TIME_KEY, timevalue, allocator);
-	}
-
-	// optional values
-	// phase
-	if (phase != "") {
-		rapidjson::Value phasevalue;
-		phasevalue.SetString(rapidjson::StringRef(phase.c_str()), allocator);
-		json.AddMember(PHASE_KEY, phasevalue, allocator);
-	}
-
-	// polarity
-	if (polarity != "") {
-		rapidjson::Value polarityvalue;
-		polarityvalue.SetString(rapidjson::StringRef(polarity.c_str()),
-				allocator);
-		json.AddMember(POLARITY_KEY, polarityvalue, allocator);
-	}
-
-	// onset
-	if (onset != "") {
-		rapidjson::Value onsetvalue;
-		onsetvalue.SetString(rapidjson::StringRef(onset.c_str()), allocator);
-		json.AddMember(ONSET_KEY, onsetvalue, allocator);
-	}
+void pick::resetfrom(rapidjson::Value &json) {
+	clear();
+	type.clear();
 
-	// picker
-	if (picker != "") {
-		rapidjson::Value pickervalue;
-		pickervalue.SetString(rapidjson::StringRef(picker.c_str()), allocator);
-		json.AddMember(PICKER_KEY, pickervalue, allocator);
-	}
+	detectionformats::ParseFields(*this, json, fields);
+}
 
-	// filter
-	if (filterdata.size() > 0) {
-		// build json array
-		rapidjson::Value dataarray(rapidjson::kArrayType);
+void pick::resetfrom(const char *jsonbuffer, size_t length,
+		rapidjson::Document &jsondocument) {
+	resetfrom(detectionformats::FromJSONString(jsonbuffer, length,
+			jsondocument));
+}
 
-		for (int i = 0; i < (int) filterdata.size(); i++) {
-			rapidjson::Value filtervalue(rapidjson::kObjectType);
-			filterdata[i].tojson(filtervalue, allocator);
-			dataarray.PushBack(filtervalue, allocator);
-		}
+void pick::clear() {
+	type = PICK_TYPE;
+	id.clear();
+	site.clear();
+	time = std::numeric_limits<double>::quiet_NaN();
+	source.clear();
+	phase.clear();
+	polarity.clear();
+	onset.clear();
+	picker.clear();
+	filterdata.clear();
+	amplitude.clear();
+	beam.clear();
+	associationinfo.clear();
+}
 
-		if (dataarray.Size() > 0) {
-			json.AddMember(FILTER_KEY, dataarray, allocator);
-		}
-	}
+rapidjson::Value & pick::tojson(rapidjson::Value &json,
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+	return (detectionformats::WriteFields(*this, json, allocator, fields));
+}
 
-	// amplitude
-	if (pick::amplitude.isempty() == false) {
-		rapidjson::Value amplitudevalue(rapidjson::kObjectType);
-		amplitude.tojson(amplitudevalue, allocator);
-		json.AddMember(AMPLITUDE_KEY, amplitudevalue, allocator);
-	}
+void pick::tobinary(std::string &buffer) const {
+	detectionformats::EncodeFields(*this, buffer, fields);
+}
 
-	// beam
-	if (pick::beam.isempty() == false) {
-		rapidjson::Value beamvalue(rapidjson::kObjectType);
-		amplitude.tojson(beamvalue, allocator);
-		json.AddMember(BEAM_KEY, beamvalue, allocator);
-	}
+size_t pick::frombinary(const char *buffer, size_t length) {
+	return (detectionformats::DecodeFields(*this, buffer, length, fields));
+}
 
-	// associated
-	if (associationinfo.isempty() == false) {
-		rapidjson::Value associatedvalue(rapidjson::kObjectType);
-		associationinfo.tojson(associatedvalue, allocator);
-		json.AddMember(ASSOCIATIONINFO_KEY, associatedvalue, allocator);
-	}
+bool pick::operator==(const pick &other) const {
+	return (detectionformats::EqualFields(*this, other, fields));
+}
 
-	return (json);
+bool pick::operator!=(const pick &other) const {
+	return (!(*this == other));
 }
 
-std::vector<std::string> pick::geterrors() {
+std::vector<std::string> pick::geterrors() const {
 	std::vector<std::string> errorlist;
 
 	// check for requried data
@@ -417,28 +269,11 @@ std::vector<std::string> pick::geterrors() {
 		errorlist.push_back("Non-pick type in pick class.");
 	}
 
-	// id
-	if (id == "") {
-		// empty id
-		errorlist.push_back("Empty ID in pick class.");
-	}
-
-	// site
-	if (site.isvalid() != true) {
-		// site not found
-		errorlist.push_back("Site object did not validate in pick class.");
-	}
-
-	// source
-	if (source.isvalid() != true) {
-		// bad source
-		errorlist.push_back("Source object did not validate in pick class.");
-	}
+	// id, site, source, and time
+	detectionformats::CheckRequiredFields(*this, "pick", fields, errorlist);
 
 	// time
-	if (std::isnan(time) == true) {
-		errorlist.push_back("Time is missing in pick class.");
-	} else {
+	if (std::isnan(time) != true) {
 		try {
 			if (detectionformats::IsStringISO8601(
 					detectionformats::ConvertEpochTimeToISO8601(time))
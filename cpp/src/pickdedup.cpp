@@ -0,0 +1,254 @@
+#include "pickdedup.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+// the initial table slots, a power of two
+#define INITIALSLOTS 1024
+
+// the number of picks in a row, each more than a period outside the
+// generations, that it takes to move the generations to them
+#define OUTLIERPICKS 16
+
+namespace detectionformats {
+
+// hashes a buffer eight bytes at a time, for the encoded picks, which are
+// long enough that byte at a time FNV-1a dominates a check
+static uint64_t HashWords(const char *buffer, size_t length) {
+	uint64_t hash = FNV64OFFSETBASIS;
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+		uint64_t word;
+		std::memcpy(&word, buffer + i, sizeof(word));
+		hash = (hash ^ word) * FNV64PRIME;
+		hash ^= hash >> 32;
+	}
+	return (HashBytes(buffer + i, length - i, hash));
+}
+
+// adds a string and a separator to a 64 bit FNV-1a hash
+static uint64_t HashString(const std::string &field, uint64_t hash) {
+	hash = HashBytes(field, hash);
+	const char separator = '.';
+	return (HashBytes(&separator, 1, hash));
+}
+
+// spreads the bits of a combined hash, the splitmix64 finalizer, and keeps
+// it off 0, which marks an empty slot
+static uint64_t FinishHash(uint64_t hash) {
+	hash ^= hash >> 30;
+	hash *= 0xBF58476D1CE4E5B9ULL;
+	hash ^= hash >> 27;
+	hash *= 0x94D049BB133111EBULL;
+	hash ^= hash >> 31;
+	return ((hash == 0) ? 1 : hash);
+}
+
+// hashes the time bucket of an arrival
+static uint64_t HashBucket(uint64_t arrival, int64_t bucket) {
+	return (FinishHash(arrival ^ (static_cast<uint64_t>(bucket)
+			* 0x9E3779B97F4A7C15ULL)));
+}
+
+pickdedup::table::table()
+		: hashes(INITIALSLOTS, 0),
+			values(INITIALSLOTS, 0),
+			count(0) {
+}
+
+bool pickdedup::table::find(uint64_t hash, uint64_t &value) const {
+	size_t mask = hashes.size() - 1;
+	for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+		if (hashes[slot] == hash) {
+			value = values[slot];
+			return (true);
+		}
+		if (hashes[slot] == 0) {
+			return (false);
+		}
+	}
+}
+
+void pickdedup::table::set(uint64_t hash, uint64_t value) {
+	// kept at most half full so probes stay short
+	if ((count + 1) * 2 > hashes.size()) {
+		std::vector<uint64_t> oldhashes(hashes.size() * 2, 0);
+		std::vector<uint64_t> oldvalues(values.size() * 2, 0);
+		oldhashes.swap(hashes);
+		oldvalues.swap(values);
+
+		size_t mask = hashes.size() - 1;
+		for (size_t i = 0; i < oldhashes.size(); i++) {
+			if (oldhashes[i] == 0) {
+				continue;
+			}
+			size_t slot = oldhashes[i] & mask;
+			while (hashes[slot] != 0) {
+				slot = (slot + 1) & mask;
+			}
+			hashes[slot] = oldhashes[i];
+			values[slot] = oldvalues[i];
+		}
+	}
+
+	size_t mask = hashes.size() - 1;
+	size_t slot = hash & mask;
+	while ((hashes[slot] != 0) && (hashes[slot] != hash)) {
+		slot = (slot + 1) & mask;
+	}
+	if (hashes[slot] == 0) {
+		hashes[slot] = hash;
+		count++;
+	}
+	values[slot] = value;
+}
+
+void pickdedup::table::clear() {
+	if (count > 0) {
+		std::memset(&hashes[0], 0, hashes.size() * sizeof(uint64_t));
+		count = 0;
+	}
+}
+
+pickdedup::pickdedup(double newexpiry, double newtolerance)
+		: expiry(newexpiry),
+			tolerance(newtolerance),
+			generationstart(std::numeric_limits<double>::quiet_NaN()),
+			outlierpicks(0) {
+}
+
+pickdedupstatus pickdedup::check(const pick &newpick) {
+	metrics.picks++;
+
+	double time = newpick.time;
+	bool timed = (std::isnan(time) == false);
+	if (timed == true) {
+		rotate(time);
+	}
+
+	uint64_t idhash = FinishHash(HashBytes(newpick.id));
+	buffer.clear();
+	newpick.tobinary(buffer);
+	uint64_t content = HashWords(buffer.data(), buffer.length());
+
+	// the site and phase, hashed as
+	// "station.channel.network.location.phase."
+	uint64_t arrival = FNV64OFFSETBASIS;
+	arrival = HashString(newpick.site.station, arrival);
+	arrival = HashString(newpick.site.channel, arrival);
+	arrival = HashString(newpick.site.network, arrival);
+	arrival = HashString(newpick.site.location, arrival);
+	arrival = HashString(newpick.phase, arrival);
+	bool bucketed = ((timed == true) && (tolerance > 0));
+
+	// the id is refreshed into the current generation however it is
+	// classified, so a pick relayed steadily is not forgotten
+	uint64_t seen = 0;
+	if ((ids[0].find(idhash, seen) == true)
+			|| (ids[1].find(idhash, seen) == true)) {
+		ids[0].set(idhash, content);
+		if (seen == content) {
+			metrics.duplicates++;
+			return (duplicatepick);
+		}
+		if (bucketed == true) {
+			remember(arrival, time);
+		}
+		metrics.updates++;
+		return (updatedpick);
+	}
+
+	ids[0].set(idhash, content);
+	if (bucketed == true) {
+		if (isrepick(arrival, time) == true) {
+			metrics.repicks++;
+			return (duplicatepick);
+		}
+		remember(arrival, time);
+	}
+	metrics.unique++;
+	return (uniquepick);
+}
+
+void pickdedup::clear() {
+	for (int i = 0; i < 2; i++) {
+		ids[i].clear();
+		arrivals[i].clear();
+	}
+	generationstart = std::numeric_limits<double>::quiet_NaN();
+	outlierpicks = 0;
+}
+
+size_t pickdedup::size() const {
+	return (ids[0].count + ids[1].count);
+}
+
+pickdedupmetrics pickdedup::getmetrics() const {
+	return (metrics);
+}
+
+bool pickdedup::isrepick(uint64_t arrival, double time) const {
+	// the bucket width is the tolerance, so a pick within it of time is in
+	// time's bucket or one of its neighbors
+	int64_t bucket = static_cast<int64_t>(std::floor(time / tolerance));
+	for (int64_t b = bucket - 1; b <= bucket + 1; b++) {
+		uint64_t hash = HashBucket(arrival, b);
+		for (int g = 0; g < 2; g++) {
+			uint64_t bits;
+			if (arrivals[g].find(hash, bits) == false) {
+				continue;
+			}
+			double seen;
+			std::memcpy(&seen, &bits, sizeof(seen));
+			if (std::fabs(seen - time) <= tolerance) {
+				return (true);
+			}
+		}
+	}
+	return (false);
+}
+
+void pickdedup::remember(uint64_t arrival, double time) {
+	uint64_t bits;
+	std::memcpy(&bits, &time, sizeof(bits));
+	int64_t bucket = static_cast<int64_t>(std::floor(time / tolerance));
+	arrivals[0].set(HashBucket(arrival, bucket), bits);
+}
+
+void pickdedup::rotate(double time) {
+	if (std::isnan(generationstart) == true) {
+		generationstart = time;
+		return;
+	}
+
+	// one pick with a bad time, far ahead or behind, must not move the
+	// generations to where the picks that follow never move them again
+	bool outlier = (time > generationstart + 2 * expiry)
+			|| (time < generationstart - 2 * expiry);
+	if (outlier == false) {
+		outlierpicks = 0;
+		if (time < generationstart + expiry) {
+			return;
+		}
+	} else if (++outlierpicks < OUTLIERPICKS) {
+		metrics.outliers++;
+		return;
+	} else {
+		outlierpicks = 0;
+	}
+
+	// the older generation is dropped and its storage reused for the new
+	// one, and if the time has jumped past both the current is dropped too
+	if ((outlier == true) || (time >= generationstart + 2 * expiry)) {
+		ids[0].clear();
+		arrivals[0].clear();
+	}
+	std::swap(ids[0], ids[1]);
+	std::swap(arrivals[0], arrivals[1]);
+	ids[0].clear();
+	arrivals[0].clear();
+	generationstart = time;
+}
+}
@@ -0,0 +1,325 @@
+#include "pickwindow.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+// the picks in a chunk, a few pages of times so a shift stays in cache
+#define CHUNKSIZE 256
+
+// the evicted chunks kept for reuse
+#define SPARECHUNKS 64
+
+// the site ID matching any site
+#define ANYSITE 0xFFFFFFFFu
+
+// the number of picks in a row, each more than a duration after the newest
+// time seen, that it takes to accept them
+#define OUTLIERPICKS 16
+
+// the fewest interned sites pruned, so a small window does not prune on
+// every new site
+#define MINSITES 1024
+
+namespace detectionformats {
+
+// builds the site key "station.channel.network.location" into key, reusing
+// its storage
+static void MakeKey(const site &picksite, std::string &key) {
+	key.assign(picksite.station);
+	key += '.';
+	key += picksite.channel;
+	key += '.';
+	key += picksite.network;
+	key += '.';
+	key += picksite.location;
+}
+
+pickwindow::chunk::chunk()
+		: begin(0),
+			end(0),
+			times(CHUNKSIZE),
+			sites(CHUNKSIZE),
+			picks(CHUNKSIZE) {
+	for (size_t i = 0; i < CHUNKSIZE; i++) {
+		picks[i].reset(new pick());
+	}
+}
+
+pickwindow::pickwindow(double newduration)
+		: duration(newduration),
+			horizon(-std::numeric_limits<double>::infinity()),
+			latest(std::numeric_limits<double>::quiet_NaN()),
+			outlierpicks(0),
+			count(0) {
+}
+
+bool pickwindow::add(const pick &newpick) {
+	double time = newpick.time;
+	if ((std::isnan(time) == true) || (time < horizon)) {
+		return (false);
+	}
+
+	// one pick with a bad time far ahead must not evict the window and
+	// refuse every pick after it
+	if (time > latest + duration) {
+		if (++outlierpicks < OUTLIERPICKS) {
+			return (false);
+		}
+	}
+	outlierpicks = 0;
+	if ((std::isnan(latest) == true) || (time > latest)) {
+		latest = time;
+	}
+	if (time - duration > horizon) {
+		evict(time - duration);
+	}
+
+	MakeKey(newpick.site, keybuffer);
+	std::unordered_map<std::string, uint32_t>::iterator found = siteids.find(
+			keybuffer);
+	if (found == siteids.end()) {
+		// the sites of evicted picks are forgotten once they are most of
+		// those interned
+		if (siteids.size() >= std::max(static_cast<size_t>(MINSITES),
+				2 * count)) {
+			prunesites();
+		}
+		found = siteids.insert(
+				std::make_pair(keybuffer, static_cast<uint32_t>(siteids.size())))
+				.first;
+	}
+	uint32_t siteid = found->second;
+
+	// in order, the common case, appends to the last chunk
+	if ((chunks.empty() == true)
+			|| (time >= chunks.back()->times[chunks.back()->end - 1])) {
+		if ((chunks.empty() == true) || (chunks.back()->end == CHUNKSIZE)) {
+			chunks.push_back(allocate());
+		}
+		insert(chunks.back().get(), chunks.back()->end, newpick, siteid);
+		count++;
+		return (true);
+	}
+
+	// out of order, goes after any picks with the same time in the first
+	// chunk whose last pick is later
+	std::deque<std::unique_ptr<chunk>>::iterator position = std::upper_bound(
+			chunks.begin(), chunks.end(), time,
+			[](double value, const std::unique_ptr<chunk> &target) {
+				return (value < target->times[target->end - 1]);
+			});
+	chunk *target = position->get();
+	size_t slot = std::upper_bound(target->times.begin() + target->begin,
+			target->times.begin() + target->end, time)
+			- target->times.begin();
+
+	// a full chunk is split in half, the pick going into whichever half
+	// holds its slot
+	if ((target->end - target->begin) == CHUNKSIZE) {
+		std::unique_ptr<chunk> upper = allocate();
+		size_t middle = CHUNKSIZE / 2;
+		for (size_t i = middle; i < CHUNKSIZE; i++) {
+			upper->times[i - middle] = target->times[i];
+			upper->sites[i - middle] = target->sites[i];
+			std::swap(upper->picks[i - middle], target->picks[i]);
+		}
+		upper->end = CHUNKSIZE - middle;
+		target->end = middle;
+		position = chunks.insert(position + 1, std::move(upper));
+		if (slot > middle) {
+			target = position->get();
+			slot -= middle;
+		}
+	}
+
+	insert(target, slot, newpick, siteid);
+	count++;
+	return (true);
+}
+
+size_t pickwindow::expire(double now) {
+	if ((std::isnan(latest) == true) || (now > latest)) {
+		latest = now;
+	}
+	if (now - duration <= horizon) {
+		return (0);
+	}
+	return (evict(now - duration));
+}
+
+size_t pickwindow::query(double starttime, double endtime,
+		std::vector<const pick *> &results) const {
+	return (collect(starttime, endtime, ANYSITE, results));
+}
+
+size_t pickwindow::query(double starttime, double endtime,
+		const site &picksite, std::vector<const pick *> &results) const {
+	std::string key;
+	MakeKey(picksite, key);
+	std::unordered_map<std::string, uint32_t>::const_iterator found =
+			siteids.find(key);
+	if (found == siteids.end()) {
+		return (0);
+	}
+	return (collect(starttime, endtime, found->second, results));
+}
+
+void pickwindow::clear() {
+	while (chunks.empty() == false) {
+		std::unique_ptr<chunk> target = std::move(chunks.front());
+		chunks.pop_front();
+		target->begin = 0;
+		target->end = 0;
+		if (spares.size() < SPARECHUNKS) {
+			spares.push_back(std::move(target));
+		}
+	}
+	siteids.clear();
+	horizon = -std::numeric_limits<double>::infinity();
+	latest = std::numeric_limits<double>::quiet_NaN();
+	outlierpicks = 0;
+	count = 0;
+}
+
+size_t pickwindow::size() const {
+	return (count);
+}
+
+double pickwindow::getduration() const {
+	return (duration);
+}
+
+double pickwindow::getoldest() const {
+	if (chunks.empty() == true) {
+		return (std::numeric_limits<double>::quiet_NaN());
+	}
+	return (chunks.front()->times[chunks.front()->begin]);
+}
+
+double pickwindow::getnewest() const {
+	if (chunks.empty() == true) {
+		return (std::numeric_limits<double>::quiet_NaN());
+	}
+	return (chunks.back()->times[chunks.back()->end - 1]);
+}
+
+void pickwindow::insert(chunk *target, size_t position, const pick &newpick,
+		uint32_t siteid) {
+	// a chunk that was evicted from the front has its free slots there,
+	// move its picks down first
+	if (target->end == CHUNKSIZE) {
+		size_t shift = target->begin;
+		for (size_t i = target->begin; i < target->end; i++) {
+			target->times[i - shift] = target->times[i];
+			target->sites[i - shift] = target->sites[i];
+			std::swap(target->picks[i - shift], target->picks[i]);
+		}
+		target->begin = 0;
+		target->end -= shift;
+		position -= shift;
+	}
+
+	if (position < target->end) {
+		size_t moved = target->end - position;
+		std::memmove(&target->times[position + 1], &target->times[position],
+				moved * sizeof(double));
+		std::memmove(&target->sites[position + 1], &target->sites[position],
+				moved * sizeof(uint32_t));
+
+		// the unused pick past the end moves to position, for the
+		// assignment below to reuse
+		std::rotate(target->picks.begin() + position,
+				target->picks.begin() + target->end,
+				target->picks.begin() + target->end + 1);
+	}
+
+	target->times[position] = newpick.time;
+	target->sites[position] = siteid;
+	*target->picks[position] = newpick;
+	target->end++;
+}
+
+size_t pickwindow::evict(double cutoff) {
+	horizon = cutoff;
+
+	size_t evicted = 0;
+	while (chunks.empty() == false) {
+		chunk *target = chunks.front().get();
+		if (target->times[target->end - 1] >= cutoff) {
+			// the chunk is kept, drop its old picks from the front
+			while (target->times[target->begin] < cutoff) {
+				target->begin++;
+				evicted++;
+			}
+			break;
+		}
+
+		// the whole chunk is old
+		evicted += target->end - target->begin;
+		target->begin = 0;
+		target->end = 0;
+		if (spares.size() < SPARECHUNKS) {
+			spares.push_back(std::move(chunks.front()));
+		}
+		chunks.pop_front();
+	}
+
+	count -= evicted;
+	return (evicted);
+}
+
+void pickwindow::prunesites() {
+	std::unordered_map<std::string, uint32_t> kept;
+	std::string key;
+	for (size_t c = 0; c < chunks.size(); c++) {
+		chunk *target = chunks[c].get();
+		for (size_t i = target->begin; i < target->end; i++) {
+			MakeKey(target->picks[i]->site, key);
+			target->sites[i] = kept.insert(
+					std::make_pair(key, static_cast<uint32_t>(kept.size())))
+					.first->second;
+		}
+	}
+	siteids.swap(kept);
+}
+
+std::unique_ptr<pickwindow::chunk> pickwindow::allocate() {
+	if (spares.empty() == true) {
+		return (std::unique_ptr<chunk>(new chunk()));
+	}
+	std::unique_ptr<chunk> target = std::move(spares.back());
+	spares.pop_back();
+	return (target);
+}
+
+size_t pickwindow::collect(double starttime, double endtime, uint32_t siteid,
+		std::vector<const pick *> &results) const {
+	// the first chunk whose last pick is at or after starttime
+	std::deque<std::unique_ptr<chunk>>::const_iterator position =
+			std::lower_bound(chunks.begin(), chunks.end(), starttime,
+					[](const std::unique_ptr<chunk> &target, double value) {
+						return (target->times[target->end - 1] < value);
+					});
+
+	size_t found = 0;
+	for (; position != chunks.end(); ++position) {
+		const chunk *target = position->get();
+		size_t i = std::lower_bound(target->times.begin() + target->begin,
+				target->times.begin() + target->end, starttime)
+				- target->times.begin();
+		for (; i < target->end; i++) {
+			if (target->times[i] > endtime) {
+				return (found);
+			}
+			if ((siteid == ANYSITE) || (target->sites[i] == siteid)) {
+				results.push_back(target->picks[i].get());
+				found++;
+			}
+		}
+	}
+	return (found);
+}
+}
@@ -0,0 +1,209 @@
+#include "pipeline.h"
+
+#include <algorithm>
+
+namespace detectionformats {
+
+// records depth as the stage's maximum depth if it is the largest seen
+static void UpdateMaxDepth(pipeline::stagecounters &counters, size_t depth) {
+	size_t maxdepth = counters.maxdepth.load(std::memory_order_relaxed);
+	while ((depth > maxdepth)
+			&& (counters.maxdepth.compare_exchange_weak(maxdepth, depth,
+					std::memory_order_relaxed) == false)) {
+	}
+}
+
+// moves message onto queue, waiting while the queue is full unless the
+// pipeline is aborting, in which case the message is discarded
+template<class Queue>
+static void PushWaiting(Queue &queue, pipeline::handle &message,
+		pipeline::stagecounters &counters, const std::atomic<bool> &aborting) {
+	backoff wait;
+	while (queue.trypush(std::move(message)) == false) {
+		if (aborting.load(std::memory_order_relaxed) == true) {
+			message.reset();
+			return;
+		}
+		wait.pause();
+	}
+	UpdateMaxDepth(counters, queue.size());
+}
+
+// runs one stage thread, taking messages from input, processing them, and
+// passing them on to output until upstreamdone is set and input is empty
+template<class InputQueue, class OutputQueue, class Function>
+static void RunStage(InputQueue &input, OutputQueue &output,
+		const std::atomic<bool> &upstreamdone,
+		pipeline::stagecounters &counters,
+		pipeline::stagecounters &outputcounters,
+		const std::atomic<bool> &aborting, Function process) {
+	backoff wait;
+	pipeline::handle message;
+	while (true) {
+		// read done before trying the queue, if upstream was already done
+		// and the queue is empty nothing more can arrive
+		bool done = upstreamdone.load(std::memory_order_acquire);
+
+		if (input.trypop(message) == true) {
+			wait.reset();
+			process(*message);
+			counters.processed.fetch_add(1, std::memory_order_relaxed);
+			PushWaiting(output, message, outputcounters, aborting);
+			continue;
+		}
+
+		if (done == true) {
+			return;
+		}
+		wait.pause();
+	}
+}
+
+pipeline::pipeline(size_t queuecapacity, size_t parsethreads,
+		size_t validatethreads)
+		: rawqueue(queuecapacity),
+			parsedqueue(queuecapacity),
+			validatedqueue(queuecapacity),
+			outputqueue(queuecapacity),
+			nextsequence(0),
+			pushing(0),
+			closed(false),
+			inputdone(false),
+			parsedone(false),
+			validatedone(false),
+			serializedone(false),
+			aborting(false),
+			parsersrunning(std::max(static_cast<size_t>(1), parsethreads)),
+			validatorsrunning(
+					std::max(static_cast<size_t>(1), validatethreads)) {
+	for (size_t i = 0; i < parsersrunning.load(); i++) {
+		threads.push_back(std::thread(&pipeline::parsestage, this));
+	}
+	for (size_t i = 0; i < validatorsrunning.load(); i++) {
+		threads.push_back(std::thread(&pipeline::validatestage, this));
+	}
+	threads.push_back(std::thread(&pipeline::serializestage, this));
+}
+
+pipeline::~pipeline() {
+	// nobody will pop any more, so stages must not wait on full queues,
+	// including a push blocked on a full parse queue that close() waits for
+	aborting.store(true);
+	close();
+
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+}
+
+bool pipeline::push(std::string message) {
+	// count this push before checking closed, so that close() can wait for
+	// it to land before telling the parse stage no more input is coming
+	pushing.fetch_add(1);
+	if (closed.load() == true) {
+		pushing.fetch_sub(1);
+		return (false);
+	}
+
+	handle pushed(new pipelinemessage());
+	pushed->sequence = nextsequence.fetch_add(1, std::memory_order_relaxed);
+	pushed->received = std::chrono::steady_clock::now();
+	pushed->raw = std::move(message);
+
+	PushWaiting(rawqueue, pushed, parsecounters, aborting);
+
+	pushing.fetch_sub(1);
+	return (true);
+}
+
+bool pipeline::pop(handle &message) {
+	backoff wait;
+	while (true) {
+		bool done = serializedone.load(std::memory_order_acquire);
+
+		if (outputqueue.trypop(message) == true) {
+			outputcounters.processed.fetch_add(1, std::memory_order_relaxed);
+			return (true);
+		}
+
+		if (done == true) {
+			return (false);
+		}
+		wait.pause();
+	}
+}
+
+void pipeline::close() {
+	if (closed.exchange(true) == true) {
+		return;
+	}
+
+	// wait for any push that got in before the close to finish
+	while (pushing.load() > 0) {
+		std::this_thread::yield();
+	}
+	inputdone.store(true, std::memory_order_release);
+}
+
+pipelinemetrics pipeline::getmetrics() const {
+	pipelinemetrics metrics;
+
+	metrics.parse.depth = rawqueue.size();
+	metrics.parse.maxdepth = parsecounters.maxdepth.load();
+	metrics.parse.processed = parsecounters.processed.load();
+
+	metrics.validate.depth = parsedqueue.size();
+	metrics.validate.maxdepth = validatecounters.maxdepth.load();
+	metrics.validate.processed = validatecounters.processed.load();
+
+	metrics.serialize.depth = validatedqueue.size();
+	metrics.serialize.maxdepth = serializecounters.maxdepth.load();
+	metrics.serialize.processed = serializecounters.processed.load();
+
+	metrics.output.depth = outputqueue.size();
+	metrics.output.maxdepth = outputcounters.maxdepth.load();
+	metrics.output.processed = outputcounters.processed.load();
+
+	return (metrics);
+}
+
+void pipeline::parsestage() {
+	parsecontext &context = parsecontext::local();
+	RunStage(rawqueue, parsedqueue, inputdone, parsecounters,
+			validatecounters, aborting,
+			[&context](pipelinemessage &message) {
+				ParseMessage(message.raw.c_str(), message.raw.length(),
+						context, message.result);
+			});
+
+	if (parsersrunning.fetch_sub(1) == 1) {
+		parsedone.store(true, std::memory_order_release);
+	}
+}
+
+void pipeline::validatestage() {
+	RunStage(parsedqueue, validatedqueue, parsedone, validatecounters,
+			serializecounters, aborting, [](pipelinemessage &message) {
+				message.valid = (message.result.isparsed() == true)
+						&& (message.result.object->isvalid() == true);
+			});
+
+	if (validatorsrunning.fetch_sub(1) == 1) {
+		validatedone.store(true, std::memory_order_release);
+	}
+}
+
+void pipeline::serializestage() {
+	parsecontext &context = parsecontext::local();
+	RunStage(validatedqueue, outputqueue, validatedone, serializecounters,
+			outputcounters, aborting, [&context](pipelinemessage &message) {
+				if (message.result.isparsed() == false) {
+					return;
+				}
+
+				context.serialize(*message.result.object, message.json);
+			});
+
+	serializedone.store(true, std::memory_order_release);
+}
+}
@@ -1,4 +1,5 @@
 #include "retract.h"
+#include "fields.h"
 
 // JSON Keys
 #define TYPE_KEY "Type"
@@ -7,6 +8,15 @@
 
 namespace detectionformats
 {
+	// field descriptors, in the order the fields are written to json
+	static constexpr auto fields = std::make_tuple(
+			detectionformats::stringfield(TYPE_KEY, &retract::type, true),
+			detectionformats::requiredfield(
+					detectionformats::stringfield(ID_KEY, &retract::id)),
+			detectionformats::requiredfield(
+					detectionformats::objectfield(SOURCE_KEY,
+							&retract::source)));
+
 	retract::retract()
 	{
 		type = RETRACT_TYPE;
@@ -30,27 +40,7 @@ namespace detectionformats
 
 	retract::retract(rapidjson::Value &json)
 	{
-		// required values
-		// type
-		if ((json.HasMember(TYPE_KEY) == true) && (json[TYPE_KEY].IsString() == true))
-			type = std::string(json[TYPE_KEY].GetString(), json[TYPE_KEY].GetStringLength());
-		else
-			type = "";
-
-		// id
-		if ((json.HasMember(ID_KEY) == true) && (json[ID_KEY].IsString() == true))
-			id = std::string(json[ID_KEY].GetString(), json[ID_KEY].GetStringLength());
-		else
-			id = "";
-
-		// source
-		if ((json.HasMember(SOURCE_KEY) == true) && (json[SOURCE_KEY].IsObject() == true))
-		{
-			rapidjson::Value & sourcevalue = json[SOURCE_KEY];
-			source = detectionformats::source(sourcevalue);
-		}
-		else
-			source = detectionformats::source();
+		resetfrom(json);
 	}
 
 	retract::retract(const retract & newretract)
@@ -65,33 +55,47 @@ namespace detectionformats
 	{
 	}
 
-	rapidjson::Value & retract::tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator)
+	void retract::resetfrom(rapidjson::Value &json)
 	{
-		json.SetObject();
+		clear();
+		type.clear();
 
-		// required values
-		// type
-		rapidjson::Value typevalue;
-		typevalue.SetString(rapidjson::StringRef(type.c_str()), allocator);
-		json.AddMember(TYPE_KEY, typevalue, allocator);
+		detectionformats::ParseFields(*this, json, fields);
+	}
 
-		// id
-		if (id != "")
-		{
-			rapidjson::Value idvalue;
-			idvalue.SetString(rapidjson::StringRef(id.c_str()), allocator);
-			json.AddMember(ID_KEY, idvalue, allocator);
-		}
+	void retract::clear()
+	{
+		type = RETRACT_TYPE;
+		id.clear();
+		source.clear();
+	}
+
+	rapidjson::Value & retract::tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const
+	{
+		return (detectionformats::WriteFields(*this, json, allocator, fields));
+	}
+
+	void retract::tobinary(std::string &buffer) const
+	{
+		detectionformats::EncodeFields(*this, buffer, fields);
+	}
 
-		// source
-		rapidjson::Value sourcevalue(rapidjson::kObjectType);
-		source.tojson(sourcevalue, allocator);
-		json.AddMember(SOURCE_KEY, sourcevalue, allocator);
+	size_t retract::frombinary(const char *buffer, size_t length)
+	{
+		return (detectionformats::DecodeFields(*this, buffer, length, fields));
+	}
 
-		return(json);
+	bool retract::operator==(const retract &other) const
+	{
+		return (detectionformats::EqualFields(*this, other, fields));
 	}
 
-	std::vector<std::string> retract::geterrors()
+	bool retract::operator!=(const retract &other) const
+	{
+		return (!(*this == other));
+	}
+
+	std::vector<std::string> retract::geterrors() const
 	{
 		std::vector<std::string> errorlist;
 
@@ -103,19 +107,9 @@ namespace detectionformats
 			errorlist.push_back("Non-retract type in retract class.");
 		}
 		
-		// id
-		if (id == "")
-		{
-			// empty id
-			errorlist.push_back("Empty ID in retract class.");
-		}
-		
-		// source
-		if (source.isvalid() != true)
-		{
-			// bad source
-			errorlist.push_back("Source object did not validate in retract class.");
-		}
+		// id and source
+		detectionformats::CheckRequiredFields(*this, "retract", fields,
+				errorlist);
 
 		// return the list of errors
 		return (errorlist);
@@ -0,0 +1,197 @@
+#include "retractionindex.h"
+
+// the filter geometry: 64 byte blocks of eight words, and the bits set per
+// id, which with about 12 bits per expected id gives under 1% false
+// positives
+#define BLOCKWORDS 8
+#define BLOCKBITS 512
+#define BITSPERID 12
+#define HASHCOUNT 6
+
+namespace detectionformats {
+
+// hashes an id with 64 bit FNV-1a and spreads the result with the splitmix64
+// finalizer, since the block and bit positions come from separate bits
+static uint64_t HashId(const std::string &id) {
+	uint64_t hash = HashBytes(id);
+	hash ^= hash >> 30;
+	hash *= 0xBF58476D1CE4E5B9ULL;
+	hash ^= hash >> 27;
+	hash *= 0x94D049BB133111EBULL;
+	hash ^= hash >> 31;
+	return (hash);
+}
+
+// finds the words and masks of an id's bits within its block, the bit
+// positions taken nine bits at a time from the top 54 bits of the hash
+static void BlockMasks(uint64_t hash, uint64_t masks[BLOCKWORDS]) {
+	for (int i = 0; i < BLOCKWORDS; i++) {
+		masks[i] = 0;
+	}
+	for (int i = 0; i < HASHCOUNT; i++) {
+		unsigned int bit = (hash >> (10 + 9 * i)) & (BLOCKBITS - 1);
+		masks[bit >> 6] |= 1ULL << (bit & 63);
+	}
+}
+
+// picks an id's block from the hash remultiplied, so the block does not
+// depend on the same bits as the positions within it
+static size_t BlockIndex(uint64_t hash, size_t blockcount) {
+	return (((hash * 0x9E3779B97F4A7C15ULL) >> 32) & (blockcount - 1));
+}
+
+// checks whether a filter has every bit of masks set in a block
+static bool HasMasks(const std::atomic<uint64_t> *block,
+		const uint64_t masks[BLOCKWORDS]) {
+	for (int i = 0; i < BLOCKWORDS; i++) {
+		if ((block[i].load(std::memory_order_acquire) & masks[i]) != masks[i]) {
+			return (false);
+		}
+	}
+	return (true);
+}
+
+retractionindex::retractionindex(size_t expected,
+		clock::duration newtimetolive)
+		: timetolive(newtimetolive),
+			generationstart(clock::now()),
+			blockcount(1),
+			current(0) {
+	while (blockcount * BLOCKBITS < expected * BITSPERID) {
+		blockcount *= 2;
+	}
+
+	// each filter is given an extra block's worth of words so it can start
+	// on a cache line
+	for (int g = 0; g < 2; g++) {
+		size_t words = (blockcount + 1) * BLOCKWORDS;
+		filterstorage[g].reset(new std::atomic<uint64_t>[words]);
+		for (size_t i = 0; i < words; i++) {
+			filterstorage[g][i].store(0, std::memory_order_relaxed);
+		}
+		uintptr_t address = reinterpret_cast<uintptr_t>(filterstorage[g].get());
+		size_t offset = ((BLOCKWORDS * sizeof(uint64_t))
+				- (address % (BLOCKWORDS * sizeof(uint64_t))))
+				% (BLOCKWORDS * sizeof(uint64_t));
+		filters[g] = filterstorage[g].get() + offset / sizeof(uint64_t);
+	}
+}
+
+bool retractionindex::add(const retract &retraction, clock::time_point now) {
+	if (retraction.id.empty() == true) {
+		return (false);
+	}
+
+	std::lock_guard<std::mutex> guard(mutex);
+	if (now - generationstart >= timetolive) {
+		rotate(now);
+	}
+
+	std::vector<source> &sources = sets[current][retraction.id];
+	for (size_t i = 0; i < sources.size(); i++) {
+		if ((sources[i].agencyid == retraction.source.agencyid)
+				&& (sources[i].author == retraction.source.author)) {
+			return (false);
+		}
+	}
+	sources.push_back(retraction.source);
+
+	// the bits are set after the exact set is, so a lookup that passes the
+	// filter finds the id once it takes the mutex
+	setbits(current, HashId(retraction.id));
+	return (true);
+}
+
+bool retractionindex::isretracted(const std::string &id) const {
+	if (mayberetracted(HashId(id)) == false) {
+		return (false);
+	}
+
+	std::lock_guard<std::mutex> guard(mutex);
+	return ((sets[0].find(id) != sets[0].end())
+			|| (sets[1].find(id) != sets[1].end()));
+}
+
+bool retractionindex::isretracted(const std::string &id,
+		const source &retractsource) const {
+	if (mayberetracted(HashId(id)) == false) {
+		return (false);
+	}
+
+	std::lock_guard<std::mutex> guard(mutex);
+	for (int g = 0; g < 2; g++) {
+		retractionset::const_iterator found = sets[g].find(id);
+		if (found == sets[g].end()) {
+			continue;
+		}
+		for (size_t i = 0; i < found->second.size(); i++) {
+			if ((found->second[i].agencyid == retractsource.agencyid)
+					&& (found->second[i].author == retractsource.author)) {
+				return (true);
+			}
+		}
+	}
+	return (false);
+}
+
+bool retractionindex::expire(clock::time_point now) {
+	std::lock_guard<std::mutex> guard(mutex);
+	if (now - generationstart < timetolive) {
+		return (false);
+	}
+	rotate(now);
+	return (true);
+}
+
+void retractionindex::clear() {
+	std::lock_guard<std::mutex> guard(mutex);
+	cleargeneration(0);
+	cleargeneration(1);
+	generationstart = clock::now();
+}
+
+size_t retractionindex::size() const {
+	std::lock_guard<std::mutex> guard(mutex);
+	return (sets[0].size() + sets[1].size());
+}
+
+bool retractionindex::mayberetracted(uint64_t hash) const {
+	uint64_t masks[BLOCKWORDS];
+	BlockMasks(hash, masks);
+	size_t block = BlockIndex(hash, blockcount) * BLOCKWORDS;
+	return ((HasMasks(filters[0] + block, masks) == true)
+			|| (HasMasks(filters[1] + block, masks) == true));
+}
+
+void retractionindex::setbits(unsigned int generation, uint64_t hash) {
+	uint64_t masks[BLOCKWORDS];
+	BlockMasks(hash, masks);
+	std::atomic<uint64_t> *block = filters[generation]
+			+ BlockIndex(hash, blockcount) * BLOCKWORDS;
+	for (int i = 0; i < BLOCKWORDS; i++) {
+		if (masks[i] != 0) {
+			block[i].fetch_or(masks[i], std::memory_order_release);
+		}
+	}
+}
+
+void retractionindex::rotate(clock::time_point now) {
+	// the older generation is cleared to become the current one; a lookup
+	// racing with this can miss an id in it, which is expiring anyway.  If
+	// the time has jumped past both generations, the current one goes too
+	unsigned int older = current ^ 1;
+	cleargeneration(older);
+	if (now - generationstart >= 2 * timetolive) {
+		cleargeneration(current);
+	}
+	current = older;
+	generationstart = now;
+}
+
+void retractionindex::cleargeneration(unsigned int generation) {
+	sets[generation].clear();
+	for (size_t i = 0; i < blockcount * BLOCKWORDS; i++) {
+		filters[generation][i].store(0, std::memory_order_relaxed);
+	}
+}
+}
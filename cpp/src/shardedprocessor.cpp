@@ -0,0 +1,318 @@
+#include "shardedprocessor.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "rapidjson/reader.h"
+
+// JSON Keys
+#define SITE_KEY "Site"
+#define ID_KEY "ID"
+#define STATION_KEY "Station"
+#define NETWORK_KEY "Network"
+#define CHANNEL_KEY "Channel"
+#define LOCATION_KEY "Location"
+
+// the stack buffer the shard key scan parses with, enough for any site
+#define KEYSCANBUFFERSIZE 1024
+
+namespace detectionformats {
+
+// a SAX handler that picks the top level Site's SCNL, and the top level ID,
+// out of a message, stopping at the end of the Site object
+struct SiteKeyHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>,
+		SiteKeyHandler> {
+	SiteKeyHandler()
+			: depth(0),
+				nextissite(false),
+				insite(false),
+				foundsite(false),
+				target(NULL) {
+	}
+
+	bool Default() {
+		nextissite = false;
+		target = NULL;
+		return (true);
+	}
+
+	bool String(const char *value, rapidjson::SizeType length, bool) {
+		if (target != NULL) {
+			target->assign(value, length);
+		}
+		return (Default());
+	}
+
+	bool StartObject() {
+		if (nextissite == true) {
+			insite = true;
+		}
+		nextissite = false;
+		target = NULL;
+		depth++;
+		return (true);
+	}
+
+	bool Key(const char *key, rapidjson::SizeType length, bool) {
+		Default();
+		if ((depth == 1) && (length == std::strlen(SITE_KEY))
+				&& (std::memcmp(key, SITE_KEY, length) == 0)) {
+			nextissite = true;
+		} else if ((depth == 1) && (length == std::strlen(ID_KEY))
+				&& (std::memcmp(key, ID_KEY, length) == 0)) {
+			target = &id;
+		} else if ((insite == true) && (depth == 2)) {
+			std::string name(key, length);
+			if (name == STATION_KEY) {
+				target = &station;
+			} else if (name == NETWORK_KEY) {
+				target = &network;
+			} else if (name == CHANNEL_KEY) {
+				target = &channel;
+			} else if (name == LOCATION_KEY) {
+				target = &location;
+			}
+		}
+		return (true);
+	}
+
+	bool EndObject(rapidjson::SizeType) {
+		depth--;
+		if ((insite == true) && (depth == 1)) {
+			// the site is all we need, stop the parse here
+			foundsite = true;
+			return (false);
+		}
+		return (Default());
+	}
+
+	int depth;
+	bool nextissite;
+	bool insite;
+	bool foundsite;
+	std::string *target;
+	std::string station;
+	std::string network;
+	std::string channel;
+	std::string location;
+	std::string id;
+};
+
+// gets the cpus this process may run on
+static std::vector<int> AllowedCPUs() {
+	std::vector<int> cpus;
+#if defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &set)) {
+				cpus.push_back(cpu);
+			}
+		}
+	}
+#endif
+	return (cpus);
+}
+
+// pins the calling thread to cpu, returning the cpu's NUMA node, or -1 if
+// it could not be pinned or the node is unknown
+static int PinThread(int cpu) {
+#if defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+		return (-1);
+	}
+
+	unsigned int currentcpu = 0;
+	unsigned int node = 0;
+	if (syscall(SYS_getcpu, &currentcpu, &node, NULL) != 0) {
+		return (-1);
+	}
+	return (static_cast<int>(node));
+#else
+	(void) cpu;
+	return (-1);
+#endif
+}
+
+shardedprocessor::shardedprocessor(handler newhandler, size_t shardcount,
+		size_t queuecapacity, bool pin)
+		: messagehandler(newhandler),
+			nextsequence(0),
+			pushing(0),
+			closed(false),
+			inputdone(false) {
+	std::vector<int> cpus = AllowedCPUs();
+	if (shardcount == 0) {
+		shardcount = (cpus.empty() == false) ?
+				cpus.size() : std::thread::hardware_concurrency();
+	}
+	shardcount = std::max(static_cast<size_t>(1), shardcount);
+
+	for (size_t i = 0; i < shardcount; i++) {
+		shards.push_back(std::unique_ptr<shard>(new shard(queuecapacity)));
+		if ((pin == true) && (cpus.empty() == false)) {
+			shards.back()->cpu = cpus[i % cpus.size()];
+		}
+	}
+	for (size_t i = 0; i < shards.size(); i++) {
+		shards[i]->thread = std::thread(&shardedprocessor::run, this,
+				std::ref(*shards[i]));
+	}
+}
+
+shardedprocessor::~shardedprocessor() {
+	close();
+}
+
+bool shardedprocessor::push(std::string message) {
+	// count this push before checking closed, so that close() can wait for
+	// it to land before telling the shards no more input is coming
+	pushing.fetch_add(1);
+	if (closed.load() == true) {
+		pushing.fetch_sub(1);
+		return (false);
+	}
+
+	shard &target = *shards[getshard(message)];
+
+	pipeline::handle pushed(new pipelinemessage());
+	pushed->sequence = nextsequence.fetch_add(1, std::memory_order_relaxed);
+	pushed->received = std::chrono::steady_clock::now();
+	pushed->raw = std::move(message);
+
+	backoff wait;
+	while (target.queue.trypush(std::move(pushed)) == false) {
+		wait.pause();
+	}
+
+	size_t depth = target.queue.size();
+	size_t maxdepth = target.maxdepth.load(std::memory_order_relaxed);
+	while ((depth > maxdepth)
+			&& (target.maxdepth.compare_exchange_weak(maxdepth, depth,
+					std::memory_order_relaxed) == false)) {
+	}
+
+	pushing.fetch_sub(1);
+	return (true);
+}
+
+size_t shardedprocessor::getshard(const std::string &message) const {
+	char buffer[KEYSCANBUFFERSIZE];
+	rapidjson::MemoryPoolAllocator<> allocator(buffer, sizeof(buffer));
+	rapidjson::GenericReader<rapidjson::UTF8<>, rapidjson::UTF8<>,
+			rapidjson::MemoryPoolAllocator<>> reader(&allocator, 256);
+
+	SiteKeyHandler keys;
+	rapidjson::StringStream stream(message.c_str());
+	reader.Parse(stream, keys);
+
+	// FNV-1a rather than std::hash, so messages get the same shards on
+	// every platform
+	uint64_t hash = FNV64OFFSETBASIS;
+	if (keys.foundsite == true) {
+		hash = HashBytes(keys.station, hash);
+		hash = HashBytes(".", 1, hash);
+		hash = HashBytes(keys.channel, hash);
+		hash = HashBytes(".", 1, hash);
+		hash = HashBytes(keys.network, hash);
+		hash = HashBytes(".", 1, hash);
+		hash = HashBytes(keys.location, hash);
+	} else {
+		hash = HashBytes(keys.id, hash);
+	}
+
+	return (static_cast<size_t>(hash % shards.size()));
+}
+
+void shardedprocessor::close() {
+	if (closed.exchange(true) == true) {
+		return;
+	}
+
+	// wait for any push that got in before the close to finish
+	while (pushing.load() > 0) {
+		std::this_thread::yield();
+	}
+	inputdone.store(true, std::memory_order_release);
+
+	for (size_t i = 0; i < shards.size(); i++) {
+		shards[i]->thread.join();
+	}
+}
+
+size_t shardedprocessor::getshardcount() const {
+	return (shards.size());
+}
+
+shardedmetrics shardedprocessor::getmetrics() const {
+	shardedmetrics metrics;
+
+	uint64_t total = 0;
+	uint64_t busiest = 0;
+	for (size_t i = 0; i < shards.size(); i++) {
+		shardmetrics current;
+		current.cpu = shards[i]->cpu;
+		current.node = shards[i]->node.load();
+		current.depth = shards[i]->queue.size();
+		current.maxdepth = shards[i]->maxdepth.load();
+		current.processed = shards[i]->processed.load();
+		metrics.shards.push_back(current);
+
+		total += current.processed;
+		busiest = std::max(busiest, current.processed);
+	}
+
+	if (total > 0) {
+		metrics.imbalance = static_cast<double>(busiest)
+				/ (static_cast<double>(total) / shards.size());
+	}
+
+	return (metrics);
+}
+
+void shardedprocessor::run(shard &worker) {
+	if (worker.cpu >= 0) {
+		worker.node.store(PinThread(worker.cpu));
+	}
+
+	// first used here, after pinning, so its buffers are local to the cpu
+	parsecontext &context = parsecontext::local();
+
+	backoff wait;
+	pipeline::handle message;
+	while (true) {
+		// read done before trying the queue, if input was already done and
+		// the queue is empty nothing more can arrive
+		bool done = inputdone.load(std::memory_order_acquire);
+
+		if (worker.queue.trypop(message) == true) {
+			wait.reset();
+			ParseMessage(message->raw.c_str(), message->raw.length(), context,
+					message->result);
+			message->valid = (message->result.isparsed() == true)
+					&& (message->result.object->isvalid() == true);
+			messagehandler(*message);
+			worker.processed.fetch_add(1, std::memory_order_relaxed);
+			message.reset();
+			continue;
+		}
+
+		if (done == true) {
+			return;
+		}
+		wait.pause();
+	}
+}
+}
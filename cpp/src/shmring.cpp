@@ -0,0 +1,533 @@
+#include "shmring.h"
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include "pick.h"
+#include "correlation.h"
+#include "detection.h"
+#include "retract.h"
+#include "stationInfo.h"
+#include "stationInfoRequest.h"
+#include "util.h"
+
+// identifies a ring created by shmring, and its layout version
+#define RINGMAGIC 0x44465252
+#define RINGVERSION 2
+
+// the smallest and largest rings, record sizes are 32 bits
+#define MINRINGSIZE 4096
+#define MAXRINGSIZE (1024 * 1024 * 1024)
+
+// records start on this boundary, which is also the record header size
+#define RECORDALIGN 16
+
+// record formats
+#define PADFORMAT 0
+#define JSONFORMAT 1
+#define BINARYFORMAT 2
+
+namespace detectionformats {
+
+// the ring header, shared by every process using the ring.  The counters
+// written by the producers and those written by the reader are kept on
+// separate cache lines.
+struct shmring::ringheader {
+	std::atomic<uint32_t> magic;
+	uint32_t version;
+	uint64_t capacity;
+
+	// the process that created the ring, to recognize a stale ring
+	int64_t creator;
+
+	// the ring position producers next claim from
+	alignas(64) std::atomic<uint64_t> tail;
+
+	// the ring position the reader next pops from
+	alignas(64) std::atomic<uint64_t> head;
+
+	// bumped by producers after each commit, the reader's futex
+	alignas(64) std::atomic<uint32_t> published;
+	std::atomic<uint32_t> readerwaiting;
+
+	// bumped by the reader after freeing space, the producers' futex
+	alignas(64) std::atomic<uint32_t> released;
+	std::atomic<uint32_t> writerswaiting;
+};
+
+// the header at the start of each record.  size, the whole record in bytes,
+// is stored last and is zero until the record is committed.
+struct recordheader {
+	std::atomic<uint32_t> size;
+	uint16_t format;
+	int16_t type;
+	uint32_t length;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(recordheader) == RECORDALIGN,
+		"record header must fill the record alignment");
+
+// sleeps while *word is expected, for at most timeoutms, -1 for no limit.
+// The ring is shared between processes, so the futex is not private.
+static void FutexWait(std::atomic<uint32_t> *word, uint32_t expected,
+		int timeoutms) {
+	timespec timeout;
+	timespec *pointer = NULL;
+	if (timeoutms >= 0) {
+		timeout.tv_sec = timeoutms / 1000;
+		timeout.tv_nsec = (timeoutms % 1000) * 1000000L;
+		pointer = &timeout;
+	}
+	syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT,
+			expected, pointer, NULL, 0);
+}
+
+// wakes up to count sleepers on word
+static void FutexWake(std::atomic<uint32_t> *word, int count) {
+	syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, count,
+			NULL, NULL, 0);
+}
+
+// checks a record payload length, a record longer than a quarter of the
+// ring may never find space
+static bool IsRecordLength(size_t length, uint64_t ringsize) {
+	return ((length > 0) && (length <= ringsize / 4));
+}
+
+// gets the milliseconds left until deadline, -1 if there is no deadline
+static int RemainingMS(bool hasdeadline,
+		std::chrono::steady_clock::time_point deadline) {
+	if (hasdeadline == false) {
+		return (-1);
+	}
+	std::chrono::steady_clock::time_point now =
+			std::chrono::steady_clock::now();
+	if (now >= deadline) {
+		return (0);
+	}
+	return (static_cast<int>(std::chrono::duration_cast<
+			std::chrono::milliseconds>(deadline - now).count()) + 1);
+}
+
+// gets the formattypes of a class type name
+static int16_t FormatType(const std::string &type) {
+	if (type == PICK_TYPE) {
+		return (formattypes::picktype);
+	} else if (type == CORRELATION_TYPE) {
+		return (formattypes::correlationtype);
+	} else if (type == DETECTION_TYPE) {
+		return (formattypes::detectiontype);
+	} else if (type == RETRACT_TYPE) {
+		return (formattypes::retracttype);
+	} else if (type == STATIONINFO_TYPE) {
+		return (formattypes::stationinfotype);
+	} else if (type == STATIONINFOREQUEST_TYPE) {
+		return (formattypes::stationinforequesttype);
+	}
+	return (formattypes::unknown);
+}
+
+// decodes a binary message of class T into result
+template<class T>
+static void DecodeBinary(const char *buffer, size_t length,
+		parseresult &result) {
+	std::shared_ptr<T> message = std::make_shared<T>();
+	message->frombinary(buffer, length);
+	result.object = message;
+}
+
+shmring::shmring(const std::string &name, size_t capacity,
+		bool replacestale)
+		: ringname(name),
+			owner(true),
+			mapping(NULL),
+			mappingsize(0),
+			header(NULL),
+			ring(NULL),
+			ringsize(MINRINGSIZE) {
+	if (capacity > MAXRINGSIZE) {
+		throw std::invalid_argument("shmring capacity larger than 1 GB");
+	}
+	while (ringsize < capacity) {
+		ringsize *= 2;
+	}
+
+	int descriptor = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL,
+			S_IRUSR | S_IWUSR);
+	if ((descriptor < 0) && (errno == EEXIST) && (replacestale == true)) {
+		// only replace a ring left behind by a process that did not clean
+		// up, never one still in use
+		if (isstale(name) == true) {
+			shm_unlink(name.c_str());
+			descriptor = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL,
+					S_IRUSR | S_IWUSR);
+		} else {
+			errno = EEXIST;
+		}
+	}
+	if (descriptor < 0) {
+		throw SystemError("shm_open " + name);
+	}
+
+	size_t length = sizeof(ringheader) + ringsize;
+	if (ftruncate(descriptor, length) < 0) {
+		std::runtime_error error = SystemError("ftruncate " + name);
+		close(descriptor);
+		shm_unlink(name.c_str());
+		throw error;
+	}
+
+	try {
+		map(descriptor, length);
+	} catch (...) {
+		shm_unlink(name.c_str());
+		throw;
+	}
+
+	// the new memory is zero, so every record is uncommitted
+	header = new (mapping) ringheader();
+	header->version = RINGVERSION;
+	header->capacity = ringsize;
+	header->creator = getpid();
+	header->tail.store(0);
+	header->head.store(0);
+	header->published.store(0);
+	header->readerwaiting.store(0);
+	header->released.store(0);
+	header->writerswaiting.store(0);
+
+	// publish the ring to processes opening it
+	header->magic.store(RINGMAGIC, std::memory_order_release);
+}
+
+shmring::shmring(const std::string &name)
+		: ringname(name),
+			owner(false),
+			mapping(NULL),
+			mappingsize(0),
+			header(NULL),
+			ring(NULL),
+			ringsize(0) {
+	int descriptor = shm_open(name.c_str(), O_RDWR, 0);
+	if (descriptor < 0) {
+		throw SystemError("shm_open " + name);
+	}
+
+	struct stat status;
+	if ((fstat(descriptor, &status) < 0)
+			|| (static_cast<size_t>(status.st_size)
+					< sizeof(ringheader) + MINRINGSIZE)) {
+		close(descriptor);
+		throw std::runtime_error("shm_open " + name + ": not a shmring");
+	}
+
+	map(descriptor, status.st_size);
+
+	header = static_cast<ringheader *>(mapping);
+	if ((header->magic.load(std::memory_order_acquire) != RINGMAGIC)
+			|| (header->version != RINGVERSION)
+			|| (sizeof(ringheader) + header->capacity != mappingsize)) {
+		munmap(mapping, mappingsize);
+		throw std::runtime_error("shm_open " + name + ": not a shmring");
+	}
+	ringsize = header->capacity;
+}
+
+shmring::~shmring() {
+	munmap(mapping, mappingsize);
+	if (owner == true) {
+		shm_unlink(ringname.c_str());
+	}
+}
+
+bool shmring::isstale(const std::string &name) {
+	int descriptor = shm_open(name.c_str(), O_RDONLY, 0);
+	if (descriptor < 0) {
+		return (false);
+	}
+
+	struct stat status;
+	if ((fstat(descriptor, &status) < 0)
+			|| (static_cast<size_t>(status.st_size) < sizeof(ringheader))) {
+		close(descriptor);
+		return (false);
+	}
+
+	void *existing = mmap(NULL, sizeof(ringheader), PROT_READ, MAP_SHARED,
+			descriptor, 0);
+	close(descriptor);
+	if (existing == MAP_FAILED) {
+		return (false);
+	}
+
+	// a ring still being created has no magic yet, so is never stale
+	const ringheader *existingheader =
+			static_cast<const ringheader *>(existing);
+	bool stale = (existingheader->magic.load(std::memory_order_acquire)
+			== RINGMAGIC) && (existingheader->version == RINGVERSION)
+			&& (kill(static_cast<pid_t>(existingheader->creator), 0) < 0)
+			&& (errno == ESRCH);
+	munmap(existing, sizeof(ringheader));
+	return (stale);
+}
+
+void shmring::map(int descriptor, size_t length) {
+	mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED,
+			descriptor, 0);
+	if (mapping == MAP_FAILED) {
+		mapping = NULL;
+		std::runtime_error error = SystemError("mmap " + ringname);
+		close(descriptor);
+		throw error;
+	}
+
+	// the mapping holds its own reference to the memory
+	close(descriptor);
+	mappingsize = length;
+	ring = static_cast<char *>(mapping) + sizeof(ringheader);
+}
+
+bool shmring::trypushjson(const char *buffer, size_t length) {
+	return (trypushrecord(JSONFORMAT, formattypes::unknown, buffer, length));
+}
+
+bool shmring::pushjson(const char *buffer, size_t length, int timeoutms) {
+	return (pushrecord(JSONFORMAT, formattypes::unknown, buffer, length,
+			timeoutms));
+}
+
+bool shmring::trypushbinary(const std::string &type, const char *buffer,
+		size_t length) {
+	return (trypushrecord(BINARYFORMAT, FormatType(type), buffer, length));
+}
+
+bool shmring::pushbinary(const std::string &type, const char *buffer,
+		size_t length, int timeoutms) {
+	return (pushrecord(BINARYFORMAT, FormatType(type), buffer, length,
+			timeoutms));
+}
+
+bool shmring::trypushrecord(uint16_t format, int16_t type,
+		const char *buffer, size_t length) {
+	if (IsRecordLength(length, ringsize) == false) {
+		return (false);
+	}
+
+	uint64_t recordsize = (sizeof(recordheader) + length + RECORDALIGN - 1)
+			& ~static_cast<uint64_t>(RECORDALIGN - 1);
+	uint64_t mask = ringsize - 1;
+
+	// claim the space, along with the end of the ring if the record would
+	// not fit before it
+	uint64_t tail = header->tail.load(std::memory_order_relaxed);
+	uint64_t offset;
+	uint64_t claim;
+	while (true) {
+		offset = tail & mask;
+		claim = recordsize;
+		if (offset + recordsize > ringsize) {
+			claim += ringsize - offset;
+		}
+
+		uint64_t head = header->head.load(std::memory_order_acquire);
+		if (tail + claim - head > ringsize) {
+			return (false);
+		}
+
+		if (header->tail.compare_exchange_weak(tail, tail + claim,
+				std::memory_order_relaxed) == true) {
+			break;
+		}
+	}
+
+	if (claim != recordsize) {
+		// fill the end of the ring with a pad record, and start at the front
+		recordheader *pad = reinterpret_cast<recordheader *>(ring + offset);
+		pad->format = PADFORMAT;
+		pad->size.store(static_cast<uint32_t>(ringsize - offset),
+				std::memory_order_release);
+		offset = 0;
+	}
+
+	recordheader *record = reinterpret_cast<recordheader *>(ring + offset);
+	std::memcpy(ring + offset + sizeof(recordheader), buffer, length);
+	record->format = format;
+	record->type = type;
+	record->length = static_cast<uint32_t>(length);
+	record->size.store(static_cast<uint32_t>(recordsize),
+			std::memory_order_release);
+
+	// wake the reader if it is asleep.  The seq_cst increment and load pair
+	// with the reader's store and recheck in pop().
+	header->published.fetch_add(1);
+	if (header->readerwaiting.load() != 0) {
+		FutexWake(&header->published, 1);
+	}
+
+	return (true);
+}
+
+bool shmring::pushrecord(uint16_t format, int16_t type, const char *buffer,
+		size_t length, int timeoutms) {
+	if (IsRecordLength(length, ringsize) == false) {
+		throw std::invalid_argument("shmring message is empty or longer than "
+				"a quarter of the ring");
+	}
+
+	bool hasdeadline = (timeoutms >= 0);
+	std::chrono::steady_clock::time_point deadline =
+			std::chrono::steady_clock::now()
+					+ std::chrono::milliseconds(hasdeadline ? timeoutms : 0);
+
+	while (true) {
+		if (trypushrecord(format, type, buffer, length) == true) {
+			return (true);
+		}
+
+		uint32_t seen = header->released.load();
+		header->writerswaiting.fetch_add(1);
+		if (trypushrecord(format, type, buffer, length) == true) {
+			header->writerswaiting.fetch_sub(1);
+			return (true);
+		}
+
+		int remaining = RemainingMS(hasdeadline, deadline);
+		if (remaining == 0) {
+			header->writerswaiting.fetch_sub(1);
+			return (false);
+		}
+		FutexWait(&header->released, seen, remaining);
+		header->writerswaiting.fetch_sub(1);
+	}
+}
+
+bool shmring::trypop(parseresult &result) {
+	result.type = formattypes::unknown;
+	result.object.reset();
+	result.error.clear();
+
+	uint64_t mask = ringsize - 1;
+	uint64_t head = header->head.load(std::memory_order_relaxed);
+
+	while (true) {
+		char *start = ring + (head & mask);
+		recordheader *record = reinterpret_cast<recordheader *>(start);
+		uint32_t size = record->size.load(std::memory_order_acquire);
+		if (size == 0) {
+			// empty, or the next record is still being copied in
+			return (false);
+		}
+
+		bool ispad = (record->format == PADFORMAT);
+		if (ispad == false) {
+			const char *payload = start + sizeof(recordheader);
+			size_t length = record->length;
+
+			if (record->format == JSONFORMAT) {
+				ParseMessage(payload, length, parsecontext::local(), result);
+			} else {
+				result.type = record->type;
+				try {
+					switch (record->type) {
+						case formattypes::picktype:
+							DecodeBinary<pick>(payload, length, result);
+							break;
+						case formattypes::correlationtype:
+							DecodeBinary<correlation>(payload, length, result);
+							break;
+						case formattypes::detectiontype:
+							DecodeBinary<detection>(payload, length, result);
+							break;
+						case formattypes::retracttype:
+							DecodeBinary<retract>(payload, length, result);
+							break;
+						case formattypes::stationinfotype:
+							DecodeBinary<stationInfo>(payload, length, result);
+							break;
+						case formattypes::stationinforequesttype:
+							DecodeBinary<stationInfoRequest>(payload, length,
+									result);
+							break;
+						default:
+							result.error = "Unknown Type.";
+							break;
+					}
+				} catch (const std::exception &e) {
+					result.object.reset();
+					result.error = e.what();
+				}
+			}
+		}
+
+		// clear the record, a later record may start anywhere in it, then
+		// hand the space back to the producers
+		std::memset(start, 0, size);
+		head += size;
+		header->head.store(head, std::memory_order_release);
+
+		header->released.fetch_add(1);
+		if (header->writerswaiting.load() != 0) {
+			FutexWake(&header->released, INT_MAX);
+		}
+
+		if (ispad == false) {
+			return (true);
+		}
+	}
+}
+
+bool shmring::pop(parseresult &result, int timeoutms) {
+	bool hasdeadline = (timeoutms >= 0);
+	std::chrono::steady_clock::time_point deadline =
+			std::chrono::steady_clock::now()
+					+ std::chrono::milliseconds(hasdeadline ? timeoutms : 0);
+
+	while (true) {
+		if (trypop(result) == true) {
+			return (true);
+		}
+
+		uint32_t seen = header->published.load();
+		header->readerwaiting.store(1);
+		if (trypop(result) == true) {
+			header->readerwaiting.store(0);
+			return (true);
+		}
+
+		int remaining = RemainingMS(hasdeadline, deadline);
+		if (remaining == 0) {
+			header->readerwaiting.store(0);
+			return (false);
+		}
+		FutexWait(&header->published, seen, remaining);
+		header->readerwaiting.store(0);
+	}
+}
+
+size_t shmring::capacity() const {
+	return (ringsize);
+}
+
+size_t shmring::size() const {
+	uint64_t head = header->head.load();
+	uint64_t tail = header->tail.load();
+	return ((tail > head) ? static_cast<size_t>(tail - head) : 0);
+}
+}
+#endif
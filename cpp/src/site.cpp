@@ -1,4 +1,5 @@
 #include "site.h"
+#include "fields.h"
 // JSON Keys
 #define STATION_KEY "Station"
 #define CHANNEL_KEY "Channel"
@@ -6,6 +7,15 @@
 #define LOCATION_KEY "Location"
 
 namespace detectionformats {
+// field descriptors, in the order the fields are written to json
+static constexpr auto fields = std::make_tuple(
+		detectionformats::requiredfield(
+				detectionformats::stringfield(STATION_KEY, &site::station)),
+		detectionformats::requiredfield(
+				detectionformats::stringfield(NETWORK_KEY, &site::network)),
+		detectionformats::stringfield(CHANNEL_KEY, &site::channel),
+		detectionformats::stringfield(LOCATION_KEY, &site::location));
+
 site::site() {
 	station = "";
 	channel = "";
@@ -22,40 +32,7 @@ site::site(std::string newstation, std::string newchannel,
 }
 
 site::site(rapidjson::Value &json) {
-
-	// required values
-	// station
-	if ((json.HasMember(STATION_KEY) == true)
-			&& (json[STATION_KEY].IsString() == true))
-		station = std::string(json[STATION_KEY].GetString(),
-				json[STATION_KEY].GetStringLength());
-	else
-		station = "";
-
-	// network
-	if ((json.HasMember(NETWORK_KEY) == true)
-			&& (json[NETWORK_KEY].IsString() == true))
-		network = std::string(json[NETWORK_KEY].GetString(),
-				json[NETWORK_KEY].GetStringLength());
-	else
-		network = "";
-
-	// optional values
-	// channel
-	if ((json.HasMember(CHANNEL_KEY) == true)
-			&& (json[CHANNEL_KEY].IsString() == true))
-		channel = std::string(json[CHANNEL_KEY].GetString(),
-				json[CHANNEL_KEY].GetStringLength());
-	else
-		channel = "";
-
-	// location
-	if ((json.HasMember(LOCATION_KEY) == true)
-			&& (json[LOCATION_KEY].IsString() == true))
-		location = std::string(json[LOCATION_KEY].GetString(),
-				json[LOCATION_KEY].GetStringLength());
-	else
-		location = "";
+	resetfrom(json);
 }
 
 site::site(const site & newsite) {
@@ -68,61 +45,46 @@ site::site(const site & newsite) {
 site::~site() {
 }
 
+void site::resetfrom(rapidjson::Value &json) {
+	clear();
+
+	detectionformats::ParseFields(*this, json, fields);
+}
+
+void site::clear() {
+	station.clear();
+	channel.clear();
+	network.clear();
+	location.clear();
+}
+
 rapidjson::Value & site::tojson(rapidjson::Value &json,
-		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) {
-	json.SetObject();
-
-	// required values
-	// station
-	if (station != "") {
-		rapidjson::Value stationvalue;
-		stationvalue.SetString(rapidjson::StringRef(station.c_str()),
-				allocator);
-		json.AddMember(STATION_KEY, stationvalue, allocator);
-	}
-	// network
-	if (network != "") {
-		rapidjson::Value networkvalue;
-		networkvalue.SetString(rapidjson::StringRef(network.c_str()),
-				allocator);
-		json.AddMember(NETWORK_KEY, networkvalue, allocator);
-	}
-
-	// optional values
-	// channel
-	if (channel != "") {
-		rapidjson::Value channelvalue;
-		channelvalue.SetString(rapidjson::StringRef(channel.c_str()),
-				allocator);
-		json.AddMember(CHANNEL_KEY, channelvalue, allocator);
-	}
-
-	// location
-	if (location != "") {
-		rapidjson::Value locationvalue;
-		locationvalue.SetString(rapidjson::StringRef(location.c_str()),
-				allocator);
-		json.AddMember(LOCATION_KEY, locationvalue, allocator);
-	}
-
-	return (json);
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+	return (detectionformats::WriteFields(*this, json, allocator, fields));
+}
+
+void site::tobinary(std::string &buffer) const {
+	detectionformats::EncodeFields(*this, buffer, fields);
+}
+
+size_t site::frombinary(const char *buffer, size_t length) {
+	return (detectionformats::DecodeFields(*this, buffer, length, fields));
+}
+
+bool site::operator==(const site &other) const {
+	return (detectionformats::EqualFields(*this, other, fields));
+}
+
+bool site::operator!=(const site &other) const {
+	return (!(*this == other));
 }
 
-std::vector<std::string> site::geterrors() {
+std::vector<std::string> site::geterrors() const {
 	std::vector<std::string> errorlist;
 
 	// check for required keys
-	// Station
-	if (station == "") {
-		// empty Station
-		errorlist.push_back("Empty Station in site class.");
-	}
-
-	// Network
-	if (network == "") {
-		// empty network
-		errorlist.push_back("Empty Network in site class.");
-	}
+	// Station and Network
+	detectionformats::CheckRequiredFields(*this, "site", fields, errorlist);
 
 	// since station, channel, network, and location are free text strings, no
 	// further  validation is required.  channel and location are also optional
@@ -1,4 +1,5 @@
 #include "source.h"
+#include "fields.h"
 
 // JSON Keys
 #define AGENCYID_KEY "AgencyID"
@@ -6,6 +7,15 @@
 
 namespace detectionformats
 {
+	// field descriptors, in the order the fields are written to json
+	static constexpr auto fields = std::make_tuple(
+			detectionformats::requiredfield(
+					detectionformats::stringfield(AGENCYID_KEY,
+							&source::agencyid)),
+			detectionformats::requiredfield(
+					detectionformats::stringfield(AUTHOR_KEY,
+							&source::author)));
+
 	source::source()
 	{
 		agencyid = "";
@@ -20,18 +30,7 @@ namespace detectionformats
 
 	source::source(rapidjson::Value &json)
 	{
-		// required values
-		// agencyid
-		if ((json.HasMember(AGENCYID_KEY) == true) && (json[AGENCYID_KEY].IsString() == true))
-			agencyid = std::string(json[AGENCYID_KEY].GetString(), json[AGENCYID_KEY].GetStringLength());
-		else
-			agencyid = "";
-
-		// author
-		if ((json.HasMember(AUTHOR_KEY) == true) && (json[AUTHOR_KEY].IsString() == true))
-			author = std::string(json[AUTHOR_KEY].GetString(), json[AUTHOR_KEY].GetStringLength());
-		else
-			author = "";
+		resetfrom(json);
 	}
 
 	source::source(const source & newsource)
@@ -44,46 +43,52 @@ namespace detectionformats
 	{
 	}
 
+	void source::resetfrom(rapidjson::Value &json)
+	{
+		clear();
 
-	rapidjson::Value & source::tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator)
+		detectionformats::ParseFields(*this, json, fields);
+	}
+
+	void source::clear()
 	{
-		json.SetObject();
+		agencyid.clear();
+		author.clear();
+	}
 
-		// required values
-		// siteid
-		if (agencyid != "")
-		{
-			rapidjson::Value agencyidvalue;
-			agencyidvalue.SetString(rapidjson::StringRef(agencyid.c_str()), allocator);
-			json.AddMember(AGENCYID_KEY, agencyidvalue, allocator);
-		}
 
-		// author
-		if (author != "")
-		{
-			rapidjson::Value authorvalue;
-			authorvalue.SetString(rapidjson::StringRef(author.c_str()), allocator);
-			json.AddMember(AUTHOR_KEY, authorvalue, allocator);
-		}
+	rapidjson::Value & source::tojson(rapidjson::Value &json, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const
+	{
+		return (detectionformats::WriteFields(*this, json, allocator, fields));
+	}
+
+	void source::tobinary(std::string &buffer) const
+	{
+		detectionformats::EncodeFields(*this, buffer, fields);
+	}
 
-		return(json);		
+	size_t source::frombinary(const char *buffer, size_t length)
+	{
+		return (detectionformats::DecodeFields(*this, buffer, length, fields));
 	}
 
-	std::vector<std::string> source::geterrors()
+	bool source::operator==(const source &other) const
 	{
-		std::vector<std::string> errorlist;
+		return (detectionformats::EqualFields(*this, other, fields));
+	}
 
-		if (agencyid == "")
-		{
-			// empty agencyid
-			errorlist.push_back("Empty AgencyID in source class.");
-		}
+	bool source::operator!=(const source &other) const
+	{
+		return (!(*this == other));
+	}
+
+	std::vector<std::string> source::geterrors() const
+	{
+		std::vector<std::string> errorlist;
 
-		if (author == "")
-		{
-			// empty author
-			errorlist.push_back("Empty Author in source class.");
-		}
+		// agencyid and author
+		detectionformats::CheckRequiredFields(*this, "source", fields,
+				errorlist);
 
 		// since agencyid and author are free text strings, no further validation is required.
 
@@ -91,7 +96,7 @@ namespace detectionformats
 		return (errorlist);
 	}
 
-	bool source::isempty()
+	bool source::isempty() const
     {
 		if (agencyid != "")
 			return(false);
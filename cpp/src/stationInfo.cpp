@@ -1,4 +1,5 @@
 #include "stationInfo.h"
+#include "fields.h"
 
 #include <limits>
 
@@ -14,6 +15,27 @@
 #define INFORMATIONREQUESTOR_KEY "InformationRequestor"
 
 namespace detectionformats {
+// field descriptors, in the order the fields are written to json
+static constexpr auto fields = std::make_tuple(
+		detectionformats::stringfield(TYPE_KEY, &stationInfo::type, true),
+		detectionformats::requiredfield(
+				detectionformats::objectfield(SITE_KEY, &stationInfo::site)),
+		detectionformats::requiredfield(
+				detectionformats::numberfield(LATITUDE_KEY,
+						&stationInfo::latitude)),
+		detectionformats::requiredfield(
+				detectionformats::numberfield(LONGITUDE_KEY,
+						&stationInfo::longitude)),
+		detectionformats::requiredfield(
+				detectionformats::numberfield(ELEVATION_KEY,
+						&stationInfo::elevation)),
+		detectionformats::numberfield(QUALITY_KEY, &stationInfo::quality),
+		detectionformats::boolfield(ENABLE_KEY, &stationInfo::enable),
+		detectionformats::boolfield(USEFORTELESEISMIC_KEY,
+				&stationInfo::useforteleseismic),
+		detectionformats::optionalobjectfield(INFORMATIONREQUESTOR_KEY,
+				&stationInfo::informationRequestor));
+
 stationInfo::stationInfo() {
 	type = STATIONINFO_TYPE;
 	site = detectionformats::site();
@@ -59,77 +81,7 @@ stationInfo::stationInfo(detectionformats::site newsite, double newlatitude,
 }
 
 stationInfo::stationInfo(rapidjson::Value &json) {
-	// required values
-	// type
-	if ((json.HasMember(TYPE_KEY) == true)
-			&& (json[TYPE_KEY].IsString() == true))
-		type = std::string(json[TYPE_KEY].GetString(),
-				json[TYPE_KEY].GetStringLength());
-	else
-		type = "";
-
-	// site
-	if ((json.HasMember(SITE_KEY) == true)
-			&& (json[SITE_KEY].IsObject() == true)) {
-		rapidjson::Value & sitevalue = json["Site"];
-		site = detectionformats::site(sitevalue);
-	} else
-		site = detectionformats::site();
-
-	// latitude
-	if ((json.HasMember(LATITUDE_KEY) == true)
-			&& (json[LATITUDE_KEY].IsNumber() == true)
-			&& (json[LATITUDE_KEY].IsDouble() == true))
-		latitude = json[LATITUDE_KEY].GetDouble();
-	else
-		latitude = std::numeric_limits<double>::quiet_NaN();
-
-	// longitude
-	if ((json.HasMember(LONGITUDE_KEY) == true)
-			&& (json[LONGITUDE_KEY].IsNumber() == true)
-			&& (json[LONGITUDE_KEY].IsDouble() == true))
-		longitude = json[LONGITUDE_KEY].GetDouble();
-	else
-		longitude = std::numeric_limits<double>::quiet_NaN();
-
-	// elevation
-	if ((json.HasMember(ELEVATION_KEY) == true)
-			&& (json[ELEVATION_KEY].IsNumber() == true)
-			&& (json[ELEVATION_KEY].IsDouble() == true))
-		elevation = json[ELEVATION_KEY].GetDouble();
-	else
-		elevation = std::numeric_limits<double>::quiet_NaN();
-
-	// optional values
-	// quality
-	if ((json.HasMember(QUALITY_KEY) == true)
-			&& (json[QUALITY_KEY].IsNumber() == true)
-			&& (json[QUALITY_KEY].IsDouble() == true))
-		quality = json[QUALITY_KEY].GetDouble();
-	else
-		quality = std::numeric_limits<double>::quiet_NaN();
-
-	// enable
-	if ((json.HasMember(ENABLE_KEY) == true)
-			&& (json[ENABLE_KEY].IsBool() == true))
-		enable = json[ENABLE_KEY].GetBool();
-	else
-		enable = true;
-
-	// useforteleseismic
-	if ((json.HasMember(USEFORTELESEISMIC_KEY) == true)
-			&& (json[USEFORTELESEISMIC_KEY].IsBool() == true))
-		useforteleseismic = json[USEFORTELESEISMIC_KEY].GetBool();
-	else
-		useforteleseismic = false;
-
-	// informationRequestor
-	if ((json.HasMember(INFORMATIONREQUESTOR_KEY) == true)
-			&& (json[INFORMATIONREQUESTOR_KEY].IsObject() == true)) {
-		rapidjson::Value & sourcevalue = json[INFORMATIONREQUESTOR_KEY];
-		informationRequestor = detectionformats::source(sourcevalue);
-	} else
-		informationRequestor = detectionformats::source();
+	resetfrom(json);
 }
 
 stationInfo::stationInfo(const stationInfo &newstation) {
@@ -147,54 +99,47 @@ stationInfo::stationInfo(const stationInfo &newstation) {
 stationInfo::~stationInfo() {
 }
 
-rapidjson::Value & stationInfo::tojson(rapidjson::Value &json,
-		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) {
-	json.SetObject();
-
-	// required values
-	// type
-	rapidjson::Value typevalue;
-	typevalue.SetString(rapidjson::StringRef(type.c_str()), allocator);
-	json.AddMember(TYPE_KEY, typevalue, allocator);
-
-	// site
-	rapidjson::Value sitevalue(rapidjson::kObjectType);
-	site.tojson(sitevalue, allocator);
-	json.AddMember(SITE_KEY, sitevalue, allocator);
+void stationInfo::resetfrom(rapidjson::Value &json) {
+	clear();
+	type.clear();
 
-	// latitude
-	if (std::isnan(latitude) != true)
-		json.AddMember(LATITUDE_KEY, latitude, allocator);
+	detectionformats::ParseFields(*this, json, fields);
+}
 
-	// longitude
-	if (std::isnan(longitude) != true)
-		json.AddMember(LONGITUDE_KEY, longitude, allocator);
+void stationInfo::clear() {
+	type = STATIONINFO_TYPE;
+	site.clear();
+	latitude = std::numeric_limits<double>::quiet_NaN();
+	longitude = std::numeric_limits<double>::quiet_NaN();
+	elevation = std::numeric_limits<double>::quiet_NaN();
+	quality = std::numeric_limits<double>::quiet_NaN();
+	enable = true;
+	useforteleseismic = false;
+	informationRequestor.clear();
+}
 
-	// elevation
-	if (std::isnan(elevation) != true)
-		json.AddMember(ELEVATION_KEY, elevation, allocator);
+rapidjson::Value & stationInfo::tojson(rapidjson::Value &json,
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+	return (detectionformats::WriteFields(*this, json, allocator, fields));
+}
 
-	// optional values
-	// quality
-	if (std::isnan(quality) != true)
-		json.AddMember(QUALITY_KEY, quality, allocator);
+void stationInfo::tobinary(std::string &buffer) const {
+	detectionformats::EncodeFields(*this, buffer, fields);
+}
 
-	// enable
-	json.AddMember(ENABLE_KEY, enable, allocator);
+size_t stationInfo::frombinary(const char *buffer, size_t length) {
+	return (detectionformats::DecodeFields(*this, buffer, length, fields));
+}
 
-	// useforteleseismic
-	json.AddMember(USEFORTELESEISMIC_KEY, useforteleseismic, allocator);
+bool stationInfo::operator==(const stationInfo &other) const {
+	return (detectionformats::EqualFields(*this, other, fields));
+}
 
-	// informationRequestor
-	if (informationRequestor.isempty() != true) {
-		rapidjson::Value sourcevalue(rapidjson::kObjectType);
-		informationRequestor.tojson(sourcevalue, allocator);
-		json.AddMember(INFORMATIONREQUESTOR_KEY, sourcevalue, allocator);
-	}
-	return (json);
+bool stationInfo::operator!=(const stationInfo &other) const {
+	return (!(*this == other));
 }
 
-std::vector<std::string> stationInfo::geterrors() {
+std::vector<std::string> stationInfo::geterrors() const {
 	std::vector<std::string> errorlist;
 
 	// check for required data
@@ -204,35 +149,20 @@ std::vector<std::string> stationInfo::geterrors() {
 		errorlist.push_back("Non-stationInfo type in stationInfo class.");
 	}
 
-	// site
-	if (site.isvalid() != true) {
-		// site not found
-		errorlist.push_back(
-				"Site object did not validate in stationInfo class.");
-	}
+	// site, latitude, longitude, and elevation
+	detectionformats::CheckRequiredFields(*this, "stationInfo", fields,
+			errorlist);
 
 	// latitude
-	if (std::isnan(latitude) == true) {
-		// latitude not found
-		errorlist.push_back("No Latitude in stationInfo class.");
-	} else if ((latitude < -90) || (latitude > 90)) {
+	if ((latitude < -90) || (latitude > 90)) {
 		errorlist.push_back("Invalid Latitude in stationInfo class.");
 	}
 
 	// longitude
-	if (std::isnan(longitude) == true) {
-		// longitude not found
-		errorlist.push_back("No Longitude in stationInfo class.");
-	} else if ((longitude < -180) || (longitude > 180)) {
+	if ((longitude < -180) || (longitude > 180)) {
 		errorlist.push_back("Invalid Longitude in stationInfo class.");
 	}
 
-	// elevation
-	if (std::isnan(elevation) == true) {
-		// elevation not found
-		errorlist.push_back("No Elevation in stationInfo class.");
-	}
-
 	// optional data
 	// Currently no validation criteria for optional values Quality,
 	// Enable, and UseForTeleseismic.
@@ -1,4 +1,5 @@
 #include "stationInfoRequest.h"
+#include "fields.h"
 
 #include <limits>
 
@@ -8,6 +9,17 @@
 #define SOURCE_KEY "Source"
 
 namespace detectionformats {
+// field descriptors, in the order the fields are written to json
+static constexpr auto fields = std::make_tuple(
+		detectionformats::stringfield(TYPE_KEY, &stationInfoRequest::type,
+				true),
+		detectionformats::requiredfield(
+				detectionformats::objectfield(SITE_KEY,
+						&stationInfoRequest::site)),
+		detectionformats::requiredfield(
+				detectionformats::objectfield(SOURCE_KEY,
+						&stationInfoRequest::source)));
+
 stationInfoRequest::stationInfoRequest() {
 	type = STATIONINFOREQUEST_TYPE;
 	site = detectionformats::site();
@@ -31,31 +43,7 @@ stationInfoRequest::stationInfoRequest(detectionformats::site newsite,
 }
 
 stationInfoRequest::stationInfoRequest(rapidjson::Value &json) {
-	// required values
-	// type
-	if ((json.HasMember(TYPE_KEY) == true)
-			&& (json[TYPE_KEY].IsString() == true))
-		type = std::string(json[TYPE_KEY].GetString(),
-				json[TYPE_KEY].GetStringLength());
-	else
-		type = "";
-
-	// site
-	if ((json.HasMember(SITE_KEY) == true)
-			&& (json[SITE_KEY].IsObject() == true)) {
-		rapidjson::Value & sitevalue = json["Site"];
-		site = detectionformats::site(sitevalue);
-	} else
-		site = detectionformats::site();
-
-	// source
-	if ((json.HasMember(SOURCE_KEY) == true)
-			&& (json[SOURCE_KEY].IsObject() == true)) {
-		rapidjson::Value & sourcevalue = json[SOURCE_KEY];
-		source = detectionformats::source(sourcevalue);
-	} else
-		source = detectionformats::source();
-
+	resetfrom(json);
 }
 
 stationInfoRequest::stationInfoRequest(const stationInfoRequest &newstation) {
@@ -67,30 +55,41 @@ stationInfoRequest::stationInfoRequest(const stationInfoRequest &newstation) {
 stationInfoRequest::~stationInfoRequest() {
 }
 
+void stationInfoRequest::resetfrom(rapidjson::Value &json) {
+	clear();
+	type.clear();
+
+	detectionformats::ParseFields(*this, json, fields);
+}
+
+void stationInfoRequest::clear() {
+	type = STATIONINFOREQUEST_TYPE;
+	site.clear();
+	source.clear();
+}
+
 rapidjson::Value & stationInfoRequest::tojson(rapidjson::Value &json,
-		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) {
-	json.SetObject();
-
-	// required values
-	// type
-	rapidjson::Value typevalue;
-	typevalue.SetString(rapidjson::StringRef(type.c_str()), allocator);
-	json.AddMember(TYPE_KEY, typevalue, allocator);
-
-	// site
-	rapidjson::Value sitevalue(rapidjson::kObjectType);
-	site.tojson(sitevalue, allocator);
-	json.AddMember(SITE_KEY, sitevalue, allocator);
-
-	// source
-	rapidjson::Value sourcevalue(rapidjson::kObjectType);
-	source.tojson(sourcevalue, allocator);
-	json.AddMember(SOURCE_KEY, sourcevalue, allocator);
-
-	return (json);
+		rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> &allocator) const {
+	return (detectionformats::WriteFields(*this, json, allocator, fields));
 }
 
-std::vector<std::string> stationInfoRequest::geterrors() {
+void stationInfoRequest::tobinary(std::string &buffer) const {
+	detectionformats::EncodeFields(*this, buffer, fields);
+}
+
+size_t stationInfoRequest::frombinary(const char *buffer, size_t length) {
+	return (detectionformats::DecodeFields(*this, buffer, length, fields));
+}
+
+bool stationInfoRequest::operator==(const stationInfoRequest &other) const {
+	return (detectionformats::EqualFields(*this, other, fields));
+}
+
+bool stationInfoRequest::operator!=(const stationInfoRequest &other) const {
+	return (!(*this == other));
+}
+
+std::vector<std::string> stationInfoRequest::geterrors() const {
 	std::vector<std::string> errorlist;
 
 	// check for required data
@@ -101,19 +100,9 @@ std::vector<std::string> stationInfoRequest::geterrors() {
 				"Non-stationInfoRequest type in stationInfoRequest class.");
 	}
 
-	// site
-	if (site.isvalid() != true) {
-		// site not found
-		errorlist.push_back(
-				"Site object did not validate in stationInfoRequest class.");
-	}
-
-	// source
-	if (source.isvalid() != true) {
-		// bad source
-		errorlist.push_back(
-				"Source object did not validate in stationInfoRequest class.");
-	}
+	// site and source
+	detectionformats::CheckRequiredFields(*this, "stationInfoRequest", fields,
+			errorlist);
 
 	// return the list of errors
 	return (errorlist);
@@ -0,0 +1,332 @@
+#include "stationindex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// the most stations in a leaf
+#define LEAFSIZE 16
+
+// degree radian conversions
+#define DEGREESTORADIANS (3.14159265358979323846 / 180.0)
+#define RADIANSTODEGREES (180.0 / 3.14159265358979323846)
+
+namespace detectionformats {
+
+// converts a latitude and longitude in degrees to a unit vector
+static void UnitVector(double latitude, double longitude, double vector[3]) {
+	double phi = latitude * DEGREESTORADIANS;
+	double lambda = longitude * DEGREESTORADIANS;
+	vector[0] = std::cos(phi) * std::cos(lambda);
+	vector[1] = std::cos(phi) * std::sin(lambda);
+	vector[2] = std::sin(phi);
+}
+
+// converts a great circle distance in degrees to the squared straight line
+// distance between unit vectors that far apart
+static double SquaredChord(double distance) {
+	double chord = 2.0 * std::sin(0.5 * distance * DEGREESTORADIANS);
+	return (chord * chord);
+}
+
+stationindex::stationindex(const stationinventory &inventory) {
+	const double *latitudes = inventory.getlatitudes();
+	const double *longitudes = inventory.getlongitudes();
+	for (uint32_t id = 0; id < inventory.size(); id++) {
+		if (inventory.isenabled(id) == false) {
+			continue;
+		}
+
+		double vector[3];
+		UnitVector(latitudes[id], longitudes[id], vector);
+		xs.push_back(vector[0]);
+		ys.push_back(vector[1]);
+		zs.push_back(vector[2]);
+		ids.push_back(id);
+		teleseismics.push_back(inventory.isteleseismic(id) ? 1 : 0);
+	}
+	if (ids.empty() == true) {
+		return;
+	}
+
+	std::vector<uint32_t> order(ids.size());
+	for (uint32_t i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	build(order, 0, static_cast<uint32_t>(order.size()));
+
+	// put the arrays in tree order, so each node's stations are contiguous
+	std::vector<double> treexs(order.size());
+	std::vector<double> treeys(order.size());
+	std::vector<double> treezs(order.size());
+	std::vector<uint32_t> treeids(order.size());
+	std::vector<uint8_t> treeteleseismics(order.size());
+	for (size_t i = 0; i < order.size(); i++) {
+		treexs[i] = xs[order[i]];
+		treeys[i] = ys[order[i]];
+		treezs[i] = zs[order[i]];
+		treeids[i] = ids[order[i]];
+		treeteleseismics[i] = teleseismics[order[i]];
+	}
+	xs.swap(treexs);
+	ys.swap(treeys);
+	zs.swap(treezs);
+	ids.swap(treeids);
+	teleseismics.swap(treeteleseismics);
+}
+
+std::vector<stationdistance> stationindex::nearest(double latitude,
+		double longitude, size_t count, bool teleseismic) const {
+	std::vector<stationdistance> results;
+	if ((nodes.empty() == true) || (count == 0)) {
+		return (results);
+	}
+
+	double query[3];
+	UnitVector(latitude, longitude, query);
+
+	// a max heap of the nearest found so far, by squared chord
+	std::vector<std::pair<double, uint32_t>> best;
+	best.reserve(count + 1);
+
+	// depth first, nearer child first, with each node's lower bound
+	std::vector<std::pair<uint32_t, double>> pending;
+	pending.push_back(std::make_pair(0u, 0.0));
+	double squared[LEAFSIZE];
+	while (pending.empty() == false) {
+		std::pair<uint32_t, double> current = pending.back();
+		pending.pop_back();
+		if ((best.size() == count) && (current.second > best.front().first)) {
+			continue;
+		}
+
+		const node &visit = nodes[current.first];
+		if (visit.right == 0) {
+			uint32_t size = visit.end - visit.begin;
+			const double *x = xs.data() + visit.begin;
+			const double *y = ys.data() + visit.begin;
+			const double *z = zs.data() + visit.begin;
+			for (uint32_t i = 0; i < size; i++) {
+				double dx = x[i] - query[0];
+				double dy = y[i] - query[1];
+				double dz = z[i] - query[2];
+				squared[i] = dx * dx + dy * dy + dz * dz;
+			}
+
+			for (uint32_t i = 0; i < size; i++) {
+				if ((teleseismic == true)
+						&& (teleseismics[visit.begin + i] == 0)) {
+					continue;
+				}
+				if (best.size() < count) {
+					best.push_back(std::make_pair(squared[i], visit.begin + i));
+					std::push_heap(best.begin(), best.end());
+				} else if (squared[i] < best.front().first) {
+					std::pop_heap(best.begin(), best.end());
+					best.back() = std::make_pair(squared[i], visit.begin + i);
+					std::push_heap(best.begin(), best.end());
+				}
+			}
+			continue;
+		}
+
+		double difference = query[visit.axis] - visit.split;
+		uint32_t nearchild = current.first + 1;
+		uint32_t farchild = visit.right;
+		if (difference > 0) {
+			std::swap(nearchild, farchild);
+		}
+		pending.push_back(
+				std::make_pair(farchild,
+						std::max(current.second, difference * difference)));
+		pending.push_back(std::make_pair(nearchild, current.second));
+	}
+
+	std::sort_heap(best.begin(), best.end());
+	std::vector<uint32_t> candidates;
+	candidates.reserve(best.size());
+	for (size_t i = 0; i < best.size(); i++) {
+		candidates.push_back(best[i].second);
+	}
+	measure(latitude, longitude, candidates, results);
+	return (results);
+}
+
+std::vector<stationdistance> stationindex::nearest(const hypocenter &origin,
+		size_t count, bool teleseismic) const {
+	return (nearest(origin.latitude, origin.longitude, count, teleseismic));
+}
+
+std::vector<stationdistance> stationindex::within(double latitude,
+		double longitude, double distance, bool teleseismic) const {
+	std::vector<stationdistance> results;
+	if ((nodes.empty() == true) || (distance < 0)) {
+		return (results);
+	}
+
+	double query[3];
+	UnitVector(latitude, longitude, query);
+	double limit = (distance >= 180) ? 4.0 : SquaredChord(distance);
+
+	std::vector<std::pair<double, uint32_t>> found;
+	std::vector<uint32_t> pending;
+	pending.push_back(0);
+	double squared[LEAFSIZE];
+	while (pending.empty() == false) {
+		uint32_t current = pending.back();
+		pending.pop_back();
+
+		const node &visit = nodes[current];
+		if (visit.right == 0) {
+			uint32_t size = visit.end - visit.begin;
+			const double *x = xs.data() + visit.begin;
+			const double *y = ys.data() + visit.begin;
+			const double *z = zs.data() + visit.begin;
+			for (uint32_t i = 0; i < size; i++) {
+				double dx = x[i] - query[0];
+				double dy = y[i] - query[1];
+				double dz = z[i] - query[2];
+				squared[i] = dx * dx + dy * dy + dz * dz;
+			}
+
+			for (uint32_t i = 0; i < size; i++) {
+				if ((squared[i] <= limit)
+						&& ((teleseismic == false)
+								|| (teleseismics[visit.begin + i] != 0))) {
+					found.push_back(std::make_pair(squared[i], visit.begin + i));
+				}
+			}
+			continue;
+		}
+
+		double difference = query[visit.axis] - visit.split;
+		uint32_t nearchild = current + 1;
+		uint32_t farchild = visit.right;
+		if (difference > 0) {
+			std::swap(nearchild, farchild);
+		}
+		if (difference * difference <= limit) {
+			pending.push_back(farchild);
+		}
+		pending.push_back(nearchild);
+	}
+
+	std::sort(found.begin(), found.end());
+	std::vector<uint32_t> candidates;
+	candidates.reserve(found.size());
+	for (size_t i = 0; i < found.size(); i++) {
+		candidates.push_back(found[i].second);
+	}
+	measure(latitude, longitude, candidates, results);
+	return (results);
+}
+
+std::vector<stationdistance> stationindex::within(const hypocenter &origin,
+		double distance, bool teleseismic) const {
+	return (within(origin.latitude, origin.longitude, distance, teleseismic));
+}
+
+size_t stationindex::size() const {
+	return (ids.size());
+}
+
+uint32_t stationindex::build(std::vector<uint32_t> &order, uint32_t begin,
+		uint32_t end) {
+	uint32_t index = static_cast<uint32_t>(nodes.size());
+	node created;
+	created.begin = begin;
+	created.end = end;
+	created.right = 0;
+	created.axis = 0;
+	created.split = 0;
+	nodes.push_back(created);
+	if (end - begin <= LEAFSIZE) {
+		return (index);
+	}
+
+	// split the axis the stations are most spread along at the median
+	const std::vector<double> *axes[3] = { &xs, &ys, &zs };
+	double widest = -1;
+	uint32_t axis = 0;
+	for (uint32_t i = 0; i < 3; i++) {
+		const std::vector<double> &values = *axes[i];
+		double low = values[order[begin]];
+		double high = low;
+		for (uint32_t j = begin + 1; j < end; j++) {
+			low = std::min(low, values[order[j]]);
+			high = std::max(high, values[order[j]]);
+		}
+		if (high - low > widest) {
+			widest = high - low;
+			axis = i;
+		}
+	}
+
+	const std::vector<double> &values = *axes[axis];
+	uint32_t middle = begin + (end - begin) / 2;
+	std::nth_element(order.begin() + begin, order.begin() + middle,
+			order.begin() + end, [&values](uint32_t left, uint32_t right) {
+				return (values[left] < values[right]);
+			});
+	nodes[index].axis = axis;
+	nodes[index].split = values[order[middle]];
+
+	build(order, begin, middle);
+	uint32_t right = build(order, middle, end);
+	nodes[index].right = right;
+	return (index);
+}
+
+void stationindex::measure(double latitude, double longitude,
+		const std::vector<uint32_t> &candidates,
+		std::vector<stationdistance> &results) const {
+	size_t size = candidates.size();
+	results.resize(size);
+	if (size == 0) {
+		return;
+	}
+
+	double query[3];
+	UnitVector(latitude, longitude, query);
+
+	// the local north and east directions at the query point
+	double phi = latitude * DEGREESTORADIANS;
+	double lambda = longitude * DEGREESTORADIANS;
+	double north[3] = { -std::sin(phi) * std::cos(lambda), -std::sin(phi)
+			* std::sin(lambda), std::cos(phi) };
+	double east[3] = { -std::sin(lambda), std::cos(lambda), 0 };
+
+	// gather the candidates, then measure them in straight loops
+	std::vector<double> x(size);
+	std::vector<double> y(size);
+	std::vector<double> z(size);
+	for (size_t i = 0; i < size; i++) {
+		x[i] = xs[candidates[i]];
+		y[i] = ys[candidates[i]];
+		z[i] = zs[candidates[i]];
+	}
+
+	std::vector<double> distances(size);
+	std::vector<double> azimuths(size);
+	for (size_t i = 0; i < size; i++) {
+		double dx = x[i] - query[0];
+		double dy = y[i] - query[1];
+		double dz = z[i] - query[2];
+		double halfchord = 0.5 * std::sqrt(dx * dx + dy * dy + dz * dz);
+		distances[i] = 2.0 * std::asin(std::min(halfchord, 1.0))
+				* RADIANSTODEGREES;
+	}
+	for (size_t i = 0; i < size; i++) {
+		double northward = x[i] * north[0] + y[i] * north[1] + z[i] * north[2];
+		double eastward = x[i] * east[0] + y[i] * east[1];
+		double azimuth = std::atan2(eastward, northward) * RADIANSTODEGREES;
+		azimuths[i] = (azimuth < 0) ? azimuth + 360.0 : azimuth;
+	}
+
+	for (size_t i = 0; i < size; i++) {
+		results[i].id = ids[candidates[i]];
+		results[i].distance = distances[i];
+		results[i].azimuth = azimuths[i];
+	}
+}
+}
@@ -0,0 +1,129 @@
+#include "stationinforesponder.h"
+
+#include "parsecontext.h"
+
+// JSON Keys
+#define INFORMATIONREQUESTOR_KEY "InformationRequestor"
+
+namespace detectionformats {
+
+stationinforesponder::stationinforesponder(
+		const stationinventory &newinventory, clock::duration newwindow)
+		: inventory(newinventory),
+			window(newwindow),
+			pending(0) {
+}
+
+bool stationinforesponder::add(const stationInfoRequest &request,
+		clock::time_point received) {
+	metrics.requests++;
+	if ((request.site.station.empty() == true)
+			|| (request.site.network.empty() == true)) {
+		metrics.invalid++;
+		return (false);
+	}
+
+	std::string key = stationinventory::makekey(request.site);
+	std::unordered_map<std::string, size_t>::iterator found = groupindex.find(
+			key);
+	if (found == groupindex.end()) {
+		found = groupindex.insert(std::make_pair(key, groups.size())).first;
+		groups.push_back(requestgroup());
+		groups.back().requestsite = request.site;
+	}
+
+	// a site has few requesters, so a scan finds duplicates quickly
+	std::vector<source> &requesters = groups[found->second].requesters;
+	for (size_t i = 0; i < requesters.size(); i++) {
+		if ((requesters[i].agencyid == request.source.agencyid)
+				&& (requesters[i].author == request.source.author)) {
+			metrics.coalesced++;
+			return (false);
+		}
+	}
+	requesters.push_back(request.source);
+
+	if (pending == 0) {
+		oldest = received;
+	}
+	pending++;
+	return (true);
+}
+
+bool stationinforesponder::isready(clock::time_point now) const {
+	return ((pending > 0) && (now - oldest >= window));
+}
+
+size_t stationinforesponder::poll(std::vector<std::string> &responses,
+		clock::time_point now) {
+	if (isready(now) == false) {
+		return (0);
+	}
+	return (flush(responses));
+}
+
+size_t stationinforesponder::flush(std::vector<std::string> &responses) {
+	parsecontext &context = parsecontext::local();
+
+	// each source is serialized once per flush, however many sites it asked
+	// for
+	std::unordered_map<std::string, std::string> sourcejson;
+	std::string body;
+	std::string requestor;
+
+	size_t count = 0;
+	for (size_t i = 0; i < groups.size(); i++) {
+		requestgroup &group = groups[i];
+		metrics.lookups++;
+		uint32_t id = inventory.find(group.requestsite);
+		if (id == stationinventory::npos) {
+			metrics.unknown += group.requesters.size();
+			continue;
+		}
+
+		// the station without a requestor, which is the last field written,
+		// so each response is this with its requestor added before the
+		// closing brace
+		stationInfo station = inventory.getstation(id);
+		context.serialize(station, body);
+		body.resize(body.length() - 1);
+
+		for (size_t j = 0; j < group.requesters.size(); j++) {
+			source &requester = group.requesters[j];
+			std::string sourcekey = requester.agencyid + "\n" + requester.author;
+			std::unordered_map<std::string, std::string>::iterator json =
+					sourcejson.find(sourcekey);
+			if (json == sourcejson.end()) {
+				context.serialize(requester, requestor);
+				json = sourcejson.insert(std::make_pair(sourcekey, requestor))
+						.first;
+			}
+
+			std::string response;
+			response.reserve(
+					body.length() + json->second.length()
+							+ sizeof(INFORMATIONREQUESTOR_KEY) + 5);
+			response += body;
+			response += ",\"" INFORMATIONREQUESTOR_KEY "\":";
+			response += json->second;
+			response += '}';
+			responses.push_back(std::move(response));
+			count++;
+		}
+	}
+
+	metrics.responses += count;
+	groups.clear();
+	groupindex.clear();
+	pending = 0;
+	return (count);
+}
+
+size_t stationinforesponder::getpending() const {
+	return (pending);
+}
+
+respondermetrics stationinforesponder::getmetrics() const {
+	return (metrics);
+}
+}
@@ -0,0 +1,635 @@
+#include "stationinventory.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cmath>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+#include "parsecontext.h"
+
+// JSON Keys
+#define TYPE_KEY "Type"
+
+// the flag bits
+#define ENABLEFLAG 1
+#define TELESEISMICFLAG 2
+
+// the separator between key fields
+#define KEYSEPARATOR '.'
+
+// snapshot identification, bump the version whenever the layout changes
+#define SNAPSHOTMAGIC "DFSTINV"
+#define SNAPSHOTVERSION 1
+#define SNAPSHOTBYTEORDER 0x01020304
+
+// snapshot sections start on cache line boundaries
+#define SNAPSHOTALIGNMENT 64
+
+// snapshot sections, in file order
+#define SLOTSECTION 0
+#define HASHSECTION 1
+#define LATITUDESECTION 2
+#define LONGITUDESECTION 3
+#define ELEVATIONSECTION 4
+#define QUALITYSECTION 5
+#define FLAGSECTION 6
+#define KEYOFFSETSECTION 7
+#define KEYSECTION 8
+#define SECTIONCOUNT 9
+
+namespace detectionformats {
+
+const uint32_t stationinventory::npos = 0xFFFFFFFF;
+
+// the snapshot file header
+struct SnapshotHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byteorder;
+	uint64_t count;
+	uint64_t tablesize;
+	uint64_t keybytes;
+	uint64_t size;
+	uint64_t checksum;
+	uint64_t reserved;
+};
+
+// hashes a site as its key would hash, without building the key
+static uint64_t HashSite(const std::string &station,
+		const std::string &channel, const std::string &network,
+		const std::string &location) {
+	const char separator = KEYSEPARATOR;
+	uint64_t hash = HashBytes(station);
+	hash = HashBytes(&separator, 1, hash);
+	hash = HashBytes(channel, hash);
+	hash = HashBytes(&separator, 1, hash);
+	hash = HashBytes(network, hash);
+	hash = HashBytes(&separator, 1, hash);
+	return (HashBytes(location, hash));
+}
+
+// checks whether key is the given site, without building the site's key
+static bool KeyMatches(const char *key, size_t length,
+		const std::string &station, const std::string &channel,
+		const std::string &network, const std::string &location) {
+	if (length
+			!= station.length() + channel.length() + network.length()
+					+ location.length() + 3) {
+		return (false);
+	}
+
+	const char *position = key;
+	const std::string *fields[] = { &station, &channel, &network, &location };
+	for (size_t i = 0; i < 4; i++) {
+		if (std::memcmp(position, fields[i]->data(), fields[i]->length())
+				!= 0) {
+			return (false);
+		}
+		position += fields[i]->length();
+		if ((i < 3) && (*position++ != KEYSEPARATOR)) {
+			return (false);
+		}
+	}
+	return (true);
+}
+
+// splits a key into its four fields, returning false if it has fewer
+static bool SplitKey(const char *key, size_t length, std::string fields[4]) {
+	const char *end = key + length;
+	for (size_t i = 0; i < 3; i++) {
+		const char *separator = static_cast<const char *>(std::memchr(key,
+				KEYSEPARATOR, end - key));
+		if (separator == NULL) {
+			return (false);
+		}
+		fields[i].assign(key, separator - key);
+		key = separator + 1;
+	}
+	fields[3].assign(key, end - key);
+	return (true);
+}
+
+// rounds offset up to the snapshot alignment
+static uint64_t AlignSection(uint64_t offset) {
+	uint64_t mask = SNAPSHOTALIGNMENT - 1;
+	return ((offset + mask) & ~mask);
+}
+
+// computes where each snapshot section starts, returning the file size
+static uint64_t SnapshotLayout(uint64_t count, uint64_t tablesize,
+		uint64_t keybytes, uint64_t offsets[SECTIONCOUNT]) {
+	uint64_t sizes[SECTIONCOUNT];
+	sizes[SLOTSECTION] = tablesize * sizeof(uint32_t);
+	sizes[HASHSECTION] = count * sizeof(uint64_t);
+	sizes[LATITUDESECTION] = count * sizeof(double);
+	sizes[LONGITUDESECTION] = count * sizeof(double);
+	sizes[ELEVATIONSECTION] = count * sizeof(double);
+	sizes[QUALITYSECTION] = count * sizeof(double);
+	sizes[FLAGSECTION] = count * sizeof(uint8_t);
+	sizes[KEYOFFSETSECTION] = (count + 1) * sizeof(uint32_t);
+	sizes[KEYSECTION] = keybytes;
+
+	uint64_t offset = AlignSection(sizeof(SnapshotHeader));
+	for (size_t i = 0; i < SECTIONCOUNT; i++) {
+		offsets[i] = offset;
+		offset = AlignSection(offset + sizes[i]);
+	}
+	return (offset);
+}
+
+stationinventory::stationinventory(size_t expected)
+		: mapping(NULL),
+			mappingsize(0) {
+	// keep the table at most half full
+	size_t capacity = 16;
+	while (capacity < expected * 2) {
+		capacity *= 2;
+	}
+	slots.assign(capacity, npos);
+	keyoffsets.assign(1, 0);
+
+	hashes.reserve(expected);
+	latitudes.reserve(expected);
+	longitudes.reserve(expected);
+	elevations.reserve(expected);
+	qualities.reserve(expected);
+	flags.reserve(expected);
+	keyoffsets.reserve(expected + 1);
+
+	attach();
+}
+
+stationinventory::~stationinventory() {
+	unmap();
+}
+
+uint32_t stationinventory::add(const stationInfo &station) {
+	// a mapped snapshot is read only
+	detach();
+
+	const site &stationsite = station.site;
+	uint64_t hash = HashSite(stationsite.station, stationsite.channel,
+			stationsite.network, stationsite.location);
+	size_t slot = findslot(hash, stationsite.station, stationsite.channel,
+			stationsite.network, stationsite.location);
+
+	uint32_t id = slots[slot];
+	if (id == npos) {
+		id = static_cast<uint32_t>(hashes.size());
+		slots[slot] = id;
+
+		hashes.push_back(hash);
+		keydata += makekey(stationsite);
+		keyoffsets.push_back(static_cast<uint32_t>(keydata.length()));
+		latitudes.push_back(0);
+		longitudes.push_back(0);
+		elevations.push_back(0);
+		qualities.push_back(0);
+		flags.push_back(0);
+
+		if (hashes.size() * 2 > slots.size()) {
+			grow();
+		}
+	}
+
+	latitudes[id] = station.latitude;
+	longitudes[id] = station.longitude;
+	elevations[id] = station.elevation;
+	qualities[id] = station.quality;
+	flags[id] = ((station.enable == true) ? ENABLEFLAG : 0)
+			| ((station.useforteleseismic == true) ? TELESEISMICFLAG : 0);
+
+	// the arrays may have moved
+	attach();
+	return (id);
+}
+
+uint32_t stationinventory::find(const std::string &station,
+		const std::string &channel, const std::string &network,
+		const std::string &location) const {
+	uint64_t hash = HashSite(station, channel, network, location);
+	return (slotview[findslot(hash, station, channel, network, location)]);
+}
+
+uint32_t stationinventory::find(const site &newsite) const {
+	return (find(newsite.station, newsite.channel, newsite.network,
+			newsite.location));
+}
+
+uint32_t stationinventory::find(const std::string &key) const {
+	std::string fields[4];
+	if (SplitKey(key.data(), key.length(), fields) == false) {
+		return (npos);
+	}
+	return (find(fields[0], fields[1], fields[2], fields[3]));
+}
+
+void stationinventory::clear() {
+	unmap();
+
+	slots.assign(16, npos);
+	hashes.clear();
+	latitudes.clear();
+	longitudes.clear();
+	elevations.clear();
+	qualities.clear();
+	flags.clear();
+	keyoffsets.assign(1, 0);
+	keydata.clear();
+
+	attach();
+}
+
+size_t stationinventory::size() const {
+	return (count);
+}
+
+std::string stationinventory::getkey(uint32_t id) const {
+	return (std::string(keyview + keyoffsetview[id],
+			keyoffsetview[id + 1] - keyoffsetview[id]));
+}
+
+stationInfo stationinventory::getstation(uint32_t id) const {
+	stationInfo station;
+	std::string fields[4];
+	SplitKey(keyview + keyoffsetview[id],
+			keyoffsetview[id + 1] - keyoffsetview[id], fields);
+	station.site = site(fields[0], fields[1], fields[2], fields[3]);
+	station.latitude = latitudeview[id];
+	station.longitude = longitudeview[id];
+	station.elevation = elevationview[id];
+	station.quality = qualityview[id];
+	station.enable = isenabled(id);
+	station.useforteleseismic = isteleseismic(id);
+	return (station);
+}
+
+const double * stationinventory::getlatitudes() const {
+	return (latitudeview);
+}
+
+const double * stationinventory::getlongitudes() const {
+	return (longitudeview);
+}
+
+const double * stationinventory::getelevations() const {
+	return (elevationview);
+}
+
+const double * stationinventory::getqualities() const {
+	return (qualityview);
+}
+
+bool stationinventory::isenabled(uint32_t id) const {
+	return ((flagview[id] & ENABLEFLAG) != 0);
+}
+
+bool stationinventory::isteleseismic(uint32_t id) const {
+	return ((flagview[id] & TELESEISMICFLAG) != 0);
+}
+
+void stationinventory::save(const std::string &path) const {
+	uint64_t keybytes = keyoffsetview[count];
+	uint64_t offsets[SECTIONCOUNT];
+	uint64_t size = SnapshotLayout(count, tablesize, keybytes, offsets);
+
+	std::string snapshot(size, '\0');
+	char *data = &snapshot[0];
+	std::memcpy(data + offsets[SLOTSECTION], slotview,
+			tablesize * sizeof(uint32_t));
+	std::memcpy(data + offsets[HASHSECTION], hashview,
+			count * sizeof(uint64_t));
+	std::memcpy(data + offsets[LATITUDESECTION], latitudeview,
+			count * sizeof(double));
+	std::memcpy(data + offsets[LONGITUDESECTION], longitudeview,
+			count * sizeof(double));
+	std::memcpy(data + offsets[ELEVATIONSECTION], elevationview,
+			count * sizeof(double));
+	std::memcpy(data + offsets[QUALITYSECTION], qualityview,
+			count * sizeof(double));
+	std::memcpy(data + offsets[FLAGSECTION], flagview, count);
+	std::memcpy(data + offsets[KEYOFFSETSECTION], keyoffsetview,
+			(count + 1) * sizeof(uint32_t));
+	std::memcpy(data + offsets[KEYSECTION], keyview, keybytes);
+
+	SnapshotHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, SNAPSHOTMAGIC, sizeof(header.magic));
+	header.version = SNAPSHOTVERSION;
+	header.byteorder = SNAPSHOTBYTEORDER;
+	header.count = count;
+	header.tablesize = tablesize;
+	header.keybytes = keybytes;
+	header.size = size;
+	header.checksum = HashBytes(data + sizeof(header), size - sizeof(header));
+	std::memcpy(data, &header, sizeof(header));
+
+	// write beside the snapshot and rename over it, so that a reader never
+	// sees a partial file
+	std::string temporary = path + ".tmp";
+	FILE *file = std::fopen(temporary.c_str(), "wb");
+	if (file == NULL) {
+		throw std::runtime_error(
+				"open " + temporary + ": " + std::strerror(errno));
+	}
+	bool written = (std::fwrite(data, 1, size, file) == size);
+	written = (std::fclose(file) == 0) && (written == true);
+	if ((written == false)
+			|| (std::rename(temporary.c_str(), path.c_str()) != 0)) {
+		std::string error = std::strerror(errno);
+		std::remove(temporary.c_str());
+		throw std::runtime_error("write " + path + ": " + error);
+	}
+}
+
+bool stationinventory::loadsnapshot(const std::string &path) {
+#if defined(_WIN32)
+	(void) path;
+	return (false);
+#else
+	int descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (descriptor < 0) {
+		return (false);
+	}
+	struct stat status;
+	if ((fstat(descriptor, &status) < 0)
+			|| (static_cast<uint64_t>(status.st_size) < sizeof(SnapshotHeader))) {
+		close(descriptor);
+		return (false);
+	}
+	size_t size = static_cast<size_t>(status.st_size);
+	void *address = mmap(NULL, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+	if (address == MAP_FAILED) {
+		return (false);
+	}
+	const char *data = static_cast<const char *>(address);
+
+	// the header must match this build, and the body its checksum
+	SnapshotHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	uint64_t offsets[SECTIONCOUNT];
+	if ((std::memcmp(header.magic, SNAPSHOTMAGIC, sizeof(header.magic)) != 0)
+			|| (header.version != SNAPSHOTVERSION)
+			|| (header.byteorder != SNAPSHOTBYTEORDER)
+			|| (header.count >= npos) || (header.tablesize < 16)
+			|| ((header.tablesize & (header.tablesize - 1)) != 0)
+			|| (header.count * 2 > header.tablesize)
+			|| (header.size != size)
+			|| (SnapshotLayout(header.count, header.tablesize,
+					header.keybytes, offsets) != size)
+			|| (HashBytes(data + sizeof(header), size - sizeof(header))
+					!= header.checksum)) {
+		munmap(address, size);
+		return (false);
+	}
+
+	const uint32_t *newslots = reinterpret_cast<const uint32_t *>(data
+			+ offsets[SLOTSECTION]);
+	const uint64_t *newhashes = reinterpret_cast<const uint64_t *>(data
+			+ offsets[HASHSECTION]);
+	const double *newlatitudes = reinterpret_cast<const double *>(data
+			+ offsets[LATITUDESECTION]);
+	const double *newlongitudes = reinterpret_cast<const double *>(data
+			+ offsets[LONGITUDESECTION]);
+	const double *newelevations = reinterpret_cast<const double *>(data
+			+ offsets[ELEVATIONSECTION]);
+	const uint32_t *newkeyoffsets = reinterpret_cast<const uint32_t *>(data
+			+ offsets[KEYOFFSETSECTION]);
+	const char *newkeys = data + offsets[KEYSECTION];
+
+	// every station must be findable, and pass stationInfo validation
+	bool consistent = (newkeyoffsets[0] == 0)
+			&& (newkeyoffsets[header.count] == header.keybytes);
+	// each station in exactly one slot, before probing for any of them; a
+	// table with too few empty slots would never end a probe
+	std::vector<bool> placed(header.count, false);
+	size_t used = 0;
+	for (size_t i = 0; (i < header.tablesize) && (consistent == true);
+			i++) {
+		if (newslots[i] == npos) {
+			continue;
+		}
+		consistent = (newslots[i] < header.count)
+				&& (placed[newslots[i]] == false);
+		if (consistent == true) {
+			placed[newslots[i]] = true;
+			used++;
+		}
+	}
+	consistent = (consistent == true) && (used == header.count);
+	std::string fields[4];
+	for (size_t id = 0; (id < header.count) && (consistent == true); id++) {
+		uint32_t start = newkeyoffsets[id];
+		uint32_t end = newkeyoffsets[id + 1];
+		consistent = (start <= end) && (end <= header.keybytes)
+				&& (SplitKey(newkeys + start, end - start, fields) == true)
+				&& (HashBytes(newkeys + start, end - start) == newhashes[id])
+				&& (fields[0].empty() == false)
+				&& (fields[2].empty() == false)
+				&& (std::isnan(newlatitudes[id]) == false)
+				&& (newlatitudes[id] >= -90) && (newlatitudes[id] <= 90)
+				&& (std::isnan(newlongitudes[id]) == false)
+				&& (newlongitudes[id] >= -180) && (newlongitudes[id] <= 180)
+				&& (std::isnan(newelevations[id]) == false);
+		if (consistent == true) {
+			size_t mask = header.tablesize - 1;
+			size_t slot = static_cast<size_t>(newhashes[id]) & mask;
+			while ((newslots[slot] != npos) && (newslots[slot] != id)) {
+				slot = (slot + 1) & mask;
+			}
+			consistent = (newslots[slot] == id);
+		}
+	}
+	if (consistent == false) {
+		munmap(address, size);
+		return (false);
+	}
+
+	// use the snapshot in place
+	clear();
+	mapping = address;
+	mappingsize = size;
+	count = header.count;
+	tablesize = header.tablesize;
+	slotview = newslots;
+	hashview = newhashes;
+	latitudeview = newlatitudes;
+	longitudeview = newlongitudes;
+	elevationview = newelevations;
+	qualityview = reinterpret_cast<const double *>(data
+			+ offsets[QUALITYSECTION]);
+	flagview = reinterpret_cast<const uint8_t *>(data + offsets[FLAGSECTION]);
+	keyoffsetview = newkeyoffsets;
+	keyview = newkeys;
+	return (true);
+#endif
+}
+
+size_t stationinventory::loadjson(const std::string &path) {
+	FILE *file = std::fopen(path.c_str(), "rb");
+	if (file == NULL) {
+		throw std::runtime_error("open " + path + ": " + std::strerror(errno));
+	}
+	std::string contents;
+	char buffer[65536];
+	size_t length;
+	while ((length = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		contents.append(buffer, length);
+	}
+	std::fclose(file);
+
+	const char *position = contents.data();
+	const char *end = position + contents.length();
+	parsecontext &context = parsecontext::local();
+
+	size_t added = 0;
+	while (position < end) {
+		const char *newline = static_cast<const char *>(std::memchr(position,
+				'\n', end - position));
+		const char *lineend = (newline != NULL) ? newline : end;
+
+		parsecontext::document &document = context.parse(position,
+				lineend - position);
+		position = (newline != NULL) ? newline + 1 : end;
+		if ((document.HasParseError() == true)
+				|| (document.IsObject() == false)) {
+			continue;
+		}
+		rapidjson::Value::ConstMemberIterator type = document.FindMember(
+				TYPE_KEY);
+		if ((type == document.MemberEnd())
+				|| (IsJSONKey(type->value, STATIONINFO_TYPE) == false)) {
+			continue;
+		}
+
+		try {
+			stationInfo station(document);
+			if (station.isvalid() == true) {
+				add(station);
+				added++;
+			}
+		} catch (const std::exception &) {
+			// skip a station that does not convert
+		}
+	}
+
+	return (added);
+}
+
+bool stationinventory::load(const std::string &snapshotpath,
+		const std::string &jsonpath) {
+	if (loadsnapshot(snapshotpath) == true) {
+		return (true);
+	}
+
+	clear();
+	loadjson(jsonpath);
+
+	// a snapshot that cannot be written only costs the next start up time
+	try {
+		save(snapshotpath);
+	} catch (const std::exception &) {
+	}
+	return (false);
+}
+
+std::string stationinventory::makekey(const site &newsite) {
+	std::string key;
+	key.reserve(newsite.station.length() + newsite.channel.length()
+			+ newsite.network.length() + newsite.location.length() + 3);
+	key += newsite.station;
+	key += KEYSEPARATOR;
+	key += newsite.channel;
+	key += KEYSEPARATOR;
+	key += newsite.network;
+	key += KEYSEPARATOR;
+	key += newsite.location;
+	return (key);
+}
+
+size_t stationinventory::findslot(uint64_t hash, const std::string &station,
+		const std::string &channel, const std::string &network,
+		const std::string &location) const {
+	// linear probing, the table is never more than half full
+	size_t mask = tablesize - 1;
+	size_t slot = static_cast<size_t>(hash) & mask;
+	while (true) {
+		uint32_t id = slotview[slot];
+		if ((id == npos)
+				|| ((hashview[id] == hash)
+						&& (KeyMatches(keyview + keyoffsetview[id],
+								keyoffsetview[id + 1] - keyoffsetview[id],
+								station, channel, network, location) == true))) {
+			return (slot);
+		}
+		slot = (slot + 1) & mask;
+	}
+}
+
+void stationinventory::grow() {
+	slots.assign(slots.size() * 2, npos);
+
+	size_t mask = slots.size() - 1;
+	for (uint32_t id = 0; id < hashes.size(); id++) {
+		size_t slot = static_cast<size_t>(hashes[id]) & mask;
+		while (slots[slot] != npos) {
+			slot = (slot + 1) & mask;
+		}
+		slots[slot] = id;
+	}
+}
+
+void stationinventory::attach() {
+	slotview = slots.data();
+	hashview = hashes.data();
+	latitudeview = latitudes.data();
+	longitudeview = longitudes.data();
+	elevationview = elevations.data();
+	qualityview = qualities.data();
+	flagview = flags.data();
+	keyoffsetview = keyoffsets.data();
+	keyview = keydata.data();
+	tablesize = slots.size();
+	count = hashes.size();
+}
+
+void stationinventory::detach() {
+	if (mapping == NULL) {
+		return;
+	}
+
+	slots.assign(slotview, slotview + tablesize);
+	hashes.assign(hashview, hashview + count);
+	latitudes.assign(latitudeview, latitudeview + count);
+	longitudes.assign(longitudeview, longitudeview + count);
+	elevations.assign(elevationview, elevationview + count);
+	qualities.assign(qualityview, qualityview + count);
+	flags.assign(flagview, flagview + count);
+	keyoffsets.assign(keyoffsetview, keyoffsetview + count + 1);
+	keydata.assign(keyview, keyoffsetview[count]);
+
+	unmap();
+	attach();
+}
+
+void stationinventory::unmap() {
+	if (mapping == NULL) {
+		return;
+	}
+#if !defined(_WIN32)
+	munmap(mapping, mappingsize);
+#endif
+	mapping = NULL;
+	mappingsize = 0;
+}
+}
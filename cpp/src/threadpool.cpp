@@ -0,0 +1,212 @@
+#include "threadpool.h"
+
+#include <algorithm>
+#include <exception>
+
+// the number of chunks run() aims to give each worker, enough that a worker
+// that finishes early has something to steal
+#define CHUNKSPERTHREAD 8
+
+namespace detectionformats {
+
+// the pool the current thread is a worker of, and its queue, so that run()
+// called from inside a task runs tasks rather than blocking its worker
+static thread_local const threadpool *WorkerPool = NULL;
+static thread_local size_t WorkerIndex = 0;
+
+threadpool::threadpool(size_t threadcount)
+		: nextqueue(0),
+			queued(0),
+			pending(0),
+			stopping(false) {
+	if (threadcount == 0) {
+		threadcount = std::thread::hardware_concurrency();
+	}
+	if (threadcount == 0) {
+		threadcount = 1;
+	}
+
+	for (size_t i = 0; i < threadcount; i++) {
+		queues.push_back(std::unique_ptr<workqueue>(new workqueue()));
+	}
+
+	// start the workers once every queue exists, since they steal from each
+	// other's queues
+	for (size_t i = 0; i < threadcount; i++) {
+		threads.push_back(std::thread(&threadpool::work, this, i));
+	}
+}
+
+threadpool::~threadpool() {
+	wait();
+
+	{
+		std::lock_guard<std::mutex> lock(statemutex);
+		stopping = true;
+	}
+	workavailable.notify_all();
+
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+}
+
+void threadpool::submit(std::function<void()> task) {
+	pending++;
+
+	workqueue &queue = *queues[nextqueue++ % queues.size()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+
+	// count the task under the state mutex so that a worker about to sleep
+	// cannot miss it
+	{
+		std::lock_guard<std::mutex> lock(statemutex);
+		queued++;
+	}
+	workavailable.notify_one();
+}
+
+void threadpool::run(size_t count, size_t chunksize,
+		const std::function<void(size_t, size_t)> &function) {
+	if (count == 0) {
+		return;
+	}
+
+	if (chunksize == 0) {
+		chunksize = std::max(static_cast<size_t>(1),
+				count / (threads.size() * CHUNKSPERTHREAD));
+	}
+
+	// track this run's chunks separately from any other submitted tasks
+	size_t chunks = (count + chunksize - 1) / chunksize;
+	size_t remaining = chunks;
+	std::exception_ptr error;
+	std::atomic<bool> failed(false);
+	std::mutex donemutex;
+	std::condition_variable done;
+
+	for (size_t begin = 0; begin < count; begin += chunksize) {
+		size_t end = std::min(count, begin + chunksize);
+		submit([&, begin, end]() {
+			// the first exception is kept for run() to rethrow, and the
+			// chunks not yet started are skipped
+			std::exception_ptr caught;
+			if (failed.load() == false) {
+				try {
+					function(begin, end);
+				} catch (...) {
+					caught = std::current_exception();
+				}
+			}
+
+			// count down under the mutex, so that run() cannot return and
+			// destroy it while this chunk is still signalling
+			std::lock_guard<std::mutex> lock(donemutex);
+			if ((caught) && (!error)) {
+				error = caught;
+				failed.store(true);
+			}
+			if (--remaining == 0) {
+				done.notify_all();
+			}
+		});
+	}
+
+	// a worker of this pool waiting would hold its thread while its chunks
+	// queue behind it, so it runs tasks until none are left to take, and
+	// only then waits for the chunks other workers are running
+	if (WorkerPool == this) {
+		while (true) {
+			{
+				std::lock_guard<std::mutex> lock(donemutex);
+				if (remaining == 0) {
+					break;
+				}
+			}
+			if (runtask(WorkerIndex) == false) {
+				break;
+			}
+		}
+	}
+
+	std::unique_lock<std::mutex> lock(donemutex);
+	done.wait(lock, [&remaining]() {return (remaining == 0);});
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+void threadpool::wait() {
+	std::unique_lock<std::mutex> lock(statemutex);
+	workfinished.wait(lock, [this]() {return (pending.load() == 0);});
+}
+
+size_t threadpool::size() const {
+	return (threads.size());
+}
+
+void threadpool::work(size_t index) {
+	WorkerPool = this;
+	WorkerIndex = index;
+
+	while (true) {
+		if (runtask(index) == true) {
+			continue;
+		}
+
+		// nothing to run or steal, sleep until a task is submitted
+		std::unique_lock<std::mutex> lock(statemutex);
+		workavailable.wait(lock,
+				[this]() {return ((stopping == true) || (queued.load() > 0));});
+		if ((stopping == true) && (queued.load() == 0)) {
+			return;
+		}
+	}
+}
+
+bool threadpool::runtask(size_t index) {
+	std::function<void()> task;
+	if (take(index, task) == false) {
+		return (false);
+	}
+	task();
+
+	if (--pending == 0) {
+		std::lock_guard<std::mutex> lock(statemutex);
+		workfinished.notify_all();
+	}
+	return (true);
+}
+
+bool threadpool::take(size_t index, std::function<void()> &task) {
+	// newest task from our own queue first, it is the most likely to still
+	// be in cache
+	{
+		workqueue &queue = *queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tasks.empty() == false) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			queued--;
+			return (true);
+		}
+	}
+
+	// then steal the oldest task from another worker
+	for (size_t i = 1; i < queues.size(); i++) {
+		workqueue &queue = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tasks.empty() == false) {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			queued--;
+			return (true);
+		}
+	}
+
+	return (false);
+}
+}
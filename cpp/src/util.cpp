@@ -1,5 +1,11 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <regex>
 #include "util.h"
+#include "rapidjson/encodedstream.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
 
 #if defined(_MSC_VER)
 #define _CRT_SECURE_NO_WARNINGS
@@ -11,35 +17,100 @@ namespace detectionformats
 {
 	////////////// functions //////////////
 
-	int GetDetectionType(std::string jsonstring)
+	/**
+	* \brief SAX handler finding the top level Type of a message
+	*
+	* Records the first string value of the Type member of the top level
+	* object, so the type is found without building a document
+	*/
+	struct typehandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, typehandler>
 	{
-		rapidjson::Document jsondocument;
+		typehandler() : depth(0), istype(false), isobject(false), found(false) {}
 
-		// parse the json into a document
-		if (jsondocument.Parse(jsonstring.c_str()).HasParseError())
+		bool Default()
 		{
-			return(formattypes::unknown);
+			istype = false;
+			return (true);
 		}
 
-		// make sure we got valid json
-		if (jsondocument.IsObject() == false)
+		bool String(const char *value, rapidjson::SizeType length, bool)
 		{
-			return(formattypes::unknown);
+			if ((istype == true) && (found == false))
+			{
+				type.assign(value, length);
+				found = true;
+			}
+			istype = false;
+			return (true);
 		}
 
-		// Type
-		if (jsondocument.HasMember(TYPE_KEY) == true)
+		bool Key(const char *key, rapidjson::SizeType length, bool)
+		{
+			istype = (depth == 1) && (length == sizeof(TYPE_KEY) - 1) && (memcmp(key, TYPE_KEY, length) == 0);
+			return (true);
+		}
+
+		bool StartObject()
 		{
-			// check type
-			if (jsondocument[TYPE_KEY].IsString() == false)
+			if (depth == 0)
 			{
-				return(formattypes::unknown);
+				isobject = true;
 			}
+			istype = false;
+			depth++;
+			return (true);
+		}
+
+		bool EndObject(rapidjson::SizeType)
+		{
+			depth--;
+			return (true);
+		}
 
-			// get type string
-			std::string typestring = std::string(jsondocument[TYPE_KEY].GetString(), jsondocument[TYPE_KEY].GetStringLength());
+		bool StartArray()
+		{
+			istype = false;
+			depth++;
+			return (true);
+		}
+
+		bool EndArray(rapidjson::SizeType)
+		{
+			depth--;
+			return (true);
+		}
+
+		int depth;
+		bool istype;
+		bool isobject;
+		bool found;
+		std::string type;
+	};
+
+	int GetDetectionType(std::string jsonstring)
+	{
+		// scan the json for the type rather than building a document, the
+		// whole message is still checked so that invalid json is unknown
+		typehandler handler;
+		rapidjson::Reader reader;
+		rapidjson::MemoryStream memory(jsonstring.c_str(), jsonstring.length());
+		rapidjson::EncodedInputStream<rapidjson::UTF8<>, rapidjson::MemoryStream> stream(memory);
+		if (reader.Parse(stream, handler).IsError())
+		{
+			return(formattypes::unknown);
+		}
+
+		// make sure we got valid json
+		if (handler.isobject == false)
+		{
+			return(formattypes::unknown);
+		}
 
+		// Type
+		if (handler.found == true)
+		{
 			// return appropriate type
+			const std::string &typestring = handler.type;
 			if (typestring == PICK_TYPE)
 				return(formattypes::picktype);
 			else if (typestring == CORRELATION_TYPE)
@@ -166,129 +237,107 @@ namespace detectionformats
 		return(true);
 	}
 
-    // Space where environment variable TZ will be
-    // stored after the first call to ConvertISO8601ToEpochTime()
-    #define MAXENV 128
-    char    envTZ[MAXENV];
+	// days since 1970-01-01 of a proleptic gregorian calendar date, month
+	// must be from 1 to 12, day may be outside the month and is counted
+	// linearly
+	static int64_t DaysFromCivil(int64_t year, int month, int day)
+	{
+		year -= (month <= 2) ? 1 : 0;
+		int64_t era = ((year >= 0) ? year : year - 399) / 400;
+		int64_t yearofera = year - (era * 400);
+		int64_t dayofyear = ((153 * (month + ((month > 2) ? -3 : 9))) + 2) / 5
+			+ day - 1;
+		int64_t dayofera = (yearofera * 365) + (yearofera / 4)
+			- (yearofera / 100) + dayofyear;
+		return((era * 146097) + dayofera - 719468);
+	}
+
+	// proleptic gregorian calendar date of a count of days since 1970-01-01
+	static void CivilFromDays(int64_t days, int &year, int &month, int &day)
+	{
+		days += 719468;
+		int64_t era = ((days >= 0) ? days : days - 146096) / 146097;
+		int64_t dayofera = days - (era * 146097);
+		int64_t yearofera = (dayofera - (dayofera / 1460) + (dayofera / 36524)
+			- (dayofera / 146096)) / 365;
+		int64_t dayofyear = dayofera - ((365 * yearofera) + (yearofera / 4)
+			- (yearofera / 100));
+		int64_t monthindex = ((5 * dayofyear) + 2) / 153;
+
+		day = static_cast<int>(dayofyear - (((153 * monthindex) + 2) / 5) + 1);
+		month = static_cast<int>((monthindex < 10) ? monthindex + 3 : monthindex - 9);
+		year = static_cast<int>(yearofera + (era * 400) + ((month <= 2) ? 1 : 0));
+	}
+
+	// parses count decimal digits starting at buffer, stopping at the first
+	// non-digit the same way atoi would
+	static int ParseISO8601Digits(const char *buffer, int count)
+	{
+		int value = 0;
+		for (int i = 0; i < count; i++)
+		{
+			if ((buffer[i] < '0') || (buffer[i] > '9'))
+				break;
+			value = (value * 10) + (buffer[i] - '0');
+		}
+		return(value);
+	}
+
 	double ConvertISO8601ToEpochTime(std::string TimeString)
+	{
+		return(ConvertISO8601ToEpochTime(TimeString.c_str(), TimeString.length()));
+	}
+
+	double ConvertISO8601ToEpochTime(const char *TimeBuffer, size_t TimeLength)
 	{
 		// make sure we got something
-		if (TimeString.length() == 0)
+		if ((TimeBuffer == NULL) || (TimeLength == 0))
 		{
 			return(-1.0);
 		}
 
 		// time string is too short
-		if (TimeString.length() < 24)
+		if (TimeLength < 24)
 		{
 			return(-1.0);
 		}
 
 		// time string is too long
-		if (TimeString.length() > 24)
+		if (TimeLength > 24)
 		{
 			return(-1.0);
 		}
 
-		struct tm timeinfo;
-		memset(&timeinfo, 0, sizeof(struct tm));
-
 		// Time string is in ISO8601 format:
 		// 000000000011111111112222
 		// 012345678901234567890123
 		// YYYY-MM-DDTHH:MM:SS.SSSZ
 
-		// year (0-3 in ISO8601 string)
-		// struct tm stores year as "current year minus 1900"
-		timeinfo.tm_year = atoi(TimeString.substr(0, 4).c_str()) - 1900;
-
-		// month (5-6 in ISO8601 string)
-		// struct tm stores month  as number from 0 to 11, January = 0
-		timeinfo.tm_mon = atoi(TimeString.substr(5, 2).c_str()) - 1;
-
-		// day (8-9 in ISO8601 string)
-		timeinfo.tm_mday = atoi(TimeString.substr(8, 2).c_str());
-
-		// hour (11-12 in ISO8601 string)
-		timeinfo.tm_hour = atoi(TimeString.substr(11, 2).c_str());
-
-		// minute (14-15 in ISO8601 string)
-		timeinfo.tm_min = atoi(TimeString.substr(14, 2).c_str());
-
-		// decimal seconds (17-22 in ISO8601 string)
-		double seconds = atof(TimeString.substr(17, 6).c_str());
-
-#ifdef _WIN32
-        // windows specific timezone handling
-        char * pTZ;
-        char szTZExisting[32] = "TZ=";
-
-        // Save current TZ setting locally
-        pTZ = getenv("TZ");
-
-        if(pTZ)
-        {
-            /* remember we have "TZ=" stored as the first 3 chars of the array */
-            strncpy(&szTZExisting[3], pTZ, sizeof(szTZExisting) - 4);
-            szTZExisting[sizeof(szTZExisting)-1] = 0x00;
-        }
-
-        // Change time zone to GMT
-        _putenv("TZ=UTC");
-
-        // set the timezone-offset to 0
-        _timezone = 0;
-
-        // set the DST-offset to 0
-        _daylight = 0;
-
-        // ensure _tzset() has been called, so that it isn't called again.
-        _tzset();
-
-        // convert to epoch time
-        double usableTime = double(mktime(&timeinfo));
-
-        // Restore original TZ setting
-        _putenv(szTZExisting);
-        _tzset();
-
-#else
-        // linux and other timezone handling
-        char  *tz;
-        char   TZorig[MAXENV];
-
-        // Save current TZ setting locally
-        tz = getenv("TZ");
-        if( tz != (char *) NULL )
-        {
-            if( strlen(tz) > MAXENV-4 )
-            {
-                printf("ConvertISO8601ToEpochTime: unable to store current TZ environment variable.\n");
-                return( -1 );
-            }
-        }
-        sprintf( TZorig, "TZ=%s", tz );
-
-        // Change time zone to GMT
-        sprintf( envTZ, "TZ=GMT" );
-        if( putenv( envTZ ) != 0 )
-        {
-            printf("ConvertISO8601ToEpochTime: putenv: unable to set TZ environment variable.\n" );
-            return( -1 );
-        }
-
-        // convert to epoch time
-        double usableTime = double(mktime(&timeinfo));
-
-        // Restore original TZ setting
-        sprintf( envTZ, "%s", TZorig );
-        if( putenv( envTZ ) != 0 )
-        {
-            printf("ConvertISO8601ToEpochTime: putenv: unable to restore TZ environment variable.\n" );
-        }
-        tzset();
-
-#endif
+		// the conversion is done arithmetically in UTC rather than with
+		// mktime, which depends on (and would require changing) the process
+		// wide TZ environment, so that this function is thread safe
+		int year = ParseISO8601Digits(&TimeBuffer[0], 4);
+		int month = ParseISO8601Digits(&TimeBuffer[5], 2);
+		int day = ParseISO8601Digits(&TimeBuffer[8], 2);
+		int hour = ParseISO8601Digits(&TimeBuffer[11], 2);
+		int minute = ParseISO8601Digits(&TimeBuffer[14], 2);
+
+		// decimal seconds (17-22 in ISO8601 string), copied to a null
+		// terminated stack buffer for atof
+		char secondsbuffer[7];
+		memcpy(secondsbuffer, &TimeBuffer[17], 6);
+		secondsbuffer[6] = 0x00;
+		double seconds = atof(secondsbuffer);
+
+		// normalize out of range months into the year the same way mktime
+		// would
+		int monthindex = month - 1;
+		int yearoffset = (monthindex >= 0) ? monthindex / 12 : ((monthindex + 1) / 12) - 1;
+		year += yearoffset;
+		month = monthindex - (yearoffset * 12) + 1;
+
+		int64_t days = DaysFromCivil(year, month, day);
+		double usableTime = double((days * 86400) + (hour * 3600) + (minute * 60));
 
 		// add decimal seconds and return
 		return (usableTime + seconds);
@@ -296,22 +345,39 @@ namespace detectionformats
 
 	std::string ConvertEpochTimeToISO8601(double epochtime)
 	{
-		time_t time = (int)epochtime;
+		int64_t time = (int)epochtime;
 		double decimalseconds = epochtime - (int)time;
 
-		// build the time portion, all but the seconds which are
-		// seperate since time_t can't do decimal seconds
-		char timebuf[sizeof "2011-10-08T07:07:"];
-		tm* timestruct = gmtime(&time);
-		strftime(timebuf, sizeof timebuf, "%Y-%m-%dT%H:%M:", timestruct);
+		// split into days and seconds of the day, rounding the days down so
+		// that times before the epoch land in the previous day
+		int64_t days = time / 86400;
+		int64_t secondofday = time % 86400;
+		if (secondofday < 0)
+		{
+			secondofday += 86400;
+			days--;
+		}
+
+		int year, month, day;
+		CivilFromDays(days, year, month, day);
+		int hour = static_cast<int>(secondofday / 3600);
+		int minute = static_cast<int>((secondofday % 3600) / 60);
+		int second = static_cast<int>(secondofday % 60);
+
+		// build the time portion, all but the seconds which are seperate
+		// since they include decimal seconds, gmtime is not used since its
+		// static result is shared between threads
+		char timebuf[sizeof "-2147483648-10-08T07:07:"];
+		snprintf(timebuf, sizeof timebuf, "%04d-%02d-%02dT%02d:%02d:", year,
+			month, day, hour, minute);
 		std::string timestring = timebuf;
 
 		// build the seconds portion
 		char secbuf[sizeof "00.000Z"];
-		if ((timestruct->tm_sec + decimalseconds) < 10)
-			sprintf(secbuf, "0%1.3f", timestruct->tm_sec + decimalseconds);
+		if ((second + decimalseconds) < 10)
+			sprintf(secbuf, "0%1.3f", second + decimalseconds);
 		else
-			sprintf(secbuf, "%2.3f", timestruct->tm_sec + decimalseconds);
+			sprintf(secbuf, "%2.3f", second + decimalseconds);
 		std::string secondsstring = secbuf;
 
 		// return the combined ISO8601 string
@@ -334,9 +400,14 @@ namespace detectionformats
 	}
 
 	rapidjson::Document & FromJSONString(std::string jsonstring, rapidjson::Document & jsondocument)
+	{
+		return(FromJSONString(jsonstring.c_str(), jsonstring.length(), jsondocument));
+	}
+
+	rapidjson::Document & FromJSONString(const char *jsonbuffer, size_t length, rapidjson::Document & jsondocument)
 	{
 		// parse the json into a document
-		if (jsondocument.Parse(jsonstring.c_str()).HasParseError())
+		if (jsondocument.Parse(jsonbuffer, length).HasParseError())
 		{
 			throw std::invalid_argument("Error parsing JSON string into document.");
 		}
@@ -353,4 +424,8 @@ namespace detectionformats
 		}
 	}
 
+	std::runtime_error SystemError(const std::string &what)
+	{
+		return (std::runtime_error(what + ": " + std::strerror(errno)));
+	}
 }
@@ -0,0 +1,112 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// test data
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\",\"Polarity\":\"up\",\"Onset\":\"questionable\",\"Picker\":\"manual\",\"Filter\":[{\"HighPass\":1.05,\"LowPass\":2.65},{\"HighPass\":2.10,\"LowPass\":3.58}],\"Amplitude\":{\"Amplitude\":21.5,\"Period\":2.65,\"SNR\":3.8},\"Beam\":{\"BackAzimuth\":2.65,\"Slowness\":1.44,\"PowerRatio\":12.18,\"BackAzimuthError\":3.8,\"SlownessError\":0.4,\"PowerRatioError\":0.557},\"AssociationInfo\":{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}}"
+#define PICKSTRING2 "{\"Type\":\"Pick\",\"ID\":\"99ABC12345678901234567890\",\"Site\":{\"Station\":\"KNB\",\"Network\":\"UU\",\"Channel\":\"EHZ\",\"Location\":\"--\"},\"Source\":{\"AgencyID\":\"UU\",\"Author\":\"AnotherTestAuthor\"},\"Time\":\"2016-01-04T11:02:09.550Z\",\"Phase\":\"S\",\"Filter\":[{\"HighPass\":0.5,\"LowPass\":8.0}]}"
+#define CORRELATIONSTRING "{\"ZScore\":33.67,\"Site\":{\"Station\":\"BMN\",\"Channel\":\"HHZ\",\"Network\":\"LB\",\"Location\":\"01\"},\"Magnitude\":2.14,\"Type\":\"Correlation\",\"Correlation\":2.65,\"EventType\":\"earthquake\",\"AssociationInfo\":{\"Distance\":0.442559,\"Azimuth\":0.418479,\"Phase\":\"P\",\"Sigma\":0.086333,\"Residual\":-0.025393},\"DetectionThreshold\":1.5,\"Source\":{\"Author\":\"TestAuthor\",\"AgencyID\":\"US\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Hypocenter\":{\"TimeError\":1.984,\"Time\":\"2015-12-28T21:30:44.039Z\",\"LongitudeError\":22.64,\"LatitudeError\":12.5,\"DepthError\":2.44,\"Latitude\":40.3344,\"Longitude\":-121.44,\"Depth\":32.44},\"SNR\":3.8,\"ID\":\"12GFH48776857\",\"ThresholdType\":\"minimum\",\"Phase\":\"P\"}"
+
+#define ITERATIONS 1000
+
+// global allocation counter, operator new is replaced for this executable
+// only, every form of it so that each allocation is freed by its match, and
+// counts while countallocations is set
+static std::atomic<bool> countallocations(false);
+static std::atomic<long> allocationcount(0);
+
+// allocates size bytes, counting the allocation
+static void * CountedAllocate(std::size_t size) noexcept {
+	if (countallocations == true) {
+		allocationcount++;
+	}
+	return (std::malloc(size > 0 ? size : 1));
+}
+
+void * operator new(std::size_t size) {
+	void * pointer = CountedAllocate(size);
+	if (pointer == NULL) {
+		throw std::bad_alloc();
+	}
+	return (pointer);
+}
+
+void * operator new[](std::size_t size) {
+	return (operator new(size));
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept {
+	return (CountedAllocate(size));
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+	return (CountedAllocate(size));
+}
+
+void operator delete(void * pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void * pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void * pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void * pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void * pointer, const std::nothrow_t &) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void * pointer, const std::nothrow_t &) noexcept {
+	std::free(pointer);
+}
+
+// tests to see if the parser does no heap allocation once the pool has
+// reached its steady state
+TEST(PoolTest, SteadyStateAllocation) {
+	detectionformats::pickpool pickpool(4);
+	detectionformats::correlationpool correlationpool(4);
+	std::string pickstring = std::string(PICKSTRING);
+	std::string pickstring2 = std::string(PICKSTRING2);
+	std::string correlationstring = std::string(CORRELATIONSTRING);
+
+	// warm up, letting every pooled object grow to fit the messages
+	for (int i = 0; i < 8; i++) {
+		pickpool.release(
+				pickpool.acquire(pickstring.c_str(), pickstring.length()));
+		pickpool.release(
+				pickpool.acquire(pickstring2.c_str(), pickstring2.length()));
+		correlationpool.release(
+				correlationpool.acquire(correlationstring.c_str(),
+						correlationstring.length()));
+	}
+
+	allocationcount = 0;
+	countallocations = true;
+
+	for (int i = 0; i < ITERATIONS; i++) {
+		const std::string & message = (i % 2 == 0) ? pickstring : pickstring2;
+		detectionformats::pick * pickobject = pickpool.acquire(
+				message.c_str(), message.length());
+		detectionformats::correlation * correlationobject =
+				correlationpool.acquire(correlationstring.c_str(),
+						correlationstring.length());
+
+		pickpool.release(pickobject);
+		correlationpool.release(correlationobject);
+	}
+
+	countallocations = false;
+
+	ASSERT_EQ(allocationcount.load(), 0)<< "Steady state parse allocated.";
+}
@@ -0,0 +1,163 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#if !defined(_WIN32)
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\"}"
+#define RETRACTSTRING "{\"Type\":\"Retract\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define BADSTRING "{\"Type\":"
+
+// a small block size so that lines span blocks
+#define BLOCKSIZE 64
+#define DEPTH 3
+
+// writes contents to a new temporary file and returns its path
+static std::string writearchive(const std::string &contents) {
+	std::string path = "/tmp/detectionformats-archive-test-"
+			+ std::to_string(getpid()) + ".json";
+	FILE *file = std::fopen(path.c_str(), "wb");
+	std::fwrite(contents.data(), 1, contents.length(), file);
+	std::fclose(file);
+	return (path);
+}
+
+// reads every line of the archive at path with next()
+static std::vector<std::string> readlines(const std::string &path,
+		bool useuring) {
+	detectionformats::archivereader reader(path, BLOCKSIZE, DEPTH, useuring);
+
+	std::vector<std::string> lines;
+	std::string region;
+	const char *data;
+	size_t length;
+	while (reader.next(data, length) == true) {
+		region.append(data, length);
+	}
+
+	size_t start = 0;
+	while (start < region.length()) {
+		size_t end = region.find('\n', start);
+		if (end == std::string::npos) {
+			end = region.length();
+		}
+		lines.push_back(region.substr(start, end - start));
+		start = end + 1;
+	}
+	return (lines);
+}
+
+// tests that every line is read, whole, in order
+TEST(ArchiveReaderTest, Lines) {
+	std::vector<std::string> expected;
+	std::string contents;
+	for (size_t i = 0; i < 20; i++) {
+		// lines both shorter and several times longer than a block
+		std::string line = std::to_string(i) + ":"
+				+ std::string((i * 37) % 200, 'a' + (i % 26));
+		expected.push_back(line);
+		contents += line + "\n";
+	}
+	// the last line need not end with a newline
+	expected.push_back("last");
+	contents += "last";
+
+	std::string path = writearchive(contents);
+
+	std::vector<std::string> fallback = readlines(path, false);
+	ASSERT_EQ(expected.size(), fallback.size());
+	for (size_t i = 0; i < expected.size(); i++) {
+		ASSERT_EQ(expected[i], fallback[i]);
+	}
+
+	// the same lines whether or not io_uring is in use
+	std::vector<std::string> uring = readlines(path, true);
+	ASSERT_EQ(expected.size(), uring.size());
+	for (size_t i = 0; i < expected.size(); i++) {
+		ASSERT_EQ(expected[i], uring[i]);
+	}
+
+	std::remove(path.c_str());
+}
+
+// tests each region handed out ends on a line boundary
+TEST(ArchiveReaderTest, Regions) {
+	std::string contents;
+	for (size_t i = 0; i < 100; i++) {
+		contents += std::string(PICKSTRING) + "\n";
+	}
+	std::string path = writearchive(contents);
+
+	detectionformats::archivereader reader(path, BLOCKSIZE * 16, DEPTH);
+	ASSERT_EQ(contents.length(), reader.size());
+
+	size_t total = 0;
+	const char *data;
+	size_t length;
+	while (reader.next(data, length) == true) {
+		ASSERT_GT(length, 0);
+		ASSERT_EQ('\n', data[length - 1]);
+		total += length;
+	}
+	ASSERT_EQ(contents.length(), total);
+
+	// at the end of the archive next() keeps returning false
+	ASSERT_FALSE(reader.next(data, length));
+
+	std::remove(path.c_str());
+}
+
+// tests reading messages
+TEST(ArchiveReaderTest, Messages) {
+	std::string contents = std::string(PICKSTRING) + "\n\n" + RETRACTSTRING
+			+ "\r\n" + BADSTRING + "\n" + PICKSTRING;
+	std::string path = writearchive(contents);
+
+	for (int useuring = 0; useuring < 2; useuring++) {
+		detectionformats::archivereader reader(path, BLOCKSIZE, DEPTH,
+				useuring == 1);
+
+		std::vector<int> types;
+		uint64_t errors = 0;
+		uint64_t count = reader.readmessages(
+				[&types, &errors](detectionformats::parseresult &result) {
+					if (result.isparsed() == false) {
+						errors++;
+						return;
+					}
+					types.push_back(result.type);
+				});
+
+		// the blank line is skipped
+		ASSERT_EQ(4, count);
+		ASSERT_EQ(1, errors);
+		ASSERT_EQ(3, types.size());
+		ASSERT_EQ(detectionformats::formattypes::picktype, types[0]);
+		ASSERT_EQ(detectionformats::formattypes::retracttype, types[1]);
+		ASSERT_EQ(detectionformats::formattypes::picktype, types[2]);
+	}
+
+	std::remove(path.c_str());
+}
+
+// tests an empty archive and a missing one
+TEST(ArchiveReaderTest, Empty) {
+	std::string path = writearchive("");
+	detectionformats::archivereader reader(path);
+
+	const char *data;
+	size_t length;
+	ASSERT_FALSE(reader.next(data, length));
+	ASSERT_EQ(0, reader.size());
+	std::remove(path.c_str());
+
+	ASSERT_THROW(detectionformats::archivereader missing(path),
+			std::runtime_error);
+}
+
+#endif
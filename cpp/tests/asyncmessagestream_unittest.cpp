@@ -0,0 +1,228 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\"}"
+#define RETRACTSTRING "{\"Type\":\"Retract\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define BADSTRING "{\"Type\":"
+
+// makes a socket pair with a non blocking reading end
+static void makestream(int descriptors[2]) {
+	socketpair(AF_UNIX, SOCK_STREAM, 0, descriptors);
+	fcntl(descriptors[0], F_SETFL, fcntl(descriptors[0], F_GETFL) | O_NONBLOCK);
+}
+
+// writes a string
+static void writestring(int descriptor, const std::string &data) {
+	ssize_t written = write(descriptor, data.data(), data.length());
+	(void) written;
+}
+
+// tests reading messages without waiting
+TEST(AsyncMessageStreamTest, TryNext) {
+	int descriptors[2];
+	makestream(descriptors);
+	detectionformats::messagestream stream(descriptors[0]);
+	ASSERT_EQ(descriptors[0], stream.getdescriptor());
+
+	detectionformats::parseresult result;
+	ASSERT_EQ(detectionformats::messagestream::wouldblock,
+			stream.trynext(result));
+
+	// a partial message is held until the rest arrives
+	std::string pick = PICKSTRING;
+	writestring(descriptors[1], pick.substr(0, 20));
+	ASSERT_EQ(detectionformats::messagestream::wouldblock,
+			stream.trynext(result));
+	writestring(descriptors[1],
+			pick.substr(20) + "\n\r\n" + RETRACTSTRING + "\n" + BADSTRING
+					+ "\n" + PICKSTRING);
+
+	ASSERT_EQ(detectionformats::messagestream::ready, stream.trynext(result));
+	ASSERT_EQ(detectionformats::formattypes::picktype, result.type);
+	ASSERT_EQ(detectionformats::messagestream::ready, stream.trynext(result));
+	ASSERT_EQ(detectionformats::formattypes::retracttype, result.type);
+	ASSERT_EQ(detectionformats::messagestream::ready, stream.trynext(result));
+	ASSERT_FALSE(result.isparsed());
+
+	// the last message has no newline, so needs the end of the stream
+	ASSERT_EQ(detectionformats::messagestream::wouldblock,
+			stream.trynext(result));
+	close(descriptors[1]);
+	ASSERT_EQ(detectionformats::messagestream::ready, stream.trynext(result));
+	ASSERT_EQ(detectionformats::formattypes::picktype, result.type);
+	ASSERT_EQ(detectionformats::messagestream::finished,
+			stream.trynext(result));
+
+	close(descriptors[0]);
+}
+
+// a waiter that reads a stream to its end from an eventloop
+class streamreader : public detectionformats::eventwaiter {
+public:
+	streamreader(detectionformats::eventloop &newloop, int descriptor)
+			: loop(newloop),
+				stream(descriptor),
+				messages(0),
+				finished(false) {
+	}
+
+	void ready() override {
+		detectionformats::parseresult result;
+		int status;
+		while ((status = stream.trynext(result))
+				== detectionformats::messagestream::ready) {
+			messages++;
+		}
+		if (status == detectionformats::messagestream::wouldblock) {
+			loop.watch(stream.getdescriptor(), *this);
+		} else {
+			finished = true;
+		}
+	}
+
+	detectionformats::eventloop &loop;
+	detectionformats::messagestream stream;
+	size_t messages;
+	bool finished;
+};
+
+// tests serving many streams from one eventloop thread
+TEST(AsyncMessageStreamTest, EventLoop) {
+	const size_t streamcount = 50;
+	const size_t messagecount = 20;
+
+	detectionformats::eventloop loop;
+	std::vector<int> writers;
+	std::vector<std::unique_ptr<streamreader>> readers;
+	for (size_t i = 0; i < streamcount; i++) {
+		int descriptors[2];
+		makestream(descriptors);
+		writers.push_back(descriptors[1]);
+		readers.push_back(std::unique_ptr<streamreader>(
+				new streamreader(loop, descriptors[0])));
+		loop.watch(descriptors[0], *readers.back());
+	}
+
+	// feed every stream a message at a time, in split writes
+	std::thread feeder([&writers]() {
+		std::string pick = std::string(PICKSTRING) + "\n";
+		for (size_t j = 0; j < messagecount; j++) {
+			for (size_t i = 0; i < writers.size(); i++) {
+				writestring(writers[i], pick.substr(0, 30));
+				writestring(writers[i], pick.substr(30));
+			}
+		}
+		for (size_t i = 0; i < writers.size(); i++) {
+			close(writers[i]);
+		}
+	});
+
+	// run() returns once every reader has seen the end of its stream
+	loop.run();
+	feeder.join();
+
+	for (size_t i = 0; i < readers.size(); i++) {
+		ASSERT_TRUE(readers[i]->finished);
+		ASSERT_EQ(messagecount, readers[i]->messages);
+		close(readers[i]->stream.getdescriptor());
+	}
+}
+
+// tests forgetting a descriptor, and stopping the loop
+TEST(AsyncMessageStreamTest, Forget) {
+	int descriptors[2];
+	makestream(descriptors);
+
+	detectionformats::eventloop loop;
+	streamreader reader(loop, descriptors[0]);
+	loop.watch(descriptors[0], reader);
+	loop.forget(descriptors[0]);
+
+	// nothing is watched, so run() returns at once
+	loop.run();
+	ASSERT_FALSE(reader.finished);
+
+	loop.watch(descriptors[0], reader);
+	loop.stop();
+	loop.run();
+	ASSERT_FALSE(reader.finished);
+
+	close(descriptors[0]);
+	close(descriptors[1]);
+}
+
+#ifdef DETECTION_HAVE_COROUTINES
+// reads a stream with co_await, counting the messages
+detectionformats::asynctask consume(
+		detectionformats::asyncmessagestream &stream, size_t &messages,
+		bool &finished) {
+	while (std::optional<detectionformats::parseresult> message =
+			co_await stream.next()) {
+		if (message->isparsed() == true) {
+			messages++;
+		}
+	}
+	finished = true;
+}
+
+// tests reading streams with coroutines
+TEST(AsyncMessageStreamTest, Coroutine) {
+	const size_t streamcount = 20;
+	const size_t messagecount = 10;
+
+	detectionformats::eventloop loop;
+	std::vector<int> writers;
+	std::vector<std::unique_ptr<detectionformats::asyncmessagestream>> streams;
+	std::vector<size_t> messages(streamcount, 0);
+	std::vector<int> descriptorlist;
+	for (size_t i = 0; i < streamcount; i++) {
+		int descriptors[2];
+		makestream(descriptors);
+		writers.push_back(descriptors[1]);
+		descriptorlist.push_back(descriptors[0]);
+		streams.push_back(std::unique_ptr<detectionformats::asyncmessagestream>(
+				new detectionformats::asyncmessagestream(loop,
+						descriptors[0])));
+	}
+
+	bool finished[streamcount];
+	for (size_t i = 0; i < streamcount; i++) {
+		finished[i] = false;
+		consume(*streams[i], messages[i], finished[i]);
+	}
+
+	std::thread feeder([&writers]() {
+		std::string pick = std::string(PICKSTRING) + "\n";
+		for (size_t j = 0; j < messagecount; j++) {
+			for (size_t i = 0; i < writers.size(); i++) {
+				writestring(writers[i], pick);
+			}
+		}
+		for (size_t i = 0; i < writers.size(); i++) {
+			close(writers[i]);
+		}
+	});
+
+	loop.run();
+	feeder.join();
+
+	for (size_t i = 0; i < streamcount; i++) {
+		ASSERT_TRUE(finished[i]);
+		ASSERT_EQ(messagecount, messages[i]);
+		close(descriptorlist[i]);
+	}
+}
+#endif
+
+#endif
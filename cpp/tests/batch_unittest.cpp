@@ -0,0 +1,109 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\"}"
+#define RETRACTSTRING "{\"Type\":\"Retract\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define STATIONINFOREQUESTSTRING "{\"Type\":\"StationInfoRequest\",\"Site\":{\"Station\":\"BOZ\",\"Channel\":\"BHZ\",\"Network\":\"US\",\"Location\":\"00\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define UNKNOWNSTRING "{\"Type\":\"Unknown\"}"
+#define BADSTRING "{\"Type\":"
+#define MESSAGECOUNT 500
+
+// tests to see if a mixed batch parses in order
+TEST(BatchTest, ParseBatch) {
+	std::vector<std::string> messages;
+	for (int i = 0; i < MESSAGECOUNT; i++) {
+		switch (i % 5) {
+			case 0:
+				messages.push_back(PICKSTRING);
+				break;
+			case 1:
+				messages.push_back(RETRACTSTRING);
+				break;
+			case 2:
+				messages.push_back(STATIONINFOREQUESTSTRING);
+				break;
+			case 3:
+				messages.push_back(UNKNOWNSTRING);
+				break;
+			default:
+				messages.push_back(BADSTRING);
+				break;
+		}
+	}
+
+	detectionformats::threadpool pool(4);
+	std::vector<detectionformats::parseresult> results =
+			detectionformats::ParseBatch(messages, pool);
+	ASSERT_EQ(results.size(), messages.size());
+
+	for (size_t i = 0; i < results.size(); i++) {
+		const detectionformats::parseresult &result = results[i];
+		switch (i % 5) {
+			case 0:
+				ASSERT_EQ(result.type, detectionformats::formattypes::picktype);
+				ASSERT_TRUE(result.isparsed());
+				ASSERT_STREQ(result.get<detectionformats::pick>()->phase.c_str(),
+						"P");
+				ASSERT_NEAR(result.get<detectionformats::pick>()->time,
+						1451338344.017, 0.0001);
+				ASSERT_TRUE(result.get<detectionformats::retract>() == NULL);
+				break;
+			case 1:
+				ASSERT_EQ(result.type,
+						detectionformats::formattypes::retracttype);
+				ASSERT_TRUE(result.get<detectionformats::retract>() != NULL);
+				break;
+			case 2:
+				ASSERT_EQ(result.type,
+						detectionformats::formattypes::stationinforequesttype);
+				ASSERT_STREQ(
+						result.get<detectionformats::stationInfoRequest>()->site
+								.station.c_str(),
+						"BOZ");
+				break;
+			default:
+				ASSERT_EQ(result.type, detectionformats::formattypes::unknown);
+				ASSERT_FALSE(result.isparsed());
+				ASSERT_FALSE(result.error.empty());
+				break;
+		}
+	}
+
+	// buffer overload
+	const char *buffers[] = { PICKSTRING, BADSTRING };
+	size_t lengths[] = { sizeof(PICKSTRING) - 1, sizeof(BADSTRING) - 1 };
+	results = detectionformats::ParseBatch(buffers, lengths, 2, pool);
+	ASSERT_TRUE(results[0].isparsed());
+	ASSERT_FALSE(results[1].isparsed());
+}
+
+// tests to see if a reused document is left empty by a failed parse
+TEST(BatchTest, ParseMessageReuse) {
+	rapidjson::Document document;
+	detectionformats::parseresult result;
+	detectionformats::ParseMessage(PICKSTRING, sizeof(PICKSTRING) - 1,
+			document, result);
+	ASSERT_TRUE(result.isparsed());
+	ASSERT_TRUE(document.IsObject());
+
+	detectionformats::parseresult badresult;
+	detectionformats::ParseMessage(BADSTRING, sizeof(BADSTRING) - 1,
+			document, badresult);
+	ASSERT_FALSE(badresult.isparsed());
+	ASSERT_TRUE(document.IsNull());
+	ASSERT_TRUE(document.HasParseError());
+
+	detectionformats::parseresult nullresult;
+	detectionformats::ParseMessage(NULL, 0, document, nullresult);
+	ASSERT_FALSE(nullresult.isparsed());
+	ASSERT_TRUE(document.IsNull());
+
+	// the document still parses after the failures
+	detectionformats::ParseMessage(RETRACTSTRING, sizeof(RETRACTSTRING) - 1,
+			document, result);
+	ASSERT_EQ(result.type, detectionformats::formattypes::retracttype);
+	ASSERT_STREQ(document["ID"].GetString(), "12GFH48776857");
+}
@@ -394,3 +394,27 @@ TEST(CorrelationTest, Validate) {
 	// check return code
 	ASSERT_EQ(result, false)<< "Tested for unsuccessful validation.";
 }
+
+// tests to see if correlation can successfully
+// be overwritten in place from json
+TEST(CorrelationTest, ResetFrom) {
+	// start from a correlation with stale values
+	detectionformats::correlation correlationobject;
+	correlationobject.id = std::string("stale");
+	correlationobject.thresholdtype = std::string("maximum");
+
+	std::string correlationstring = std::string(CORRELATIONSTRING);
+	rapidjson::Document correlationdocument;
+	correlationobject.resetfrom(correlationstring.c_str(),
+			correlationstring.length(), correlationdocument);
+
+	// check data values
+	checkdata(correlationobject, "Tested resetfrom");
+
+	// clear back to null values
+	correlationobject.clear();
+	ASSERT_STREQ(correlationobject.id.c_str(), "");
+	ASSERT_STREQ(correlationobject.type.c_str(), CORRELATION_TYPE);
+	ASSERT_TRUE(std::isnan(correlationobject.correlationvalue));
+	ASSERT_TRUE(correlationobject.associationinfo.isempty());
+}
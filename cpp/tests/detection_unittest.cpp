@@ -1,6 +1,7 @@
 #include "detection-formats.h"
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <string>
 
 // test data
@@ -345,3 +346,118 @@ TEST(DetectionTest, Validate) {
 	// check return code
 	ASSERT_EQ(result, false)<< "Tested for unsuccessful validation.";
 }
+
+// tests to see if copies of a detection share their data until modified
+TEST(DetectionTest, SharedData) {
+	rapidjson::Document detectiondocument;
+	detectionformats::detection detectionobject(
+			detectionformats::FromJSONString(std::string(DETECTIONSTRING),
+					detectiondocument));
+
+	// copy shares the picks and correlations
+	detectionformats::detection updateobject(detectionobject);
+	ASSERT_EQ(&updateobject.pickdata.shared(0),
+			&detectionobject.pickdata.shared(0));
+	ASSERT_EQ(&updateobject.correlationdata.shared(0),
+			&detectionobject.correlationdata.shared(0));
+	ASSERT_TRUE(updateobject.pickdata.isshared(0));
+
+	// serializing and validating does not copy
+	rapidjson::Document updatedocument;
+	detectionformats::ToJSONString(
+			updateobject.tojson(updatedocument,
+					updatedocument.GetAllocator()));
+	ASSERT_EQ(updateobject.geterrors().size(),
+			detectionobject.geterrors().size());
+	ASSERT_TRUE(updateobject.pickdata.isshared(0));
+
+	// modifying the copy does not change the original
+	updateobject.pickdata[0].phase = "S";
+	ASSERT_FALSE(updateobject.pickdata.isshared(0));
+	ASSERT_STREQ(updateobject.pickdata[0].phase.c_str(), "S");
+	ASSERT_STREQ(detectionobject.pickdata[0].phase.c_str(), "P");
+	ASSERT_EQ(&updateobject.correlationdata.shared(0),
+			&detectionobject.correlationdata.shared(0));
+
+	// the original is still valid
+	checkdata(detectionobject, "After modifying copy");
+}
+
+// tests to see if detection survives a binary round trip
+TEST(DetectionTest, Binary) {
+	rapidjson::Document detectiondocument;
+	detectionformats::detection detectionobject(
+			detectionformats::FromJSONString(std::string(DETECTIONSTRING),
+					detectiondocument));
+
+	std::string buffer;
+	detectionobject.tobinary(buffer);
+
+	detectionformats::detection detectionobject2;
+	ASSERT_EQ(detectionobject2.frombinary(buffer.data(), buffer.size()),
+			buffer.size());
+	ASSERT_TRUE(detectionobject2 == detectionobject);
+	ASSERT_EQ(detectionobject2.pickdata.size(), (size_t) 1);
+	ASSERT_EQ(detectionobject2.correlationdata.size(), (size_t) 1);
+	checkdata(detectionobject2, "");
+
+	detectionobject2.pickdata[0].phase = "S";
+	ASSERT_TRUE(detectionobject2 != detectionobject);
+}
+
+// tests to see if detection skips data entries that are not picks or
+// correlations
+TEST(DetectionTest, SkipsUnknownData) {
+	std::string detectionstring = "{\"Type\":\"Detection\","
+			"\"ID\":\"12GFH48776857\",\"Data\":[{\"Type\":\"Pick\","
+			"\"ID\":\"1\"},2,{\"Type\":\"Unknown\"},{\"Type\":3},{\"ID\":\"4\"},"
+			"{\"Type\":\"Correlation\",\"ID\":\"5\"},{\"Type\":\"Pick\","
+			"\"ID\":\"6\"}]}";
+
+	rapidjson::Document detectiondocument;
+	detectionformats::detection detectionobject(
+			detectionformats::FromJSONString(detectionstring,
+					detectiondocument));
+
+	ASSERT_EQ(detectionobject.pickdata.size(), (size_t) 2);
+	ASSERT_EQ(detectionobject.correlationdata.size(), (size_t) 1);
+	ASSERT_STREQ(detectionobject.pickdata[0].id.c_str(), "1");
+	ASSERT_STREQ(detectionobject.pickdata[1].id.c_str(), "6");
+	ASSERT_STREQ(detectionobject.correlationdata[0].id.c_str(), "5");
+}
+
+// tests to see if parallel validation matches serial validation
+TEST(DetectionTest, ParallelValidate) {
+	rapidjson::Document detectiondocument;
+	detectionformats::detection detectionobject(
+			detectionformats::FromJSONString(std::string(DETECTIONSTRING),
+					detectiondocument));
+
+	// grow the data to several hundred entries
+	for (int i = 0; i < 200; i++) {
+		detectionobject.pickdata.push_back(
+				detectionobject.pickdata.gethandle(0));
+		detectionobject.correlationdata.push_back(
+				detectionobject.correlationdata.gethandle(0));
+	}
+
+	detectionformats::threadpool pool(4);
+	ASSERT_TRUE(detectionobject.geterrors(pool) == detectionobject.geterrors());
+	ASSERT_EQ(detectionobject.isvalid(pool), detectionobject.isvalid());
+	ASSERT_EQ(detectionobject.isvalid(),
+			detectionobject.geterrors().empty());
+
+	// invalidate a few entries
+	detectionobject.pickdata[17].id = "";
+	detectionobject.correlationdata[5].id = "";
+	detectionobject.correlationdata[150].id = "";
+
+	std::vector<std::string> errors = detectionobject.geterrors(pool);
+	ASSERT_TRUE(errors == detectionobject.geterrors());
+	ASSERT_EQ(
+			std::count(errors.begin(), errors.end(),
+					std::string("Invalid pick in detection class.")),
+			1);
+	ASSERT_FALSE(detectionobject.isvalid(pool));
+	ASSERT_FALSE(detectionobject.isvalid());
+}
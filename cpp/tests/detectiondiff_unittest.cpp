@@ -0,0 +1,244 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+#include "testpicks.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#define PICKCOUNT 200
+
+// builds a correlation with the given id and value
+static detectionformats::correlation makediffcorrelation(std::string id,
+		double value) {
+	detectionformats::correlation newcorrelation;
+	newcorrelation.id = id;
+	newcorrelation.site = detectionformats::site("BMN", "HHZ", "LB", "01");
+	newcorrelation.source = detectionformats::source("US", "TestAuthor");
+	newcorrelation.phase = "P";
+	newcorrelation.time = 1000.0;
+	newcorrelation.correlationvalue = value;
+	return (newcorrelation);
+}
+
+// builds a detection with some picks
+static detectionformats::detection makediffdetection(int pickcount) {
+	detectionformats::detection newdetection;
+	newdetection.id = "12GFH48776857";
+	newdetection.source = detectionformats::source("US", "TestAuthor");
+	newdetection.hypocenter = detectionformats::hypocenter(40.3344, -121.44,
+			1000.0, 32.44, 12.5, 22.64, 2.44, 1.2);
+	newdetection.detectiontype = "New";
+	newdetection.detectiontime = 1010.0;
+	newdetection.bayes = 2.65;
+	for (int i = 0; i < pickcount; i++) {
+		newdetection.pickdata.push_back(
+				maketestpick("pick" + std::to_string(i), "BOZ", 1001.0 + i));
+	}
+	newdetection.correlationdata.push_back(makediffcorrelation("c0", 0.5));
+	return (newdetection);
+}
+
+// round trips a diff through json
+static detectionformats::detectiondiff jsondiff(
+		detectionformats::detectiondiff &diff) {
+	rapidjson::Document document;
+	diff.tojson(document, document.GetAllocator());
+	std::string json = detectionformats::ToJSONString(document);
+	rapidjson::Document parsed;
+	parsed.Parse(json.c_str());
+	return (detectionformats::detectiondiff(parsed));
+}
+
+// round trips a diff through its binary encoding
+static detectionformats::detectiondiff binarydiff(
+		const detectionformats::detectiondiff &diff) {
+	std::string buffer;
+	diff.tobinary(buffer);
+	detectionformats::detectiondiff decoded;
+	EXPECT_EQ(buffer.length(), decoded.frombinary(buffer.c_str(),
+			buffer.length()));
+	return (decoded);
+}
+
+// tests that equal versions make no changes
+TEST(DetectionDiffTest, Unchanged) {
+	detectionformats::detection olddetection = makediffdetection(3);
+	detectionformats::detection copy(olddetection);
+	detectionformats::detectiondiff diff(olddetection, copy);
+	ASSERT_TRUE(diff.empty());
+
+	// equal but not shared data is compared
+	detectionformats::detection rebuilt = makediffdetection(3);
+	ASSERT_TRUE(detectionformats::detectiondiff(olddetection, rebuilt).empty());
+	ASSERT_TRUE(diff.apply(olddetection) == olddetection);
+	ASSERT_TRUE(jsondiff(diff).empty());
+	ASSERT_TRUE(binarydiff(diff).empty());
+}
+
+// tests field changes
+TEST(DetectionDiffTest, Fields) {
+	detectionformats::detection olddetection = makediffdetection(3);
+	detectionformats::detection newdetection(olddetection);
+	newdetection.detectiontype = "Update";
+	newdetection.detectiontime = 1020.0;
+	newdetection.hypocenter.latitude = 40.5;
+	newdetection.hypocenter.time = 1000.5;
+	newdetection.bayes = std::nan("");
+	newdetection.eventtype = "earthquake";
+	newdetection.source = detectionformats::source("UW", "OtherAuthor");
+
+	detectionformats::detectiondiff diff(olddetection, newdetection);
+	ASSERT_FALSE(diff.empty());
+	ASSERT_TRUE(diff.ischanged(detectionformats::diffdetectiontype));
+	ASSERT_TRUE(diff.ischanged(detectionformats::difflatitude));
+	ASSERT_TRUE(diff.ischanged(detectionformats::diffbayes));
+	ASSERT_TRUE(diff.ischanged(detectionformats::diffsource));
+	ASSERT_FALSE(diff.ischanged(detectionformats::difflongitude));
+	ASSERT_FALSE(diff.ischanged(detectionformats::diffid));
+	ASSERT_TRUE(diff.picks.empty());
+	ASSERT_TRUE(diff.correlations.empty());
+
+	ASSERT_TRUE(diff.apply(olddetection) == newdetection);
+	ASSERT_TRUE(jsondiff(diff).apply(olddetection) == newdetection);
+	ASSERT_TRUE(binarydiff(diff).apply(olddetection) == newdetection);
+
+	// the bayes value becoming missing is a remove
+	rapidjson::Document document;
+	diff.tojson(document, document.GetAllocator());
+	std::string json = detectionformats::ToJSONString(document);
+	ASSERT_NE(std::string::npos,
+			json.find("{\"op\":\"remove\",\"path\":\"/Bayes\"}"));
+	ASSERT_NE(std::string::npos,
+			json.find("{\"op\":\"replace\",\"path\":\"/Hypocenter/Latitude\","
+					"\"value\":40.5}"));
+}
+
+// tests pick and correlation changes by id
+TEST(DetectionDiffTest, Data) {
+	detectionformats::detection olddetection = makediffdetection(5);
+	detectionformats::detection newdetection(olddetection);
+
+	// remove pick1, modify pick3, add two
+	detectionformats::detection rebuilt(olddetection);
+	rebuilt.pickdata.clear();
+	for (size_t i = 0; i < olddetection.pickdata.size(); i++) {
+		if (olddetection.pickdata.shared(i).id == "pick1") {
+			continue;
+		}
+		rebuilt.pickdata.push_back(olddetection.pickdata.gethandle(i));
+	}
+	rebuilt.pickdata[2].time = 2000.0;
+	rebuilt.pickdata.push_back(maketestpick("a/b~c", "BOZ", 1100.0));
+	rebuilt.pickdata.push_back(maketestpick("pick9", "BOZ", 1101.0));
+	rebuilt.correlationdata[0].correlationvalue = 0.75;
+	rebuilt.correlationdata.push_back(makediffcorrelation("c1", 0.4));
+	newdetection = rebuilt;
+
+	detectionformats::detectiondiff diff(olddetection, newdetection);
+	ASSERT_EQ(0u, diff.changed);
+	ASSERT_FALSE(diff.picks.replaced);
+	ASSERT_EQ(1, static_cast<int>(diff.picks.removed.size()));
+	ASSERT_STREQ("pick1", diff.picks.removed[0].c_str());
+	ASSERT_EQ(1, static_cast<int>(diff.picks.modified.size()));
+	ASSERT_STREQ("pick3", diff.picks.modified[0].id.c_str());
+	ASSERT_EQ(2, static_cast<int>(diff.picks.added.size()));
+	ASSERT_TRUE(diff.picks.order.empty());
+	ASSERT_EQ(1, static_cast<int>(diff.correlations.modified.size()));
+	ASSERT_EQ(1, static_cast<int>(diff.correlations.added.size()));
+
+	ASSERT_TRUE(diff.apply(olddetection) == newdetection);
+	ASSERT_TRUE(jsondiff(diff).apply(olddetection) == newdetection);
+	ASSERT_TRUE(binarydiff(diff).apply(olddetection) == newdetection);
+
+	// the ids are escaped in the paths
+	rapidjson::Document document;
+	diff.tojson(document, document.GetAllocator());
+	std::string json = detectionformats::ToJSONString(document);
+	ASSERT_NE(std::string::npos, json.find("\"/Data/Pick/a~1b~0c\""));
+
+	// the unchanged picks stay shared with the old version
+	detectionformats::detection applied = diff.apply(olddetection);
+	ASSERT_TRUE(applied.pickdata.gethandle(0)
+			== olddetection.pickdata.gethandle(0));
+}
+
+// tests reordered data
+TEST(DetectionDiffTest, Order) {
+	detectionformats::detection olddetection = makediffdetection(4);
+	detectionformats::detection newdetection(olddetection);
+	newdetection.pickdata.clear();
+	for (int i = 3; i >= 0; i--) {
+		newdetection.pickdata.push_back(olddetection.pickdata.gethandle(i));
+	}
+
+	detectionformats::detectiondiff diff(olddetection, newdetection);
+	ASSERT_TRUE(diff.picks.modified.empty());
+	ASSERT_EQ(4, static_cast<int>(diff.picks.order.size()));
+	ASSERT_TRUE(diff.apply(olddetection) == newdetection);
+	ASSERT_TRUE(jsondiff(diff).apply(olddetection) == newdetection);
+	ASSERT_TRUE(binarydiff(diff).apply(olddetection) == newdetection);
+}
+
+// tests data whose ids cannot be matched
+TEST(DetectionDiffTest, Replaced) {
+	detectionformats::detection olddetection = makediffdetection(2);
+	olddetection.pickdata.push_back(maketestpick("pick0", "BOZ", 1500.0));
+	detectionformats::detection newdetection(olddetection);
+	newdetection.pickdata[0].time = 1400.0;
+
+	detectionformats::detectiondiff diff(olddetection, newdetection);
+	ASSERT_TRUE(diff.picks.replaced);
+	ASSERT_EQ(3, static_cast<int>(diff.picks.added.size()));
+	ASSERT_TRUE(diff.apply(olddetection) == newdetection);
+	ASSERT_TRUE(jsondiff(diff).apply(olddetection) == newdetection);
+	ASSERT_TRUE(binarydiff(diff).apply(olddetection) == newdetection);
+}
+
+// tests changes that do not fit
+TEST(DetectionDiffTest, Invalid) {
+	detectionformats::detection olddetection = makediffdetection(3);
+	detectionformats::detection newdetection(olddetection);
+	newdetection.pickdata[1].time = 3000.0;
+	detectionformats::detectiondiff diff(olddetection, newdetection);
+
+	// applying to a version without the modified pick
+	ASSERT_THROW(diff.apply(makediffdetection(1)), std::invalid_argument);
+
+	// a truncated buffer
+	std::string buffer;
+	diff.tobinary(buffer);
+	detectionformats::detectiondiff decoded;
+	ASSERT_THROW(decoded.frombinary(buffer.c_str(), buffer.length() - 1),
+			std::invalid_argument);
+
+	// an unknown path or operation
+	rapidjson::Document document;
+	document.Parse("[{\"op\":\"replace\",\"path\":\"/Magnitude\","
+			"\"value\":1.0}]");
+	ASSERT_THROW(detectionformats::detectiondiff{document},
+			std::invalid_argument);
+	document.Parse("[{\"op\":\"move\",\"path\":\"/Bayes\"}]");
+	ASSERT_THROW(detectionformats::detectiondiff{document},
+			std::invalid_argument);
+	document.Parse("[{\"op\":\"replace\",\"path\":\"/Bayes\","
+			"\"value\":\"high\"}]");
+	ASSERT_THROW(detectionformats::detectiondiff{document},
+			std::invalid_argument);
+}
+
+// tests that a small update of a large detection diffs small
+TEST(DetectionDiffTest, Size) {
+	detectionformats::detection olddetection = makediffdetection(PICKCOUNT);
+	detectionformats::detection newdetection(olddetection);
+	newdetection.detectiontype = "Update";
+	newdetection.hypocenter.latitude = 40.4;
+	newdetection.pickdata.push_back(maketestpick("new", "BOZ", 1300.0));
+
+	std::string full;
+	newdetection.tobinary(full);
+	std::string changes;
+	detectionformats::detectiondiff(olddetection, newdetection).tobinary(
+			changes);
+	ASSERT_LT(changes.length() * 10, full.length());
+}
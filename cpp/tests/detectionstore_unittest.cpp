@@ -0,0 +1,230 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define THREADCOUNT 4
+#define PERTHREAD 5000
+#define VERSIONS 5
+
+// builds a detection message
+static detectionformats::detection makestoredetection(std::string id,
+		std::string type, double detectiontime, double origintime) {
+	detectionformats::detection newdetection;
+	newdetection.id = id;
+	newdetection.source = detectionformats::source("US", "TestAuthor");
+	newdetection.hypocenter = detectionformats::hypocenter(40.3344, -121.44,
+			origintime, 32.44, 12.5, 22.64, 2.44, 1.2);
+	newdetection.detectiontype = type;
+	newdetection.detectiontime = detectiontime;
+	return (newdetection);
+}
+
+// tests the lifecycle of a detection
+TEST(DetectionStoreTest, Lifecycle) {
+	detectionformats::detectionstore store;
+	detectionformats::detectiontypeindex state;
+	ASSERT_FALSE(store.getstate("A", state));
+	ASSERT_FALSE(store.find("A"));
+
+	ASSERT_TRUE(store.apply(makestoredetection("A", "New", 100.0, 90.0)));
+	ASSERT_TRUE(store.getstate("A", state));
+	ASSERT_EQ(detectionformats::newdetection, state);
+	ASSERT_DOUBLE_EQ(100.0, store.find("A")->detectiontime);
+
+	ASSERT_TRUE(store.apply(makestoredetection("A", "Update", 110.0, 91.0)));
+	ASSERT_TRUE(store.getstate("A", state));
+	ASSERT_EQ(detectionformats::update, state);
+	ASSERT_DOUBLE_EQ(91.0, store.find("A")->hypocenter.time);
+
+	// once final, only a Final or a retraction is applied
+	ASSERT_TRUE(store.apply(makestoredetection("A", "Final", 120.0, 91.5)));
+	ASSERT_FALSE(store.apply(makestoredetection("A", "Update", 130.0, 92.0)));
+	ASSERT_TRUE(store.apply(makestoredetection("A", "Final", 130.0, 91.6)));
+	ASSERT_TRUE(store.getstate("A", state));
+	ASSERT_EQ(detectionformats::final, state);
+
+	// once retracted, nothing is, and it is not found
+	ASSERT_TRUE(store.apply(makestoredetection("A", "Retract", 140.0, 91.6)));
+	ASSERT_FALSE(store.apply(makestoredetection("A", "Final", 150.0, 91.6)));
+	ASSERT_TRUE(store.getstate("A", state));
+	ASSERT_EQ(detectionformats::retractdetection, state);
+	ASSERT_FALSE(store.find("A"));
+	ASSERT_EQ(1, static_cast<int>(store.size()));
+
+	// no id or an unknown type
+	ASSERT_FALSE(store.apply(makestoredetection("", "New", 100.0, 90.0)));
+	ASSERT_FALSE(store.apply(makestoredetection("B", "Old", 100.0, 90.0)));
+
+	detectionformats::detectionstoremetrics metrics = store.getmetrics();
+	ASSERT_EQ(9u, metrics.messages);
+	ASSERT_EQ(1u, metrics.created);
+	ASSERT_EQ(1u, metrics.updated);
+	ASSERT_EQ(2u, metrics.finalized);
+	ASSERT_EQ(1u, metrics.retracted);
+	ASSERT_EQ(2u, metrics.stale);
+	ASSERT_EQ(2u, metrics.invalid);
+}
+
+// tests versions arriving out of order
+TEST(DetectionStoreTest, OutOfOrder) {
+	detectionformats::detectionstore store;
+
+	// an Update before its New creates the detection, and the New, being
+	// older, is then ignored
+	ASSERT_TRUE(store.apply(makestoredetection("A", "Update", 110.0, 91.0)));
+	ASSERT_FALSE(store.apply(makestoredetection("A", "New", 100.0, 90.0)));
+	ASSERT_FALSE(store.apply(makestoredetection("A", "Update", 105.0, 90.5)));
+	ASSERT_DOUBLE_EQ(110.0, store.find("A")->detectiontime);
+
+	// without detection times, arrival order wins
+	ASSERT_TRUE(store.apply(makestoredetection("A", "Update", std::nan(""),
+			92.0)));
+	ASSERT_DOUBLE_EQ(92.0, store.find("A")->hypocenter.time);
+}
+
+// tests retract messages
+TEST(DetectionStoreTest, Retract) {
+	detectionformats::detectionstore store;
+	store.apply(makestoredetection("A", "New", 100.0, 90.0));
+
+	// only the detection's source can retract it
+	ASSERT_FALSE(
+			store.apply(detectionformats::retract("A", "UW", "TestAuthor")));
+	ASSERT_FALSE(
+			store.apply(detectionformats::retract("B", "US", "TestAuthor")));
+	ASSERT_TRUE(
+			store.apply(detectionformats::retract("A", "US", "TestAuthor")));
+	ASSERT_FALSE(store.find("A"));
+	ASSERT_FALSE(store.apply(makestoredetection("A", "Update", 110.0, 91.0)));
+}
+
+// tests a retract message arriving before its detection
+TEST(DetectionStoreTest, EarlyRetract) {
+	detectionformats::detectionstore store;
+	ASSERT_FALSE(
+			store.apply(detectionformats::retract("A", "US", "TestAuthor")));
+	ASSERT_FALSE(
+			store.apply(detectionformats::retract("B", "UW", "TestAuthor")));
+	ASSERT_EQ(2u, store.getmetrics().pending);
+
+	// the New is kept, retracted, so later messages stay ignored
+	ASSERT_TRUE(store.apply(makestoredetection("A", "New", 100.0, 90.0)));
+	ASSERT_FALSE(store.find("A"));
+	detectionformats::detectiontypeindex state;
+	ASSERT_TRUE(store.getstate("A", state));
+	ASSERT_EQ(detectionformats::detectiontypeindex::retractdetection, state);
+	ASSERT_FALSE(store.apply(makestoredetection("A", "Update", 110.0, 91.0)));
+
+	// B was retracted by another source
+	ASSERT_TRUE(store.apply(makestoredetection("B", "New", 100.0, 90.0)));
+	ASSERT_TRUE(store.find("B"));
+	ASSERT_EQ(1u, store.getmetrics().retracted);
+}
+
+// tests the kept versions
+TEST(DetectionStoreTest, History) {
+	detectionformats::detectionstore store(2);
+	for (int i = 0; i < VERSIONS; i++) {
+		store.apply(makestoredetection("A", "Update", 100.0 + i, 90.0));
+	}
+
+	std::vector<detectionformats::detectionstore::version> versions = store
+			.gethistory("A");
+	ASSERT_EQ(3, static_cast<int>(versions.size()));
+	ASSERT_DOUBLE_EQ(102.0, versions[0]->detectiontime);
+	ASSERT_DOUBLE_EQ(103.0, versions[1]->detectiontime);
+	ASSERT_DOUBLE_EQ(104.0, versions[2]->detectiontime);
+
+	// a version looked up stays valid after it is replaced
+	detectionformats::detectionstore::version current = store.find("A");
+	store.apply(makestoredetection("A", "Update", 200.0, 90.0));
+	ASSERT_DOUBLE_EQ(104.0, current->detectiontime);
+
+	ASSERT_TRUE(store.gethistory("B").empty());
+}
+
+// tests origin time queries and expiry
+TEST(DetectionStoreTest, Within) {
+	detectionformats::detectionstore store;
+	for (int i = 0; i < 100; i++) {
+		store.apply(makestoredetection(std::to_string(i), "New", 1000.0 + i,
+				i));
+	}
+
+	// an update moves a detection in time
+	store.apply(makestoredetection("5", "Update", 2000.0, 50.5));
+	store.apply(makestoredetection("6", "Retract", 2000.0, 6.0));
+
+	std::vector<detectionformats::detectionstore::version> found;
+	ASSERT_EQ(9, static_cast<int>(store.within(0.0, 10.0, found)));
+	for (size_t i = 1; i < found.size(); i++) {
+		ASSERT_LE(found[i - 1]->hypocenter.time, found[i]->hypocenter.time);
+	}
+
+	found.clear();
+	ASSERT_EQ(2, static_cast<int>(store.within(50.0, 50.9, found)));
+	ASSERT_STREQ("50", found[0]->id.c_str());
+	ASSERT_STREQ("5", found[1]->id.c_str());
+
+	// retracted detections expire too, the moved one does not
+	ASSERT_EQ(49, static_cast<int>(store.expire(50.0)));
+	ASSERT_EQ(51, static_cast<int>(store.size()));
+	detectionformats::detectiontypeindex state;
+	ASSERT_FALSE(store.getstate("6", state));
+	ASSERT_FALSE(store.find("49"));
+	ASSERT_TRUE(store.find("5"));
+	ASSERT_EQ(49u, store.getmetrics().expired);
+}
+
+// tests expiring detections without origin times
+TEST(DetectionStoreTest, ExpireUntimed) {
+	detectionformats::detectionstore store;
+	store.apply(makestoredetection("A", "New", 100.0, std::nan("")));
+	store.apply(makestoredetection("B", "New", 100.0, std::nan("")));
+	ASSERT_EQ(0, static_cast<int>(store.expire(0.0)));
+
+	// an update keeps B for another call, and C gains an origin time
+	store.apply(makestoredetection("B", "Update", 110.0, std::nan("")));
+	store.apply(makestoredetection("C", "New", 100.0, std::nan("")));
+	store.apply(makestoredetection("C", "Update", 110.0, 50.0));
+	ASSERT_EQ(1, static_cast<int>(store.expire(0.0)));
+	ASSERT_FALSE(store.find("A"));
+	ASSERT_TRUE(store.find("B"));
+
+	ASSERT_EQ(1, static_cast<int>(store.expire(0.0)));
+	ASSERT_FALSE(store.find("B"));
+	ASSERT_TRUE(store.find("C"));
+	ASSERT_EQ(1, static_cast<int>(store.size()));
+}
+
+// tests applying from several threads at once
+TEST(DetectionStoreTest, Concurrent) {
+	detectionformats::detectionstore store(1);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < THREADCOUNT; t++) {
+		threads.push_back(std::thread([&store, t]() {
+			for (int i = 0; i < PERTHREAD; i++) {
+				std::string id = std::to_string(t) + "-" + std::to_string(i);
+				for (int v = VERSIONS - 1; v >= 0; v--) {
+					store.apply(makestoredetection(id, "Update", v, i));
+				}
+				store.find(id);
+			}
+		}));
+	}
+	for (size_t t = 0; t < threads.size(); t++) {
+		threads[t].join();
+	}
+
+	ASSERT_EQ(THREADCOUNT * PERTHREAD, static_cast<int>(store.size()));
+	detectionformats::detectionstoremetrics metrics = store.getmetrics();
+	ASSERT_EQ(static_cast<uint64_t>(THREADCOUNT * PERTHREAD), metrics.created);
+	ASSERT_EQ(static_cast<uint64_t>(THREADCOUNT * PERTHREAD * (VERSIONS - 1)),
+			metrics.stale);
+	ASSERT_DOUBLE_EQ(VERSIONS - 1, store.find("2-17")->detectiontime);
+}
@@ -0,0 +1,213 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\"}"
+#define RETRACTSTRING "{\"Type\":\"Retract\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define BADSTRING "{\"Type\":"
+
+// connects to a localhost tcp port
+static int connecttcp(uint16_t port) {
+	int descriptor = socket(AF_INET, SOCK_STREAM, 0);
+	sockaddr_in address;
+	std::memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(port);
+	connect(descriptor, reinterpret_cast<sockaddr *>(&address),
+			sizeof(address));
+	return (descriptor);
+}
+
+// connects to a unix domain socket
+static int connectunix(const std::string &path) {
+	int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.c_str(), path.length());
+	connect(descriptor, reinterpret_cast<sockaddr *>(&address),
+			sizeof(address));
+	return (descriptor);
+}
+
+// writes all of data
+static void writeall(int descriptor, const std::string &data) {
+	size_t written = 0;
+	while (written < data.length()) {
+		ssize_t length = write(descriptor, data.data() + written,
+				data.length() - written);
+		if (length <= 0) {
+			return;
+		}
+		written += length;
+	}
+}
+
+// waits up to 10 seconds for the server to hand count messages to the
+// callback
+static bool waitformessages(const detectionformats::ingestserver &server,
+		uint64_t count) {
+	for (int i = 0; i < 10000; i++) {
+		if (server.getstatistics().messages >= count) {
+			return (true);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return (false);
+}
+
+// tests to see if messages sent over tcp and unix sockets reach the
+// callback, including messages split across writes
+TEST(IngestServerTest, Messages) {
+	std::atomic<int> picks(0);
+	std::atomic<int> retracts(0);
+	std::atomic<int> errors(0);
+	detectionformats::ingestserver server(
+			[&picks, &retracts, &errors](detectionformats::parseresult &result,
+					bool valid) {
+				if (result.isparsed() == false) {
+					errors++;
+				} else if (result.type
+						== detectionformats::formattypes::picktype) {
+					ASSERT_TRUE(result.get<detectionformats::pick>() != NULL);
+					picks++;
+				} else if (result.type
+						== detectionformats::formattypes::retracttype) {
+					ASSERT_TRUE(valid);
+					retracts++;
+				}
+			});
+
+	std::string path = "/tmp/detectionformats-ingest-"
+			+ std::to_string(getpid()) + ".sock";
+	uint16_t port = server.listentcp(0);
+	server.listenunix(path);
+	ASSERT_NE(port, 0);
+
+	std::thread loop([&server]() {server.run();});
+
+	// tcp, one message split across many small writes
+	int tcpclient = connecttcp(port);
+	std::string messages;
+	for (int i = 0; i < 100; i++) {
+		messages += std::string(PICKSTRING) + "\n";
+	}
+	messages += std::string(BADSTRING) + "\r\n\n";
+	for (size_t i = 0; i < messages.length(); i += 7) {
+		writeall(tcpclient, messages.substr(i, 7));
+	}
+	close(tcpclient);
+
+	// unix, the last message without a trailing newline
+	int unixclient = connectunix(path);
+	writeall(unixclient,
+			std::string(RETRACTSTRING) + "\n" + std::string(RETRACTSTRING));
+	close(unixclient);
+
+	ASSERT_TRUE(waitformessages(server, 103));
+	server.stop();
+	loop.join();
+
+	ASSERT_EQ(picks.load(), 100);
+	ASSERT_EQ(retracts.load(), 2);
+	ASSERT_EQ(errors.load(), 1);
+
+	detectionformats::ingeststatistics statistics = server.getstatistics();
+	ASSERT_EQ(statistics.connections, (uint64_t) 2);
+	ASSERT_EQ(statistics.errors, (uint64_t) 1);
+}
+
+// tests to see if a unix socket path is only taken over from a server that
+// has exited
+TEST(IngestServerTest, UnixSocketPath) {
+	detectionformats::ingestserver::callback ignore = [](
+			detectionformats::parseresult &, bool) {
+	};
+	std::string path = "/tmp/detectionformats-ingest-path-"
+			+ std::to_string(getpid()) + ".sock";
+
+	// a regular file is left alone
+	std::fclose(std::fopen(path.c_str(), "w"));
+	{
+		detectionformats::ingestserver server(ignore);
+		ASSERT_THROW(server.listenunix(path), std::runtime_error);
+	}
+	struct stat status;
+	ASSERT_EQ(0, lstat(path.c_str(), &status));
+	ASSERT_TRUE(S_ISREG(status.st_mode));
+	unlink(path.c_str());
+
+	// a live server's socket is not taken over
+	{
+		detectionformats::ingestserver first(ignore);
+		first.listenunix(path);
+		detectionformats::ingestserver second(ignore);
+		ASSERT_THROW(second.listenunix(path), std::runtime_error);
+		ASSERT_EQ(0, lstat(path.c_str(), &status));
+	}
+
+	// a socket left behind with nothing listening is replaced
+	int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.c_str(), path.length());
+	ASSERT_EQ(0, bind(stale, reinterpret_cast<sockaddr *>(&address),
+			sizeof(address)));
+	close(stale);
+	{
+		detectionformats::ingestserver server(ignore);
+		server.listenunix(path);
+		int client = connectunix(path);
+		close(client);
+	}
+	ASSERT_NE(0, lstat(path.c_str(), &status));
+}
+
+// tests to see if reading pauses while the callback is behind, without
+// losing messages
+TEST(IngestServerTest, Backpressure) {
+	std::atomic<int> count(0);
+	detectionformats::ingestserver server(
+			[&count](detectionformats::parseresult &, bool) {
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+				count++;
+			}, 8);
+
+	uint16_t port = server.listentcp(0);
+	std::thread loop([&server]() {server.run();});
+
+	int client = connecttcp(port);
+	std::string messages;
+	for (int i = 0; i < 500; i++) {
+		messages += std::string(RETRACTSTRING) + "\n";
+	}
+	writeall(client, messages);
+	close(client);
+
+	ASSERT_TRUE(waitformessages(server, 500));
+	server.stop();
+	loop.join();
+
+	ASSERT_EQ(count.load(), 500);
+	ASSERT_GT(server.getstatistics().pauses, (uint64_t) 0);
+}
+
+#endif
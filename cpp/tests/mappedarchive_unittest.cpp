@@ -0,0 +1,146 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#if !defined(_WIN32)
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\"}"
+#define CORRELATIONSTRING "{\"Type\":\"Correlation\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Phase\":\"P\",\"Time\":\"2015-12-28T21:32:24.017Z\",\"Correlation\":2.65,\"Hypocenter\":{\"Latitude\":40.3344,\"Longitude\":-121.44,\"Depth\":32.44,\"Time\":\"2015-12-28T21:30:44.039Z\"}}"
+#define RETRACTSTRING "{\"Type\":\"Retract\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define INVALIDPICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\",\"Onset\":\"bad\"}"
+#define BADSTRING "{\"Type\":"
+
+// writes contents to a new temporary file and returns its path
+static std::string writemapped(const std::string &contents) {
+	std::string path = "/tmp/detectionformats-mapped-test-"
+			+ std::to_string(getpid()) + ".json";
+	FILE *file = std::fopen(path.c_str(), "wb");
+	std::fwrite(contents.data(), 1, contents.length(), file);
+	std::fclose(file);
+	return (path);
+}
+
+// tests splitting into ranges of whole lines
+TEST(MappedArchiveTest, Split) {
+	std::string contents;
+	for (size_t i = 0; i < 50; i++) {
+		contents += std::string(PICKSTRING) + "\n";
+	}
+	std::string path = writemapped(contents);
+	detectionformats::mappedarchive archive(path);
+	ASSERT_EQ(contents.length(), archive.size());
+
+	for (size_t count = 1; count < 70; count += 7) {
+		std::vector<detectionformats::archiverange> ranges = archive.split(
+				count);
+		ASSERT_GE(count, ranges.size());
+		ASSERT_FALSE(ranges.empty());
+
+		// the ranges cover the archive, and each ends after a newline
+		ASSERT_EQ(0, ranges.front().begin);
+		ASSERT_EQ(archive.size(), ranges.back().end);
+		for (size_t i = 0; i < ranges.size(); i++) {
+			ASSERT_LT(ranges[i].begin, ranges[i].end);
+			ASSERT_EQ('\n', archive.data()[ranges[i].end - 1]);
+			if (i > 0) {
+				ASSERT_EQ(ranges[i - 1].end, ranges[i].begin);
+			}
+		}
+	}
+
+	std::remove(path.c_str());
+}
+
+// tests parsing an archive
+TEST(MappedArchiveTest, Parse) {
+	std::string contents;
+	for (size_t i = 0; i < 30; i++) {
+		contents += std::string(PICKSTRING) + "\n";
+		contents += std::string(CORRELATIONSTRING) + "\r\n\n";
+		contents += std::string(RETRACTSTRING) + "\n";
+		contents += std::string(BADSTRING) + "\n";
+	}
+	// the last line need not end with a newline
+	contents += PICKSTRING;
+	std::string path = writemapped(contents);
+
+	detectionformats::threadpool pool(3);
+	detectionformats::mappedarchive archive(path);
+	std::vector<detectionformats::archivecontents> ranges = archive.parse(
+			pool, 7);
+
+	uint64_t lines = 0, errors = 0, others = 0;
+	size_t picks = 0, correlations = 0;
+	for (size_t i = 0; i < ranges.size(); i++) {
+		lines += ranges[i].lines;
+		errors += ranges[i].errors;
+		others += ranges[i].others;
+		picks += ranges[i].picks.size();
+		correlations += ranges[i].correlations.size();
+		ASSERT_TRUE(ranges[i].detections.empty());
+	}
+
+	ASSERT_EQ(121, lines);
+	ASSERT_EQ(30, errors);
+	ASSERT_EQ(30, others);
+	ASSERT_EQ(31, picks);
+	ASSERT_EQ(30, correlations);
+	ASSERT_EQ("12GFH48776857", ranges[0].picks[0].id);
+
+	std::remove(path.c_str());
+}
+
+// tests validating an archive
+TEST(MappedArchiveTest, Validate) {
+	std::string pickline = std::string(PICKSTRING) + "\n";
+	std::string contents;
+	for (size_t i = 0; i < 200; i++) {
+		contents += pickline;
+	}
+	uint64_t invalidoffset = contents.length();
+	contents += std::string(INVALIDPICKSTRING) + "\n";
+	uint64_t badoffset = contents.length();
+	contents += std::string(BADSTRING) + "\n";
+	for (size_t i = 0; i < 200; i++) {
+		contents += pickline;
+	}
+	std::string path = writemapped(contents);
+
+	detectionformats::threadpool pool(4);
+	detectionformats::mappedarchive archive(path);
+	detectionformats::archivesummary summary = archive.validate(pool);
+
+	ASSERT_EQ(402, summary.lines);
+	ASSERT_EQ(1, summary.errors);
+	ASSERT_EQ(1, summary.invalid);
+	ASSERT_EQ(2, summary.failures.size());
+	ASSERT_EQ(invalidoffset, summary.failures[0]);
+	ASSERT_EQ(badoffset, summary.failures[1]);
+
+	std::remove(path.c_str());
+}
+
+// tests an empty archive and a missing one
+TEST(MappedArchiveTest, Empty) {
+	std::string path = writemapped("");
+
+	{
+		detectionformats::threadpool pool(2);
+		detectionformats::mappedarchive archive(path);
+		ASSERT_EQ(0, archive.size());
+		ASSERT_TRUE(archive.split(4).empty());
+		ASSERT_TRUE(archive.parse(pool).empty());
+		ASSERT_EQ(0, archive.validate(pool).lines);
+	}
+	std::remove(path.c_str());
+
+	ASSERT_THROW(detectionformats::mappedarchive missing(path),
+			std::runtime_error);
+}
+
+#endif
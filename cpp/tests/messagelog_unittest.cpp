@@ -0,0 +1,246 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+#include "testpicks.h"
+
+#if !defined(_WIN32)
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define PICKCOUNT 1000
+
+// removes a log directory and its files
+static void removelog(const std::string &path) {
+	DIR *listing = opendir(path.c_str());
+	if (listing != NULL) {
+		for (struct dirent *item = readdir(listing); item != NULL;
+				item = readdir(listing)) {
+			std::string file = item->d_name;
+			if ((file != ".") && (file != "..")) {
+				unlink((path + "/" + file).c_str());
+			}
+		}
+		closedir(listing);
+		rmdir(path.c_str());
+	}
+}
+
+// gets an empty temporary directory path
+static std::string logpath(const std::string &name) {
+	std::string path = "/tmp/detectionformats-messagelog-test-"
+			+ std::to_string(getpid()) + "-" + name;
+	removelog(path);
+	return (path);
+}
+
+// appends characters to a file
+static void appendlogfile(const std::string &path,
+		const std::string &contents) {
+	FILE *file = std::fopen(path.c_str(), "ab");
+	std::fwrite(contents.data(), 1, contents.length(), file);
+	std::fclose(file);
+}
+
+// tests appending, finding and reading messages
+TEST(MessageLogTest, FindAndRead) {
+	std::string path = logpath("find");
+	{
+		detectionformats::messagelog log(path);
+		for (int i = 0; i < PICKCOUNT; i++) {
+			log.append(maketestpick("pick" + std::to_string(i), "BMN",
+					1000.0 + i));
+		}
+		detectionformats::detection newdetection;
+		newdetection.id = "detection0";
+		newdetection.hypocenter = detectionformats::hypocenter(40.3344, -121.44,
+				1500.5, 32.44, 12.5, 22.64, 2.44, 1.2);
+		log.append(newdetection);
+		log.append(detectionformats::retract("detection0", "US", "TestAuthor"));
+		ASSERT_EQ(PICKCOUNT + 2, static_cast<int>(log.size()));
+
+		// an updated pick is found in both versions, in order
+		log.append(maketestpick("pick7", "BMN", 2000.0));
+		std::vector<detectionformats::messagelogentry> found;
+		ASSERT_EQ(2, static_cast<int>(log.find("pick7", found)));
+		std::string message;
+		ASSERT_TRUE(log.read(found[1], message));
+		detectionformats::pick decoded;
+		ASSERT_EQ(message.length(), decoded.frombinary(message.data(),
+				message.length()));
+		ASSERT_TRUE(decoded == maketestpick("pick7", "BMN", 2000.0));
+
+		// a time range includes the detection by origin time, not the retract
+		found.clear();
+		ASSERT_EQ(11, static_cast<int>(log.within(1495.0, 1504.0, found)));
+		for (size_t i = 1; i < found.size(); i++) {
+			ASSERT_LE(found[i - 1].time, found[i].time);
+		}
+		found.clear();
+		ASSERT_EQ(2, static_cast<int>(log.find("detection0", found)));
+		ASSERT_EQ(detectionformats::formattypes::detectiontype, found[0].type);
+		ASSERT_EQ(detectionformats::formattypes::retracttype, found[1].type);
+		ASSERT_FALSE(log.find("missing", found));
+	}
+	removelog(path);
+}
+
+// tests logging json
+TEST(MessageLogTest, Json) {
+	std::string path = logpath("json");
+	{
+		detectionformats::messagelog log(path, 1024 * 1024,
+				detectionformats::jsonencoding);
+		detectionformats::messagelogentry entry = log.append(
+				maketestpick("pick1", "BMN", 10.0));
+		ASSERT_EQ(detectionformats::jsonencoding, entry.encoding);
+
+		std::string message;
+		ASSERT_TRUE(log.read(entry, message));
+		rapidjson::Document document;
+		detectionformats::pick decoded(
+				detectionformats::FromJSONString(message, document));
+		ASSERT_TRUE(decoded == maketestpick("pick1", "BMN", 10.0));
+
+		ASSERT_THROW(log.append(-1, "id", 0.0, detectionformats::jsonencoding,
+				"{}", 2), std::invalid_argument);
+		ASSERT_THROW(log.append(0, "id", 0.0, detectionformats::jsonencoding,
+				"", 0), std::invalid_argument);
+	}
+	removelog(path);
+}
+
+// tests segment rollover and reopening
+TEST(MessageLogTest, Rollover) {
+	std::string path = logpath("rollover");
+	{
+		detectionformats::messagelog log(path, 4096);
+		for (int i = 0; i < PICKCOUNT; i++) {
+			log.append(maketestpick("pick" + std::to_string(i), "BMN", i));
+		}
+		ASSERT_LT(10, static_cast<int>(log.getsegmentcount()));
+	}
+
+	{
+		detectionformats::messagelog reopened(path, 4096);
+		ASSERT_EQ(PICKCOUNT, static_cast<int>(reopened.size()));
+		ASSERT_EQ(0u, reopened.getdiscarded());
+		reopened.append(
+				maketestpick("pick" + std::to_string(PICKCOUNT), "BMN",
+						PICKCOUNT));
+
+		std::vector<detectionformats::messagelogentry> found;
+		ASSERT_EQ(PICKCOUNT + 1,
+				static_cast<int>(reopened.within(0.0, PICKCOUNT, found)));
+		for (size_t i = 0; i < found.size(); i += 97) {
+			std::string message;
+			ASSERT_TRUE(reopened.read(found[i], message));
+			detectionformats::pick decoded;
+			decoded.frombinary(message.data(), message.length());
+			ASSERT_TRUE(decoded == maketestpick("pick" + std::to_string(i),
+					"BMN", i));
+		}
+	}
+	removelog(path);
+}
+
+// tests rebuilding the index after a crash
+TEST(MessageLogTest, Recovery) {
+	std::string path = logpath("recovery");
+	std::string segment = path + "/00000000.log";
+	std::string sidecar = path + "/00000000.idx";
+	{
+		detectionformats::messagelog log(path);
+		for (int i = 0; i < 10; i++) {
+			log.append(maketestpick("pick" + std::to_string(i), "BMN", i));
+		}
+		log.sync();
+	}
+
+	// an index written before the last messages, and a record cut short
+	{
+		detectionformats::messagelog log(path);
+		log.sync();
+	}
+	std::string oldsidecar;
+	{
+		FILE *file = std::fopen(sidecar.c_str(), "rb");
+		char buffer[4096];
+		size_t count = std::fread(buffer, 1, sizeof(buffer), file);
+		std::fclose(file);
+		oldsidecar.assign(buffer, count);
+	}
+	{
+		detectionformats::messagelog log(path);
+		for (int i = 10; i < 20; i++) {
+			log.append(maketestpick("pick" + std::to_string(i), "BMN", i));
+		}
+	}
+	unlink(sidecar.c_str());
+	appendlogfile(sidecar, oldsidecar);
+	appendlogfile(segment, std::string("\x40\x00\x00\x00\x12\x34", 6));
+
+	// the reader sees the whole records without changing anything
+	{
+		detectionformats::messagelogreader reader(path);
+		ASSERT_EQ(20, static_cast<int>(reader.size()));
+	}
+
+	{
+		detectionformats::messagelog log(path);
+		ASSERT_EQ(20, static_cast<int>(log.size()));
+		ASSERT_EQ(6u, log.getdiscarded());
+		std::vector<detectionformats::messagelogentry> found;
+		ASSERT_EQ(1, static_cast<int>(log.find("pick15", found)));
+
+		// appends after the cut are read back
+		log.append(maketestpick("pick20", "BMN", 20.0));
+		found.clear();
+		ASSERT_EQ(1, static_cast<int>(log.find("pick20", found)));
+		std::string message;
+		ASSERT_TRUE(log.read(found[0], message));
+		detectionformats::pick decoded;
+		decoded.frombinary(message.data(), message.length());
+		ASSERT_TRUE(decoded == maketestpick("pick20", "BMN", 20.0));
+
+		// without any sidecar, the index is rebuilt from the segment
+		log.sync();
+		unlink(sidecar.c_str());
+		detectionformats::messagelogreader reader(path);
+		ASSERT_EQ(21, static_cast<int>(reader.size()));
+	}
+	removelog(path);
+}
+
+// tests reading messages in place
+TEST(MessageLogTest, Reader) {
+	std::string path = logpath("reader");
+	{
+		detectionformats::messagelog log(path, 8192);
+		for (int i = 0; i < PICKCOUNT; i++) {
+			log.append(maketestpick("pick" + std::to_string(i), "BMN", i));
+		}
+	}
+
+	detectionformats::messagelogreader reader(path);
+	ASSERT_EQ(PICKCOUNT, static_cast<int>(reader.size()));
+	std::vector<detectionformats::messagelogentry> found;
+	ASSERT_EQ(1, static_cast<int>(reader.find("pick512", found)));
+	const char *data = NULL;
+	size_t length = 0;
+	ASSERT_TRUE(reader.get(found[0], data, length));
+	detectionformats::pick decoded;
+	ASSERT_EQ(length, decoded.frombinary(data, length));
+	ASSERT_TRUE(decoded == maketestpick("pick512", "BMN", 512.0));
+
+	found[0].segment = 100000;
+	ASSERT_FALSE(reader.get(found[0], data, length));
+	ASSERT_THROW(detectionformats::messagelogreader(path + "-missing"),
+			std::runtime_error);
+	removelog(path);
+}
+#endif
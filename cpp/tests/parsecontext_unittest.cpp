@@ -0,0 +1,120 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\"}"
+#define RETRACTSTRING "{\"Type\":\"Retract\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define BADSTRING "{\"Type\":"
+
+// tests parsing messages one after another with one context
+TEST(ParseContextTest, Parse) {
+	detectionformats::parsecontext context;
+
+	std::string pick = PICKSTRING;
+	detectionformats::parsecontext::document &document = context.parse(
+			pick.c_str(), pick.length());
+	ASSERT_FALSE(document.HasParseError());
+	ASSERT_STREQ("Pick", document["Type"].GetString());
+
+	// the buffer does not need to be null terminated
+	std::string retract = std::string(RETRACTSTRING) + "trailing";
+	detectionformats::parsecontext::document &second = context.parse(
+			retract.c_str(), retract.length() - 8);
+	ASSERT_FALSE(second.HasParseError());
+	ASSERT_STREQ("Retract", second["Type"].GetString());
+
+	// a failed parse leaves nothing of the last message behind
+	std::string bad = BADSTRING;
+	detectionformats::parsecontext::document &failed = context.parse(
+			bad.c_str(), bad.length());
+	ASSERT_TRUE(failed.HasParseError());
+	ASSERT_TRUE(failed.IsNull());
+
+	detectionformats::parsecontext::document &last = context.parse(
+			pick.c_str(), pick.length());
+	ASSERT_FALSE(last.HasParseError());
+	ASSERT_STREQ("BMN", last["Site"]["Station"].GetString());
+}
+
+// tests that the buffers grow to fit a large message
+TEST(ParseContextTest, Grow) {
+	detectionformats::parsecontext context(1024, 1024);
+	size_t initial = context.capacity();
+
+	// a message far larger than the buffers, nested deeper than the stack
+	std::string large = "{\"Values\":[";
+	for (int i = 0; i < 5000; i++) {
+		large += (i > 0) ? ",[\"value\",1.5]" : "[\"value\",1.5]";
+	}
+	large += "]}";
+
+	detectionformats::parsecontext::document &document = context.parse(
+			large.c_str(), large.length());
+	ASSERT_FALSE(document.HasParseError());
+	ASSERT_EQ(5000, static_cast<int>(document["Values"].Size()));
+
+	// the next parse enlarges the buffers, and the one after reuses them
+	std::string pick = PICKSTRING;
+	context.parse(pick.c_str(), pick.length());
+	size_t grown = context.capacity();
+	ASSERT_GT(grown, initial);
+
+	ASSERT_FALSE(context.parse(large.c_str(), large.length()).HasParseError());
+	context.parse(pick.c_str(), pick.length());
+	ASSERT_EQ(grown, context.capacity());
+}
+
+// tests serializing with a context
+TEST(ParseContextTest, Serialize) {
+	rapidjson::Document pickdocument;
+	detectionformats::pick pickobject(
+			detectionformats::FromJSONString(std::string(PICKSTRING),
+					pickdocument));
+	rapidjson::Document expecteddocument;
+	std::string expected = detectionformats::ToJSONString(
+			pickobject.tojson(expecteddocument,
+					expecteddocument.GetAllocator()));
+
+	detectionformats::parsecontext context;
+	std::string json;
+	context.serialize(pickobject, json);
+	ASSERT_EQ(expected, json);
+
+	// again, reusing the output buffer
+	context.serialize(pickobject, json);
+	ASSERT_EQ(expected, json);
+}
+
+// tests ParseMessage with a context
+TEST(ParseContextTest, ParseMessage) {
+	detectionformats::parsecontext context;
+	detectionformats::parseresult result;
+
+	std::string pick = PICKSTRING;
+	detectionformats::ParseMessage(pick.c_str(), pick.length(), context,
+			result);
+	ASSERT_TRUE(result.isparsed());
+	ASSERT_EQ(detectionformats::formattypes::picktype, result.type);
+
+	std::string bad = BADSTRING;
+	detectionformats::parseresult failed;
+	detectionformats::ParseMessage(bad.c_str(), bad.length(), context, failed);
+	ASSERT_FALSE(failed.isparsed());
+	ASSERT_FALSE(failed.error.empty());
+}
+
+// tests that each thread has its own context
+TEST(ParseContextTest, Local) {
+	detectionformats::parsecontext *first =
+			&detectionformats::parsecontext::local();
+	ASSERT_EQ(first, &detectionformats::parsecontext::local());
+
+	detectionformats::parsecontext *other = NULL;
+	std::thread thread([&other]() {
+		other = &detectionformats::parsecontext::local();
+	});
+	thread.join();
+	ASSERT_NE(first, other);
+}
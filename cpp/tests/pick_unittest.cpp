@@ -529,4 +529,112 @@ TEST(PickTest, Validate) {
 
 	// check return code
 	ASSERT_EQ(result, false)<< "Tested for unsuccessful validation.";
+
+	// the required fields are reported missing in descriptor order
+	std::vector<std::string> errors = badpickobject.geterrors();
+	ASSERT_EQ(4, static_cast<int>(errors.size()));
+	ASSERT_STREQ(errors[0].c_str(), "Missing ID in pick class.");
+	ASSERT_STREQ(errors[1].c_str(),
+			"Site object did not validate in pick class.");
+	ASSERT_STREQ(errors[3].c_str(), "Missing Time in pick class.");
+}
+
+// tests to see if pick can successfully
+// be overwritten in place from json
+TEST(PickTest, ResetFrom) {
+	// start from a pick with stale values
+	detectionformats::pick pickobject;
+	pickobject.id = std::string("stale");
+	pickobject.phase = std::string("Pn");
+	pickobject.filterdata.resize(5);
+
+	rapidjson::Document pickdocument;
+	pickobject.resetfrom(
+			detectionformats::FromJSONString(std::string(PICKSTRING),
+					pickdocument));
+
+	// check data values
+	checkdata(pickobject, "Tested resetfrom");
+	ASSERT_EQ(pickobject.filterdata.size(), (size_t) 2);
+
+	// reset from a buffer without filters
+	std::string pickstring = std::string(PICKSTRINGNOFILTER);
+	rapidjson::Document pickdocument2;
+	pickobject.resetfrom(pickstring.c_str(), pickstring.length(),
+			pickdocument2);
+
+	// check data values
+	checkdata(pickobject, "Tested resetfrom buffer");
+	ASSERT_EQ(pickobject.filterdata.size(), (size_t) 0);
+
+	// clear back to null values
+	pickobject.clear();
+	ASSERT_STREQ(pickobject.id.c_str(), "");
+	ASSERT_STREQ(pickobject.type.c_str(), PICK_TYPE);
+	ASSERT_TRUE(std::isnan(pickobject.time));
+	ASSERT_TRUE(pickobject.amplitude.isempty());
+}
+
+// tests to see if pick ignores unknown keys and values of the wrong type
+TEST(PickTest, IgnoresUnknownKeys) {
+	std::string pickstring = "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\","
+			"\"Unknown\":\"value\",\"Phas\":\"S\",\"Phase\":\"P\","
+			"\"Polarity\":1,\"Time\":3.5,\"Site\":\"BMN\","
+			"\"Filter\":[{\"HighPass\":1.05},2]}";
+
+	rapidjson::Document pickdocument;
+	detectionformats::pick pickobject(
+			detectionformats::FromJSONString(pickstring, pickdocument));
+
+	ASSERT_STREQ(pickobject.type.c_str(), PICK_TYPE);
+	ASSERT_STREQ(pickobject.id.c_str(), "12GFH48776857");
+	ASSERT_STREQ(pickobject.phase.c_str(), "P");
+	ASSERT_STREQ(pickobject.polarity.c_str(), "");
+	ASSERT_TRUE(std::isnan(pickobject.time));
+	ASSERT_STREQ(pickobject.site.station.c_str(), "");
+	ASSERT_EQ(pickobject.filterdata.size(), (size_t) 2);
+	ASSERT_EQ(pickobject.filterdata[0].highpass, 1.05);
+	ASSERT_TRUE(std::isnan(pickobject.filterdata[1].highpass));
+}
+
+// tests to see if the beam subobject is written under its own key
+TEST(PickTest, WritesBeam) {
+	rapidjson::Document pickdocument;
+	detectionformats::pick pickobject(
+			detectionformats::FromJSONString(std::string(PICKSTRING),
+					pickdocument));
+
+	rapidjson::Document outputdocument;
+	rapidjson::Value & json = pickobject.tojson(outputdocument,
+			outputdocument.GetAllocator());
+
+	ASSERT_TRUE(json.HasMember("Beam"));
+	ASSERT_TRUE(json["Beam"].HasMember("BackAzimuth"));
+	ASSERT_FALSE(json["Beam"].HasMember("Amplitude"));
+	ASSERT_EQ(json["Beam"]["BackAzimuth"].GetDouble(), BACKAZIMUTH);
+}
+
+// tests to see if pick survives a binary round trip
+TEST(PickTest, Binary) {
+	rapidjson::Document pickdocument;
+	detectionformats::pick pickobject(
+			detectionformats::FromJSONString(std::string(PICKSTRING),
+					pickdocument));
+
+	std::string buffer;
+	pickobject.tobinary(buffer);
+
+	detectionformats::pick pickobject2;
+	ASSERT_EQ(pickobject2.frombinary(buffer.data(), buffer.size()),
+			buffer.size());
+	ASSERT_TRUE(pickobject2 == pickobject);
+	checkdata(pickobject2, "");
+
+	pickobject2.phase = "S";
+	ASSERT_TRUE(pickobject2 != pickobject);
+
+	// a truncated buffer is rejected
+	detectionformats::pick pickobject3;
+	ASSERT_THROW(pickobject3.frombinary(buffer.data(), buffer.size() - 1),
+			std::invalid_argument);
 }
@@ -0,0 +1,148 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+#include "testpicks.h"
+
+#include <string>
+
+#define EXPIRY 600.0
+#define TOLERANCE 0.5
+#define MANYPICKS 20000
+
+// tests relayed picks and updates by id
+TEST(PickDedupTest, ById) {
+	detectionformats::pickdedup dedup(EXPIRY, TOLERANCE);
+
+	detectionformats::pick first = maketestpick("1", "BOZ", 1000.0);
+	ASSERT_EQ(detectionformats::uniquepick, dedup.check(first));
+	ASSERT_EQ(detectionformats::duplicatepick, dedup.check(first));
+	ASSERT_EQ(detectionformats::duplicatepick, dedup.check(first));
+
+	// the same id with a field changed
+	detectionformats::pick changed = first;
+	changed.polarity = "up";
+	ASSERT_EQ(detectionformats::updatedpick, dedup.check(changed));
+	ASSERT_EQ(detectionformats::duplicatepick, dedup.check(changed));
+
+	// a second pick well apart
+	ASSERT_EQ(detectionformats::uniquepick,
+			dedup.check(maketestpick("2", "BOZ", 1010.0)));
+	ASSERT_EQ(2, static_cast<int>(dedup.size()));
+
+	detectionformats::pickdedupmetrics metrics = dedup.getmetrics();
+	ASSERT_EQ(6u, metrics.picks);
+	ASSERT_EQ(2u, metrics.unique);
+	ASSERT_EQ(3u, metrics.duplicates);
+	ASSERT_EQ(0u, metrics.repicks);
+	ASSERT_EQ(1u, metrics.updates);
+}
+
+// tests picks of the same arrival under new ids
+TEST(PickDedupTest, ByArrival) {
+	detectionformats::pickdedup dedup(EXPIRY, TOLERANCE);
+
+	ASSERT_EQ(detectionformats::uniquepick,
+			dedup.check(maketestpick("1", "BOZ", 1000.0)));
+
+	// within the tolerance either side, across bucket edges
+	ASSERT_EQ(detectionformats::duplicatepick,
+			dedup.check(maketestpick("2", "BOZ", 1000.3)));
+	ASSERT_EQ(detectionformats::duplicatepick,
+			dedup.check(maketestpick("3", "BOZ", 999.6)));
+
+	// and a relay of the re-pick is a duplicate by id
+	ASSERT_EQ(detectionformats::duplicatepick,
+			dedup.check(maketestpick("2", "BOZ", 1000.3)));
+
+	// beyond the tolerance, another phase, or another site
+	ASSERT_EQ(detectionformats::uniquepick,
+			dedup.check(maketestpick("4", "BOZ", 1000.7)));
+	ASSERT_EQ(detectionformats::uniquepick,
+			dedup.check(maketestpick("5", "BOZ", 1000.0, "S")));
+	ASSERT_EQ(detectionformats::uniquepick,
+			dedup.check(maketestpick("6", "LKWY", 1000.0)));
+
+	// picks with no time are only checked by id
+	ASSERT_EQ(detectionformats::uniquepick,
+			dedup.check(maketestpick("7", "BOZ", std::nan(""))));
+
+	detectionformats::pickdedupmetrics metrics = dedup.getmetrics();
+	ASSERT_EQ(2u, metrics.repicks);
+	ASSERT_EQ(1u, metrics.duplicates);
+	ASSERT_EQ(5u, metrics.unique);
+}
+
+// tests forgetting picks
+TEST(PickDedupTest, Expiry) {
+	detectionformats::pickdedup dedup(EXPIRY, TOLERANCE);
+
+	detectionformats::pick old = maketestpick("1", "BOZ", 0.0);
+	ASSERT_EQ(detectionformats::uniquepick, dedup.check(old));
+
+	// one period on, the pick is still remembered
+	ASSERT_EQ(detectionformats::uniquepick,
+			dedup.check(maketestpick("2", "LKWY", EXPIRY)));
+	ASSERT_EQ(detectionformats::duplicatepick,
+			dedup.check(maketestpick("3", "BOZ", 0.1)));
+
+	// two periods on, it is forgotten
+	ASSERT_EQ(detectionformats::uniquepick,
+			dedup.check(maketestpick("4", "LKWY", 2 * EXPIRY)));
+	ASSERT_EQ(detectionformats::uniquepick, dedup.check(old));
+
+	dedup.clear();
+	ASSERT_EQ(0, static_cast<int>(dedup.size()));
+	ASSERT_EQ(detectionformats::uniquepick, dedup.check(old));
+}
+
+// tests that a pick with a bad time does not stop picks being forgotten
+TEST(PickDedupTest, OutlierTime) {
+	detectionformats::pickdedup dedup(EXPIRY, TOLERANCE);
+	ASSERT_EQ(detectionformats::uniquepick,
+			dedup.check(maketestpick("1", "BOZ", 0.0)));
+	ASSERT_EQ(detectionformats::uniquepick,
+			dedup.check(maketestpick("bad", "BOZ", 4102444800.0)));
+	for (int i = 0; i < 1000; i++) {
+		dedup.check(maketestpick(std::to_string(i + 2), "LKWY",
+				i * EXPIRY / 10));
+	}
+	ASSERT_LE(dedup.size(), 21u);
+	ASSERT_EQ(1u, dedup.getmetrics().outliers);
+
+	// nor does one that comes first
+	dedup.clear();
+	dedup.check(maketestpick("bad", "BOZ", 4102444800.0));
+	for (int i = 0; i < 1000; i++) {
+		dedup.check(maketestpick(std::to_string(i + 2), "LKWY",
+				i * EXPIRY / 10));
+	}
+	ASSERT_LE(dedup.size(), 21u);
+
+	// a stream that really has moved on moves the generations after a few
+	// picks
+	for (int i = 0; i < 100; i++) {
+		dedup.check(maketestpick("later" + std::to_string(i), "BOZ",
+				1000 * EXPIRY + i));
+	}
+	ASSERT_LT(dedup.size(), 100u);
+}
+
+// tests many picks, growing the tables
+TEST(PickDedupTest, Many) {
+	detectionformats::pickdedup dedup(EXPIRY, TOLERANCE);
+
+	for (int i = 0; i < MANYPICKS; i++) {
+		ASSERT_EQ(detectionformats::uniquepick,
+				dedup.check(
+						maketestpick(std::to_string(i),
+								"S" + std::to_string(i % 1000), i * 0.01)));
+	}
+	ASSERT_EQ(MANYPICKS, static_cast<int>(dedup.size()));
+	for (int i = 0; i < MANYPICKS; i++) {
+		ASSERT_EQ(detectionformats::duplicatepick,
+				dedup.check(
+						maketestpick(std::to_string(i),
+								"S" + std::to_string(i % 1000), i * 0.01)));
+	}
+	ASSERT_EQ(static_cast<uint64_t>(MANYPICKS),
+			dedup.getmetrics().duplicates);
+}
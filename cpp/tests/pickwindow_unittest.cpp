@@ -0,0 +1,221 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+#include "testpicks.h"
+
+#include <cmath>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#define DURATION 60.0
+#define PICKCOUNT 5000
+#define SITECOUNT 20
+
+// tests adding picks out of order
+TEST(PickWindowTest, Order) {
+	detectionformats::pickwindow window(DURATION);
+	ASSERT_EQ(0, static_cast<int>(window.size()));
+	ASSERT_TRUE(std::isnan(window.getoldest()));
+	ASSERT_TRUE(std::isnan(window.getnewest()));
+
+	ASSERT_TRUE(window.add(maketestpick("0", "S0", 10.0)));
+	ASSERT_TRUE(window.add(maketestpick("1", "S0", 30.0)));
+	ASSERT_TRUE(window.add(maketestpick("2", "S1", 20.0)));
+	ASSERT_TRUE(window.add(maketestpick("3", "S1", 5.0)));
+	ASSERT_TRUE(window.add(maketestpick("4", "S2", 20.0)));
+
+	// picks with no time are refused
+	ASSERT_FALSE(window.add(detectionformats::pick()));
+
+	ASSERT_EQ(5, static_cast<int>(window.size()));
+	ASSERT_DOUBLE_EQ(5.0, window.getoldest());
+	ASSERT_DOUBLE_EQ(30.0, window.getnewest());
+
+	std::vector<const detectionformats::pick *> found;
+	ASSERT_EQ(5, static_cast<int>(window.query(0.0, 100.0, found)));
+
+	// in time order, equal times in the order added
+	ASSERT_STREQ("3", found[0]->id.c_str());
+	ASSERT_STREQ("0", found[1]->id.c_str());
+	ASSERT_STREQ("2", found[2]->id.c_str());
+	ASSERT_STREQ("4", found[3]->id.c_str());
+	ASSERT_STREQ("1", found[4]->id.c_str());
+}
+
+// tests range and site queries
+TEST(PickWindowTest, Query) {
+	detectionformats::pickwindow window(DURATION);
+	for (int i = 0; i < 50; i++) {
+		window.add(maketestpick(std::to_string(i), "S" + std::to_string(i % 3),
+				i));
+	}
+
+	// both ends are included
+	std::vector<const detectionformats::pick *> found;
+	ASSERT_EQ(11, static_cast<int>(window.query(10.0, 20.0, found)));
+	ASSERT_DOUBLE_EQ(10.0, found.front()->time);
+	ASSERT_DOUBLE_EQ(20.0, found.back()->time);
+
+	found.clear();
+	ASSERT_EQ(0, static_cast<int>(window.query(20.5, 20.9, found)));
+	ASSERT_EQ(0, static_cast<int>(window.query(60.0, 70.0, found)));
+
+	// a site's picks only
+	ASSERT_EQ(4,
+			static_cast<int>(window.query(10.0, 20.0,
+					detectionformats::site("S1", "BHZ", "US", "00"), found)));
+	for (size_t i = 0; i < found.size(); i++) {
+		ASSERT_STREQ("S1", found[i]->site.station.c_str());
+	}
+
+	// every code is matched
+	found.clear();
+	ASSERT_EQ(0,
+			static_cast<int>(window.query(10.0, 20.0,
+					detectionformats::site("S1", "BHN", "US", "00"), found)));
+	ASSERT_EQ(0,
+			static_cast<int>(window.query(10.0, 20.0,
+					detectionformats::site("S9", "BHZ", "US", "00"), found)));
+}
+
+// tests eviction
+TEST(PickWindowTest, Evict) {
+	detectionformats::pickwindow window(DURATION);
+	ASSERT_DOUBLE_EQ(DURATION, window.getduration());
+
+	for (int i = 0; i <= 100; i++) {
+		ASSERT_TRUE(window.add(maketestpick(std::to_string(i), "S0", i)));
+	}
+
+	// the newest pick at 100 keeps 40 to 100
+	ASSERT_EQ(61, static_cast<int>(window.size()));
+	ASSERT_DOUBLE_EQ(40.0, window.getoldest());
+
+	// a pick older than the window is refused, one inside it is not
+	ASSERT_FALSE(window.add(maketestpick("101", "S0", 39.0)));
+	ASSERT_TRUE(window.add(maketestpick("102", "S0", 40.5)));
+	ASSERT_EQ(62, static_cast<int>(window.size()));
+
+	// following a clock
+	ASSERT_EQ(0, static_cast<int>(window.expire(90.0)));
+	ASSERT_EQ(21, static_cast<int>(window.expire(120.0)));
+	ASSERT_EQ(41, static_cast<int>(window.size()));
+	ASSERT_DOUBLE_EQ(60.0, window.getoldest());
+	ASSERT_FALSE(window.add(maketestpick("103", "S0", 59.0)));
+
+	window.clear();
+	ASSERT_EQ(0, static_cast<int>(window.size()));
+	ASSERT_TRUE(window.add(maketestpick("104", "S0", 1.0)));
+	ASSERT_EQ(1, static_cast<int>(window.size()));
+}
+
+// tests a jittered stream against a multimap
+TEST(PickWindowTest, MatchesMultimap) {
+	std::mt19937 generator(42);
+	std::normal_distribution<double> jitter(0.0, 2.0);
+	std::uniform_int_distribution<int> station(0, SITECOUNT - 1);
+	std::uniform_real_distribution<double> offset(0.0, DURATION);
+
+	detectionformats::pickwindow window(DURATION);
+	std::multimap<double, detectionformats::pick> expected;
+	double newest = -1e300;
+
+	for (int i = 0; i < PICKCOUNT; i++) {
+		detectionformats::pick newpick = maketestpick(
+				std::to_string(i), "S" + std::to_string(station(generator)),
+				i * 0.05 + jitter(generator));
+
+		bool added = window.add(newpick);
+		if (newpick.time < newest - DURATION) {
+			ASSERT_FALSE(added);
+		} else {
+			ASSERT_TRUE(added);
+			expected.insert(std::make_pair(newpick.time, newpick));
+			newest = std::max(newest, newpick.time);
+			expected.erase(expected.begin(),
+					expected.lower_bound(newest - DURATION));
+		}
+		ASSERT_EQ(expected.size(), window.size());
+
+		if ((i % 100) != 0) {
+			continue;
+		}
+
+		double starttime = newest - offset(generator);
+		double endtime = starttime + 10.0;
+		detectionformats::site querysite("S" + std::to_string(i % SITECOUNT),
+				"BHZ", "US", "00");
+
+		std::vector<const detectionformats::pick *> found;
+		std::vector<const detectionformats::pick *> sitefound;
+		window.query(starttime, endtime, found);
+		window.query(starttime, endtime, querysite, sitefound);
+
+		std::multimap<double, detectionformats::pick>::iterator it =
+				expected.lower_bound(starttime);
+		size_t j = 0;
+		size_t k = 0;
+		for (; (it != expected.end()) && (it->first <= endtime); ++it) {
+			ASSERT_LT(j, found.size());
+			ASSERT_EQ(it->second, *found[j]);
+			j++;
+			if (it->second.site.station == querysite.station) {
+				ASSERT_LT(k, sitefound.size());
+				ASSERT_EQ(it->second, *sitefound[k]);
+				k++;
+			}
+		}
+		ASSERT_EQ(j, found.size());
+		ASSERT_EQ(k, sitefound.size());
+	}
+}
+
+// tests that a pick with a bad time does not empty the window and refuse
+// the picks after it
+TEST(PickWindowTest, OutlierTime) {
+	detectionformats::pickwindow window(DURATION);
+	for (int i = 0; i < 50; i++) {
+		ASSERT_TRUE(window.add(maketestpick(std::to_string(i), "S0", i)));
+	}
+	ASSERT_FALSE(window.add(maketestpick("bad", "S0", 4102444800.0)));
+	ASSERT_TRUE(window.add(maketestpick("50", "S0", 50.0)));
+	ASSERT_EQ(51, static_cast<int>(window.size()));
+	ASSERT_DOUBLE_EQ(50.0, window.getnewest());
+
+	// a stream that really has moved on is accepted after a few picks
+	int added = 0;
+	for (int i = 0; i < 40; i++) {
+		added += window.add(maketestpick("later" + std::to_string(i), "S0",
+				100000.0 + i)) ? 1 : 0;
+	}
+	ASSERT_GT(added, 0);
+	ASSERT_EQ(added, static_cast<int>(window.size()));
+	ASSERT_GE(window.getoldest(), 100000.0);
+
+	// or at once after expire() moves it on
+	window.expire(200000.0);
+	ASSERT_TRUE(window.add(maketestpick("clock", "S0", 200000.0)));
+}
+
+// tests that the sites of evicted picks are forgotten without breaking
+// site queries
+TEST(PickWindowTest, PruneSites) {
+	detectionformats::pickwindow window(DURATION);
+	for (int i = 0; i < PICKCOUNT; i++) {
+		ASSERT_TRUE(window.add(maketestpick(std::to_string(i),
+				"S" + std::to_string(i), i)));
+	}
+
+	std::vector<const detectionformats::pick *> found;
+	for (int i = PICKCOUNT - 1; i >= PICKCOUNT - DURATION; i--) {
+		found.clear();
+		ASSERT_EQ(1, static_cast<int>(window.query(0.0, PICKCOUNT,
+				detectionformats::site("S" + std::to_string(i), "BHZ", "US",
+						"00"), found)));
+		ASSERT_STREQ(std::to_string(i).c_str(), found[0]->id.c_str());
+	}
+	found.clear();
+	ASSERT_EQ(0, static_cast<int>(window.query(0.0, PICKCOUNT,
+			detectionformats::site("S0", "BHZ", "US", "00"), found)));
+}
@@ -0,0 +1,76 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\"}"
+#define RETRACTSTRING "{\"Type\":\"Retract\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define INVALIDSTRING "{\"Type\":\"Retract\",\"ID\":\"\"}"
+#define BADSTRING "{\"Type\":"
+#define MESSAGECOUNT 1000
+
+// tests to see if every pushed message comes out of the pipeline
+TEST(PipelineTest, Messages) {
+	detectionformats::pipeline messagepipeline(16, 2, 2);
+
+	std::thread reader([&messagepipeline]() {
+		const char *mix[] = { PICKSTRING, RETRACTSTRING, INVALIDSTRING,
+		BADSTRING };
+		for (int i = 0; i < MESSAGECOUNT; i++) {
+			ASSERT_TRUE(messagepipeline.push(mix[i % 4]));
+		}
+		messagepipeline.close();
+	});
+
+	std::vector<int> seen(MESSAGECOUNT, 0);
+	detectionformats::pipeline::handle message;
+	while (messagepipeline.pop(message) == true) {
+		ASSERT_LT(message->sequence, (uint64_t) MESSAGECOUNT);
+		seen[message->sequence]++;
+
+		switch (message->sequence % 4) {
+			case 0:
+			case 1:
+				ASSERT_TRUE(message->result.isparsed());
+				ASSERT_TRUE(message->valid);
+				ASSERT_FALSE(message->json.empty());
+				break;
+			case 2:
+				ASSERT_TRUE(message->result.isparsed());
+				ASSERT_FALSE(message->valid);
+				break;
+			default:
+				ASSERT_FALSE(message->result.isparsed());
+				ASSERT_FALSE(message->valid);
+				ASSERT_TRUE(message->json.empty());
+				break;
+		}
+	}
+	reader.join();
+
+	for (int i = 0; i < MESSAGECOUNT; i++) {
+		ASSERT_EQ(seen[i], 1);
+	}
+
+	detectionformats::pipelinemetrics metrics = messagepipeline.getmetrics();
+	ASSERT_EQ(metrics.parse.processed, (uint64_t) MESSAGECOUNT);
+	ASSERT_EQ(metrics.validate.processed, (uint64_t) MESSAGECOUNT);
+	ASSERT_EQ(metrics.serialize.processed, (uint64_t) MESSAGECOUNT);
+	ASSERT_EQ(metrics.output.processed, (uint64_t) MESSAGECOUNT);
+	ASSERT_EQ(metrics.parse.depth, (size_t) 0);
+	ASSERT_LE(metrics.parse.maxdepth, (size_t) 16);
+
+	// closed
+	ASSERT_FALSE(messagepipeline.push(PICKSTRING));
+}
+
+// tests to see if a pipeline that is never drained can be destroyed
+TEST(PipelineTest, Destroy) {
+	// enough messages to fill the output queue, which nothing pops
+	detectionformats::pipeline messagepipeline(2);
+	for (int i = 0; i < 8; i++) {
+		ASSERT_TRUE(messagepipeline.push(PICKSTRING));
+	}
+}
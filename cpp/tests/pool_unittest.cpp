@@ -0,0 +1,91 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#include <string>
+
+// test data
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\",\"Polarity\":\"up\",\"Onset\":\"questionable\",\"Picker\":\"manual\",\"Filter\":[{\"HighPass\":1.05,\"LowPass\":2.65},{\"HighPass\":2.10,\"LowPass\":3.58}],\"Amplitude\":{\"Amplitude\":21.5,\"Period\":2.65,\"SNR\":3.8},\"Beam\":{\"BackAzimuth\":2.65,\"Slowness\":1.44,\"PowerRatio\":12.18,\"BackAzimuthError\":3.8,\"SlownessError\":0.4,\"PowerRatioError\":0.557},\"AssociationInfo\":{\"Phase\":\"P\",\"Distance\":0.442559,\"Azimuth\":0.418479,\"Residual\":-0.025393,\"Sigma\":0.086333}}"
+#define PICKSTRING2 "{\"Type\":\"Pick\",\"ID\":\"99ABC12345678901234567890\",\"Site\":{\"Station\":\"KNB\",\"Network\":\"UU\",\"Channel\":\"EHZ\",\"Location\":\"--\"},\"Source\":{\"AgencyID\":\"UU\",\"Author\":\"AnotherTestAuthor\"},\"Time\":\"2016-01-04T11:02:09.550Z\",\"Phase\":\"S\",\"Filter\":[{\"HighPass\":0.5,\"LowPass\":8.0}]}"
+
+#define ID "12GFH48776857"
+#define ID2 "99ABC12345678901234567890"
+#define STATION2 "KNB"
+#define AUTHOR2 "AnotherTestAuthor"
+#define PHASE2 "S"
+#define HIGHPASS2 0.5
+
+// tests to see if the pool hands out and reuses objects
+TEST(PoolTest, AcquireRelease) {
+	detectionformats::pickpool pool(2);
+
+	ASSERT_EQ(pool.size(), (size_t) 2);
+	ASSERT_EQ(pool.available(), (size_t) 2);
+
+	detectionformats::pick * first = pool.acquire();
+	detectionformats::pick * second = pool.acquire();
+	ASSERT_EQ(pool.available(), (size_t) 0);
+	ASSERT_NE(first, second);
+
+	// pool grows when empty
+	detectionformats::pick * third = pool.acquire();
+	ASSERT_NE(third, (detectionformats::pick *) NULL);
+	ASSERT_GT(pool.size(), (size_t) 2);
+
+	// released objects come back cleared
+	first->id = std::string(ID);
+	pool.release(first);
+	pool.release(second);
+	pool.release(third);
+
+	ASSERT_EQ(pool.available(), pool.size());
+
+	detectionformats::pick * reused = pool.acquire();
+	ASSERT_STREQ(reused->id.c_str(), "");
+	ASSERT_STREQ(reused->type.c_str(), PICK_TYPE);
+	pool.release(reused);
+}
+
+// tests to see if pooled objects are correctly overwritten in place
+TEST(PoolTest, ResetFromBuffer) {
+	detectionformats::pickpool pool(1);
+	std::string pickstring = std::string(PICKSTRING);
+	std::string pickstring2 = std::string(PICKSTRING2);
+
+	detectionformats::pick * pickobject = pool.acquire(pickstring.c_str(),
+			pickstring.length());
+	ASSERT_STREQ(pickobject->id.c_str(), ID);
+	ASSERT_EQ(pickobject->filterdata.size(), (size_t) 2);
+	ASSERT_FALSE(pickobject->beam.isempty());
+	ASSERT_TRUE(pickobject->isvalid());
+	pool.release(pickobject);
+
+	// the second message omits keys the first one had, they must not
+	// survive the reset
+	pickobject = pool.acquire(pickstring2.c_str(), pickstring2.length());
+	ASSERT_STREQ(pickobject->id.c_str(), ID2);
+	ASSERT_STREQ(pickobject->site.station.c_str(), STATION2);
+	ASSERT_STREQ(pickobject->site.location.c_str(), "--");
+	ASSERT_STREQ(pickobject->source.author.c_str(), AUTHOR2);
+	ASSERT_STREQ(pickobject->phase.c_str(), PHASE2);
+	ASSERT_STREQ(pickobject->polarity.c_str(), "");
+	ASSERT_STREQ(pickobject->picker.c_str(), "");
+	ASSERT_EQ(pickobject->filterdata.size(), (size_t) 1);
+	ASSERT_EQ(pickobject->filterdata[0].highpass, HIGHPASS2);
+	ASSERT_TRUE(pickobject->amplitude.isempty());
+	ASSERT_TRUE(pickobject->beam.isempty());
+	ASSERT_TRUE(pickobject->associationinfo.isempty());
+	ASSERT_EQ(pickobject->time,
+			detectionformats::ConvertISO8601ToEpochTime(
+					std::string("2016-01-04T11:02:09.550Z")));
+	pool.release(pickobject);
+
+	// bad json throws
+	std::string badstring = "{\"Type\":\"Pick\",";
+	bool threw = false;
+	try {
+		pool.acquire(badstring.c_str(), badstring.length());
+	} catch (const std::invalid_argument &) {
+		threw = true;
+	}
+	ASSERT_TRUE(threw);
+}
@@ -0,0 +1,117 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define CAPACITY 6
+#define ELEMENTCOUNT 100000
+#define THREADCOUNT 4
+
+// tests to see if spscqueue is first in first out and bounded
+TEST(QueueTest, SPSC) {
+	detectionformats::spscqueue<int> queue(CAPACITY);
+	ASSERT_EQ(queue.capacity(), (size_t) 8);
+
+	int value = 0;
+	ASSERT_FALSE(queue.trypop(value));
+
+	for (int i = 0; i < 8; i++) {
+		ASSERT_TRUE(queue.trypush(int(i)));
+	}
+	ASSERT_FALSE(queue.trypush(int(8)));
+	ASSERT_EQ(queue.size(), (size_t) 8);
+
+	for (int i = 0; i < 8; i++) {
+		ASSERT_TRUE(queue.trypop(value));
+		ASSERT_EQ(value, i);
+	}
+	ASSERT_FALSE(queue.trypop(value));
+}
+
+// tests to see if spscqueue passes every element between two threads in
+// order
+TEST(QueueTest, SPSCThreaded) {
+	detectionformats::spscqueue<int> queue(CAPACITY);
+
+	std::thread producer([&queue]() {
+		for (int i = 0; i < ELEMENTCOUNT; i++) {
+			while (queue.trypush(int(i)) == false) {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	for (int i = 0; i < ELEMENTCOUNT; i++) {
+		int value = -1;
+		while (queue.trypop(value) == false) {
+			std::this_thread::yield();
+		}
+		ASSERT_EQ(value, i);
+	}
+	producer.join();
+}
+
+// tests to see if mpmcqueue is first in first out and bounded
+TEST(QueueTest, MPMC) {
+	detectionformats::mpmcqueue<int> queue(CAPACITY);
+	ASSERT_EQ(queue.capacity(), (size_t) 8);
+
+	int value = 0;
+	ASSERT_FALSE(queue.trypop(value));
+
+	// go around the ring more than once
+	for (int lap = 0; lap < 3; lap++) {
+		for (int i = 0; i < 8; i++) {
+			ASSERT_TRUE(queue.trypush(int(i)));
+		}
+		ASSERT_FALSE(queue.trypush(int(8)));
+
+		for (int i = 0; i < 8; i++) {
+			ASSERT_TRUE(queue.trypop(value));
+			ASSERT_EQ(value, i);
+		}
+		ASSERT_FALSE(queue.trypop(value));
+	}
+}
+
+// tests to see if mpmcqueue delivers every element exactly once with
+// several producers and consumers
+TEST(QueueTest, MPMCThreaded) {
+	detectionformats::mpmcqueue<int> queue(CAPACITY);
+	std::vector<std::atomic<int>> seen(ELEMENTCOUNT);
+	for (size_t i = 0; i < seen.size(); i++) {
+		seen[i] = 0;
+	}
+	std::atomic<int> consumed(0);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < THREADCOUNT; t++) {
+		threads.push_back(std::thread([&queue, t]() {
+			for (int i = t; i < ELEMENTCOUNT; i += THREADCOUNT) {
+				while (queue.trypush(int(i)) == false) {
+					std::this_thread::yield();
+				}
+			}
+		}));
+		threads.push_back(std::thread([&queue, &seen, &consumed]() {
+			int value;
+			while (consumed.load() < ELEMENTCOUNT) {
+				if (queue.trypop(value) == true) {
+					seen[value]++;
+					consumed++;
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		}));
+	}
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+
+	for (size_t i = 0; i < seen.size(); i++) {
+		ASSERT_EQ(seen[i].load(), 1);
+	}
+}
@@ -0,0 +1,131 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define IDCOUNT 20000
+#define READERS 4
+
+// tests adding and looking up retractions
+TEST(RetractionIndexTest, Lookup) {
+	detectionformats::retractionindex index;
+	ASSERT_FALSE(index.isretracted("12GFH48776857"));
+
+	ASSERT_TRUE(
+			index.add(
+					detectionformats::retract("12GFH48776857", "US",
+							"TestAuthor")));
+	ASSERT_TRUE(index.isretracted("12GFH48776857"));
+	ASSERT_FALSE(index.isretracted("12GFH48776858"));
+
+	// by source
+	ASSERT_TRUE(
+			index.isretracted("12GFH48776857",
+					detectionformats::source("US", "TestAuthor")));
+	ASSERT_FALSE(
+			index.isretracted("12GFH48776857",
+					detectionformats::source("UW", "TestAuthor")));
+
+	// the same retraction again, another source, and no id
+	ASSERT_FALSE(
+			index.add(
+					detectionformats::retract("12GFH48776857", "US",
+							"TestAuthor")));
+	ASSERT_TRUE(
+			index.add(
+					detectionformats::retract("12GFH48776857", "UW",
+							"TestAuthor")));
+	ASSERT_TRUE(
+			index.isretracted("12GFH48776857",
+					detectionformats::source("UW", "TestAuthor")));
+	ASSERT_FALSE(index.add(detectionformats::retract("", "US", "TestAuthor")));
+	ASSERT_EQ(1, static_cast<int>(index.size()));
+
+	index.clear();
+	ASSERT_FALSE(index.isretracted("12GFH48776857"));
+	ASSERT_EQ(0, static_cast<int>(index.size()));
+}
+
+// tests an index holding far more than it was sized for
+TEST(RetractionIndexTest, Overfull) {
+	detectionformats::retractionindex index(16);
+	for (int i = 0; i < IDCOUNT; i += 2) {
+		index.add(
+				detectionformats::retract(std::to_string(i), "US",
+						"TestAuthor"));
+	}
+
+	// the filter passes nearly everything, the answers are still exact
+	for (int i = 0; i < IDCOUNT; i++) {
+		ASSERT_EQ((i % 2) == 0, index.isretracted(std::to_string(i)));
+	}
+}
+
+// tests forgetting retractions
+TEST(RetractionIndexTest, Expiry) {
+	// the first generation starts when the index is made
+	std::chrono::seconds timetolive(60);
+	detectionformats::retractionindex index(1024, timetolive);
+	detectionformats::retractionindex::clock::time_point start =
+			detectionformats::retractionindex::clock::now();
+
+	index.add(detectionformats::retract("1", "US", "TestAuthor"), start);
+	ASSERT_FALSE(index.expire(start + std::chrono::seconds(30)));
+
+	// one period on, the retraction is in the older generation
+	ASSERT_TRUE(
+			index.add(detectionformats::retract("2", "US", "TestAuthor"),
+					start + timetolive));
+	ASSERT_TRUE(index.isretracted("1"));
+	ASSERT_TRUE(index.isretracted("2"));
+
+	// two periods on, it is forgotten
+	ASSERT_TRUE(index.expire(start + 2 * timetolive));
+	ASSERT_FALSE(index.isretracted("1"));
+	ASSERT_TRUE(index.isretracted("2"));
+
+	// a jump past both generations forgets everything
+	ASSERT_TRUE(index.expire(start + 10 * timetolive));
+	ASSERT_FALSE(index.isretracted("2"));
+	ASSERT_EQ(0, static_cast<int>(index.size()));
+}
+
+// tests lookups on several threads while retractions are added
+TEST(RetractionIndexTest, Concurrent) {
+	detectionformats::retractionindex index(IDCOUNT);
+	std::atomic<int> added(0);
+	std::atomic<int> errors(0);
+
+	std::vector<std::thread> readers;
+	for (int r = 0; r < READERS; r++) {
+		readers.push_back(std::thread([&index, &added, &errors, r]() {
+			while (added.load() < IDCOUNT) {
+				int last = added.load() - 1;
+				if (last < 0) {
+					continue;
+				}
+
+				// every id added so far is found, none beyond the end are
+				if ((index.isretracted(std::to_string(last)) == false)
+						|| (index.isretracted("x" + std::to_string(last + r))
+								== true)) {
+					errors++;
+				}
+			}
+		}));
+	}
+
+	for (int i = 0; i < IDCOUNT; i++) {
+		index.add(detectionformats::retract(std::to_string(i), "US",
+				"TestAuthor"));
+		added++;
+	}
+	for (size_t r = 0; r < readers.size(); r++) {
+		readers[r].join();
+	}
+	ASSERT_EQ(0, errors.load());
+}
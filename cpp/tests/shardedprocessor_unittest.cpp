@@ -0,0 +1,103 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+#include "testpicks.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define RETRACTSTRING "{\"Type\":\"Retract\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define OTHERRETRACTSTRING "{\"Source\":{\"AgencyID\":\"NC\",\"Author\":\"Other\"},\"Type\":\"Retract\",\"ID\":\"12GFH48776857\"}"
+#define BADSTRING "{\"Type\":"
+#define STATIONCOUNT 20
+#define MESSAGECOUNT 2000
+
+// builds the json for a pick for station with the given id
+static std::string makepick(int station, int id) {
+	detectionformats::pick newpick = maketestpick(std::to_string(id),
+			"S" + std::to_string(station), 1451338344.017);
+	rapidjson::Document document;
+	return (detectionformats::ToJSONString(
+			newpick.tojson(document, document.GetAllocator())));
+}
+
+// tests choosing shards
+TEST(ShardedProcessorTest, GetShard) {
+	detectionformats::shardedprocessor processor(
+			[](detectionformats::pipelinemessage &) {
+			}, 8, 16, false);
+	ASSERT_EQ(8, static_cast<int>(processor.getshardcount()));
+
+	// a site always goes to the same shard, whatever else the message says
+	ASSERT_EQ(processor.getshard(makepick(1, 1)),
+				processor.getshard(makepick(1, 2)));
+
+	// messages without a site go by ID
+	ASSERT_EQ(processor.getshard(RETRACTSTRING),
+				processor.getshard(OTHERRETRACTSTRING));
+
+	// and broken messages still go somewhere
+	ASSERT_GT(8, static_cast<int>(processor.getshard(BADSTRING)));
+
+	// sites are spread over the shards
+	std::vector<int> used(8, 0);
+	for (int i = 0; i < 100; i++) {
+		used[processor.getshard(makepick(i, 0))] = 1;
+	}
+	for (size_t i = 0; i < used.size(); i++) {
+		ASSERT_EQ(1, used[i]);
+	}
+}
+
+// tests that each station's messages are handled in order
+TEST(ShardedProcessorTest, Order) {
+	std::mutex lock;
+	std::map<std::string, std::vector<int>> seen;
+	size_t invalid = 0;
+
+	detectionformats::shardedprocessor processor(
+			[&lock, &seen, &invalid](
+					detectionformats::pipelinemessage &message) {
+				std::lock_guard<std::mutex> guard(lock);
+				if (message.valid == false) {
+					invalid++;
+					return;
+				}
+				std::shared_ptr<detectionformats::pick> pick =
+						message.result.get<detectionformats::pick>();
+				seen[pick->site.station].push_back(std::stoi(pick->id));
+			}, 4, 8);
+
+	for (int i = 0; i < MESSAGECOUNT; i++) {
+		ASSERT_TRUE(processor.push(makepick(i % STATIONCOUNT, i)));
+	}
+	ASSERT_TRUE(processor.push(BADSTRING));
+	processor.close();
+	ASSERT_FALSE(processor.push(makepick(0, 0)));
+
+	ASSERT_EQ(1, static_cast<int>(invalid));
+	ASSERT_EQ(STATIONCOUNT, static_cast<int>(seen.size()));
+	for (std::map<std::string, std::vector<int>>::iterator station =
+			seen.begin(); station != seen.end(); ++station) {
+		ASSERT_EQ(MESSAGECOUNT / STATIONCOUNT,
+					static_cast<int>(station->second.size()));
+		for (size_t i = 1; i < station->second.size(); i++) {
+			ASSERT_LT(station->second[i - 1], station->second[i]);
+		}
+	}
+
+	detectionformats::shardedmetrics metrics = processor.getmetrics();
+	ASSERT_EQ(4, static_cast<int>(metrics.shards.size()));
+	uint64_t processed = 0;
+	for (size_t i = 0; i < metrics.shards.size(); i++) {
+		processed += metrics.shards[i].processed;
+		ASSERT_EQ(0, static_cast<int>(metrics.shards[i].depth));
+#if defined(__linux__)
+		ASSERT_GE(metrics.shards[i].cpu, 0);
+#endif
+	}
+	ASSERT_EQ(MESSAGECOUNT + 1, static_cast<int>(processed));
+	ASSERT_GE(metrics.imbalance, 1.0);
+	ASSERT_LE(metrics.imbalance, 4.0);
+}
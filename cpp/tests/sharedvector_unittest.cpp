@@ -0,0 +1,136 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#define ID "12GFH48776857"
+#define ID2 "99ABC12345678901234567890"
+
+// tests to see if sharedvector copies share elements
+TEST(SharedVectorTest, CopySharesElements) {
+	detectionformats::sharedvector<detectionformats::pick> pickdata;
+	ASSERT_TRUE(pickdata.empty());
+
+	detectionformats::pick pickobject;
+	pickobject.id = std::string(ID);
+	pickdata.push_back(pickobject);
+	pickdata.emplace_back().id = std::string(ID2);
+
+	ASSERT_EQ(pickdata.size(), (size_t) 2);
+	ASSERT_FALSE(pickdata.isshared(0));
+
+	detectionformats::sharedvector<detectionformats::pick> copydata(pickdata);
+	ASSERT_EQ(copydata.size(), (size_t) 2);
+	ASSERT_TRUE(pickdata.isshared(0));
+	ASSERT_TRUE(copydata.isshared(1));
+	ASSERT_EQ(&copydata.shared(0), &pickdata.shared(0));
+
+	// const access does not detach
+	const detectionformats::sharedvector<detectionformats::pick> & constdata =
+			copydata;
+	ASSERT_STREQ(constdata[1].id.c_str(), ID2);
+	ASSERT_TRUE(copydata.isshared(1));
+}
+
+// tests to see if sharedvector detaches elements on write
+TEST(SharedVectorTest, CopyOnWrite) {
+	std::vector<detectionformats::pick> newpickdata(2);
+	newpickdata[0].id = std::string(ID);
+	newpickdata[1].id = std::string(ID);
+
+	detectionformats::sharedvector<detectionformats::pick> pickdata;
+	pickdata = newpickdata;
+	detectionformats::sharedvector<detectionformats::pick> copydata = pickdata;
+
+	copydata[0].id = std::string(ID2);
+
+	// only the written element was copied
+	ASSERT_STREQ(copydata[0].id.c_str(), ID2);
+	ASSERT_STREQ(pickdata[0].id.c_str(), ID);
+	ASSERT_FALSE(copydata.isshared(0));
+	ASSERT_FALSE(pickdata.isshared(0));
+	ASSERT_TRUE(pickdata.isshared(1));
+
+	// sharing by handle between vectors, the handles are read only and a
+	// write through the other vector copies the element
+	static_assert(std::is_const<std::remove_reference<
+			decltype(*pickdata.gethandle(1))>::type>::value,
+			"sharedvector handles must be read only");
+	detectionformats::sharedvector<detectionformats::pick> otherdata;
+	otherdata.push_back(pickdata.gethandle(1));
+	ASSERT_EQ(&otherdata.shared(0), &pickdata.shared(1));
+	otherdata[0].id = std::string(ID2);
+	ASSERT_STREQ(pickdata.shared(1).id.c_str(), ID);
+	otherdata.clear();
+	otherdata.push_back(pickdata.gethandle(1));
+
+	// clearing releases references
+	copydata.clear();
+	ASSERT_TRUE(copydata.empty());
+	ASSERT_TRUE(pickdata.isshared(1));
+	otherdata.clear();
+	ASSERT_FALSE(pickdata.isshared(1));
+}
+
+// tests the sharedvector iterators and vector members
+TEST(SharedVectorTest, VectorMembers) {
+	std::vector<detectionformats::pick> newpickdata(3);
+	newpickdata[0].id = "pick0";
+	newpickdata[1].id = "pick1";
+	newpickdata[2].id = "pick2";
+
+	detectionformats::sharedvector<detectionformats::pick> pickdata(
+			newpickdata);
+	detectionformats::sharedvector<detectionformats::pick> copydata = pickdata;
+
+	// read only iteration does not detach
+	std::vector<std::string> ids;
+	for (detectionformats::sharedvector<detectionformats::pick>::const_iterator
+			item = copydata.cbegin(); item != copydata.cend(); ++item) {
+		ids.push_back(item->id);
+	}
+	ASSERT_EQ(3, static_cast<int>(ids.size()));
+	ASSERT_STREQ(ids[2].c_str(), "pick2");
+	ASSERT_TRUE(copydata.isshared(0));
+	ASSERT_TRUE(copydata.isshared(2));
+
+	// writing through an iterator detaches only that element
+	for (detectionformats::pick &item : copydata) {
+		item.phase = "P";
+	}
+	ASSERT_FALSE(copydata.isshared(1));
+	ASSERT_STREQ(copydata[1].phase.c_str(), "P");
+	ASSERT_STREQ(pickdata[1].phase.c_str(), "");
+	copydata.back().phase = "S";
+	ASSERT_STREQ(copydata[2].phase.c_str(), "S");
+	ASSERT_STREQ(pickdata.back().phase.c_str(), "");
+
+	// bounds checked access
+	ASSERT_STREQ(pickdata.at(0).id.c_str(), "pick0");
+	ASSERT_THROW(pickdata.at(3), std::out_of_range);
+
+	// insert, erase and resize
+	detectionformats::sharedvector<detectionformats::pick> otherdata;
+	otherdata.insert(otherdata.end(), pickdata.gethandle(2));
+	otherdata.insert(otherdata.begin(), pickdata.front());
+	ASSERT_EQ(2, static_cast<int>(otherdata.size()));
+	ASSERT_STREQ(otherdata[0].id.c_str(), "pick0");
+	ASSERT_TRUE(pickdata.isshared(2));
+	otherdata.erase(otherdata.begin());
+	ASSERT_STREQ(otherdata.front().id.c_str(), "pick2");
+	otherdata.resize(3);
+	ASSERT_EQ(3, static_cast<int>(otherdata.size()));
+	ASSERT_STREQ(otherdata[2].id.c_str(), "");
+	otherdata.erase(otherdata.begin() + 1, otherdata.end());
+	otherdata.pop_back();
+	ASSERT_TRUE(otherdata.empty());
+
+	// copying into a std::vector
+	std::vector<detectionformats::pick> vectordata(pickdata.cbegin(),
+			pickdata.cend());
+	ASSERT_EQ(3, static_cast<int>(vectordata.size()));
+	ASSERT_STREQ(vectordata[1].id.c_str(), "pick1");
+}
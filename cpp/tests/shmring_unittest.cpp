@@ -0,0 +1,224 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define PICKSTRING "{\"Type\":\"Pick\",\"ID\":\"12GFH48776857\",\"Site\":{\"Station\":\"BMN\",\"Network\":\"LB\",\"Channel\":\"HHZ\",\"Location\":\"01\"},\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"},\"Time\":\"2015-12-28T21:32:24.017Z\",\"Phase\":\"P\"}"
+#define RETRACTSTRING "{\"Type\":\"Retract\",\"ID\":\"12GFH48776857\",\"Source\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define BADSTRING "{\"Type\":"
+
+// a ring name unique to this test process
+static std::string ringname(const std::string &test) {
+	return ("/detectionformats-" + test + "-" + std::to_string(getpid()));
+}
+
+// tests pushing and popping json
+TEST(ShmRingTest, JSON) {
+	detectionformats::shmring ring(ringname("json"), 1);
+	ASSERT_EQ(4096, ring.capacity());
+	ASSERT_EQ(0, ring.size());
+
+	detectionformats::parseresult result;
+	ASSERT_FALSE(ring.trypop(result));
+
+	ASSERT_TRUE(ring.trypushjson(PICKSTRING, std::strlen(PICKSTRING)));
+	ASSERT_TRUE(ring.trypushjson(RETRACTSTRING, std::strlen(RETRACTSTRING)));
+	ASSERT_TRUE(ring.trypushjson(BADSTRING, std::strlen(BADSTRING)));
+	ASSERT_GT(ring.size(), 0);
+
+	ASSERT_TRUE(ring.trypop(result));
+	ASSERT_EQ(detectionformats::formattypes::picktype, result.type);
+	ASSERT_EQ("12GFH48776857", result.get<detectionformats::pick>()->id);
+
+	ASSERT_TRUE(ring.pop(result, 0));
+	ASSERT_EQ(detectionformats::formattypes::retracttype, result.type);
+
+	ASSERT_TRUE(ring.trypop(result));
+	ASSERT_FALSE(result.isparsed());
+	ASSERT_FALSE(result.error.empty());
+
+	ASSERT_FALSE(ring.trypop(result));
+	ASSERT_EQ(0, ring.size());
+
+	// empty and oversized messages are refused
+	ASSERT_FALSE(ring.trypushjson(PICKSTRING, 0));
+	std::string large(2048, ' ');
+	ASSERT_FALSE(ring.trypushjson(large.data(), large.length()));
+	ASSERT_EQ(0, ring.size());
+	ASSERT_THROW(ring.pushjson(large.data(), large.length()),
+			std::invalid_argument);
+}
+
+// tests pushing and popping binary
+TEST(ShmRingTest, Binary) {
+	detectionformats::shmring ring(ringname("binary"), 4096);
+
+	rapidjson::Document document;
+	detectionformats::pick pickobject(
+			detectionformats::FromJSONString(std::string(PICKSTRING),
+					document));
+	detectionformats::retract retractobject(
+			detectionformats::FromJSONString(std::string(RETRACTSTRING),
+					document));
+
+	ASSERT_TRUE(ring.trypush(pickobject));
+	ASSERT_TRUE(ring.push(retractobject, 0));
+
+	detectionformats::parseresult result;
+	ASSERT_TRUE(ring.pop(result));
+	ASSERT_EQ(detectionformats::formattypes::picktype, result.type);
+	ASSERT_TRUE(*result.get<detectionformats::pick>() == pickobject);
+
+	ASSERT_TRUE(ring.pop(result));
+	ASSERT_EQ(detectionformats::formattypes::retracttype, result.type);
+	ASSERT_TRUE(*result.get<detectionformats::retract>() == retractobject);
+}
+
+// tests a full ring, an empty one, and wrapping around the end
+TEST(ShmRingTest, Wrap) {
+	detectionformats::shmring ring(ringname("wrap"), 4096);
+	size_t length = std::strlen(PICKSTRING);
+
+	size_t pushed = 0;
+	while (ring.trypushjson(PICKSTRING, length) == true) {
+		pushed++;
+	}
+	ASSERT_GT(pushed, 0);
+	ASSERT_FALSE(ring.pushjson(PICKSTRING, length, 10));
+
+	// cycle enough messages to wrap many times, with some room left so the
+	// records land at different offsets each time around
+	detectionformats::parseresult result;
+	ASSERT_TRUE(ring.pop(result));
+	ASSERT_TRUE(ring.pop(result));
+	for (size_t i = 0; i < 1000; i++) {
+		ASSERT_TRUE(ring.trypushjson(RETRACTSTRING, std::strlen(RETRACTSTRING)));
+		ASSERT_TRUE(ring.trypop(result));
+		ASSERT_TRUE(result.isparsed());
+	}
+
+	size_t popped = 0;
+	while (ring.trypop(result) == true) {
+		ASSERT_TRUE(result.isparsed());
+		popped++;
+	}
+	ASSERT_EQ(pushed - 2, popped);
+	ASSERT_FALSE(ring.pop(result, 10));
+	ASSERT_EQ(0, ring.size());
+}
+
+// tests several producer threads, each with its own shmring
+TEST(ShmRingTest, Producers) {
+	std::string name = ringname("producers");
+	detectionformats::shmring reader(name, 8192);
+
+	const size_t producercount = 4;
+	const size_t messagecount = 2000;
+	std::vector<std::thread> producers;
+	for (size_t i = 0; i < producercount; i++) {
+		producers.push_back(std::thread([name]() {
+			detectionformats::shmring writer(name);
+			for (size_t j = 0; j < messagecount; j++) {
+				writer.pushjson(PICKSTRING, std::strlen(PICKSTRING));
+			}
+		}));
+	}
+
+	detectionformats::parseresult result;
+	size_t popped = 0;
+	while (popped < producercount * messagecount) {
+		ASSERT_TRUE(reader.pop(result, 10000));
+		ASSERT_EQ(detectionformats::formattypes::picktype, result.type);
+		popped++;
+	}
+	for (size_t i = 0; i < producers.size(); i++) {
+		producers[i].join();
+	}
+	ASSERT_FALSE(reader.trypop(result));
+}
+
+// tests a producer in another process
+TEST(ShmRingTest, Process) {
+	std::string name = ringname("process");
+	detectionformats::shmring reader(name, 4096);
+
+	const size_t messagecount = 500;
+	pid_t child = fork();
+	ASSERT_GE(child, 0);
+	if (child == 0) {
+		detectionformats::shmring writer(name);
+		rapidjson::Document document;
+		detectionformats::pick pickobject(
+				detectionformats::FromJSONString(std::string(PICKSTRING),
+						document));
+		for (size_t i = 0; i < messagecount; i++) {
+			if (writer.push(pickobject, 10000) == false) {
+				_exit(1);
+			}
+		}
+		_exit(0);
+	}
+
+	detectionformats::parseresult result;
+	size_t popped = 0;
+	while ((popped < messagecount) && (reader.pop(result, 10000) == true)) {
+		ASSERT_EQ(detectionformats::formattypes::picktype, result.type);
+		popped++;
+	}
+
+	int status = 0;
+	waitpid(child, &status, 0);
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ(0, WEXITSTATUS(status));
+	ASSERT_EQ(messagecount, popped);
+
+	// a name that is not a ring is refused
+	ASSERT_THROW(detectionformats::shmring missing(ringname("missing")),
+			std::runtime_error);
+}
+
+// tests creating a ring whose name is in use
+TEST(ShmRingTest, Existing) {
+	std::string name = ringname("existing");
+	{
+		detectionformats::shmring ring(name, 4096);
+
+		// a ring in use is never replaced
+		ASSERT_THROW(detectionformats::shmring second(name, 4096),
+				std::runtime_error);
+		ASSERT_THROW(detectionformats::shmring second(name, 4096, true),
+				std::runtime_error);
+		ASSERT_TRUE(ring.trypushjson(PICKSTRING, std::strlen(PICKSTRING)));
+		detectionformats::parseresult result;
+		ASSERT_TRUE(ring.trypop(result));
+	}
+
+	// a ring left behind by a process that exited without destroying it
+	pid_t child = fork();
+	ASSERT_GE(child, 0);
+	if (child == 0) {
+		new detectionformats::shmring(name, 4096);
+		_exit(0);
+	}
+	int status = 0;
+	waitpid(child, &status, 0);
+	ASSERT_TRUE(WIFEXITED(status));
+
+	ASSERT_THROW(detectionformats::shmring refused(name, 4096),
+			std::runtime_error);
+	detectionformats::shmring replaced(name, 8192, true);
+	ASSERT_EQ(8192, replaced.capacity());
+	ASSERT_TRUE(replaced.trypushjson(RETRACTSTRING,
+			std::strlen(RETRACTSTRING)));
+}
+
+#endif
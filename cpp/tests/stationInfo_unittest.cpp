@@ -241,3 +241,23 @@ TEST(StationInfoTest, Validate) {
 	// check return code
 	ASSERT_EQ(result, false)<< "Tested for unsuccessful validation.";
 }
+
+// tests to see if stationInfo survives a binary round trip
+TEST(StationInfoTest, Binary) {
+	rapidjson::Document stationdocument;
+	detectionformats::stationInfo stationobject(
+			detectionformats::FromJSONString(std::string(STATIONSTRING),
+					stationdocument));
+
+	std::string buffer;
+	stationobject.tobinary(buffer);
+
+	detectionformats::stationInfo stationobject2;
+	ASSERT_EQ(stationobject2.frombinary(buffer.data(), buffer.size()),
+			buffer.size());
+	ASSERT_TRUE(stationobject2 == stationobject);
+	checkdata(stationobject2, "");
+
+	stationobject2.enable = false;
+	ASSERT_TRUE(stationobject2 != stationobject);
+}
@@ -0,0 +1,142 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#define STATIONCOUNT 3000
+#define QUERYCOUNT 200
+
+// builds station i at latitude, longitude
+static detectionformats::stationInfo makeindexstation(int i, double latitude,
+		double longitude, bool enable, bool teleseismic) {
+	return (detectionformats::stationInfo("S" + std::to_string(i), "BHZ", "US",
+			"00", latitude, longitude, 0.0, 1.0, enable, teleseismic, "US",
+			"TestAuthor"));
+}
+
+// the haversine distance in degrees
+static double haversine(double latitude1, double longitude1, double latitude2,
+		double longitude2) {
+	double radians = 3.14159265358979323846 / 180.0;
+	double dlatitude = (latitude2 - latitude1) * radians;
+	double dlongitude = (longitude2 - longitude1) * radians;
+	double a = std::sin(dlatitude / 2) * std::sin(dlatitude / 2)
+			+ std::cos(latitude1 * radians) * std::cos(latitude2 * radians)
+					* std::sin(dlongitude / 2) * std::sin(dlongitude / 2);
+	return (2 * std::asin(std::min(1.0, std::sqrt(a))) / radians);
+}
+
+// tests distances and azimuths
+TEST(StationIndexTest, Measure) {
+	detectionformats::stationinventory inventory;
+	inventory.add(makeindexstation(0, 10.0, 0.0, true, false));
+	inventory.add(makeindexstation(1, 0.0, 20.0, true, false));
+	inventory.add(makeindexstation(2, -30.0, 0.0, true, false));
+	inventory.add(makeindexstation(3, 0.0, -40.0, true, false));
+	inventory.add(makeindexstation(4, 0.0, 1.0, false, false));
+
+	detectionformats::stationindex index(inventory);
+	ASSERT_EQ(4, static_cast<int>(index.size()));
+
+	std::vector<detectionformats::stationdistance> found = index.nearest(0.0,
+			0.0, 10);
+	ASSERT_EQ(4, static_cast<int>(found.size()));
+
+	// nearest first, the disabled station left out
+	ASSERT_EQ(0u, found[0].id);
+	ASSERT_NEAR(10.0, found[0].distance, 0.000001);
+	ASSERT_NEAR(0.0, found[0].azimuth, 0.000001);
+	ASSERT_EQ(1u, found[1].id);
+	ASSERT_NEAR(20.0, found[1].distance, 0.000001);
+	ASSERT_NEAR(90.0, found[1].azimuth, 0.000001);
+	ASSERT_EQ(2u, found[2].id);
+	ASSERT_NEAR(30.0, found[2].distance, 0.000001);
+	ASSERT_NEAR(180.0, found[2].azimuth, 0.000001);
+	ASSERT_EQ(3u, found[3].id);
+	ASSERT_NEAR(40.0, found[3].distance, 0.000001);
+	ASSERT_NEAR(270.0, found[3].azimuth, 0.000001);
+
+	// a hypocenter's depth does not matter
+	detectionformats::hypocenter origin(0.0, 0.0, 0.0, 100.0,
+			std::nan(""), std::nan(""), std::nan(""), std::nan(""));
+	found = index.within(origin, 25.0);
+	ASSERT_EQ(2, static_cast<int>(found.size()));
+	ASSERT_EQ(0u, found[0].id);
+	ASSERT_EQ(1u, found[1].id);
+
+	ASSERT_EQ(0, static_cast<int>(index.within(0.0, 0.0, 5.0).size()));
+	ASSERT_EQ(4, static_cast<int>(index.within(0.0, 0.0, 180.0).size()));
+	ASSERT_EQ(0, static_cast<int>(index.nearest(0.0, 0.0, 0).size()));
+
+	detectionformats::stationinventory empty;
+	detectionformats::stationindex emptyindex(empty);
+	ASSERT_EQ(0, static_cast<int>(emptyindex.nearest(0.0, 0.0, 5).size()));
+	ASSERT_EQ(0, static_cast<int>(emptyindex.within(0.0, 0.0, 5).size()));
+}
+
+// tests queries against a brute force search
+TEST(StationIndexTest, BruteForce) {
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+	detectionformats::stationinventory inventory;
+	std::vector<double> latitudes;
+	std::vector<double> longitudes;
+	std::vector<bool> enabled;
+	std::vector<bool> teleseismic;
+	for (int i = 0; i < STATIONCOUNT; i++) {
+		// uniform on the sphere
+		latitudes.push_back(
+				std::asin(2 * unit(generator) - 1) * 180.0
+						/ 3.14159265358979323846);
+		longitudes.push_back(360.0 * unit(generator) - 180.0);
+		enabled.push_back(unit(generator) < 0.9);
+		teleseismic.push_back(unit(generator) < 0.3);
+		inventory.add(makeindexstation(i, latitudes[i], longitudes[i],
+				enabled[i], teleseismic[i]));
+	}
+	detectionformats::stationindex index(inventory);
+
+	for (int q = 0; q < QUERYCOUNT; q++) {
+		double latitude = std::asin(2 * unit(generator) - 1) * 180.0
+				/ 3.14159265358979323846;
+		double longitude = 360.0 * unit(generator) - 180.0;
+		bool onlyteleseismic = (q % 2) == 1;
+
+		std::vector<std::pair<double, uint32_t>> expected;
+		for (int i = 0; i < STATIONCOUNT; i++) {
+			if ((enabled[i] == false)
+					|| ((onlyteleseismic == true) && (teleseismic[i] == false))) {
+				continue;
+			}
+			expected.push_back(
+					std::make_pair(
+							haversine(latitude, longitude, latitudes[i],
+									longitudes[i]), static_cast<uint32_t>(i)));
+		}
+		std::sort(expected.begin(), expected.end());
+
+		std::vector<detectionformats::stationdistance> found = index.nearest(
+				latitude, longitude, 10, onlyteleseismic);
+		ASSERT_EQ(10, static_cast<int>(found.size()));
+		for (size_t i = 0; i < found.size(); i++) {
+			ASSERT_EQ(expected[i].second, found[i].id);
+			ASSERT_NEAR(expected[i].first, found[i].distance, 0.000001);
+		}
+
+		double radius = 5.0 + 20.0 * unit(generator);
+		size_t inside = 0;
+		while ((inside < expected.size()) && (expected[inside].first <= radius)) {
+			inside++;
+		}
+		found = index.within(latitude, longitude, radius, onlyteleseismic);
+		ASSERT_EQ(inside, found.size());
+		for (size_t i = 0; i < found.size(); i++) {
+			ASSERT_EQ(expected[i].second, found[i].id);
+		}
+	}
+}
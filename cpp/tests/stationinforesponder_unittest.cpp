@@ -0,0 +1,87 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// builds a request for station from agency
+static detectionformats::stationInfoRequest makerequest(
+		const std::string &station, const std::string &agency) {
+	return (detectionformats::stationInfoRequest(station, "BHZ", "US", "00",
+			agency, "TestAuthor"));
+}
+
+// builds the response the slow way, for comparison
+static std::string expectedresponse(
+		const detectionformats::stationinventory &inventory,
+		const std::string &station, const std::string &agency) {
+	detectionformats::stationInfo info = inventory.getstation(
+			inventory.find(station, "BHZ", "US", "00"));
+	info.informationRequestor = detectionformats::source(agency, "TestAuthor");
+	rapidjson::Document document;
+	return (detectionformats::ToJSONString(
+			info.tojson(document, document.GetAllocator())));
+}
+
+// tests coalescing requests and answering them
+TEST(StationInfoResponderTest, Respond) {
+	detectionformats::stationinventory inventory;
+	inventory.add(detectionformats::stationInfo("BOZ", "BHZ", "US", "00",
+			45.59697, -111.62967, 1589.0, 1.0, true, true, "US", "TestAuthor"));
+	inventory.add(detectionformats::stationInfo("HLID", "BHZ", "US", "00",
+			43.5625, -114.4138, 1772.0, std::nan(""), false, false, "US",
+			"TestAuthor"));
+
+	detectionformats::stationinforesponder responder(inventory,
+			std::chrono::milliseconds(100));
+	detectionformats::stationinforesponder::clock::time_point start =
+			detectionformats::stationinforesponder::clock::now();
+
+	ASSERT_TRUE(responder.add(makerequest("BOZ", "US"), start));
+	ASSERT_FALSE(responder.add(makerequest("BOZ", "US"), start));
+	ASSERT_TRUE(responder.add(makerequest("BOZ", "NC"), start));
+	ASSERT_TRUE(responder.add(makerequest("HLID", "US"), start));
+	ASSERT_TRUE(responder.add(makerequest("NONE", "US"), start));
+	ASSERT_FALSE(responder.add(makerequest("", "US"), start));
+	ASSERT_EQ(4, static_cast<int>(responder.getpending()));
+
+	// nothing is answered until the window has passed
+	std::vector<std::string> responses;
+	ASSERT_FALSE(responder.isready(start + std::chrono::milliseconds(50)));
+	ASSERT_EQ(0, static_cast<int>(responder.poll(responses,
+			start + std::chrono::milliseconds(50))));
+	ASSERT_TRUE(responder.isready(start + std::chrono::milliseconds(100)));
+	ASSERT_EQ(3, static_cast<int>(responder.poll(responses,
+			start + std::chrono::milliseconds(100))));
+	ASSERT_EQ(0, static_cast<int>(responder.getpending()));
+	ASSERT_FALSE(responder.isready(start + std::chrono::milliseconds(200)));
+
+	// the responses match serializing each one in full
+	ASSERT_EQ(3, static_cast<int>(responses.size()));
+	ASSERT_EQ(expectedresponse(inventory, "BOZ", "US"), responses[0]);
+	ASSERT_EQ(expectedresponse(inventory, "BOZ", "NC"), responses[1]);
+	ASSERT_EQ(expectedresponse(inventory, "HLID", "US"), responses[2]);
+
+	rapidjson::Document document;
+	detectionformats::stationInfo parsed(
+			detectionformats::FromJSONString(responses[1], document));
+	ASSERT_TRUE(parsed.isvalid());
+	ASSERT_EQ("BOZ", parsed.site.station);
+	ASSERT_EQ("NC", parsed.informationRequestor.agencyid);
+	ASSERT_NEAR(45.59697, parsed.latitude, 0.00001);
+
+	detectionformats::respondermetrics metrics = responder.getmetrics();
+	ASSERT_EQ(6u, metrics.requests);
+	ASSERT_EQ(1u, metrics.coalesced);
+	ASSERT_EQ(1u, metrics.invalid);
+	ASSERT_EQ(3u, metrics.lookups);
+	ASSERT_EQ(1u, metrics.unknown);
+	ASSERT_EQ(3u, metrics.responses);
+
+	// a request already answered is answered again in a later window
+	ASSERT_TRUE(responder.add(makerequest("BOZ", "US")));
+	ASSERT_EQ(1, static_cast<int>(responder.flush(responses)));
+	ASSERT_EQ(responses[0], responses[3]);
+}
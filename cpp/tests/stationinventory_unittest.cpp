@@ -0,0 +1,257 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#define STATIONSTRING "{\"Site\":{\"Station\":\"BOZ\",\"Channel\":\"BHZ\",\"Network\":\"US\",\"Location\":\"00\"},\"Enable\":true,\"Quality\":1.0,\"Type\":\"StationInfo\",\"Elevation\":1589.0,\"UseForTeleseismic\":true,\"Latitude\":45.59697,\"Longitude\":-111.62967,\"InformationRequestor\":{\"AgencyID\":\"US\",\"Author\":\"TestAuthor\"}}"
+#define LATITUDE 45.596970
+#define LONGITUDE -111.629670
+#define ELEVATION 1589.000000
+#define STATIONCOUNT 5000
+
+// snapshot header offsets, the slots follow the header
+#define SNAPSHOTTABLESIZE 24
+#define SNAPSHOTCHECKSUM 48
+#define SNAPSHOTHEADERSIZE 64
+
+// builds station i
+static detectionformats::stationInfo makestation(int i, double latitude) {
+	return (detectionformats::stationInfo("S" + std::to_string(i), "BHZ",
+			"N" + std::to_string(i % 7), "00", latitude, i * 0.01, 100.0 + i,
+			std::nan(""), (i % 2) == 0, (i % 3) == 0, "US", "TestAuthor"));
+}
+
+// tests adding and finding a station
+TEST(StationInventoryTest, AddFind) {
+	detectionformats::stationinventory inventory;
+	ASSERT_EQ(0, static_cast<int>(inventory.size()));
+	ASSERT_EQ(detectionformats::stationinventory::npos,
+			inventory.find("BOZ", "BHZ", "US", "00"));
+
+	rapidjson::Document document;
+	detectionformats::stationInfo station(
+			detectionformats::FromJSONString(std::string(STATIONSTRING),
+					document));
+	uint32_t id = inventory.add(station);
+	ASSERT_EQ(0u, id);
+	ASSERT_EQ(1, static_cast<int>(inventory.size()));
+
+	// every way of finding it gives the same ID
+	ASSERT_EQ(id, inventory.find("BOZ", "BHZ", "US", "00"));
+	ASSERT_EQ(id, inventory.find(station.site));
+	ASSERT_EQ(id, inventory.find(std::string("BOZ.BHZ.US.00")));
+	ASSERT_EQ("BOZ.BHZ.US.00", inventory.getkey(id));
+	ASSERT_EQ("BOZ.BHZ.US.00",
+			detectionformats::stationinventory::makekey(station.site));
+
+	ASSERT_NEAR(LATITUDE, inventory.getlatitudes()[id], 0.00001);
+	ASSERT_NEAR(LONGITUDE, inventory.getlongitudes()[id], 0.00001);
+	ASSERT_NEAR(ELEVATION, inventory.getelevations()[id], 0.00001);
+	ASSERT_NEAR(1.0, inventory.getqualities()[id], 0.00001);
+	ASSERT_TRUE(inventory.isenabled(id));
+	ASSERT_TRUE(inventory.isteleseismic(id));
+
+	// near misses are not found
+	ASSERT_EQ(detectionformats::stationinventory::npos,
+			inventory.find("BOZ", "BHZ", "US", "01"));
+	ASSERT_EQ(detectionformats::stationinventory::npos,
+			inventory.find("BO", "ZBHZ", "US", "00"));
+	ASSERT_EQ(detectionformats::stationinventory::npos,
+			inventory.find(std::string("BOZ.BHZ")));
+
+	// a later message for the site replaces its values
+	station.latitude = 10.0;
+	station.enable = false;
+	ASSERT_EQ(id, inventory.add(station));
+	ASSERT_EQ(1, static_cast<int>(inventory.size()));
+	ASSERT_NEAR(10.0, inventory.getlatitudes()[id], 0.00001);
+	ASSERT_FALSE(inventory.isenabled(id));
+}
+
+// tests many stations, growing the table
+TEST(StationInventoryTest, Grow) {
+	detectionformats::stationinventory inventory(16);
+	for (int i = 0; i < STATIONCOUNT; i++) {
+		ASSERT_EQ(static_cast<uint32_t>(i),
+				inventory.add(makestation(i, i * 0.001)));
+	}
+	ASSERT_EQ(STATIONCOUNT, static_cast<int>(inventory.size()));
+
+	for (int i = 0; i < STATIONCOUNT; i++) {
+		uint32_t id = inventory.find(makestation(i, 0).site);
+		ASSERT_EQ(static_cast<uint32_t>(i), id);
+		ASSERT_NEAR(i * 0.001, inventory.getlatitudes()[id], 0.00001);
+		ASSERT_NEAR(100.0 + i, inventory.getelevations()[id], 0.00001);
+		ASSERT_TRUE(std::isnan(inventory.getqualities()[id]));
+		ASSERT_EQ((i % 2) == 0, inventory.isenabled(id));
+		ASSERT_EQ((i % 3) == 0, inventory.isteleseismic(id));
+	}
+}
+
+#if !defined(_WIN32)
+// gets a temporary file path
+static std::string inventorypath(const std::string &suffix) {
+	return ("/tmp/detectionformats-inventory-test-" + std::to_string(getpid())
+			+ suffix);
+}
+
+// writes contents to path
+static void writeinventory(const std::string &path,
+		const std::string &contents) {
+	FILE *file = std::fopen(path.c_str(), "wb");
+	std::fwrite(contents.data(), 1, contents.length(), file);
+	std::fclose(file);
+}
+
+// reads path
+static std::string readinventory(const std::string &path) {
+	std::string contents;
+	FILE *file = std::fopen(path.c_str(), "rb");
+	char buffer[4096];
+	size_t length;
+	while ((length = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		contents.append(buffer, length);
+	}
+	std::fclose(file);
+	return (contents);
+}
+
+// tests saving and loading a snapshot
+TEST(StationInventoryTest, Snapshot) {
+	std::string path = inventorypath(".snapshot");
+	{
+		detectionformats::stationinventory inventory(16);
+		for (int i = 0; i < STATIONCOUNT; i++) {
+			inventory.add(makestation(i, i * 0.001));
+		}
+		inventory.save(path);
+	}
+
+	detectionformats::stationinventory loaded;
+	ASSERT_FALSE(loaded.loadsnapshot(path + ".missing"));
+	ASSERT_TRUE(loaded.loadsnapshot(path));
+	ASSERT_EQ(STATIONCOUNT, static_cast<int>(loaded.size()));
+	for (int i = 0; i < STATIONCOUNT; i++) {
+		uint32_t id = loaded.find(makestation(i, 0).site);
+		ASSERT_EQ(static_cast<uint32_t>(i), id);
+		ASSERT_EQ(detectionformats::stationinventory::makekey(
+						makestation(i, 0).site), loaded.getkey(id));
+		ASSERT_NEAR(i * 0.001, loaded.getlatitudes()[id], 0.00001);
+		ASSERT_TRUE(std::isnan(loaded.getqualities()[id]));
+		ASSERT_EQ((i % 2) == 0, loaded.isenabled(id));
+		ASSERT_EQ((i % 3) == 0, loaded.isteleseismic(id));
+	}
+
+	// adding to a loaded snapshot copies it first
+	uint32_t id = loaded.add(makestation(STATIONCOUNT, 1.0));
+	ASSERT_EQ(static_cast<uint32_t>(STATIONCOUNT), id);
+	ASSERT_EQ(id, loaded.find(makestation(STATIONCOUNT, 0).site));
+	ASSERT_EQ(5u, loaded.find(makestation(5, 0).site));
+	loaded.add(makestation(5, 2.0));
+	ASSERT_NEAR(2.0, loaded.getlatitudes()[5], 0.00001);
+
+	std::remove(path.c_str());
+}
+
+// tests that damaged or inconsistent snapshots are rejected
+TEST(StationInventoryTest, RejectSnapshot) {
+	std::string path = inventorypath(".rejected");
+	detectionformats::stationinventory inventory;
+	inventory.add(makestation(1, 1.0));
+	inventory.save(path);
+	std::string good = readinventory(path);
+
+	detectionformats::stationinventory loaded;
+	loaded.add(makestation(2, 2.0));
+
+	// a flipped byte fails the checksum
+	std::string damaged = good;
+	damaged[damaged.length() - 1] ^= 1;
+	writeinventory(path, damaged);
+	ASSERT_FALSE(loaded.loadsnapshot(path));
+
+	// as does a truncated file
+	writeinventory(path, good.substr(0, good.length() / 2));
+	ASSERT_FALSE(loaded.loadsnapshot(path));
+
+	// another version is not read
+	std::string versioned = good;
+	versioned[8]++;
+	writeinventory(path, versioned);
+	ASSERT_FALSE(loaded.loadsnapshot(path));
+
+	// a station that would not validate is caught
+	detectionformats::stationinventory invalid;
+	invalid.add(makestation(1, 100.0));
+	invalid.save(path);
+	ASSERT_FALSE(loaded.loadsnapshot(path));
+
+	// every slot holding the first station, which leaves the second with
+	// no empty slot to end its probe, is caught before probing
+	detectionformats::stationinventory pair;
+	pair.add(makestation(1, 1.0));
+	pair.add(makestation(2, 2.0));
+	pair.save(path);
+	std::string duplicated = readinventory(path);
+	uint64_t tablesize = 0;
+	std::memcpy(&tablesize, &duplicated[SNAPSHOTTABLESIZE],
+			sizeof(tablesize));
+	std::memset(&duplicated[SNAPSHOTHEADERSIZE], 0,
+			tablesize * sizeof(uint32_t));
+	uint64_t checksum = detectionformats::HashBytes(
+			duplicated.data() + SNAPSHOTHEADERSIZE,
+			duplicated.length() - SNAPSHOTHEADERSIZE);
+	std::memcpy(&duplicated[SNAPSHOTCHECKSUM], &checksum, sizeof(checksum));
+	writeinventory(path, duplicated);
+	ASSERT_FALSE(loaded.loadsnapshot(path));
+
+	// a rejected snapshot leaves the inventory alone
+	ASSERT_EQ(1, static_cast<int>(loaded.size()));
+	ASSERT_EQ(0u, loaded.find(makestation(2, 0).site));
+
+	writeinventory(path, good);
+	ASSERT_TRUE(loaded.loadsnapshot(path));
+	ASSERT_EQ(0u, loaded.find(makestation(1, 0).site));
+	ASSERT_EQ(detectionformats::stationinventory::npos,
+			loaded.find(makestation(2, 0).site));
+
+	std::remove(path.c_str());
+}
+
+// tests falling back to json when there is no snapshot
+TEST(StationInventoryTest, LoadJSON) {
+	std::string jsonpath = inventorypath(".json");
+	std::string snapshotpath = inventorypath(".fallback");
+	std::remove(snapshotpath.c_str());
+
+	std::string invalid = STATIONSTRING;
+	invalid.replace(invalid.find("45.59697"), 8, "145.5969");
+	std::string other = "{\"Type\":\"Retract\",\"ID\":\"1\"}";
+	writeinventory(jsonpath, std::string(STATIONSTRING) + "\n" + other + "\n"
+			+ invalid + "\n{\"Type\":\n");
+
+	detectionformats::stationinventory inventory;
+	ASSERT_THROW(inventory.loadjson(jsonpath + ".missing"),
+			std::runtime_error);
+	ASSERT_FALSE(inventory.load(snapshotpath, jsonpath));
+	ASSERT_EQ(1, static_cast<int>(inventory.size()));
+	ASSERT_EQ(0u, inventory.find("BOZ", "BHZ", "US", "00"));
+
+	// the fallback wrote a snapshot for next time
+	detectionformats::stationinventory restarted;
+	ASSERT_TRUE(restarted.load(snapshotpath, jsonpath));
+	ASSERT_EQ(1, static_cast<int>(restarted.size()));
+	ASSERT_NEAR(LATITUDE, restarted.getlatitudes()[0], 0.00001);
+
+	std::remove(jsonpath.c_str());
+	std::remove(snapshotpath.c_str());
+}
+#endif
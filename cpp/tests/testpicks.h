@@ -0,0 +1,22 @@
+#ifndef DETECTION_TESTPICKS_H
+#define DETECTION_TESTPICKS_H
+
+#include <string>
+
+#include "detection-formats.h"
+
+// builds a pick with the given id, station, time, and phase, the rest of
+// its fields the same in every test
+inline detectionformats::pick maketestpick(const std::string &id,
+		const std::string &station, double time,
+		const std::string &phase = "P") {
+	detectionformats::pick newpick;
+	newpick.id = id;
+	newpick.site = detectionformats::site(station, "BHZ", "US", "00");
+	newpick.time = time;
+	newpick.source = detectionformats::source("US", "TestAuthor");
+	newpick.phase = phase;
+	return (newpick);
+}
+
+#endif
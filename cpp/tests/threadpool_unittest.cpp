@@ -0,0 +1,85 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#define THREADCOUNT 4
+#define TASKCOUNT 1000
+
+// tests to see if the threadpool runs every submitted task
+TEST(ThreadPoolTest, Submit) {
+	detectionformats::threadpool pool(THREADCOUNT);
+	ASSERT_EQ(pool.size(), (size_t) THREADCOUNT);
+
+	std::atomic<int> count(0);
+	for (int i = 0; i < TASKCOUNT; i++) {
+		pool.submit([&count]() {count++;});
+	}
+	pool.wait();
+
+	ASSERT_EQ(count.load(), TASKCOUNT);
+}
+
+// tests to see if run covers each index exactly once
+TEST(ThreadPoolTest, Run) {
+	detectionformats::threadpool pool(THREADCOUNT);
+
+	std::vector<int> visits(TASKCOUNT, 0);
+	pool.run(visits.size(), 7, [&visits](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			visits[i]++;
+		}
+	});
+
+	for (size_t i = 0; i < visits.size(); i++) {
+		ASSERT_EQ(visits[i], 1);
+	}
+
+	// nothing to do
+	pool.run(0, 0, [](size_t, size_t) {
+		FAIL();
+	});
+}
+
+// tests to see if an exception thrown by a chunk reaches run's caller
+TEST(ThreadPoolTest, RunThrows) {
+	detectionformats::threadpool pool(THREADCOUNT);
+
+	ASSERT_THROW(pool.run(TASKCOUNT, 7, [](size_t begin, size_t end) {
+		if ((begin <= TASKCOUNT / 2) && (TASKCOUNT / 2 < end)) {
+			throw std::runtime_error("chunk failed");
+		}
+	}), std::runtime_error);
+
+	// the pool still works afterwards
+	std::atomic<int> count(0);
+	pool.run(TASKCOUNT, 7, [&count](size_t begin, size_t end) {
+		count += static_cast<int>(end - begin);
+	});
+	ASSERT_EQ(count.load(), TASKCOUNT);
+}
+
+// tests to see if run can be called from inside a task, even with a single
+// worker that would otherwise wait on itself
+TEST(ThreadPoolTest, RunNested) {
+	detectionformats::threadpool pool(1);
+
+	std::atomic<int> count(0);
+	pool.run(THREADCOUNT, 1, [&pool, &count](size_t, size_t) {
+		pool.run(TASKCOUNT, 7, [&count](size_t begin, size_t end) {
+			count += static_cast<int>(end - begin);
+		});
+	});
+	ASSERT_EQ(count.load(), THREADCOUNT * TASKCOUNT);
+
+	std::atomic<int> submitted(0);
+	pool.submit([&pool, &submitted]() {
+		pool.run(TASKCOUNT, 0, [&submitted](size_t begin, size_t end) {
+			submitted += static_cast<int>(end - begin);
+		});
+	});
+	pool.wait();
+	ASSERT_EQ(submitted.load(), TASKCOUNT);
+}
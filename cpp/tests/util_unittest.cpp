@@ -0,0 +1,86 @@
+#include "detection-formats.h"
+#include <gtest/gtest.h>
+
+#include <string>
+
+#define TIME "2015-12-28T21:32:24.017Z"
+#define EPOCHTIME 1451338344.017
+#define LEAPDAYTIME "2016-02-29T00:00:00.000Z"
+#define LEAPDAYEPOCHTIME 1456704000.0
+#define EPOCHSTART "1970-01-01T00:00:00.000Z"
+
+// tests to see if iso8601 times convert to the expected epoch times
+TEST(UtilTest, ConvertISO8601ToEpochTime) {
+	ASSERT_NEAR(detectionformats::ConvertISO8601ToEpochTime(std::string(TIME)),
+			EPOCHTIME, 0.0001);
+	ASSERT_NEAR(
+			detectionformats::ConvertISO8601ToEpochTime(
+					std::string(LEAPDAYTIME)),
+			LEAPDAYEPOCHTIME, 0.0001);
+	ASSERT_EQ(
+			detectionformats::ConvertISO8601ToEpochTime(std::string(EPOCHSTART)),
+			0.0);
+
+	// wrong length
+	ASSERT_EQ(detectionformats::ConvertISO8601ToEpochTime(std::string("")),
+			-1.0);
+	ASSERT_EQ(
+			detectionformats::ConvertISO8601ToEpochTime(
+					std::string("2015-12-28T21:32:24Z")),
+			-1.0);
+}
+
+// tests to see if epoch times convert to the expected iso8601 times
+TEST(UtilTest, ConvertEpochTimeToISO8601) {
+	ASSERT_STREQ(detectionformats::ConvertEpochTimeToISO8601(EPOCHTIME).c_str(),
+			TIME);
+	ASSERT_STREQ(
+			detectionformats::ConvertEpochTimeToISO8601(LEAPDAYEPOCHTIME).c_str(),
+			LEAPDAYTIME);
+	ASSERT_STREQ(detectionformats::ConvertEpochTimeToISO8601(0.0).c_str(),
+			EPOCHSTART);
+	ASSERT_STREQ(detectionformats::ConvertEpochTimeToISO8601(-1.0).c_str(),
+			"1969-12-31T23:59:59.000Z");
+
+	// round trip a date in each month of a leap and a common year
+	for (int year = 2015; year <= 2016; year++) {
+		for (int month = 1; month <= 12; month++) {
+			char timestring[32];
+			snprintf(timestring, sizeof(timestring),
+					"%04d-%02d-28T12:34:56.789Z", year, month);
+			double epochtime = detectionformats::ConvertISO8601ToEpochTime(
+					std::string(timestring));
+			ASSERT_STREQ(
+					detectionformats::ConvertEpochTimeToISO8601(epochtime)
+							.c_str(),
+					timestring);
+		}
+	}
+}
+
+// tests to see if message types are found without disturbing this thread's
+// parse context
+TEST(UtilTest, GetDetectionType) {
+	std::string retract = "{\"Type\":\"Retract\",\"ID\":\"12GFH48776857\"}";
+	detectionformats::parsecontext::document &document =
+			detectionformats::parsecontext::local().parse(retract.c_str(),
+					retract.length());
+
+	ASSERT_EQ(detectionformats::GetDetectionType(
+			"{\"Site\":{\"Type\":\"Pick\"},\"Type\":\"Pick\"}"),
+			detectionformats::formattypes::picktype);
+	ASSERT_EQ(detectionformats::GetDetectionType(
+			"{\"Type\":\"StationInfoRequest\"}"),
+			detectionformats::formattypes::stationinforequesttype);
+	ASSERT_EQ(detectionformats::GetDetectionType(
+			"{\"Site\":{\"Type\":\"Pick\"}}"),
+			detectionformats::formattypes::unknown);
+	ASSERT_EQ(detectionformats::GetDetectionType("{\"Type\":1}"),
+			detectionformats::formattypes::unknown);
+	ASSERT_EQ(detectionformats::GetDetectionType("[\"Pick\"]"),
+			detectionformats::formattypes::unknown);
+	ASSERT_EQ(detectionformats::GetDetectionType("{\"Type\":\"Pick\""),
+			detectionformats::formattypes::unknown);
+
+	ASSERT_STREQ(document["ID"].GetString(), "12GFH48776857");
+}